@@ -37,26 +37,21 @@
 #include <math.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include "pmm_util.h"
 
 #define NARGS 1
 
-int main(int argc, char **argv) {
+/*
+ * time the routine for a problem size i and print the result
+ */
+void run_routine(double i) {
     long long complexity;
 
     /* declare variables */
     double a;
     double b;
     double c;
-    double i;
-
-    /* parse arguments */
-    if(argc != NARGS+1) {
-        return PMM_EXIT_ARGFAIL;
-    }
-    if(sscanf(argv[1], "%lf", &i) == 0) {
-        return PMM_EXIT_ARGPARSEFAIL;
-    }
 
     /* calculate complexity */
     complexity = 2*(long long)i;
@@ -85,6 +80,32 @@ int main(int argc, char **argv) {
 
     /* destroy timer */
     pmm_timer_destroy();
+}
+
+int main(int argc, char **argv) {
+    double i;
+    int rc;
+
+    /* with -s run as a server, pmmd streams problem sizes to stdin (the
+     * routine should be configured with <protocol>server</protocol> and
+     * <exe_args>-s</exe_args>) */
+    if(argc == 2 && strcmp(argv[1], "-s") == 0) {
+        while((rc = pmm_server_read_params(NARGS, &i)) == 1) {
+            run_routine(i);
+        }
+
+        return rc == 0 ? PMM_EXIT_SUCCESS : PMM_EXIT_ARGPARSEFAIL;
+    }
+
+    /* parse arguments */
+    if(argc != NARGS+1) {
+        return PMM_EXIT_ARGFAIL;
+    }
+    if(sscanf(argv[1], "%lf", &i) == 0) {
+        return PMM_EXIT_ARGPARSEFAIL;
+    }
+
+    run_routine(i);
 
     return PMM_EXIT_SUCCESS;
 }
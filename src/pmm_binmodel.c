@@ -0,0 +1,765 @@
+/*
+    Copyright (C) 2008-2010 Robert Higgins
+        Author: Robert Higgins <robert.higgins@ucd.ie>
+
+    This file is part of PMM.
+
+    PMM is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMM is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+ * @file    pmm_binmodel.c
+ * @brief   Binary model file format
+ *
+ * Conversion of models to and from the binary model format described in
+ * pmm_binmodel.h. Reading maps the file and takes every value straight from
+ * the mapping, instead of building a document tree first as the xml format
+ * requires. Locking, temporary files and the journal are left to the callers
+ * in pmm_cfgparser.c, as for the xml format.
+ */
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>     // for malloc/free
+#include <string.h>     // for memcmp/memcpy
+#include <unistd.h>     // for pread/close
+#include <sys/stat.h>   // for fstat
+#include <sys/mman.h>   // for mmap
+
+#include "pmm_binmodel.h"
+#include "pmm_model.h"
+#include "pmm_interval.h"
+#include "pmm_param.h"
+#include "pmm_log.h"
+
+//! round a section size up so the following section is 8 byte aligned
+#define PMM_BINMODEL_ALIGN(x) (((x) + 7) & ~((uint64_t)7))
+
+/*!
+ * string table of a binary model file being built
+ */
+typedef struct pmm_binmodel_strings {
+    char *buf;          /*!< terminated strings */
+    size_t size;        /*!< bytes used */
+    size_t capacity;    /*!< bytes allocated */
+} PMM_Binmodel_Strings;
+
+int
+binmodel_add_string(struct pmm_binmodel_strings *s, const char *str,
+                    uint64_t *offset);
+int
+binmodel_check_section(const struct pmm_binmodel_header *h, uint64_t offset,
+                       uint64_t count, size_t record_size);
+int
+binmodel_fill(struct pmm_model *m, struct pmm_paramdef_set *pd_set,
+              char *image, struct pmm_binmodel_strings *s);
+
+/*!
+ * Test if an open file is a binary model file
+ *
+ * @param   fd      file descriptor of the file
+ *
+ * @return 1 if the file starts as a binary model file does, 0 otherwise
+ */
+int
+is_binmodel_fd(int fd)
+{
+    char magic[8];
+
+    if(pread(fd, magic, sizeof magic, 0) != sizeof magic) {
+        return 0;
+    }
+
+    return memcmp(magic, PMM_BINMODEL_MAGIC, sizeof magic) == 0;
+}
+
+/*!
+ * Test that a section of a binary model file lies within the file
+ *
+ * @param   h           pointer to the header of the file
+ * @param   offset      offset of the section
+ * @param   count       number of records in the section
+ * @param   record_size size of each record
+ *
+ * @return 0 if the section is valid, -1 if not
+ */
+int
+binmodel_check_section(const struct pmm_binmodel_header *h, uint64_t offset,
+                       uint64_t count, size_t record_size)
+{
+    if(offset % 8 != 0 || offset < sizeof *h || offset > h->file_size) {
+        return -1;
+    }
+
+    if(count > (h->file_size - offset) / record_size) {
+        return -1;
+    }
+
+    return 0;
+}
+
+/*!
+ * Map an open binary model file into memory and check its header. The
+ * mapping remains valid after the file is closed, or replaced by a newer
+ * version of the model.
+ *
+ * @param   fd      file descriptor of the file, open for reading
+ *
+ * @return pointer to newly allocated mapped model or NULL on failure
+ */
+struct pmm_binmodel*
+map_binmodel_fd(int fd)
+{
+    struct stat file_stats;
+    struct pmm_binmodel *bm;
+    const struct pmm_binmodel_header *h;
+    const char *base;
+
+    if(fstat(fd, &file_stats) < 0) {
+        ERRPRINTF("Error getting size of binary model.\n");
+        perror("fstat");
+        return NULL;
+    }
+
+    if(file_stats.st_size < (off_t)sizeof *h) {
+        ERRPRINTF("Binary model too short: %ld bytes.\n",
+                  (long)file_stats.st_size);
+        return NULL;
+    }
+
+    bm = malloc(sizeof *bm);
+    if(bm == NULL) {
+        ERRPRINTF("Error allocating memory.\n");
+        return NULL;
+    }
+
+    bm->size = file_stats.st_size;
+    bm->map = mmap(NULL, bm->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(bm->map == MAP_FAILED) {
+        ERRPRINTF("Error mapping binary model.\n");
+        perror("mmap");
+
+        free(bm);
+        return NULL;
+    }
+
+    base = bm->map;
+    h = bm->map;
+    bm->header = h;
+
+    if(memcmp(h->magic, PMM_BINMODEL_MAGIC, sizeof h->magic) != 0 ||
+       h->version != PMM_BINMODEL_VERSION)
+    {
+        ERRPRINTF("Unsupported binary model version.\n");
+        unmap_binmodel(&bm);
+        return NULL;
+    }
+
+    if(h->byte_order != PMM_BINMODEL_BYTE_ORDER) {
+        ERRPRINTF("Binary model written with a different byte order.\n");
+        unmap_binmodel(&bm);
+        return NULL;
+    }
+
+    if(h->file_size != bm->size || h->n_p <= 0 || h->n_benchmarks < 0 ||
+       h->n_intervals < 0 ||
+       binmodel_check_section(h, h->paramdef_offset, h->n_p,
+                              sizeof *(bm->paramdefs)) < 0 ||
+       binmodel_check_section(h, h->bench_offset, h->n_benchmarks,
+                              sizeof *(bm->benches)) < 0 ||
+       binmodel_check_section(h, h->params_offset,
+                              (uint64_t)h->n_benchmarks * h->n_p,
+                              sizeof *(bm->params)) < 0 ||
+       binmodel_check_section(h, h->metric_offset, h->n_metrics,
+                              sizeof *(bm->metrics)) < 0 ||
+       binmodel_check_section(h, h->interval_offset, h->n_intervals,
+                              sizeof *(bm->intervals)) < 0 ||
+       binmodel_check_section(h, h->interval_params_offset,
+                              h->n_interval_params,
+                              sizeof *(bm->interval_params)) < 0 ||
+       binmodel_check_section(h, h->strings_offset, h->strings_size, 1) < 0 ||
+       h->strings_size == 0 ||
+       base[h->strings_offset + h->strings_size - 1] != '\0')
+    {
+        ERRPRINTF("Binary model is corrupt.\n");
+        unmap_binmodel(&bm);
+        return NULL;
+    }
+
+    bm->paramdefs = (const void *)(base + h->paramdef_offset);
+    bm->benches = (const void *)(base + h->bench_offset);
+    bm->params = (const void *)(base + h->params_offset);
+    bm->metrics = (const void *)(base + h->metric_offset);
+    bm->intervals = (const void *)(base + h->interval_offset);
+    bm->interval_params = (const void *)(base + h->interval_params_offset);
+    bm->strings = base + h->strings_offset;
+
+    return bm;
+}
+
+/*!
+ * Unmap a binary model file and free the structure describing it
+ *
+ * @param   bm      pointer to address of the mapped model
+ */
+void
+unmap_binmodel(struct pmm_binmodel **bm)
+{
+    munmap((*bm)->map, (*bm)->size);
+
+    free(*bm);
+    *bm = NULL;
+}
+
+/*!
+ * Get a string of a mapped binary model
+ *
+ * @param   bm      pointer to the mapped model
+ * @param   offset  offset of the string in the string table
+ *
+ * @return pointer to the string in the mapping, or NULL if the offset stands
+ * for no string or is out of range
+ */
+const char*
+binmodel_string(struct pmm_binmodel *bm, uint64_t offset)
+{
+    if(offset == PMM_BINMODEL_NO_STRING ||
+       offset >= bm->header->strings_size)
+    {
+        return NULL;
+    }
+
+    return &(bm->strings[offset]);
+}
+
+/*!
+ * Create the parameter definitions stored in a mapped binary model. Formula
+ * parsers are not set up.
+ *
+ * @param   bm      pointer to the mapped model
+ *
+ * @return pointer to newly allocated parameter definition set or NULL on
+ * failure
+ */
+struct pmm_paramdef_set*
+binmodel_to_paramdef_set(struct pmm_binmodel *bm)
+{
+    struct pmm_paramdef_set *pd_set;
+    const struct pmm_binmodel_paramdef *bpd;
+    const char *str;
+    int i;
+
+    pd_set = new_paramdef_set();
+    if(pd_set == NULL) {
+        ERRPRINTF("Error allocating parameter definition set.\n");
+        return NULL;
+    }
+
+    pd_set->pd_array = malloc(bm->header->n_p * sizeof *(pd_set->pd_array));
+    if(pd_set->pd_array == NULL) {
+        ERRPRINTF("Error allocating memory.\n");
+        free_paramdef_set(&pd_set);
+        return NULL;
+    }
+
+    for(i=0; i<bm->header->n_p; i++) {
+        pd_set->pd_array[i].name = NULL;
+    }
+    pd_set->n_p = bm->header->n_p;
+
+    for(i=0; i<bm->header->n_p; i++) {
+        bpd = &(bm->paramdefs[i]);
+
+        str = binmodel_string(bm, bpd->name);
+        if(str == NULL || !set_str(&(pd_set->pd_array[i].name), (char *)str)) {
+            ERRPRINTF("Error setting parameter name.\n");
+            free_paramdef_set(&pd_set);
+            return NULL;
+        }
+
+        pd_set->pd_array[i].type = bpd->type;
+        pd_set->pd_array[i].order = bpd->order;
+        pd_set->pd_array[i].nonzero_end = bpd->nonzero_end;
+        pd_set->pd_array[i].end = bpd->end;
+        pd_set->pd_array[i].start = bpd->start;
+        pd_set->pd_array[i].stride = bpd->stride;
+        pd_set->pd_array[i].offset = bpd->offset;
+    }
+
+    pd_set->pc_max = bm->header->pc_max;
+    pd_set->pc_min = bm->header->pc_min;
+
+    str = binmodel_string(bm, bm->header->pc_formula);
+    if(str != NULL && !set_str(&(pd_set->pc_formula), (char *)str)) {
+        ERRPRINTF("Error setting parameter constraint formula.\n");
+        free_paramdef_set(&pd_set);
+        return NULL;
+    }
+
+    str = binmodel_string(bm, bm->header->complexity_formula);
+    if(str != NULL && !set_str(&(pd_set->complexity_formula), (char *)str)) {
+        ERRPRINTF("Error setting complexity formula.\n");
+        free_paramdef_set(&pd_set);
+        return NULL;
+    }
+
+    return pd_set;
+}
+
+/*!
+ * Fill a model with the benchmarks, intervals and state of a mapped binary
+ * model. Parameter definitions are not set, see binmodel_to_paramdef_set.
+ *
+ * @param   bm      pointer to the mapped model
+ * @param   m       pointer to the model, with no bench list allocated
+ *
+ * @return 0 on success, -1 on failure
+ */
+int
+binmodel_to_model(struct pmm_binmodel *bm, struct pmm_model *m)
+{
+    const struct pmm_binmodel_header *h;
+    const struct pmm_binmodel_bench *bb;
+    const struct pmm_binmodel_interval *bi;
+    const char *str;
+    struct pmm_benchmark *b;
+    struct pmm_interval *interval;
+    int i, j, n;
+
+    h = bm->header;
+
+    m->n_p = h->n_p;
+
+    m->bench_list = new_bench_list(m, m->n_p);
+    if(m->bench_list == NULL) {
+        ERRPRINTF("Error allocating bench list.\n");
+        return -1;
+    }
+
+    for(i=0; i<h->n_benchmarks; i++) {
+        bb = &(bm->benches[i]);
+
+        if(bb->n_metrics < 0 || bb->first_metric > h->n_metrics ||
+           (uint64_t)bb->n_metrics > h->n_metrics - bb->first_metric)
+        {
+            ERRPRINTF("Binary model is corrupt, benchmark %d metrics.\n", i);
+            return -1;
+        }
+
+        b = new_list_benchmark(m->bench_list);
+        if(b == NULL) {
+            ERRPRINTF("Error allocating new benchmark.\n");
+            return -1;
+        }
+
+        memcpy(b->p, &(bm->params[i*h->n_p]), h->n_p * sizeof *(b->p));
+
+        b->complexity = bb->complexity;
+        b->flops = bb->flops;
+        b->seconds = bb->seconds;
+        b->wall_t.tv_sec = bb->wall_sec;
+        b->wall_t.tv_usec = bb->wall_usec;
+        b->used_t.tv_sec = bb->used_sec;
+        b->used_t.tv_usec = bb->used_usec;
+        b->numa_node = bb->numa_node;
+        b->nice = bb->nice;
+
+        str = binmodel_string(bm, bb->cpuset);
+        if(str != NULL && !set_str(&(b->cpuset), (char *)str)) {
+            ERRPRINTF("Error setting cpuset.\n");
+            free_benchmark(&b);
+            return -1;
+        }
+
+        for(j=0; j<bb->n_metrics; j++) {
+            str = binmodel_string(bm, bm->metrics[bb->first_metric+j].name);
+            if(str == NULL ||
+               add_benchmark_metric(b, (char *)str,
+                                    bm->metrics[bb->first_metric+j].value) < 0)
+            {
+                ERRPRINTF("Error adding metric.\n");
+                free_benchmark(&b);
+                return -1;
+            }
+        }
+
+        if(insert_bench_into_list(m->bench_list, b) < 0) {
+            ERRPRINTF("Error inserting bench into bench list.\n");
+            free_benchmark(&b);
+            return -1;
+        }
+    }
+
+    for(i=0; i<h->n_intervals; i++) {
+        bi = &(bm->intervals[i]);
+
+        // intervals without a start or end may have no n_p set, the points
+        // of those with either are points of the model
+        n = (bi->has_start != 0) + (bi->has_end != 0);
+        if(bi->type < IT_NULL || bi->type > IT_COMPLETE ||
+           (n > 0 && bi->n_p != h->n_p) || bi->params > h->n_interval_params ||
+           (uint64_t)n * h->n_p > h->n_interval_params - bi->params)
+        {
+            ERRPRINTF("Binary model is corrupt, interval %d.\n", i);
+            return -1;
+        }
+
+        interval = new_interval();
+        if(interval == NULL) {
+            ERRPRINTF("Error creating new interval.\n");
+            return -1;
+        }
+
+        interval->type = bi->type;
+        interval->plane = bi->plane;
+        interval->climb_step = bi->climb_step;
+        interval->n_p = bi->n_p;
+
+        j = bi->params;
+        if(bi->has_start) {
+            interval->start = init_param_array_copy(
+                                (int *)&(bm->interval_params[j]), bi->n_p);
+            j += bi->n_p;
+        }
+        if(bi->has_end) {
+            interval->end = init_param_array_copy(
+                                (int *)&(bm->interval_params[j]), bi->n_p);
+        }
+
+        if((bi->has_start && interval->start == NULL) ||
+           (bi->has_end && interval->end == NULL))
+        {
+            ERRPRINTF("Error copying interval parameters.\n");
+            free_interval(&interval);
+            return -1;
+        }
+
+        //intervals are stored from the top of the stack down
+        add_bottom_interval(m->interval_list, interval);
+    }
+
+    m->complete = h->complete;
+    m->journal_seq = h->journal_seq;
+
+    return 0; //success
+}
+
+/*!
+ * Add a string to the string table of a binary model file being built
+ *
+ * @param   s       pointer to the string table
+ * @param   str     pointer to the string, may be NULL
+ * @param   offset  pointer to the offset of the string in the table, set to
+ *                  PMM_BINMODEL_NO_STRING if str is NULL
+ *
+ * @return 0 on success, -1 on failure
+ */
+int
+binmodel_add_string(struct pmm_binmodel_strings *s, const char *str,
+                    uint64_t *offset)
+{
+    size_t len;
+    size_t capacity;
+    char *buf;
+
+    if(str == NULL) {
+        *offset = PMM_BINMODEL_NO_STRING;
+        return 0;
+    }
+
+    len = strlen(str) + 1;
+
+    if(s->size + len > s->capacity) {
+        capacity = s->capacity > 0 ? 2*s->capacity : 256;
+        while(s->size + len > capacity) {
+            capacity *= 2;
+        }
+
+        buf = realloc(s->buf, capacity);
+        if(buf == NULL) {
+            ERRPRINTF("Error reallocating string table.\n");
+            return -1;
+        }
+        s->buf = buf;
+        s->capacity = capacity;
+    }
+
+    memcpy(&(s->buf[s->size]), str, len);
+    *offset = s->size;
+    s->size += len;
+
+    return 0;
+}
+
+/*!
+ * Build the binary model file contents of a model in memory
+ *
+ * @param   m       pointer to the model
+ * @param   size    pointer to size_t set to the size of the contents
+ *
+ * @return pointer to newly allocated file contents or NULL on failure
+ */
+void*
+model_to_binmodel(struct pmm_model *m, size_t *size)
+{
+    struct pmm_binmodel_strings s;
+    struct pmm_binmodel_header *h;
+    struct pmm_paramdef_set *pd_set;
+    struct pmm_bench_list *bl;
+    struct pmm_interval *interval;
+    char *image, *temp;
+    uint64_t n_metrics, n_interval_params;
+    int i;
+
+    pd_set = get_model_paramdef_set(m);
+    bl = m->bench_list;
+    if(pd_set == NULL || bl == NULL || pd_set->n_p != m->n_p) {
+        ERRPRINTF("Model has no parameter definitions or benchmarks.\n");
+        return NULL;
+    }
+
+    n_metrics = 0;
+    for(i=0; i<bl->size; i++) {
+        n_metrics += bl->index[i]->n_metrics;
+    }
+
+    n_interval_params = 0;
+    for(interval=m->interval_list->top; interval!=NULL;
+        interval=interval->previous)
+    {
+        if(interval->start != NULL) {
+            n_interval_params += interval->n_p;
+        }
+        if(interval->end != NULL) {
+            n_interval_params += interval->n_p;
+        }
+    }
+
+    // lay out the sections one after another, each 8 byte aligned, the
+    // string table follows once its size is known
+    h = calloc(1, sizeof *h);
+    if(h == NULL) {
+        ERRPRINTF("Error allocating memory for binary model.\n");
+        return NULL;
+    }
+
+    h->paramdef_offset = PMM_BINMODEL_ALIGN(sizeof *h);
+    h->bench_offset = h->paramdef_offset +
+        PMM_BINMODEL_ALIGN(m->n_p * sizeof(struct pmm_binmodel_paramdef));
+    h->params_offset = h->bench_offset +
+        PMM_BINMODEL_ALIGN(bl->size * sizeof(struct pmm_binmodel_bench));
+    h->metric_offset = h->params_offset +
+        PMM_BINMODEL_ALIGN((uint64_t)bl->size * m->n_p * sizeof(int32_t));
+    h->interval_offset = h->metric_offset +
+        PMM_BINMODEL_ALIGN(n_metrics * sizeof(struct pmm_binmodel_metric));
+    h->interval_params_offset = h->interval_offset +
+        PMM_BINMODEL_ALIGN(m->interval_list->size *
+                           sizeof(struct pmm_binmodel_interval));
+    h->strings_offset = h->interval_params_offset +
+        PMM_BINMODEL_ALIGN(n_interval_params * sizeof(int32_t));
+
+    h->n_metrics = n_metrics;
+    h->n_interval_params = n_interval_params;
+
+    image = calloc(1, h->strings_offset);
+    if(image == NULL) {
+        ERRPRINTF("Error allocating memory for binary model.\n");
+        free(h);
+        return NULL;
+    }
+
+    memcpy(image, h, sizeof *h);
+    free(h);
+    h = (void *)image;
+
+    s.buf = NULL;
+    s.size = 0;
+    s.capacity = 0;
+
+    if(binmodel_fill(m, pd_set, image, &s) < 0) {
+        ERRPRINTF("Error building binary model.\n");
+
+        free(s.buf);
+        s.buf = NULL;
+        free(image);
+        image = NULL;
+
+        return NULL;
+    }
+
+    h->strings_size = s.size;
+    h->file_size = h->strings_offset + s.size;
+
+    temp = realloc(image, h->file_size);
+    if(temp == NULL) {
+        ERRPRINTF("Error reallocating memory for binary model.\n");
+
+        free(s.buf);
+        s.buf = NULL;
+        free(image);
+        image = NULL;
+
+        return NULL;
+    }
+    image = temp;
+    h = (void *)image;
+
+    memcpy(image + h->strings_offset, s.buf, s.size);
+    *size = h->file_size;
+
+    free(s.buf);
+    s.buf = NULL;
+
+    return image;
+}
+
+/*!
+ * Fill the header and sections of a binary model file being built, the
+ * offsets of the sections must already be set in the header
+ *
+ * @param   m       pointer to the model
+ * @param   pd_set  pointer to the parameter definitions of the model
+ * @param   image   pointer to the file contents, up to the string table
+ * @param   s       pointer to the string table, filled as strings are met
+ *
+ * @return 0 on success, -1 on failure
+ */
+int
+binmodel_fill(struct pmm_model *m, struct pmm_paramdef_set *pd_set,
+              char *image, struct pmm_binmodel_strings *s)
+{
+    struct pmm_binmodel_header *h;
+    struct pmm_binmodel_paramdef *bpd;
+    struct pmm_binmodel_bench *bb;
+    struct pmm_binmodel_metric *bmet;
+    struct pmm_binmodel_interval *bi;
+    int32_t *interval_params;
+    struct pmm_bench_list *bl;
+    struct pmm_benchmark *b;
+    struct pmm_interval *interval;
+    uint64_t empty;
+    int i, j, k, n;
+
+    bl = m->bench_list;
+
+    h = (void *)image;
+    memcpy(h->magic, PMM_BINMODEL_MAGIC, sizeof h->magic);
+    h->version = PMM_BINMODEL_VERSION;
+    h->byte_order = PMM_BINMODEL_BYTE_ORDER;
+    h->n_p = m->n_p;
+    h->n_benchmarks = bl->size;
+    h->complete = m->complete;
+    h->n_intervals = m->interval_list->size;
+    h->pc_max = pd_set->pc_max;
+    h->pc_min = pd_set->pc_min;
+    h->journal_seq = m->journal_seq;
+
+    if(binmodel_add_string(s, pd_set->pc_formula, &(h->pc_formula)) < 0 ||
+       binmodel_add_string(s, pd_set->complexity_formula,
+                           &(h->complexity_formula)) < 0)
+    {
+        return -1;
+    }
+
+    bpd = (void *)(image + h->paramdef_offset);
+    for(i=0; i<m->n_p; i++) {
+        if(binmodel_add_string(s, pd_set->pd_array[i].name,
+                               &(bpd[i].name)) < 0)
+        {
+            return -1;
+        }
+
+        bpd[i].type = pd_set->pd_array[i].type;
+        bpd[i].order = pd_set->pd_array[i].order;
+        bpd[i].nonzero_end = pd_set->pd_array[i].nonzero_end;
+        bpd[i].end = pd_set->pd_array[i].end;
+        bpd[i].start = pd_set->pd_array[i].start;
+        bpd[i].stride = pd_set->pd_array[i].stride;
+        bpd[i].offset = pd_set->pd_array[i].offset;
+    }
+
+    // benchmarks in the sorted order of the bench list index, their
+    // parameters are already packed in that order
+    memcpy(image + h->params_offset, bl->params,
+           (size_t)bl->size * m->n_p * sizeof *(bl->params));
+
+    bb = (void *)(image + h->bench_offset);
+    bmet = (void *)(image + h->metric_offset);
+    k = 0;
+    for(i=0; i<bl->size; i++) {
+        b = bl->index[i];
+
+        bb[i].complexity = b->complexity;
+        bb[i].flops = b->flops;
+        bb[i].seconds = b->seconds;
+        bb[i].wall_sec = b->wall_t.tv_sec;
+        bb[i].wall_usec = b->wall_t.tv_usec;
+        bb[i].used_sec = b->used_t.tv_sec;
+        bb[i].used_usec = b->used_t.tv_usec;
+        bb[i].numa_node = b->numa_node;
+        bb[i].nice = b->nice;
+        bb[i].first_metric = k;
+        bb[i].n_metrics = b->n_metrics;
+
+        if(binmodel_add_string(s, b->cpuset, &(bb[i].cpuset)) < 0) {
+            return -1;
+        }
+
+        for(j=0; j<b->n_metrics; j++, k++) {
+            if(binmodel_add_string(s, b->metrics[j].name,
+                                   &(bmet[k].name)) < 0)
+            {
+                return -1;
+            }
+            bmet[k].value = b->metrics[j].value;
+        }
+    }
+
+    bi = (void *)(image + h->interval_offset);
+    interval_params = (void *)(image + h->interval_params_offset);
+    i = 0;
+    n = 0;
+    for(interval=m->interval_list->top; interval!=NULL;
+        interval=interval->previous)
+    {
+        bi[i].type = interval->type;
+        bi[i].plane = interval->plane;
+        bi[i].climb_step = interval->climb_step;
+        bi[i].n_p = interval->n_p;
+        bi[i].has_start = interval->start != NULL;
+        bi[i].has_end = interval->end != NULL;
+        bi[i].params = n;
+
+        if(interval->start != NULL) {
+            memcpy(&(interval_params[n]), interval->start,
+                   interval->n_p * sizeof *interval_params);
+            n += interval->n_p;
+        }
+        if(interval->end != NULL) {
+            memcpy(&(interval_params[n]), interval->end,
+                   interval->n_p * sizeof *interval_params);
+            n += interval->n_p;
+        }
+
+        i++;
+    }
+
+    // an empty table still holds a terminator, so readers can check that
+    // every string in it is terminated
+    if(s->size == 0 && binmodel_add_string(s, "", &empty) < 0) {
+        return -1;
+    }
+
+    return 0; //success
+}
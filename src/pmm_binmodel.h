@@ -0,0 +1,183 @@
+/*
+    Copyright (C) 2008-2010 Robert Higgins
+        Author: Robert Higgins <robert.higgins@ucd.ie>
+
+    This file is part of PMM.
+
+    PMM is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMM is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+ * @file   pmm_binmodel.h
+ * @brief  Binary model file format
+ *
+ * A binary model file is a header followed by sections of fixed size
+ * records: the parameter definitions, the benchmarks, their parameters, their
+ * metrics, the intervals and their parameters, and finally a table of the
+ * strings the other sections refer to by offset. Benchmarks are stored in
+ * the sorted order of the bench list, with their parameters packed in an
+ * array of n_p values per benchmark. The format is load only: a mapped file
+ * is converted to a model with binmodel_to_model() and unmapped, lookups are
+ * served by the model. Files are written in the byte order of the host and
+ * are only read on hosts of the same byte order.
+ */
+
+#ifndef PMM_BINMODEL_H_
+#define PMM_BINMODEL_H_
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "pmm_model.h"
+#include "pmm_param.h"
+
+//! first bytes of a binary model file
+#define PMM_BINMODEL_MAGIC "PMMMODEL"
+//! version of the binary model format
+#define PMM_BINMODEL_VERSION 1
+//! value stored to detect files written with a different byte order
+#define PMM_BINMODEL_BYTE_ORDER 0x01020304
+//! string offset standing for a NULL string
+#define PMM_BINMODEL_NO_STRING UINT64_MAX
+
+/*!
+ * header of a binary model file, offsets are from the start of the file
+ */
+typedef struct pmm_binmodel_header {
+    char magic[8];              /*!< PMM_BINMODEL_MAGIC, not terminated */
+    uint32_t version;           /*!< PMM_BINMODEL_VERSION */
+    uint32_t byte_order;        /*!< PMM_BINMODEL_BYTE_ORDER */
+
+    int32_t n_p;                /*!< number of parameters of the model */
+    int32_t n_benchmarks;       /*!< number of benchmarks, the completion */
+    int32_t complete;           /*!< is model complete */
+    int32_t n_intervals;        /*!< number of intervals in the stack */
+    int32_t pc_max;             /*!< max of the parameter constraint */
+    int32_t pc_min;             /*!< min of the parameter constraint */
+
+    uint64_t journal_seq;       /*!< sequence number of the last journal
+                                     record the model contains */
+    uint64_t pc_formula;        /*!< string of the parameter constraint */
+    uint64_t complexity_formula;/*!< string of the complexity formula */
+
+    uint64_t paramdef_offset;   /*!< n_p pmm_binmodel_paramdef */
+    uint64_t bench_offset;      /*!< n_benchmarks pmm_binmodel_bench */
+    uint64_t params_offset;     /*!< n_benchmarks*n_p int32_t */
+    uint64_t n_metrics;         /*!< number of metrics of all benchmarks */
+    uint64_t metric_offset;     /*!< n_metrics pmm_binmodel_metric */
+    uint64_t interval_offset;   /*!< n_intervals pmm_binmodel_interval, from
+                                     the top of the stack */
+    uint64_t n_interval_params; /*!< number of interval parameters */
+    uint64_t interval_params_offset; /*!< n_interval_params int32_t */
+    uint64_t strings_offset;    /*!< table of terminated strings */
+    uint64_t strings_size;      /*!< size of the string table */
+    uint64_t file_size;         /*!< size of the whole file */
+} PMM_Binmodel_Header;
+
+/*!
+ * parameter definition record of a binary model file
+ */
+typedef struct pmm_binmodel_paramdef {
+    uint64_t name;              /*!< string of the name */
+    int32_t type;
+    int32_t order;
+    int32_t nonzero_end;
+    int32_t end;
+    int32_t start;
+    int32_t stride;
+    int32_t offset;
+    int32_t pad;
+} PMM_Binmodel_Paramdef;
+
+/*!
+ * benchmark record of a binary model file, its parameters are held in the
+ * params section at the same index
+ */
+typedef struct pmm_binmodel_bench {
+    int64_t complexity;
+    double flops;
+    double seconds;
+    int64_t wall_sec;
+    int64_t wall_usec;
+    int64_t used_sec;
+    int64_t used_usec;
+    uint64_t cpuset;            /*!< string of the cpuset */
+    uint64_t first_metric;      /*!< index of the first metric */
+    int32_t n_metrics;          /*!< number of metrics from first_metric */
+    int32_t numa_node;
+    int32_t nice;
+    int32_t pad;
+} PMM_Binmodel_Bench;
+
+/*!
+ * benchmark metric record of a binary model file
+ */
+typedef struct pmm_binmodel_metric {
+    uint64_t name;              /*!< string of the name */
+    double value;
+} PMM_Binmodel_Metric;
+
+/*!
+ * interval record of a binary model file, its start and end are held in the
+ * interval params section, n_p values each from index params
+ */
+typedef struct pmm_binmodel_interval {
+    int32_t type;
+    int32_t plane;
+    int32_t climb_step;
+    int32_t n_p;
+    int32_t has_start;
+    int32_t has_end;
+    uint64_t params;            /*!< index of the start, then the end */
+} PMM_Binmodel_Interval;
+
+/*!
+ * a binary model file mapped into memory, with pointers to its sections
+ */
+typedef struct pmm_binmodel {
+    void *map;                                  /*!< mapping of the file */
+    size_t size;                                /*!< size of the mapping */
+
+    const struct pmm_binmodel_header *header;
+    const struct pmm_binmodel_paramdef *paramdefs;
+    const struct pmm_binmodel_bench *benches;
+    const int32_t *params;
+    const struct pmm_binmodel_metric *metrics;
+    const struct pmm_binmodel_interval *intervals;
+    const int32_t *interval_params;
+    const char *strings;
+} PMM_Binmodel;
+
+int
+is_binmodel_fd(int fd);
+struct pmm_binmodel*
+map_binmodel_fd(int fd);
+void
+unmap_binmodel(struct pmm_binmodel **bm);
+
+const char*
+binmodel_string(struct pmm_binmodel *bm, uint64_t offset);
+
+struct pmm_paramdef_set*
+binmodel_to_paramdef_set(struct pmm_binmodel *bm);
+int
+binmodel_to_model(struct pmm_binmodel *bm, struct pmm_model *m);
+
+void*
+model_to_binmodel(struct pmm_model *m, size_t *size);
+
+#endif /*PMM_BINMODEL_H_*/
@@ -42,12 +42,15 @@
 #include <fcntl.h>      // for fcntl/open
 #include <libgen.h>     // for dirname
 #include <limits.h>     // for PATH_MAX
+#include <pthread.h>    // for pthread_create
 
 #include <libxml/xmlmemory.h>
 #include <libxml/parser.h>
+#include <libxml/SAX2.h>
 
 
 #include "pmm_model.h"
+#include "pmm_binmodel.h"
 #include "pmm_cfgparser.h"
 #include "pmm_muparse.h"
 #include "pmm_interval.h"
@@ -56,15 +59,78 @@
 
 #include "pmm_log.h"
 
+//! size of the chunks a model file is read and parsed in
+#define PMM_MODEL_PARSER_CHUNK 16384
+//! initial size of the buffer holding the text of an element
+#define PMM_MODEL_PARSER_TEXT_INIT 64
+
+/*!
+ * State of the streaming parse of an xml model file.
+ *
+ * Model files are parsed with SAX callbacks. A tree is built for each of the
+ * small children of the model node, which is parsed into the model and freed
+ * as soon as the child ends. No tree is built for the bench list, instead the
+ * benchmarks are decoded into the model as their elements end, so memory use
+ * does not grow with the size of the file.
+ */
+typedef struct pmm_model_parser {
+    struct pmm_model *m;        /*!< model being parsed */
+    int depth;                  /*!< depth of the current element, the model
+                                     node has depth 1 */
+    int have_root;              /*!< has the root element been read */
+    int in_bench_list;          /*!< is the parser in the bench list */
+    int size;                   /*!< size the bench list records */
+    int completion;             /*!< completion the model records */
+    int rc;                     /*!< 0, or -1 once parsing has failed */
+
+    struct pmm_benchmark *b;    /*!< benchmark being decoded */
+    int n_params;               /*!< number of parameters of b decoded */
+    struct timeval *t;          /*!< timeval of b being decoded */
+    char *metric_name;          /*!< name of the metric being decoded */
+    double metric_value;        /*!< value of the metric being decoded */
+    int have_metric_value;      /*!< has the metric value been decoded */
+
+    char *text;                 /*!< text of the current element */
+    int text_len;               /*!< length of the text */
+    int text_capacity;          /*!< allocated size of text */
+} PMM_Model_Parser;
+
+/*!
+ * Models being loaded by a pool of threads, each thread takes the next model
+ * not yet loaded until none are left. See load_models.
+ */
+typedef struct pmm_model_loader {
+    struct pmm_model **models;  /*!< models to load */
+    int n;                      /*!< number of models */
+    int *rc;                    /*!< return code of loading each model */
+    int (*load)(struct pmm_model *m); /*!< function loading a model */
+    int next;                   /*!< index of the next model to load */
+    pthread_mutex_t mutex;      /*!< protects next */
+} PMM_Model_Loader;
+
 
 struct pmm_loadhistory* parse_loadconfig(xmlDocPtr, xmlNodePtr node);
+int add_slot_cpuset(xmlDocPtr doc, xmlNodePtr node, struct pmm_config *cfg);
 
 int sync_parent_dir(char *file_path);
+int sync_close_file(int fd);
+int write_fd_fully(int fd, const char *buf, size_t len);
+
+int apply_journal_record(struct pmm_model *m, xmlDocPtr doc);
+int write_journal_record_xtwp(xmlTextWriterPtr writer, struct pmm_model *m);
 
 int
 parse_paramdef_set(struct pmm_paramdef_set *pd_set, xmlDocPtr doc,
                    xmlNodePtr node);
 int
+init_paramdef_set_parsers(struct pmm_paramdef_set *pd_set);
+int
+parse_binmodel_fd(struct pmm_model *m, int fd);
+int
+write_xml_model_fd(int fd, struct pmm_model *m);
+int
+write_binmodel_fd(int fd, struct pmm_model *m);
+int
 parse_paramdef(struct pmm_paramdef *pd_array, int n_p, xmlDocPtr doc,
                xmlNodePtr node);
 int
@@ -72,45 +138,124 @@ parse_param_constraint(struct pmm_paramdef_set *pd_set, xmlDocPtr doc,
                        xmlNodePtr node);
 
 int
-parse_bench_list(struct pmm_model *m, xmlDocPtr doc, xmlNodePtr node);
+parse_xml_model_fd(struct pmm_model *m, int fd);
+int
+load_routine_model(struct pmm_model *m);
+void*
+model_loader_thread(void *arg);
+void
+xmlparser_init_once();
+int
+parse_model_element(struct pmm_model *m, xmlDocPtr doc, xmlNodePtr node,
+                    int *completion);
+void
+model_parser_start_element(void *ctx, const xmlChar *localname,
+                           const xmlChar *prefix, const xmlChar *URI,
+                           int nb_namespaces, const xmlChar **namespaces,
+                           int nb_attributes, int nb_defaulted,
+                           const xmlChar **attributes);
+void
+model_parser_end_element(void *ctx, const xmlChar *localname,
+                         const xmlChar *prefix, const xmlChar *URI);
+void
+model_parser_characters(void *ctx, const xmlChar *ch, int len);
+void
+model_parser_fail(xmlParserCtxtPtr ctxt);
+int
+model_parser_bench_start(struct pmm_model_parser *mp, const xmlChar *name);
+int
+model_parser_bench_end(struct pmm_model_parser *mp, const xmlChar *name);
+int
+model_parser_bench_list_end(struct pmm_model_parser *mp);
+int
+parse_placement(struct pmm_benchmark *b, xmlDocPtr doc, xmlNodePtr node);
+int
+write_placement_xtwp(xmlTextWriterPtr writer, struct pmm_benchmark *b);
+int
+parse_metrics(struct pmm_benchmark *b, xmlDocPtr doc, xmlNodePtr node);
+int
+write_metrics_xtwp(xmlTextWriterPtr writer, struct pmm_benchmark *b);
 int
 parse_routine_construction(struct pmm_routine *r, xmlDocPtr doc,
                                xmlNodePtr node);
+int parse_hrmm(char *key);
+int
+parse_routine_periodic(struct pmm_routine *r, xmlDocPtr doc, xmlNodePtr node);
 
 
-/*
- * TODO Finish this code
+/*!
+ * Convert a time of day in the form hh:mm to a number of seconds after
+ * midnight
  *
- * Convert hours and minutes to a time structure
+ * @param   key     pointer to the time of day string
  *
-struct tm hrmm_to_tm(char *key)
-    struct tm time;
+ * @return seconds after midnight or -1 on error
+ */
+int
+parse_hrmm(char *key)
+{
+    int hr, mm;
+    char c;
+
+    if(key == NULL || sscanf(key, " %d:%d %c", &hr, &mm, &c) != 2) {
+        return -1;
+    }
 
+    if(hr < 0 || hr > 23 || mm < 0 || mm > 59) {
+        return -1;
+    }
 
-}*/
+    return hr*60*60 + mm*60;
+}
 
-/*
- * TODO finish this routine, decide on how/if to support a crontab like
- * period, with week day support and other things
+/*!
+ * Parse the daily benchmarking window of a routine with the periodic
+ * construction condition
+ *
+ * @param   r       pointer to the routine
+ * @param   doc     pointer to the xml document
+ * @param   node    pointer to the period node
  *
-void parse_routine_periodic(node, doc, struct pmm_routine *r) {
+ * @return 0 on success, -1 on failure
+ */
+int
+parse_routine_periodic(struct pmm_routine *r, xmlDocPtr doc, xmlNodePtr node)
+{
+    char *key;
+    xmlNodePtr cnode;
+
+    cnode = node->xmlChildrenNode;
 
-    while(node != NULL) {
+    while(cnode != NULL) {
         key = (char *)xmlNodeListGetString(doc, cnode->xmlChildrenNode, 1);
 
-        if(!xmlStrcmp(cnode->name (const xmlChar *) "starttime")) {
-            r->between_start = hrmm_to_tm(key);
+        if(!xmlStrcmp(cnode->name, (const xmlChar *) "starttime")) {
+            r->period_start = parse_hrmm(key);
+            if(r->period_start < 0) {
+                ERRPRINTF("Configuration error, routine:%s, starttime:%s\n",
+                          r->name, key);
+                free(key);
+                return -1;
+            }
         }
-        else if(!xmlStrcmp(cnode->name (const xmlChar *) "endtime")) {
-            r->between_end = hrmm_to_tm(key);
+        else if(!xmlStrcmp(cnode->name, (const xmlChar *) "endtime")) {
+            r->period_end = parse_hrmm(key);
+            if(r->period_end < 0) {
+                ERRPRINTF("Configuration error, routine:%s, endtime:%s\n",
+                          r->name, key);
+                free(key);
+                return -1;
+            }
         }
 
         free(key);
         key = NULL;
 
-        node=node->next;
+        cnode = cnode->next;
     }
-}*/
+
+    return 0;
+}
 
 /*!
  * Parse a routine from an xml document
@@ -169,6 +314,20 @@ parse_routine(xmlDocPtr doc, xmlNodePtr node)
                 return NULL;
             }
         }
+        else if(!xmlStrcmp(cnode->name, (const xmlChar *) "model_format")) {
+            if(strcmp("xml", key) == 0) {
+                r->model->format = MF_XML;
+            }
+            else if(strcmp("binary", key) == 0) {
+                r->model->format = MF_BINARY;
+            }
+            else {
+                ERRPRINTF("Configuration error, routine:%s, model_format:%s\n",
+                        r->name,
+                        key);
+                return NULL;
+            }
+        }
         else if(!xmlStrcmp(cnode->name, (const xmlChar *) "parameters")) {
             if(parse_paramdef_set(r->pd_set, doc, cnode) < 0)
             {
@@ -180,24 +339,18 @@ parse_routine(xmlDocPtr doc, xmlNodePtr node)
             if(strcmp("now", key) == 0) {
                 r->condition = CC_NOW;
             }
-            /* TODO  and add code to support CC_BEFORE
-            else if(strcmp("before", key) == 0) {
+            else if(strcmp("until", key) == 0) {
                 r->condition = CC_UNTIL;
-            } */
+            }
             else if(strcmp("idle", key) == 0) {
                 r->condition = CC_IDLE;
             }
             else if(strcmp("nousers", key) == 0) {
                 r->condition = CC_NOUSERS;
             }
-            /* TODO  add code to support CC_PERIODIC
             else if(strcmp("periodic", key) == 0) {
                 r->condition = CC_PERIODIC;
-
-                parse_routine_periodic(cnode->xmlChildren, doc, &r);
-
             }
-             */
             else {
                 ERRPRINTF("Configuration error, routine:%s, condition:%s\n",
                         r->name,
@@ -205,9 +358,64 @@ parse_routine(xmlDocPtr doc, xmlNodePtr node)
                 return NULL;
             }
         }
+        else if(!xmlStrcmp(cnode->name, (const xmlChar *) "until")) {
+            r->until = parseISO8601Date(key);
+            if(r->until == (time_t)-1) {
+                ERRPRINTF("Configuration error, routine:%s, until:%s\n",
+                        r->name,
+                        key);
+                return NULL;
+            }
+        }
+        else if(!xmlStrcmp(cnode->name, (const xmlChar *) "period")) {
+            if(parse_routine_periodic(r, doc, cnode) < 0) {
+                ERRPRINTF("Error parsing benchmarking period.\n");
+                return NULL;
+            }
+        }
         else if(!xmlStrcmp(cnode->name, (const xmlChar *) "priority")) {
             r->priority = atoi((char *)key);
         }
+        else if(!xmlStrcmp(cnode->name, (const xmlChar *) "cpuset")) {
+            if(!set_str(&(r->cpuset), key)) {
+                ERRPRINTF("set_str failed setting cpuset\n");
+                return NULL;
+            }
+        }
+        else if(!xmlStrcmp(cnode->name, (const xmlChar *) "numa_node")) {
+            r->numa_node = atoi((char *)key);
+            if(r->numa_node < 0) {
+                ERRPRINTF("Configuration error, routine:%s, numa_node:%s\n",
+                          r->name, key);
+                return NULL;
+            }
+        }
+        else if(!xmlStrcmp(cnode->name, (const xmlChar *) "nice")) {
+            r->nice = atoi((char *)key);
+        }
+        else if(!xmlStrcmp(cnode->name, (const xmlChar *) "timeout")) {
+            r->timeout = atoi((char *)key);
+            if(r->timeout <= 0) {
+                ERRPRINTF("Configuration error, routine:%s, timeout:%s\n",
+                        r->name,
+                        key);
+                return NULL;
+            }
+        }
+        else if(!xmlStrcmp(cnode->name, (const xmlChar *) "protocol")) {
+            if(strcmp("exec", key) == 0) {
+                r->protocol = BP_EXEC;
+            }
+            else if(strcmp("server", key) == 0) {
+                r->protocol = BP_SERVER;
+            }
+            else {
+                ERRPRINTF("Configuration error, routine:%s, protocol:%s\n",
+                        r->name,
+                        key);
+                return NULL;
+            }
+        }
         else if(!xmlStrcmp(cnode->name, (const xmlChar *) "construction")) {
             if(parse_routine_construction(r, doc, cnode) < 0) {
                 ERRPRINTF("Error parsing construction method definition.\n");
@@ -251,9 +459,6 @@ parse_paramdef_set(struct pmm_paramdef_set *pd_set, xmlDocPtr doc,
     char *key;
     xmlNodePtr cnode;
     int i;
-#ifdef HAVE_MUPARSER
-    double d;
-#endif
 
     cnode = node->xmlChildrenNode;
 
@@ -314,6 +519,13 @@ parse_paramdef_set(struct pmm_paramdef_set *pd_set, xmlDocPtr doc,
                 return -1;
             }
         }
+        else if(!xmlStrcmp(cnode->name, (const xmlChar *) "complexity"))
+        {
+            if(!set_str(&(pd_set->complexity_formula), key)) {
+                ERRPRINTF("set_str failed setting complexity\n");
+                return -1;
+            }
+        }
         else
         {
             // probably a text : null tag
@@ -334,22 +546,58 @@ parse_paramdef_set(struct pmm_paramdef_set *pd_set, xmlDocPtr doc,
         return -1;
     }
 
+    if(init_paramdef_set_parsers(pd_set) < 0) {
+        ERRPRINTF("Error setting up formula parsers.\n");
+        return -1;
+    }
+
+    return 0; //success
+
+}
+
+/*!
+ * Set up the parsers of the formulas of a parameter definition set, if
+ * muParser support is compiled
+ *
+ * @param   pd_set      pointer to parameter definition set structure
+ *
+ * @return 0 on success, -1 on failure
+ */
+int
+init_paramdef_set_parsers(struct pmm_paramdef_set *pd_set)
+{
+#ifdef HAVE_MUPARSER
+    double d;
+#endif
+
 #ifdef HAVE_MUPARSER
     // if the pc_formula is set, construct the muParser for it
     if(pd_set->pc_formula != NULL) {
-        create_param_constraint_muparser(pd_set);
-
-        if(evaluate_constraint(pd_set->pc_parser, &d) == -1) {
+        if(create_param_constraint_muparser(pd_set) < 0 ||
+           evaluate_constraint(pd_set->pc_parser, &d) == -1)
+        {
             ERRPRINTF("Error setting up param constraint formula parser.\n");
             return -1;
         }
     }
-#endif
-
 
+    // likewise the complexity formula, once for the routine
+    if(pd_set->complexity_formula != NULL) {
+        if(create_complexity_muparser(pd_set) < 0 ||
+           evaluate_constraint(pd_set->complexity_parser, &d) == -1)
+        {
+            ERRPRINTF("Error setting up complexity formula parser.\n");
+            return -1;
+        }
+    }
+#else
+    if(pd_set->complexity_formula != NULL) {
+        LOGPRINTF("Complexity formula ignored, muParser support not "
+                  "compiled.\n");
+    }
+#endif
 
     return 0; //success
-
 }
 
 /*!
@@ -676,6 +924,48 @@ parse_config(struct pmm_config *cfg) {
             free(key);
             key = NULL;
         }
+        if(!xmlStrcmp(cnode->name,
+                      (const xmlChar *) "max_concurrent_benchmarks"))
+        {
+            key = (char *)xmlNodeListGetString(doc, cnode->xmlChildrenNode, 1);
+            cfg->max_concurrent_benchmarks = atoi(key);
+            free(key);
+            key = NULL;
+
+            if(cfg->max_concurrent_benchmarks < 1) {
+                ERRPRINTF("max_concurrent_benchmarks must be at least 1.\n");
+                xmlFreeDoc(doc);
+                return -1;
+            }
+        }
+        if(!xmlStrcmp(cnode->name, (const xmlChar *) "scheduling_policy")) {
+            key = (char *)xmlNodeListGetString(doc, cnode->xmlChildrenNode, 1);
+
+            if(strcmp("priority", key) == 0) {
+                cfg->scheduling_policy = SP_PRIORITY;
+            }
+            else if(strcmp("cost", key) == 0) {
+                cfg->scheduling_policy = SP_COST;
+            }
+            else {
+                ERRPRINTF("Configuration error, scheduling_policy:%s\n", key);
+                free(key);
+                xmlFreeDoc(doc);
+                return -1;
+            }
+
+            free(key);
+            key = NULL;
+        }
+        // each "slot_cpuset" cnode describes the cpus of the next execution
+        // slot, in the order they appear in the config
+        if(!xmlStrcmp(cnode->name, (const xmlChar *) "slot_cpuset")) {
+            if(add_slot_cpuset(doc, cnode, cfg) < 0) {
+                ERRPRINTF("Error parsing slot cpuset.\n");
+                xmlFreeDoc(doc);
+                return -1;
+            }
+        }
         // if we get a "load_monitor" cnode parse the load monitor config
         if(!xmlStrcmp(cnode->name, (const xmlChar *) "load_monitor")) {
             cfg->loadhistory = parse_loadconfig(doc, cnode);
@@ -716,6 +1006,49 @@ parse_config(struct pmm_config *cfg) {
 }
 
 
+/*!
+ * Append the cpu list of an execution slot to the configuration.
+ *
+ * @param   doc     pointer to the xml document
+ * @param   node    pointer to the slot_cpuset node
+ * @param   cfg     pointer to the config structure
+ *
+ * @return 0 on success, -1 on failure
+ */
+int
+add_slot_cpuset(xmlDocPtr doc, xmlNodePtr node, struct pmm_config *cfg)
+{
+    char *key;
+    char **temp;
+
+    key = (char *)xmlNodeListGetString(doc, node->xmlChildrenNode, 1);
+    if(key == NULL) {
+        ERRPRINTF("Empty slot_cpuset.\n");
+        return -1;
+    }
+
+    temp = realloc(cfg->slot_cpusets,
+                   (cfg->n_slot_cpusets+1) * sizeof *(cfg->slot_cpusets));
+    if(temp == NULL) {
+        ERRPRINTF("Error reallocating memory for slot cpusets.\n");
+        free(key);
+        return -1;
+    }
+    cfg->slot_cpusets = temp;
+
+    if(!set_str(&(cfg->slot_cpusets[cfg->n_slot_cpusets]), key)) {
+        ERRPRINTF("set_str failed setting slot cpuset\n");
+        free(key);
+        return -1;
+    }
+    cfg->n_slot_cpusets++;
+
+    free(key);
+    key = NULL;
+
+    return 0;
+}
+
 /*!
  * Parse load history configuration information from an xml document.
  *
@@ -881,6 +1214,10 @@ parse_timeval_p(struct timeval *t, xmlDocPtr doc, xmlNodePtr node)
 /*!
  * Parse an xml parameter array into a parameter array and size integer
  *
+ * If the parameter array pointer is NULL the array is allocated, otherwise
+ * it must point to storage for the number of parameters in n_p, which the
+ * parsed array must match.
+ *
  * @param   p       pointer to the parameter array pointer
  * @param   n_p     pointer to the integer to store the size in
  * @param   doc     pointer to the xml document
@@ -900,18 +1237,29 @@ int parse_parameter_array_p(int **p, int *n_p, xmlDocPtr doc, xmlNodePtr node)
 
     // if the name of the cnode is ... do something with the key
     if(!xmlStrcmp(cnode->name, (const xmlChar *) "n_p")) {
-        *n_p = atoi((char *)key);
-
-        if(*n_p <= 0) {
-            ERRPRINTF("Number of parameters must be greater than 0.\n");
-            return -1;
+        if(*p != NULL) {
+            if(atoi((char *)key) != *n_p) {
+                ERRPRINTF("Expected %d parameters, got: %s\n", *n_p, key);
+                free(key);
+                return -1;
+            }
         }
+        else {
+            *n_p = atoi((char *)key);
 
-        *p = malloc(*n_p * sizeof *(*p));
+            if(*n_p <= 0) {
+                ERRPRINTF("Number of parameters must be greater than 0.\n");
+                free(key);
+                return -1;
+            }
 
-        if(*p == NULL) {
-            ERRPRINTF("Error allocating memory.\n");
-            return -1;
+            *p = malloc(*n_p * sizeof *(*p));
+
+            if(*p == NULL) {
+                ERRPRINTF("Error allocating memory.\n");
+                free(key);
+                return -1;
+            }
         }
     }
     else {
@@ -968,64 +1316,189 @@ int parse_parameter_array_p(int **p, int *n_p, xmlDocPtr doc, xmlNodePtr node)
 }
 
 /*!
- * Parse a benchmark from xml document.
+ * Parse the placement (cpus, numa node and nice value) a benchmark was
+ * executed with from an xml document.
  *
+ * @param   b       pointer to the benchmark
  * @param   doc     pointer to the xml document
- * @param   node    pointer to the node describing the benchmark
+ * @param   node    pointer to the node describing the placement
  *
- * @return pointer to a newly allocated benchmark representing the parsed
- * information or NULL on error
+ * @return 0 on success, -1 on failure
  */
-struct pmm_benchmark* parse_benchmark(xmlDocPtr doc, xmlNodePtr node) {
+int
+parse_placement(struct pmm_benchmark *b, xmlDocPtr doc, xmlNodePtr node)
+{
     char *key;
-    struct pmm_benchmark *b;
     xmlNodePtr cnode;
 
-    b = new_benchmark();
-    if(b == NULL) {
-        ERRPRINTF("Error allocating new benchmark.\n");
-        return NULL;
-    }
-
-    // get the children of the benchmark node
     cnode = node->xmlChildrenNode;
 
-    // iterate through the children of the routine node
     while(cnode != NULL) {
 
-        // get the value associated with the each cnode
         key = (char *)xmlNodeListGetString(doc, cnode->xmlChildrenNode, 1);
 
-        //LOGPRINTF("%s : %s\n", cnode->name, key);
-
-        // if the name of the cnode is ... do something with the key
-        if(!xmlStrcmp(cnode->name, (const xmlChar *) "parameter_array")) {
-            if(parse_parameter_array_p(&(b->p), &(b->n_p), doc, cnode) < 0) {
-                ERRPRINTF("Error parsing parameter_array.\n");
-                free_benchmark(&b);
-                return NULL;
+        if(!xmlStrcmp(cnode->name, (const xmlChar *) "cpuset")) {
+            if(!set_str(&(b->cpuset), key)) {
+                ERRPRINTF("set_str failed setting cpuset\n");
+                free(key);
+                return -1;
             }
         }
-        else if(!xmlStrcmp(cnode->name, (const xmlChar *) "complexity")) {
-            if(sscanf((char *)key, "%lld", &(b->complexity)) != 1) {
-                ERRPRINTF("Error parsing complexity.\n");
-                free_benchmark(&b);
-                return NULL;
+        else if(!xmlStrcmp(cnode->name, (const xmlChar *) "numa_node")) {
+            if(sscanf((char *)key, "%d", &(b->numa_node)) != 1) {
+                ERRPRINTF("Error parsing numa_node.\n");
+                free(key);
+                return -1;
             }
         }
-        else if(!xmlStrcmp(cnode->name, (const xmlChar *) "flops")) {
-            if(sscanf((char *)key, "%lf", &(b->flops)) != 1) {
-                ERRPRINTF("Error parsing flops.\n");
-                free_benchmark(&b);
-                return NULL;
+        else if(!xmlStrcmp(cnode->name, (const xmlChar *) "nice")) {
+            if(sscanf((char *)key, "%d", &(b->nice)) != 1) {
+                ERRPRINTF("Error parsing nice.\n");
+                free(key);
+                return -1;
             }
         }
-        else if(!xmlStrcmp(cnode->name, (const xmlChar *) "seconds")) {
-            if(sscanf((char *)key, "%lf", &(b->seconds)) != 1) {
-                ERRPRINTF("Error parsing seconds.\n");
-                free_benchmark(&b);
-                return NULL;
-            }
+
+        free(key);
+        key = NULL;
+
+        cnode = cnode->next;
+    }
+
+    return 0;
+}
+
+/*!
+ * Parse the additional metrics of a benchmark from an xml document.
+ *
+ * @param   b       pointer to the benchmark
+ * @param   doc     pointer to the xml document
+ * @param   node    pointer to the node describing the metrics
+ *
+ * @return 0 on success, -1 on failure
+ */
+int
+parse_metrics(struct pmm_benchmark *b, xmlDocPtr doc, xmlNodePtr node)
+{
+    char *key;
+    char *name;
+    double value;
+    int have_value;
+    xmlNodePtr cnode, mnode;
+
+    for(cnode = node->xmlChildrenNode; cnode != NULL; cnode = cnode->next) {
+
+        if(xmlStrcmp(cnode->name, (const xmlChar *) "metric")) {
+            continue;
+        }
+
+        name = NULL;
+        have_value = 0;
+
+        for(mnode = cnode->xmlChildrenNode; mnode != NULL;
+            mnode = mnode->next)
+        {
+            key = (char *)xmlNodeListGetString(doc, mnode->xmlChildrenNode, 1);
+
+            if(!xmlStrcmp(mnode->name, (const xmlChar *) "name")) {
+                free(name);
+                name = key;
+                key = NULL;
+            }
+            else if(!xmlStrcmp(mnode->name, (const xmlChar *) "value")) {
+                if(key == NULL || sscanf(key, "%lf", &value) != 1) {
+                    ERRPRINTF("Error parsing metric value.\n");
+                    free(key);
+                    free(name);
+                    return -1;
+                }
+                have_value = 1;
+            }
+
+            free(key);
+            key = NULL;
+        }
+
+        if(name == NULL || !have_value) {
+            ERRPRINTF("Incomplete metric.\n");
+            free(name);
+            return -1;
+        }
+
+        if(add_benchmark_metric(b, name, value) < 0) {
+            ERRPRINTF("Error adding metric.\n");
+            free(name);
+            return -1;
+        }
+
+        free(name);
+        name = NULL;
+    }
+
+    return 0;
+}
+
+/*!
+ * Parse a benchmark from xml document.
+ *
+ * @param   bl      pointer to the bench list the benchmark is allocated for
+ * @param   doc     pointer to the xml document
+ * @param   node    pointer to the node describing the benchmark
+ *
+ * @return pointer to a newly allocated benchmark representing the parsed
+ * information or NULL on error
+ */
+struct pmm_benchmark* parse_benchmark(struct pmm_bench_list *bl,
+                                      xmlDocPtr doc, xmlNodePtr node) {
+    char *key;
+    struct pmm_benchmark *b;
+    xmlNodePtr cnode;
+
+    b = new_list_benchmark(bl);
+    if(b == NULL) {
+        ERRPRINTF("Error allocating new benchmark.\n");
+        return NULL;
+    }
+
+    // get the children of the benchmark node
+    cnode = node->xmlChildrenNode;
+
+    // iterate through the children of the routine node
+    while(cnode != NULL) {
+
+        // get the value associated with the each cnode
+        key = (char *)xmlNodeListGetString(doc, cnode->xmlChildrenNode, 1);
+
+        //LOGPRINTF("%s : %s\n", cnode->name, key);
+
+        // if the name of the cnode is ... do something with the key
+        if(!xmlStrcmp(cnode->name, (const xmlChar *) "parameter_array")) {
+            if(parse_parameter_array_p(&(b->p), &(b->n_p), doc, cnode) < 0) {
+                ERRPRINTF("Error parsing parameter_array.\n");
+                free_benchmark(&b);
+                return NULL;
+            }
+        }
+        else if(!xmlStrcmp(cnode->name, (const xmlChar *) "complexity")) {
+            if(sscanf((char *)key, "%lld", &(b->complexity)) != 1) {
+                ERRPRINTF("Error parsing complexity.\n");
+                free_benchmark(&b);
+                return NULL;
+            }
+        }
+        else if(!xmlStrcmp(cnode->name, (const xmlChar *) "flops")) {
+            if(sscanf((char *)key, "%lf", &(b->flops)) != 1) {
+                ERRPRINTF("Error parsing flops.\n");
+                free_benchmark(&b);
+                return NULL;
+            }
+        }
+        else if(!xmlStrcmp(cnode->name, (const xmlChar *) "seconds")) {
+            if(sscanf((char *)key, "%lf", &(b->seconds)) != 1) {
+                ERRPRINTF("Error parsing seconds.\n");
+                free_benchmark(&b);
+                return NULL;
+            }
         }
         else if(!xmlStrcmp(cnode->name, (const xmlChar *) "used_time")) {
             if(parse_timeval_p(&(b->used_t), doc, cnode) < 0) {
@@ -1041,6 +1514,20 @@ struct pmm_benchmark* parse_benchmark(xmlDocPtr doc, xmlNodePtr node) {
                 return NULL;
             }
         }
+        else if(!xmlStrcmp(cnode->name, (const xmlChar *) "placement")) {
+            if(parse_placement(b, doc, cnode) < 0) {
+                ERRPRINTF("Error parsing placement.\n");
+                free_benchmark(&b);
+                return NULL;
+            }
+        }
+        else if(!xmlStrcmp(cnode->name, (const xmlChar *) "metrics")) {
+            if(parse_metrics(b, doc, cnode) < 0) {
+                ERRPRINTF("Error parsing metrics.\n");
+                free_benchmark(&b);
+                return NULL;
+            }
+        }
         else {
             // probably a text : null tag
             // TODO suppress these and check everywhere else
@@ -1382,89 +1869,6 @@ parse_history(struct pmm_loadhistory *h) {
     return 0; //success
 }
 
-/*!
- * Parse a bench list from an xml document into a model.
- *
- * @param   m       pointer to the model
- * @param   doc     pointer to the xml document
- * @param   node    pointer to the node describing the bench list
- *
- * @return 0 on success, -1 on failure
- */
-int
-parse_bench_list(struct pmm_model *m, xmlDocPtr doc, xmlNodePtr node)
-{
-    int ret;
-    char *key;
-    struct pmm_benchmark *b;
-    xmlNodePtr cnode;
-
-    int size;
-
-
-    cnode = node->xmlChildrenNode;
-
-    key = (char *)xmlNodeListGetString(doc, cnode->xmlChildrenNode, 1);
-
-    // if the name of the cnode is ... do something with the key
-    // first node must be the size fail if otherwise
-    // TODO parsing "size" from the xml first is not really required
-    if(!xmlStrcmp(cnode->name, (const xmlChar *) "size")) {
-
-        size = atoi((char *)key);
-
-        m->bench_list = new_bench_list(m, m->n_p);
-
-    }
-    else {
-        ERRPRINTF("First element of bench_list xml must be size "
-                  "got: %s\n.", cnode->name);
-        return -1;
-    }
-
-    free(key);
-    key = NULL;
-
-    cnode = cnode->next;
-
-    // iterate through the rest of the children of the bench_list node
-    while(cnode != NULL) {
-
-        // if the name of the cnode is ... do something with the key
-        if(!xmlStrcmp(cnode->name, (const xmlChar *) "benchmark")) {
-
-            b = parse_benchmark(doc, cnode);
-
-            if(b == NULL) {
-                ERRPRINTF("Error parsing benchmark.\n");
-                return -1;
-            }
-
-            ret = insert_bench_into_list(m->bench_list, b);
-            if(ret < 0) {
-                free_benchmark(&b);
-                ERRPRINTF("Error inserting bench into bench list.\n");
-                return -1;
-            }
-        }
-        else {
-            // probably a text : null tag
-            // TODO suppress these and check everywhere else
-            //LOGPRINTF("unexpected tag: %s\n", cnode->name);
-        }
-
-        cnode=cnode->next;
-    }
-
-    if(m->bench_list->size != size) {
-        ERRPRINTF("%d benchmarks parsed, expected %d\n", m->bench_list->size,
-                                                         size);
-        return -1;
-    }
-
-    return 0; //success
-}
-
 /*!
  * Parse an interval list from an xml document into a model.
  *
@@ -1522,18 +1926,11 @@ int parse_interval_list(struct pmm_model *m, xmlDocPtr doc, xmlNodePtr node)
 int parse_model(struct pmm_model *m)
 {
 
-    xmlDocPtr doc;
-    xmlNodePtr root, cnode;
-    char *key;
-
     int fd;
     struct flock fl;
+    struct stat file_stats;
 
-    int completion;
-
-    struct pmm_paramdef_set *pd_set;
-
-    pd_set = new_paramdef_set();
+    int rc;
 
     if(m->bench_list != NULL) {
         ERRPRINTF("Error, attempting to parse model file into non empty model:"
@@ -1569,21 +1966,40 @@ int parse_model(struct pmm_model *m)
         return -2;
     }
 
-    // parse the model in file to a doc tree
-    doc = xmlReadFd(fd, m->model_path, NULL, XML_PARSE_NOBLANKS);
-    if(doc == NULL) {
-        ERRPRINTF("Model file: %s not parsed correctly continuing with new "
-                  "model\n", m->model_path);
+    // the journal is compacted once it grows as large as the model file
+    if(fstat(fd, &file_stats) == 0) {
+        m->snapshot_size = file_stats.st_size;
+    }
 
-        xmlFreeDoc(doc);
+    // binary model files are mapped and read without a document tree
+    if(is_binmodel_fd(fd)) {
+        rc = parse_binmodel_fd(m, fd);
 
-        if(fd == -1) {
-            close(fd);
+        //close file and free lock
+        if(close(fd) < 0) {
+            ERRPRINTF("Error closing model file:%s.\n", m->model_path);
+            perror("close");
+
+            return -2; // failure
+        }
+
+        if(rc < 0) {
+            ERRPRINTF("Error parsing binary model file:%s.\n", m->model_path);
+            return -2; // failure
+        }
+
+        // apply benchmarks made since the model file was written
+        if(replay_model_journal(m) < 0) {
+            ERRPRINTF("Error replaying journal of model: %s\n", m->model_path);
+            return -2;
         }
 
-        return -1; // file not read, return code to init new model
+        return 0; //success
     }
 
+    // stream the model file rather than parsing it to a doc tree
+    rc = parse_xml_model_fd(m, fd);
+
     //close file and free lock
     if(close(fd) < 0) {
         ERRPRINTF("Error closing model file:%s.\n", m->model_path);
@@ -1592,393 +2008,1565 @@ int parse_model(struct pmm_model *m)
         return -2; // failure
     }
 
-    // get root node of doc tree
-    root = xmlDocGetRootElement(doc);
-
-    // check there is a root node (i.e. doc tree is not empty)
-    if(root == NULL) {
-        ERRPRINTF("Model file: %s empty\n", m->model_path);
-        xmlFreeDoc(doc);
-        return -1; // file empty, return code to init new model
+    if(rc < 0) {
+        return rc;
     }
 
-    // check that the root node is a "model" type
-    if(xmlStrcmp(root->name, (const xmlChar *) "model")) {
-        ERRPRINTF("Model xml has wrong type. root node: %s\n", root->name);
-        xmlFreeDoc(doc);
-        return -2; // model file corrupt, return failure;
+    // apply benchmarks made since the model file was written
+    if(replay_model_journal(m) < 0) {
+        ERRPRINTF("Error replaying journal of model: %s\n", m->model_path);
+        return -2;
     }
 
-    // get the child of the root node
-    cnode = root->xmlChildrenNode;
-
-    // iterate through the children of the root adding data to the model
-    while(cnode != NULL) {
+    return 0; //success
+}
 
-        // get the value associated with the each cnode
-        key = (char *)xmlNodeListGetString(doc, cnode->xmlChildrenNode, 1);
+/*!
+ * Parse a model from an open xml model file. The file is read in chunks and
+ * parsed with SAX callbacks so that the whole document is never held in a
+ * tree. See struct pmm_model_parser.
+ *
+ * @param   m   pointer to the model, with no bench list allocated
+ * @param   fd  file descriptor of the model file
+ *
+ * @return 0 on success, -1 if the file holds no model, -2 on other error
+ */
+int
+parse_xml_model_fd(struct pmm_model *m, int fd)
+{
+    struct pmm_model_parser mp;
+    xmlSAXHandler sax;
+    xmlParserCtxtPtr ctxt;
+    char buf[PMM_MODEL_PARSER_CHUNK];
+    ssize_t n;
+    int well_formed;
+
+    mp.m = m;
+    mp.depth = 0;
+    mp.have_root = 0;
+    mp.in_bench_list = 0;
+    mp.size = 0;
+    mp.completion = -1;
+    mp.rc = 0;
+    mp.b = NULL;
+    mp.n_params = 0;
+    mp.t = NULL;
+    mp.metric_name = NULL;
+    mp.metric_value = 0.0;
+    mp.have_metric_value = 0;
+    mp.text = NULL;
+    mp.text_len = 0;
+    mp.text_capacity = 0;
+
+    // start from the handlers that build a tree and override those the
+    // model parser needs
+    memset(&sax, 0, sizeof sax);
+    xmlSAXVersion(&sax, 2);
+    sax.startElementNs = model_parser_start_element;
+    sax.endElementNs = model_parser_end_element;
+    sax.characters = model_parser_characters;
+    sax.cdataBlock = model_parser_characters;
+
+    ctxt = xmlCreatePushParserCtxt(&sax, NULL, NULL, 0, m->model_path);
+    if(ctxt == NULL) {
+        ERRPRINTF("Error creating parser for model file:%s\n", m->model_path);
+        return -2;
+    }
 
-        // if the name of the cnode is ... do something with the key
-        if(!xmlStrcmp(cnode->name, (const xmlChar *) "n_p")) {
-            m->n_p = atoi((char *)key);
+    xmlCtxtUseOptions(ctxt, XML_PARSE_NOBLANKS);
+    ctxt->_private = &mp;
 
-            if(m->parent_routine != NULL &&
-               m->n_p != m->parent_routine->pd_set->n_p)
-            {
-                ERRPRINTF("model / routine parameter mismatch m:%d r:%d.\n",
-                          m->n_p, m->parent_routine->pd_set->n_p);
-                xmlFreeDoc(doc);
-                return -2; //failure
-            }
-        }
-        else if(!xmlStrcmp(cnode->name, (const xmlChar *) "completion")) {
-            // store the completion variable so we can check later
-            // that the number of parsed benchmarks matches
-            completion = atoi((char *)key);
-        }
-        else if(!xmlStrcmp(cnode->name, (const xmlChar *) "complete")) {
-            m->complete = atoi((char *)key);
+    while((n = read(fd, buf, sizeof buf)) > 0) {
+        if(xmlParseChunk(ctxt, buf, n, 0) != 0 || mp.rc < 0) {
+            break;
         }
-        else if(!xmlStrcmp(cnode->name, (const xmlChar *) "parameters")) {
+    }
 
+    if(n < 0) {
+        ERRPRINTF("Error reading model file:%s\n", m->model_path);
+        perror("read");
+        mp.rc = -1;
+    }
+    else if(n == 0) {
+        xmlParseChunk(ctxt, NULL, 0, 1);
+    }
 
-            if(parse_paramdef_set(pd_set, doc, cnode) < 0)
-            {
-                ERRPRINTF("Error parsing parameter definitions.\n");
-                xmlFreeDoc(doc);
-                return -2; //failure
-            }
+    well_formed = ctxt->wellFormed;
 
+    xmlFreeDoc(ctxt->myDoc);
+    ctxt->myDoc = NULL;
+    xmlFreeParserCtxt(ctxt);
 
-            if(pd_set->n_p != m->n_p) {
-                ERRPRINTF("Parameter definition and model mismatch.\n");
-            }
+    free(mp.text);
+    mp.text = NULL;
+    free(mp.metric_name);
+    mp.metric_name = NULL;
+    if(mp.b != NULL) {
+        free_benchmark(&(mp.b));
+    }
 
-            // if we have a parent routine, check that the param definitions
-            // in the model match the routine
-            if(m->parent_routine != NULL) {
-                if(isequal_paramdef_set(m->parent_routine->pd_set, pd_set) != 0)
-                {
-                    ERRPRINTF("Current parameter definitions do not match "
-                              "those initially used to build model.\n");
+    if(mp.rc < 0) {
+        return -2; // failure
+    }
 
-                    ERRPRINTF("model:\n");
-                    print_paramdef_set(PMM_ERR, pd_set);
+    if(!well_formed) {
+        if(!mp.have_root) {
+            ERRPRINTF("Model file: %s not parsed correctly continuing with "
+                      "new model\n", m->model_path);
 
-                    ERRPRINTF("routine:\n");
-                    print_paramdef_set(PMM_ERR, m->parent_routine->pd_set);
+            return -1; // file not read, return code to init new model
+        }
 
-                    free_paramdef_set(&pd_set);
+        ERRPRINTF("Model file: %s not parsed correctly\n", m->model_path);
+        return -2; // model file corrupt, return failure
+    }
 
-                    return -2; // failure
-                }
-                // finished with the parsed model parameter definitions now
-                free_paramdef_set(&pd_set);
-            }
-            else {
-                m->pd_set = pd_set;
-            }
+    if(m->completion != mp.completion) {
+        ERRPRINTF("Model completion mismatch, model: %s, %d benchmarks parsed, %d expected\n",
+                m->model_path, m->completion, mp.completion);
+        return -2;
+    }
 
+    return 0; //success
+}
 
+/*!
+ * SAX callback for the start of an element of a model file
+ *
+ * @param   ctx         the parser context
+ * @param   localname   the name of the element
+ *
+ * Other parameters are as for startElementNsSAX2Func and only passed on to
+ * the tree building callback.
+ */
+void
+model_parser_start_element(void *ctx, const xmlChar *localname,
+                           const xmlChar *prefix, const xmlChar *URI,
+                           int nb_namespaces, const xmlChar **namespaces,
+                           int nb_attributes, int nb_defaulted,
+                           const xmlChar **attributes)
+{
+    xmlParserCtxtPtr ctxt = ctx;
+    struct pmm_model_parser *mp = ctxt->_private;
+
+    if(mp->rc < 0) {
+        return;
+    }
+
+    mp->depth++;
+    mp->text_len = 0;
+
+    if(mp->depth == 1) {
+        mp->have_root = 1;
+
+        // check that the root node is a "model" type
+        if(xmlStrcmp(localname, (const xmlChar *) "model")) {
+            ERRPRINTF("Model xml has wrong type. root node: %s\n", localname);
+            model_parser_fail(ctxt);
+            return;
         }
-        else if(!xmlStrcmp(cnode->name, (const xmlChar *) "bench_list")) {
-            if(parse_bench_list(m, doc, cnode) < 0) {
-                ERRPRINTF("Error parsing bench list.\n");
-                xmlFreeDoc(doc);
-                return -2; //failure
-            }
+    }
+    else if(mp->depth == 2 &&
+            !xmlStrcmp(localname, (const xmlChar *) "bench_list"))
+    {
+        // no tree is built for the bench list
+        mp->in_bench_list = 1;
+        return;
+    }
+
+    if(mp->in_bench_list) {
+        if(model_parser_bench_start(mp, localname) < 0) {
+            model_parser_fail(ctxt);
         }
+        return;
+    }
 
-        else if(!xmlStrcmp(cnode->name, (const xmlChar *) "interval_list")) {
+    xmlSAX2StartElementNs(ctx, localname, prefix, URI, nb_namespaces,
+                          namespaces, nb_attributes, nb_defaulted,
+                          attributes);
+}
 
-            if(parse_interval_list(m, doc, cnode) < 0) {
-                ERRPRINTF("Error parsing interval list.\n");
-                xmlFreeDoc(doc);
-                return -2; //failure
-            }
+/*!
+ * SAX callback for the end of an element of a model file
+ *
+ * @param   ctx         the parser context
+ * @param   localname   the name of the element
+ * @param   prefix      the namespace prefix of the element
+ * @param   URI         the namespace URI of the element
+ */
+void
+model_parser_end_element(void *ctx, const xmlChar *localname,
+                         const xmlChar *prefix, const xmlChar *URI)
+{
+    xmlParserCtxtPtr ctxt = ctx;
+    struct pmm_model_parser *mp = ctxt->_private;
+    xmlNodePtr node;
+
+    if(mp->rc < 0) {
+        return;
+    }
 
+    if(mp->in_bench_list) {
+        if(mp->depth == 2) {
+            mp->in_bench_list = 0;
+
+            if(model_parser_bench_list_end(mp) < 0) {
+                ERRPRINTF("Error parsing bench list.\n");
+                model_parser_fail(ctxt);
+                return;
+            }
         }
-        else {
-            // probably a text : null tag
-            // TODO suppress these and check everywhere else
-            //LOGPRINTF("unexpected tag: %s / %s\n", cnode->name, (char *)key);
+        else if(model_parser_bench_end(mp, localname) < 0) {
+            model_parser_fail(ctxt);
+            return;
         }
 
-        free(key);
-        key = NULL;
+        mp->depth--;
+        mp->text_len = 0;
 
-        cnode=cnode->next;
+        return;
     }
 
-    xmlFreeDoc(doc);
+    xmlSAX2EndElementNs(ctx, localname, prefix, URI);
 
+    // a child of the model node is complete, parse it then free its tree
+    if(mp->depth == 2) {
+        node = ctxt->node->last;
 
-    if(m->completion != completion) {
-        ERRPRINTF("Model completion mismatch, model: %s, %d benchmarks parsed, %d expected\n",
-                m->model_path, m->completion, completion);
-        return -2;
+        if(parse_model_element(mp->m, ctxt->myDoc, node,
+                               &(mp->completion)) < 0)
+        {
+            model_parser_fail(ctxt);
+            return;
+        }
+
+        xmlUnlinkNode(node);
+        xmlFreeNode(node);
     }
 
-    return 0; //success
+    mp->depth--;
 }
 
 /*!
- * Parse models of routines listed in the config structure.
- *
- * @param   c   pointer to the config with all routine details
+ * SAX callback for character data of a model file
  *
- * @return 0 on success, -1 on failure
+ * @param   ctx     the parser context
+ * @param   ch      the characters
+ * @param   len     the number of characters
  */
-int parse_models(struct pmm_config *c)
+void
+model_parser_characters(void *ctx, const xmlChar *ch, int len)
 {
-    int i, rc;
-    struct pmm_routine *r;
-    struct pmm_model *m;
+    xmlParserCtxtPtr ctxt = ctx;
+    struct pmm_model_parser *mp = ctxt->_private;
+    char *text;
+    int capacity;
 
-    for(i=0; i<c->used; i++) {
-        r = c->routines[i];
-        m = r->model;
+    if(mp->rc < 0) {
+        return;
+    }
 
-        LOGPRINTF("Loading model: %s for routine: %s\n",
-                  r->name, m->model_path);
+    if(!mp->in_bench_list) {
+        xmlSAX2Characters(ctx, ch, len);
+        return;
+    }
 
-        rc = parse_model(m);
-        if(rc < 0) {
-            if(rc == -1) {
-                //model parsing failed, so initialize model with definitions
-                //from routine
-
-                m->n_p = r->pd_set->n_p;
-                if(init_bench_list(m, r->pd_set) < 0){
-                    ERRPRINTF("Error initialising bench list.\n");
-                    return -1; //failure
-                }
+    // keep the text of the current element, terminated
+    if(mp->text_len + len + 1 > mp->text_capacity) {
+        capacity = mp->text_capacity;
+        if(capacity == 0) {
+            capacity = PMM_MODEL_PARSER_TEXT_INIT;
+        }
+        while(mp->text_len + len + 1 > capacity) {
+            capacity *= 2;
+        }
+
+        text = realloc(mp->text, capacity);
+        if(text == NULL) {
+            ERRPRINTF("Error allocating memory.\n");
+            model_parser_fail(ctxt);
+            return;
+        }
+
+        mp->text = text;
+        mp->text_capacity = capacity;
+    }
+
+    memcpy(mp->text + mp->text_len, ch, len);
+    mp->text_len += len;
+    mp->text[mp->text_len] = '\0';
+}
+
+/*!
+ * Stop parsing a model file after an error
+ *
+ * @param   ctxt    the parser context
+ */
+void
+model_parser_fail(xmlParserCtxtPtr ctxt)
+{
+    struct pmm_model_parser *mp = ctxt->_private;
+
+    mp->rc = -1;
+    xmlStopParser(ctxt);
+}
 
+/*!
+ * Handle the start of an element inside the bench list of a model file
+ *
+ * @param   mp      pointer to the model parser state
+ * @param   name    name of the element
+ *
+ * @return 0 on success, -1 on failure
+ */
+int
+model_parser_bench_start(struct pmm_model_parser *mp, const xmlChar *name)
+{
+    struct pmm_model *m = mp->m;
+
+    if(mp->depth == 3) {
+        // first node must be the size fail if otherwise
+        // TODO parsing "size" from the xml first is not really required
+        if(m->bench_list == NULL) {
+            if(xmlStrcmp(name, (const xmlChar *) "size")) {
+                ERRPRINTF("First element of bench_list xml must be size "
+                          "got: %s\n.", name);
+                return -1;
             }
-            else {
-                ERRPRINTF("Error parsing model.\n");
-                return -1; //failure
+        }
+        else if(!xmlStrcmp(name, (const xmlChar *) "benchmark")) {
+            mp->b = new_list_benchmark(m->bench_list);
+            if(mp->b == NULL) {
+                ERRPRINTF("Error allocating new benchmark.\n");
+                return -1;
             }
+
+            mp->n_params = 0;
+        }
+    }
+    else if(mp->b != NULL) {
+        if(!xmlStrcmp(name, (const xmlChar *) "used_time")) {
+            mp->t = &(mp->b->used_t);
+        }
+        else if(!xmlStrcmp(name, (const xmlChar *) "wall_time")) {
+            mp->t = &(mp->b->wall_t);
+        }
+        else if(!xmlStrcmp(name, (const xmlChar *) "metric")) {
+            free(mp->metric_name);
+            mp->metric_name = NULL;
+            mp->have_metric_value = 0;
         }
     }
 
-    return 0; //success
+    return 0;
 }
 
 /*!
- * write an interval structure to disk in xml
+ * Handle the end of an element inside the bench list of a model file,
+ * decoding the text of the element into the benchmark being parsed
  *
- * @param   writer      xmlTextWriterPtr to use to write with
- * @param   i           pointer to interval structure to write to disk
+ * @param   mp      pointer to the model parser state
+ * @param   name    name of the element
  *
  * @return 0 on success, -1 on failure
  */
-int write_interval_xtwp(xmlTextWriterPtr writer, struct pmm_interval *i)
+int
+model_parser_bench_end(struct pmm_model_parser *mp, const xmlChar *name)
 {
-    int rc;
+    struct pmm_model *m = mp->m;
+    struct pmm_benchmark *b = mp->b;
+    char *key;
 
+    key = mp->text_len > 0 ? mp->text : "";
 
-    // Start an element named interval
-    rc = xmlTextWriterStartElement(writer, BAD_CAST "interval");
-    if (rc < 0) {
-        ERRPRINTF("Error @ xmlTextWriterStartElement (interval)\n");
-        return rc;
-    }
+    if(mp->depth == 3) {
+        if(!xmlStrcmp(name, (const xmlChar *) "size")) {
+            if(m->bench_list != NULL) {
+                return 0;
+            }
 
-    switch (i->type) {
-        case IT_GBBP_EMPTY :
-            rc = xmlTextWriterWriteFormatElement(writer, BAD_CAST "type", "%s",
-                                                 "gbbp_empty");
-            break;
-        case IT_GBBP_CLIMB :
-            rc = xmlTextWriterWriteFormatElement(writer, BAD_CAST "type", "%s",
-                                                 "gbbp_climb");
-            break;
+            mp->size = atoi(key);
 
-        case IT_GBBP_BISECT :
-            rc = xmlTextWriterWriteFormatElement(writer, BAD_CAST "type", "%s",
-                                                 "gbbp_bisect");
-            break;
+            m->bench_list = new_bench_list(m, m->n_p);
+            if(m->bench_list == NULL) {
+                ERRPRINTF("Error allocating bench list.\n");
+                return -1;
+            }
+        }
+        else if(b != NULL) {
+            mp->b = NULL;
 
-        case IT_GBBP_INFLECT :
-            rc = xmlTextWriterWriteFormatElement(writer, BAD_CAST "type", "%s",
-                                                 "gbbp_inflect");
-            break;
+            if(mp->n_params != b->n_p) {
+                ERRPRINTF("Parsed unexpected number of parameters. "
+                          "(%d of %d).\n", mp->n_params, b->n_p);
+                free_benchmark(&b);
+                return -1;
+            }
 
-        case IT_BOUNDARY_COMPLETE :
-            rc = xmlTextWriterWriteFormatElement(writer, BAD_CAST "type", "%s",
-                                                 "boundary_complete");
-            break;
+            if(insert_bench_into_list(m->bench_list, b) < 0) {
+                free_benchmark(&b);
+                ERRPRINTF("Error inserting bench into bench list.\n");
+                return -1;
+            }
+        }
 
-        case IT_POINT :
-            rc = xmlTextWriterWriteFormatElement(writer, BAD_CAST "type", "%s",
-                                                 "point");
-            break;
+        return 0;
+    }
 
-        case IT_COMPLETE :
-            rc = xmlTextWriterWriteFormatElement(writer, BAD_CAST "type", "%s",
-                                                 "complete");
-            break;
+    if(b == NULL) {
+        return 0;
+    }
 
-        default:
-            ERRPRINTF("Invalid interval type: %s (%d)\n",
-                      interval_type_to_string(i->type), i->type);
-            print_interval(PMM_ERR, i);
-            return -1; // fail
+    if(!xmlStrcmp(name, (const xmlChar *) "n_p")) {
+        if(atoi(key) != b->n_p) {
+            ERRPRINTF("Expected %d parameters, got: %s\n", b->n_p, key);
+            return -1;
+        }
     }
+    else if(!xmlStrcmp(name, (const xmlChar *) "parameter")) {
+        if(mp->n_params >= b->n_p) {
+            ERRPRINTF("Parsed more parameters than expected.\n");
+            return -1;
+        }
 
-    if (rc < 0) {
-        ERRPRINTF("Error @ xmlTextWriterWriteFormatElement (type)\n");
-        return rc;
+        b->p[mp->n_params++] = atoll(key);
+    }
+    else if(!xmlStrcmp(name, (const xmlChar *) "complexity")) {
+        if(sscanf(key, "%lld", &(b->complexity)) != 1) {
+            ERRPRINTF("Error parsing complexity.\n");
+            return -1;
+        }
+    }
+    else if(!xmlStrcmp(name, (const xmlChar *) "flops")) {
+        if(sscanf(key, "%lf", &(b->flops)) != 1) {
+            ERRPRINTF("Error parsing flops.\n");
+            return -1;
+        }
+    }
+    else if(!xmlStrcmp(name, (const xmlChar *) "seconds")) {
+        if(sscanf(key, "%lf", &(b->seconds)) != 1) {
+            ERRPRINTF("Error parsing seconds.\n");
+            return -1;
+        }
     }
+    else if(!xmlStrcmp(name, (const xmlChar *) "secs")) {
+        if(mp->t != NULL) {
+            mp->t->tv_sec = atoll(key);
+        }
+    }
+    else if(!xmlStrcmp(name, (const xmlChar *) "usecs")) {
+        if(mp->t != NULL) {
+            mp->t->tv_usec = atoll(key);
+        }
+    }
+    else if(!xmlStrcmp(name, (const xmlChar *) "used_time") ||
+            !xmlStrcmp(name, (const xmlChar *) "wall_time"))
+    {
+        mp->t = NULL;
+    }
+    else if(!xmlStrcmp(name, (const xmlChar *) "cpuset")) {
+        free(b->cpuset);
+        b->cpuset = NULL;
 
+        if(!set_str(&(b->cpuset), key)) {
+            ERRPRINTF("set_str failed setting cpuset\n");
+            return -1;
+        }
+    }
+    else if(!xmlStrcmp(name, (const xmlChar *) "numa_node")) {
+        if(sscanf(key, "%d", &(b->numa_node)) != 1) {
+            ERRPRINTF("Error parsing numa_node.\n");
+            return -1;
+        }
+    }
+    else if(!xmlStrcmp(name, (const xmlChar *) "nice")) {
+        if(sscanf(key, "%d", &(b->nice)) != 1) {
+            ERRPRINTF("Error parsing nice.\n");
+            return -1;
+        }
+    }
+    else if(!xmlStrcmp(name, (const xmlChar *) "name")) {
+        free(mp->metric_name);
+        mp->metric_name = NULL;
 
-    switch (i->type) {
-        case IT_GBBP_EMPTY :
-        case IT_GBBP_CLIMB :
-            // Add an element with name "climb_step" and value to interval.
-            rc = xmlTextWriterWriteFormatElement(writer, BAD_CAST "climb_step",
-                    "%d", i->climb_step);
-            if (rc < 0) {
-                ERRPRINTF("Error @ xmlTextWriterWriteFormatElement (plane)\n");
-                return rc;
-            }
-        case IT_GBBP_BISECT :
-        case IT_GBBP_INFLECT :
-            // Add an element with name "plane" and value to interval.
-            rc = xmlTextWriterWriteFormatElement(writer, BAD_CAST "plane",
-                    "%d", i->plane);
-            if (rc < 0) {
-                ERRPRINTF("Error @ xmlTextWriterWriteFormatElement (plane)\n");
-                return rc;
-            }
+        if(!set_str(&(mp->metric_name), key)) {
+            ERRPRINTF("set_str failed setting metric name\n");
+            return -1;
+        }
+    }
+    else if(!xmlStrcmp(name, (const xmlChar *) "value")) {
+        if(sscanf(key, "%lf", &(mp->metric_value)) != 1) {
+            ERRPRINTF("Error parsing metric value.\n");
+            return -1;
+        }
+        mp->have_metric_value = 1;
+    }
+    else if(!xmlStrcmp(name, (const xmlChar *) "metric")) {
+        if(mp->metric_name == NULL || !mp->have_metric_value) {
+            ERRPRINTF("Incomplete metric.\n");
+            return -1;
+        }
 
+        if(add_benchmark_metric(b, mp->metric_name, mp->metric_value) < 0) {
+            ERRPRINTF("Error adding metric.\n");
+            return -1;
+        }
 
-            // Add an element with name "start"
-            rc = xmlTextWriterStartElement(writer, BAD_CAST "start");
-            if (rc < 0) {
-                ERRPRINTF("Error @ xmlTextWriterStartElement (start)\n");
-                return rc;
-            }
-            // write the start parameter array
-            rc = write_parameter_array_xtwp(writer, i->start, i->n_p);
-            if (rc < 0) {
-                ERRPRINTF("Error writing parameter array (start)\n");
-                return rc;
-            }
-            // Close the start element
-            rc = xmlTextWriterEndElement(writer);
-            if (rc < 0) {
-                ERRPRINTF("Error @ xmlTextWriterEndElement\n");
-                return rc;
-            }
+        free(mp->metric_name);
+        mp->metric_name = NULL;
+    }
 
+    return 0;
+}
 
-            // Add an element with name "end"
-            rc = xmlTextWriterStartElement(writer, BAD_CAST "end");
-            if (rc < 0) {
-                ERRPRINTF("Error @ xmlTextWriterStartElement (end)\n");
-                return rc;
-            }
-            // write the end parameter array
-            rc = write_parameter_array_xtwp(writer, i->end, i->n_p);
-            if (rc < 0) {
-                ERRPRINTF("Error writing parameter array (end)\n");
-                return rc;
-            }
-            // Close the end element
-            rc = xmlTextWriterEndElement(writer);
-            if (rc < 0) {
-                ERRPRINTF("Error @ xmlTextWriterEndElement\n");
-                return rc;
+/*!
+ * Handle the end of the bench list of a model file
+ *
+ * @param   mp      pointer to the model parser state
+ *
+ * @return 0 on success, -1 on failure
+ */
+int
+model_parser_bench_list_end(struct pmm_model_parser *mp)
+{
+    struct pmm_model *m = mp->m;
+
+    if(m->bench_list == NULL) {
+        ERRPRINTF("First element of bench_list xml must be size.\n");
+        return -1;
+    }
+
+    if(m->bench_list->size != mp->size) {
+        ERRPRINTF("%d benchmarks parsed, expected %d\n", m->bench_list->size,
+                                                         mp->size);
+        return -1;
+    }
+
+    return 0;
+}
+
+/*!
+ * Parse a child of the root node of a model file, other than the bench list,
+ * into a model.
+ *
+ * @param   m           pointer to the model
+ * @param   doc         pointer to the xml document
+ * @param   node        pointer to the child node
+ * @param   completion  pointer to store the completion the file records
+ *
+ * @return 0 on success, -1 on failure
+ */
+int
+parse_model_element(struct pmm_model *m, xmlDocPtr doc, xmlNodePtr node,
+                    int *completion)
+{
+    char *key;
+    struct pmm_paramdef_set *pd_set;
+
+    // get the value associated with the node
+    key = (char *)xmlNodeListGetString(doc, node->xmlChildrenNode, 1);
+
+    // if the name of the node is ... do something with the key
+    if(!xmlStrcmp(node->name, (const xmlChar *) "n_p")) {
+        m->n_p = atoi((char *)key);
+
+        if(m->parent_routine != NULL &&
+           m->n_p != m->parent_routine->pd_set->n_p)
+        {
+            ERRPRINTF("model / routine parameter mismatch m:%d r:%d.\n",
+                      m->n_p, m->parent_routine->pd_set->n_p);
+            free(key);
+            return -1; //failure
+        }
+    }
+    else if(!xmlStrcmp(node->name, (const xmlChar *) "completion")) {
+        // store the completion variable so we can check later
+        // that the number of parsed benchmarks matches
+        *completion = atoi((char *)key);
+    }
+    else if(!xmlStrcmp(node->name, (const xmlChar *) "complete")) {
+        m->complete = atoi((char *)key);
+    }
+    else if(!xmlStrcmp(node->name, (const xmlChar *) "journal_sequence")) {
+        m->journal_seq = strtoul((char *)key, NULL, 10);
+    }
+    else if(!xmlStrcmp(node->name, (const xmlChar *) "parameters")) {
+
+        pd_set = new_paramdef_set();
+
+        if(parse_paramdef_set(pd_set, doc, node) < 0)
+        {
+            ERRPRINTF("Error parsing parameter definitions.\n");
+            free_paramdef_set(&pd_set);
+            free(key);
+            return -1; //failure
+        }
+
+
+        if(pd_set->n_p != m->n_p) {
+            ERRPRINTF("Parameter definition and model mismatch.\n");
+        }
+
+        // if we have a parent routine, check that the param definitions
+        // in the model match the routine
+        if(m->parent_routine != NULL) {
+            if(isequal_paramdef_set(m->parent_routine->pd_set, pd_set) != 0)
+            {
+                ERRPRINTF("Current parameter definitions do not match "
+                          "those initially used to build model.\n");
+
+                ERRPRINTF("model:\n");
+                print_paramdef_set(PMM_ERR, pd_set);
+
+                ERRPRINTF("routine:\n");
+                print_paramdef_set(PMM_ERR, m->parent_routine->pd_set);
+
+                free_paramdef_set(&pd_set);
+                free(key);
+
+                return -1; // failure
             }
+            // finished with the parsed model parameter definitions now
+            free_paramdef_set(&pd_set);
+        }
+        else {
+            m->pd_set = pd_set;
+        }
 
-            break;
+    }
+    else if(!xmlStrcmp(node->name, (const xmlChar *) "interval_list")) {
 
-        case IT_POINT :
-            // Add an element with name "start"
-            rc = xmlTextWriterStartElement(writer, BAD_CAST "start");
-            if (rc < 0) {
-                ERRPRINTF("Error @ xmlTextWriterStartElement (start)\n");
-                return rc;
+        if(parse_interval_list(m, doc, node) < 0) {
+            ERRPRINTF("Error parsing interval list.\n");
+            free(key);
+            return -1; //failure
+        }
+
+    }
+    else {
+        // probably a text : null tag
+        // TODO suppress these and check everywhere else
+        //LOGPRINTF("unexpected tag: %s / %s\n", node->name, (char *)key);
+    }
+
+    free(key);
+    key = NULL;
+
+    return 0; //success
+}
+
+/*!
+ * Parse a model from an open binary model file
+ *
+ * @param   m   pointer to the model, with no bench list allocated
+ * @param   fd  file descriptor of the model file
+ *
+ * @return 0 on success, -1 on failure
+ */
+int
+parse_binmodel_fd(struct pmm_model *m, int fd)
+{
+    struct pmm_binmodel *bm;
+    struct pmm_paramdef_set *pd_set;
+
+    bm = map_binmodel_fd(fd);
+    if(bm == NULL) {
+        ERRPRINTF("Error mapping binary model.\n");
+        return -1;
+    }
+
+    if(m->parent_routine != NULL &&
+       bm->header->n_p != m->parent_routine->pd_set->n_p)
+    {
+        ERRPRINTF("model / routine parameter mismatch m:%d r:%d.\n",
+                  bm->header->n_p, m->parent_routine->pd_set->n_p);
+        unmap_binmodel(&bm);
+        return -1;
+    }
+
+    pd_set = binmodel_to_paramdef_set(bm);
+    if(pd_set == NULL) {
+        ERRPRINTF("Error reading parameter definitions.\n");
+        unmap_binmodel(&bm);
+        return -1;
+    }
+
+    // if we have a parent routine, check that the param definitions
+    // in the model match the routine
+    if(m->parent_routine != NULL) {
+        if(isequal_paramdef_set(m->parent_routine->pd_set, pd_set) != 0) {
+            ERRPRINTF("Current parameter definitions do not match "
+                      "those initially used to build model.\n");
+
+            ERRPRINTF("model:\n");
+            print_paramdef_set(PMM_ERR, pd_set);
+
+            ERRPRINTF("routine:\n");
+            print_paramdef_set(PMM_ERR, m->parent_routine->pd_set);
+
+            free_paramdef_set(&pd_set);
+            unmap_binmodel(&bm);
+
+            return -1;
+        }
+
+        free_paramdef_set(&pd_set);
+    }
+    else {
+        if(init_paramdef_set_parsers(pd_set) < 0) {
+            ERRPRINTF("Error setting up formula parsers.\n");
+            free_paramdef_set(&pd_set);
+            unmap_binmodel(&bm);
+            return -1;
+        }
+
+        m->pd_set = pd_set;
+    }
+
+    if(binmodel_to_model(bm, m) < 0) {
+        ERRPRINTF("Error reading binary model.\n");
+        unmap_binmodel(&bm);
+        return -1;
+    }
+
+    unmap_binmodel(&bm);
+
+    return 0; //success
+}
+
+/*!
+ * Parse models of routines listed in the config structure. The models are
+ * loaded concurrently, see load_models.
+ *
+ * @param   c   pointer to the config with all routine details
+ *
+ * @return 0 on success, -1 on failure
+ */
+int parse_models(struct pmm_config *c)
+{
+    struct pmm_model **models;
+    int *rc;
+    int i;
+    int ret;
+
+    if(c->used == 0) {
+        return 0; //success, nothing to load
+    }
+
+    models = malloc(c->used * sizeof *models);
+    rc = malloc(c->used * sizeof *rc);
+    if(models == NULL || rc == NULL) {
+        ERRPRINTF("Error allocating memory.\n");
+        free(models);
+        free(rc);
+        return -1; //failure
+    }
+
+    for(i=0; i<c->used; i++) {
+        models[i] = c->routines[i]->model;
+    }
+
+    ret = load_models(models, c->used, load_routine_model, rc);
+    if(ret == 0) {
+        for(i=0; i<c->used; i++) {
+            if(rc[i] < 0) {
+                ERRPRINTF("Error loading model of routine: %s\n",
+                          c->routines[i]->name);
+                ret = -1; //failure
             }
-            // write the start parameter array
-            rc = write_parameter_array_xtwp(writer, i->start, i->n_p);
-            if (rc < 0) {
-                ERRPRINTF("Error writing parameter array (start)\n");
-                return rc;
+        }
+    }
+
+    free(models);
+    models = NULL;
+    free(rc);
+    rc = NULL;
+
+    return ret;
+}
+
+/*!
+ * Load the model of a routine, initialising a new model if no model file
+ * exists yet and compacting any journal left by a previous run.
+ *
+ * @param   m   pointer to the model, belonging to a routine
+ *
+ * @return 0 on success, -1 on failure
+ */
+int
+load_routine_model(struct pmm_model *m)
+{
+    struct pmm_routine *r;
+    int rc;
+
+    r = m->parent_routine;
+
+    LOGPRINTF("Loading model: %s for routine: %s\n",
+              m->model_path, r->name);
+
+    rc = parse_model(m);
+    if(rc < 0) {
+        if(rc == -1) {
+            //model parsing failed, so initialize model with definitions
+            //from routine
+
+            m->n_p = r->pd_set->n_p;
+            if(init_bench_list(m, r->pd_set) < 0){
+                ERRPRINTF("Error initialising bench list.\n");
+                return -1; //failure
             }
-            // Close the start element
-            rc = xmlTextWriterEndElement(writer);
-            if (rc < 0) {
-                ERRPRINTF("Error @ xmlTextWriterEndElement\n");
-                return rc;
+
+            //benchmarks may have been journalled before the model file
+            //was first written
+            if(replay_model_journal(m) < 0) {
+                ERRPRINTF("Error replaying journal of model.\n");
+                return -1; //failure
             }
 
-            break;
+        }
+        else {
+            ERRPRINTF("Error parsing model.\n");
+            return -1; //failure
+        }
+    }
 
-        case IT_COMPLETE :
-        case IT_BOUNDARY_COMPLETE :
-            //nothing
-            break;
+    //compact a journal left by a previous run into the model file
+    if(m->journal_size > 0) {
+        LOGPRINTF("Compacting journal of model: %s\n", m->model_path);
 
-        default :
-            ERRPRINTF("Invalid interval type: %s (%d)\n",
-                      interval_type_to_string(i->type), i->type);
-            print_interval(PMM_ERR, i);
+        if(write_model(m) < 0) {
+            ERRPRINTF("Error compacting journal of model.\n");
             return -1; //failure
+        }
     }
 
+    return 0; //success
+}
 
+/*!
+ * Load a model from its file on first use. Tools that need the models of
+ * only some of the routines of a config can load just those with this,
+ * rather than loading every model with parse_models.
+ *
+ * @param   m   pointer to the model, with its path set
+ *
+ * @return 0 if the model is loaded or was already loaded, otherwise as
+ * parse_model
+ */
+int
+load_model(struct pmm_model *m)
+{
+    if(m->bench_list != NULL) {
+        return 0; //already loaded
+    }
 
+    xmlparser_init();
 
-    // Close the interval element.
-    rc = xmlTextWriterEndElement(writer);
-    if (rc < 0) {
-        ERRPRINTF("Error @ xmlTextWriterEndElement\n");
-        return rc;
+    return parse_model(m);
+}
+
+/*!
+ * Load an array of models concurrently on a pool of threads, one per online
+ * cpu up to the number of models. The calling thread is one of the pool. A
+ * model that appears in the array more than once is loaded once only.
+ *
+ * The load function is called once for each model and must only modify that
+ * model, e.g. parse_model, load_model or load_routine_model.
+ *
+ * @param   models  array of pointers to the models
+ * @param   n       number of models
+ * @param   load    function to load a model with
+ * @param   rc      array of n to store the return code of each load in
+ *
+ * @return 0 on success, -1 on failure, in which case no model is loaded
+ */
+int
+load_models(struct pmm_model **models, int n,
+            int (*load)(struct pmm_model *m), int *rc)
+{
+    struct pmm_model_loader loader;
+    pthread_t *threads;
+    long n_threads;
+    int created;
+    int i, j;
+
+    if(n <= 0) {
+        return 0; //success, nothing to load
+    }
+
+    // libxml2 must be initialised before threads parse
+    xmlparser_init();
+
+    n_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if(n_threads < 1) {
+        n_threads = 1;
+    }
+    if(n_threads > n) {
+        n_threads = n;
+    }
+
+    threads = malloc(n_threads * sizeof *threads);
+    if(threads == NULL) {
+        ERRPRINTF("Error allocating memory.\n");
+        return -1;
+    }
+
+    loader.models = models;
+    loader.n = n;
+    loader.rc = rc;
+    loader.load = load;
+    loader.next = 0;
+    pthread_mutex_init(&(loader.mutex), NULL);
+
+    // if a thread cannot be created the rest of the pool loads its share
+    for(created=0; created<n_threads-1; created++) {
+        if(pthread_create(&(threads[created]), NULL, model_loader_thread,
+                          &loader) != 0)
+        {
+            ERRPRINTF("Error creating model loading thread, continuing "
+                      "with %d.\n", created+1);
+            break;
+        }
+    }
+
+    model_loader_thread(&loader);
+
+    for(i=0; i<created; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&(loader.mutex));
+
+    free(threads);
+    threads = NULL;
+
+    // models appearing more than once share the return code of their load
+    for(i=1; i<n; i++) {
+        for(j=0; j<i; j++) {
+            if(models[j] == models[i]) {
+                rc[i] = rc[j];
+                break;
+            }
+        }
     }
 
     return 0; //success
 }
 
 /*!
- * write the load history to file
- *
- * opens an xmlTextWriter and writes the history to the file specified
- * in the history structure
+ * Thread of the pool loading models, loads models until none are left
+ *
+ * @param   arg     pointer to the pmm_model_loader
+ *
+ * @return NULL
+ */
+void*
+model_loader_thread(void *arg)
+{
+    struct pmm_model_loader *loader = arg;
+    int i, j;
+
+    while(1) {
+        pthread_mutex_lock(&(loader->mutex));
+        i = loader->next++;
+        pthread_mutex_unlock(&(loader->mutex));
+
+        if(i >= loader->n) {
+            break;
+        }
+
+        // skip models that appear earlier in the array
+        for(j=0; j<i; j++) {
+            if(loader->models[j] == loader->models[i]) {
+                break;
+            }
+        }
+
+        if(j == i) {
+            loader->rc[i] = loader->load(loader->models[i]);
+        }
+    }
+
+    return NULL;
+}
+
+/*!
+ * write an interval structure to disk in xml
+ *
+ * @param   writer      xmlTextWriterPtr to use to write with
+ * @param   i           pointer to interval structure to write to disk
+ *
+ * @return 0 on success, -1 on failure
+ */
+int write_interval_xtwp(xmlTextWriterPtr writer, struct pmm_interval *i)
+{
+    int rc;
+
+
+    // Start an element named interval
+    rc = xmlTextWriterStartElement(writer, BAD_CAST "interval");
+    if (rc < 0) {
+        ERRPRINTF("Error @ xmlTextWriterStartElement (interval)\n");
+        return rc;
+    }
+
+    switch (i->type) {
+        case IT_GBBP_EMPTY :
+            rc = xmlTextWriterWriteFormatElement(writer, BAD_CAST "type", "%s",
+                                                 "gbbp_empty");
+            break;
+        case IT_GBBP_CLIMB :
+            rc = xmlTextWriterWriteFormatElement(writer, BAD_CAST "type", "%s",
+                                                 "gbbp_climb");
+            break;
+
+        case IT_GBBP_BISECT :
+            rc = xmlTextWriterWriteFormatElement(writer, BAD_CAST "type", "%s",
+                                                 "gbbp_bisect");
+            break;
+
+        case IT_GBBP_INFLECT :
+            rc = xmlTextWriterWriteFormatElement(writer, BAD_CAST "type", "%s",
+                                                 "gbbp_inflect");
+            break;
+
+        case IT_BOUNDARY_COMPLETE :
+            rc = xmlTextWriterWriteFormatElement(writer, BAD_CAST "type", "%s",
+                                                 "boundary_complete");
+            break;
+
+        case IT_POINT :
+            rc = xmlTextWriterWriteFormatElement(writer, BAD_CAST "type", "%s",
+                                                 "point");
+            break;
+
+        case IT_COMPLETE :
+            rc = xmlTextWriterWriteFormatElement(writer, BAD_CAST "type", "%s",
+                                                 "complete");
+            break;
+
+        default:
+            ERRPRINTF("Invalid interval type: %s (%d)\n",
+                      interval_type_to_string(i->type), i->type);
+            print_interval(PMM_ERR, i);
+            return -1; // fail
+    }
+
+    if (rc < 0) {
+        ERRPRINTF("Error @ xmlTextWriterWriteFormatElement (type)\n");
+        return rc;
+    }
+
+
+    switch (i->type) {
+        case IT_GBBP_EMPTY :
+        case IT_GBBP_CLIMB :
+            // Add an element with name "climb_step" and value to interval.
+            rc = xmlTextWriterWriteFormatElement(writer, BAD_CAST "climb_step",
+                    "%d", i->climb_step);
+            if (rc < 0) {
+                ERRPRINTF("Error @ xmlTextWriterWriteFormatElement (plane)\n");
+                return rc;
+            }
+        case IT_GBBP_BISECT :
+        case IT_GBBP_INFLECT :
+            // Add an element with name "plane" and value to interval.
+            rc = xmlTextWriterWriteFormatElement(writer, BAD_CAST "plane",
+                    "%d", i->plane);
+            if (rc < 0) {
+                ERRPRINTF("Error @ xmlTextWriterWriteFormatElement (plane)\n");
+                return rc;
+            }
+
+
+            // Add an element with name "start"
+            rc = xmlTextWriterStartElement(writer, BAD_CAST "start");
+            if (rc < 0) {
+                ERRPRINTF("Error @ xmlTextWriterStartElement (start)\n");
+                return rc;
+            }
+            // write the start parameter array
+            rc = write_parameter_array_xtwp(writer, i->start, i->n_p);
+            if (rc < 0) {
+                ERRPRINTF("Error writing parameter array (start)\n");
+                return rc;
+            }
+            // Close the start element
+            rc = xmlTextWriterEndElement(writer);
+            if (rc < 0) {
+                ERRPRINTF("Error @ xmlTextWriterEndElement\n");
+                return rc;
+            }
+
+
+            // Add an element with name "end"
+            rc = xmlTextWriterStartElement(writer, BAD_CAST "end");
+            if (rc < 0) {
+                ERRPRINTF("Error @ xmlTextWriterStartElement (end)\n");
+                return rc;
+            }
+            // write the end parameter array
+            rc = write_parameter_array_xtwp(writer, i->end, i->n_p);
+            if (rc < 0) {
+                ERRPRINTF("Error writing parameter array (end)\n");
+                return rc;
+            }
+            // Close the end element
+            rc = xmlTextWriterEndElement(writer);
+            if (rc < 0) {
+                ERRPRINTF("Error @ xmlTextWriterEndElement\n");
+                return rc;
+            }
+
+            break;
+
+        case IT_POINT :
+            // Add an element with name "start"
+            rc = xmlTextWriterStartElement(writer, BAD_CAST "start");
+            if (rc < 0) {
+                ERRPRINTF("Error @ xmlTextWriterStartElement (start)\n");
+                return rc;
+            }
+            // write the start parameter array
+            rc = write_parameter_array_xtwp(writer, i->start, i->n_p);
+            if (rc < 0) {
+                ERRPRINTF("Error writing parameter array (start)\n");
+                return rc;
+            }
+            // Close the start element
+            rc = xmlTextWriterEndElement(writer);
+            if (rc < 0) {
+                ERRPRINTF("Error @ xmlTextWriterEndElement\n");
+                return rc;
+            }
+
+            break;
+
+        case IT_COMPLETE :
+        case IT_BOUNDARY_COMPLETE :
+            //nothing
+            break;
+
+        default :
+            ERRPRINTF("Invalid interval type: %s (%d)\n",
+                      interval_type_to_string(i->type), i->type);
+            print_interval(PMM_ERR, i);
+            return -1; //failure
+    }
+
+
+
+
+    // Close the interval element.
+    rc = xmlTextWriterEndElement(writer);
+    if (rc < 0) {
+        ERRPRINTF("Error @ xmlTextWriterEndElement\n");
+        return rc;
+    }
+
+    return 0; //success
+}
+
+/*!
+ * write the load history to file
+ *
+ * opens an xmlTextWriter and writes the history to the file specified
+ * in the history structure
+ *
+ * @param   h   pointer to the load history
+ *
+ * @return 0 on success, -1 on failure
+ */
+int
+write_loadhistory(struct pmm_loadhistory *h)
+{
+    char *temp_file;
+
+    int rc;
+    xmlTextWriterPtr writer;
+    xmlOutputBufferPtr output_buffer;
+
+    struct flock fl = {F_WRLCK, SEEK_SET, 0, 0, 0};
+    int temp_fd, hist_fd;
+
+    DBGPRINTF("writing file: %s\n", h->load_path);
+
+    // create file name for mkstemp
+    if(asprintf(&temp_file, "%s.XXXXXX", h->load_path)
+       > PATH_MAX)
+    {
+        ERRPRINTF("filename too long: %s\n", temp_file);
+
+        free(temp_file);
+        temp_file = NULL;
+
+        return -1; //fail
+    }
+
+
+    //open temp file
+    temp_fd = mkstemp(temp_file);
+    if(temp_fd == -1) {
+        ERRPRINTF("Error opening temp file for writing: %s\n", temp_file);
+        perror("mkstemp");
+        return -1; //fail
+    }
+
+
+    //create output buffer
+    output_buffer = xmlOutputBufferCreateFd(temp_fd, NULL);
+    if(output_buffer == NULL) {
+        ERRPRINTF("Error creating xml output buffer.\n");
+
+        unlink(temp_file);
+        close(temp_fd);
+        free(temp_file);
+        temp_file = NULL;
+
+        return -1; //fail
+    }
+
+
+
+    //create xml writer
+    writer = xmlNewTextWriter(output_buffer);
+    if (writer == NULL) {
+        ERRPRINTF("Error creating the xml writer\n");
+
+        unlink(temp_file);
+        close(temp_fd);
+        free(temp_file);
+        temp_file = NULL;
+
+        return -1; //fail
+    }
+
+    rc = xmlTextWriterSetIndent(writer, 1);
+    if(rc < 0) {
+        ERRPRINTF("Error setting indent\n");
+
+        xmlFreeTextWriter(writer);
+        unlink(temp_file);
+        close(temp_fd);
+        free(temp_file);
+        temp_file = NULL;
+
+        return -1;
+    }
+
+    //write history
+    rc = write_loadhistory_xtwp(writer, h);
+    if(rc < 0) {
+        ERRPRINTF("Error writing history, partial history saved in: %s\n",
+                   temp_file);
+
+        xmlFreeTextWriter(writer);
+        close(temp_fd);
+        free(temp_file);
+        temp_file = NULL;
+
+        return -1;
+    }
+
+    xmlFreeTextWriter(writer);
+
+    if(fsync(temp_fd) < 0) {
+        ERRPRINTF("Error syncing data for file, remove:%s manually.\n",
+                  temp_file);
+        perror("fsync");
+
+        close(temp_fd);
+        free(temp_file);
+        temp_file = NULL;
+
+        return -1;
+
+    }
+
+    //close temp file
+    if(close(temp_fd) < 0) {
+        ERRPRINTF("Error closing file, remove:%s manually\n", temp_file);
+
+        free(temp_file);
+        temp_file = NULL;
+        return -1;
+    }
+
+    //open historyl file
+    hist_fd = open(h->load_path, O_WRONLY|O_CREAT, S_IRWXU);
+    if(hist_fd < 0) {
+        ERRPRINTF("Error opening load file: %s.\n", h->load_path);
+
+        free(temp_file);
+        temp_file = NULL;
+
+        return -1;
+    }
+
+    //set up a write lock
+    fl.l_type = F_WRLCK;
+    fl.l_whence = SEEK_SET;
+    fl.l_start = 0;
+    fl.l_len = 0;
+    fl.l_pid = 0;
+
+    //get write lock on load history file so reading processes will block
+    if(fcntl(hist_fd, F_SETLKW, &fl) == -1) {
+        ERRPRINTF("Error aquiring lock on load history file: %s\n",
+                  h->load_path);
+        perror("fcntl");
+
+        close(hist_fd);
+        free(temp_file);
+        temp_file = NULL;
+
+        return -1;
+    }
+
+    //rename temp file to history file
+    //TODO if we port to windows, this will not work
+    if(rename(temp_file, h->load_path) < 0) {
+        ERRPRINTF("Error renaming %s to %s, leaving %s on filesystem\n",
+                  temp_file, h->load_path, temp_file);
+
+        close(hist_fd);
+        free(temp_file);
+        temp_file = NULL;
+
+        return -1;
+    }
+
+    free(temp_file);
+    temp_file = NULL;
+
+    //close and free lock
+    if(close(hist_fd) < 0) {
+        ERRPRINTF("Error closing file: %s\n.", h->load_path);
+
+        return -1;
+    }
+
+    //sync dir so we are sure everything is committed to the filesystem
+    if(sync_parent_dir(h->load_path) < 0) {
+        ERRPRINTF("Error syncing parent dir of: %s.\n", h->load_path);
+
+        return -1;
+    }
+
+    return 0; //success
+}
+
+
+#define TIME_STR_SIZE 256   /*!< size of ISO 8601 time string */
+/*!
+ *
+ * Write load history to the xmlTextWriterPtr
+ *
+ * @param   writer  an xmlTextWriter pointer
+ * @param   h       pointer to load load history structure
+ *
+ * @return 0 on success, -1 on failure
+ */
+int write_loadhistory_xtwp(xmlTextWriterPtr writer, struct pmm_loadhistory *h)
+{
+    int rc;
+    int i;
+    char time_str[TIME_STR_SIZE+1] = "";
+    struct tm time_tm;
+
+    // start document with standard version/enconding
+    rc = xmlTextWriterStartDocument(writer, NULL, "ISO-8859-1", NULL);
+    if (rc < 0) {
+        ERRPRINTF("Error @ xmlTextWriterStartDocument\n");
+        return rc;
+    }
+
+    // start root element loadhistory
+    rc = xmlTextWriterStartElement(writer, BAD_CAST "loadhistory");
+    if (rc < 0) {
+        ERRPRINTF("Error @ xmlTextWriterStartElement (loadhistory)\n");
+        return rc;
+    }
+
+    i = h->start_i;
+    while(i != h->end_i) {
+
+        // Start an element named load as child of loadhistory.
+        rc = xmlTextWriterStartElement(writer, BAD_CAST "load");
+        if (rc < 0) {
+            ERRPRINTF("Error @ xmlTextWriterStartElement (load)\n");
+            return rc;
+        }
+
+        // convert time_t value to ISO 8601
+        localtime_r(&(h->history[i].time), &time_tm);
+        if(0 == strftime(time_str, TIME_STR_SIZE,
+                         "%Y-%m-%dT%H:%M:%S%z",
+                         &time_tm))
+        {
+            ERRPRINTF("Error converting time_t to ISO 8601 string.\n");
+            return -1;
+        }
+
+        // Add an element with name "time" and value to load.
+        rc = xmlTextWriterWriteFormatElement(writer, BAD_CAST "time",
+                "%s", time_str);
+        if (rc < 0) {
+            ERRPRINTF("Error @ xmlTextWriterWriteFormatElement (time)\n");
+            return rc;
+        }
+
+        // Add a comment with the human readable version of the time value
+        //rc = xmlTextWriterWriteFormatComment(writer, "%s",
+        //      ctime((time_t*)&(h->history[i].time)));
+        //if(rc < 0) {
+        //  ERRPRINTF("Error @ xmlTextWriterFormatComment (time)\n");
+        //  return rc;
+        //}
+
+
+        // Add an element with name one_min and value to load
+        rc = xmlTextWriterWriteFormatElement(writer, BAD_CAST "one_min",
+                "%f", h->history[i].load[0]);
+        if (rc < 0) {
+            ERRPRINTF("Error @ xmlTextWriterWriteFormatElement (one_min)\n");
+            return rc;
+        }
+        // Add an element with name five_min and value to load
+        rc = xmlTextWriterWriteFormatElement(writer, BAD_CAST "five_min",
+                "%f", h->history[i].load[1]);
+        if (rc < 0) {
+            ERRPRINTF("Error @ xmlTextWriterWriteFormatElement (five_min)\n");
+            return rc;
+        }
+        // Add an element with name fifteen_min and value to load
+        rc = xmlTextWriterWriteFormatElement(writer, BAD_CAST "fifteen_min",
+                "%f", h->history[i].load[2]);
+        if (rc < 0) {
+            ERRPRINTF("Error @ xmlTextWriterWriteFormatElement (fifteen_min)\n");
+            return rc;
+        }
+
+        // Close the load element.
+        rc = xmlTextWriterEndElement(writer);
+        if (rc < 0) {
+            ERRPRINTF("Error @ xmlTextWriterEndElement\n");
+            return rc;
+        }
+
+        i = (i + 1) % h->size_mod;
+
+    }
+
+    // Close the root element named loadhistory (and all other open tags).
+    rc = xmlTextWriterEndDocument(writer);
+    if (rc < 0) {
+        ERRPRINTF("Error @ xmlTextWriterEndDocument\n");
+        return rc;
+    }
+
+    return 0; //success
+}
+
+/*!
+ * Check if a file descriptor is locked
+ *
+ * @param   fd  the file descriptor to check
+ * @param   type    the type of lock to test FD_WRLCK, FD_RDLCK, FD_RWLCK
+ *
+ * @return -1 on error, 0 if file is not locked, pid of owning process if file
+ * is locked
+ */
+int check_lock(int fd, int type)
+{
+    struct flock fl;
+
+    fl.l_type = type;
+    fl.l_whence = SEEK_SET;
+    fl.l_start = 0;
+    fl.l_len = 0;
+    fl.l_pid = 0;
+
+    if(fcntl(fd, F_GETLK, &fl) == -1) {
+        ERRPRINTF("Error checking lock status on fd: %d\n", fd);
+        perror("fcntl\n");
+        return -1;
+    }
+
+
+    if(fl.l_type == F_UNLCK) {
+        return 0;
+    }
+    else {
+        return fl.l_pid;
+    }
+}
+
+/*!
+ * write all models in the configuration
+ *
+ * @param   cfg     pointer to the configuration
+ *
+ * @return 0 on success, -1 on failure
+ */
+int
+write_models(struct pmm_config *cfg)
+{
+    int i;
+    int ret = 0;
+
+    LOGPRINTF("Writing models to disk.\n");
+
+
+    for(i=0; i<cfg->used; i++) {
+        if(write_model(cfg->routines[i]->model) < 0) {
+            ERRPRINTF("Error writing model for routine: %s.\n",
+                      cfg->routines[i]->name);
+            ret = -1;
+        }
+    }
+
+    return ret;
+}
+
+/*!
+ * write an individual model to disk
  *
- * @param   h   pointer to the load history
+ * @param   m   pointer to the model
  *
  * @return 0 on success, -1 on failure
+ *
+ * @pre the caller does not hold the model mutex and no other thread writes
+ * the model or its journal
  */
 int
-write_loadhistory(struct pmm_loadhistory *h)
+write_model(struct pmm_model *m)
 {
     char *temp_file;
+    char *journal_file;
+    struct stat file_stats;
 
     int rc;
-    xmlTextWriterPtr writer;
-    xmlOutputBufferPtr output_buffer;
 
-    struct flock fl = {F_WRLCK, SEEK_SET, 0, 0, 0};
-    int temp_fd, hist_fd;
+    struct flock fl;
+    int temp_fd, model_fd;
 
-    DBGPRINTF("writing file: %s\n", h->load_path);
+    int n_written, execs_written;
+    double time_written;
+
+    DBGPRINTF("writing model file: %s\n", m->model_path);
 
     // create file name for mkstemp
-    if(asprintf(&temp_file, "%s.XXXXXX", h->load_path)
+    if(asprintf(&temp_file, "%s.XXXXXX", m->model_path)
        > PATH_MAX)
     {
         ERRPRINTF("filename too long: %s\n", temp_file);
 
         free(temp_file);
         temp_file = NULL;
-
         return -1; //fail
     }
 
-
     //open temp file
     temp_fd = mkstemp(temp_file);
     if(temp_fd == -1) {
@@ -1988,40 +3576,31 @@ write_loadhistory(struct pmm_loadhistory *h)
     }
 
 
-    //create output buffer
-    output_buffer = xmlOutputBufferCreateFd(temp_fd, NULL);
-    if(output_buffer == NULL) {
-        ERRPRINTF("Error creating xml output buffer.\n");
-
-        unlink(temp_file);
-        close(temp_fd);
-        free(temp_file);
-        temp_file = NULL;
+    //write model in the configured format. The model mutex is held only
+    //while the model is serialised, it is released before the file is
+    //synced so benchmarks are not held up by the disk
+    pthread_mutex_lock(&(m->mutex));
 
-        return -1; //fail
+    if(m->format == MF_BINARY) {
+        rc = write_binmodel_fd(temp_fd, m);
+    }
+    else {
+        rc = write_xml_model_fd(temp_fd, m);
     }
 
+    //benchmarks inserted from now on are not in the file. Those that are
+    //stay pending until the file replaces the model file, so they are
+    //written again if we fail before then
+    n_written = m->n_unjournalled;
+    execs_written = m->unwritten_num_execs;
+    time_written = m->unwritten_time_spend;
 
+    pthread_mutex_unlock(&(m->mutex));
 
-    //create xml writer
-    writer = xmlNewTextWriter(output_buffer);
-    if (writer == NULL) {
-        ERRPRINTF("Error creating the xml writer\n");
-
-        unlink(temp_file);
-        close(temp_fd);
-        free(temp_file);
-        temp_file = NULL;
-
-        return -1; //fail
-    }
-
-    rc = xmlTextWriterSetIndent(writer, 1);
     if(rc < 0) {
-        ERRPRINTF("Error setting indent\n");
+        ERRPRINTF("Error writing model, partial model saved in: %s\n",
+                   temp_file);
 
-        xmlFreeTextWriter(writer);
-        unlink(temp_file);
         close(temp_fd);
         free(temp_file);
         temp_file = NULL;
@@ -2029,33 +3608,28 @@ write_loadhistory(struct pmm_loadhistory *h)
         return -1;
     }
 
-    //write history
-    rc = write_loadhistory_xtwp(writer, h);
-    if(rc < 0) {
-        ERRPRINTF("Error writing history, partial history saved in: %s\n",
-                   temp_file);
+    if(fsync(temp_fd) < 0) {
+        ERRPRINTF("Error syncing data for file, remove:%s manually.\n",
+                  temp_file);
+        perror("fsync");
 
-        xmlFreeTextWriter(writer);
         close(temp_fd);
         free(temp_file);
         temp_file = NULL;
 
         return -1;
-    }
 
-    xmlFreeTextWriter(writer);
+    }
 
-    if(fsync(temp_fd) < 0) {
-        ERRPRINTF("Error syncing data for file, remove:%s manually.\n",
-                  temp_file);
-        perror("fsync");
+    if(fstat(temp_fd, &file_stats) < 0) {
+        ERRPRINTF("Error getting size of file: %s\n", temp_file);
+        perror("fstat");
 
         close(temp_fd);
         free(temp_file);
         temp_file = NULL;
 
         return -1;
-
     }
 
     //close temp file
@@ -2067,10 +3641,10 @@ write_loadhistory(struct pmm_loadhistory *h)
         return -1;
     }
 
-    //open historyl file
-    hist_fd = open(h->load_path, O_WRONLY|O_CREAT, S_IRWXU);
-    if(hist_fd < 0) {
-        ERRPRINTF("Error opening load file: %s.\n", h->load_path);
+    //open model file
+    model_fd = open(m->model_path, O_WRONLY|O_CREAT, S_IRWXU);
+    if(model_fd < 0) {
+        ERRPRINTF("Error opening model file: %s.\n", m->model_path);
 
         free(temp_file);
         temp_file = NULL;
@@ -2085,155 +3659,394 @@ write_loadhistory(struct pmm_loadhistory *h)
     fl.l_len = 0;
     fl.l_pid = 0;
 
-    //get write lock on load history file so reading processes will block
-    if(fcntl(hist_fd, F_SETLKW, &fl) == -1) {
-        ERRPRINTF("Error aquiring lock on load history file: %s\n",
-                  h->load_path);
+    //get write lock on model file so reading processes will block
+    if(fcntl(model_fd, F_SETLKW, &fl) == -1) {
+        ERRPRINTF("Error aquiring lock on model file: %s\n", m->model_path);
         perror("fcntl");
 
-        close(hist_fd);
+        close(model_fd);
         free(temp_file);
         temp_file = NULL;
 
         return -1;
     }
 
-    //rename temp file to history file
+    //rename temp file to model file
     //TODO if we port to windows, this will not work
-    if(rename(temp_file, h->load_path) < 0) {
+    if(rename(temp_file, m->model_path) < 0) {
         ERRPRINTF("Error renaming %s to %s, leaving %s on filesystem\n",
-                  temp_file, h->load_path, temp_file);
+                  temp_file, m->model_path, temp_file);
 
-        close(hist_fd);
+        close(model_fd);
         free(temp_file);
         temp_file = NULL;
 
         return -1;
     }
 
-    free(temp_file);
-    temp_file = NULL;
+    free(temp_file);
+    temp_file = NULL;
+
+    //the model file now holds the benchmarks that were pending when it was
+    //serialised
+    pthread_mutex_lock(&(m->mutex));
+
+    release_unjournalled(m, n_written);
+    m->unwritten_num_execs -= execs_written;
+    m->unwritten_time_spend -= time_written;
+
+    pthread_mutex_unlock(&(m->mutex));
+
+    //close and free lock
+    if(close(model_fd) < 0) {
+        ERRPRINTF("Error closing file: %s\n.", m->model_path);
+
+        return -1;
+    }
+
+
+    //sync dir so we are sure everything is committed to the filesystem
+    if(sync_parent_dir(m->model_path) < 0) {
+        ERRPRINTF("Error syncing parent dir of: %s.\n", m->model_path);
+
+        return -1;
+    }
+
+    m->snapshot_size = file_stats.st_size;
+
+    //the model file now holds every journalled benchmark, so the journal can
+    //be emptied. If we fail before it is, records it holds are skipped on
+    //replay as their sequence numbers are not above that of the model file
+    journal_file = model_journal_path(m);
+    if(journal_file == NULL) {
+        ERRPRINTF("Error getting journal path of model: %s\n", m->model_path);
+        return -1;
+    }
+
+    if(truncate(journal_file, 0) < 0 && errno != ENOENT) {
+        ERRPRINTF("Error truncating journal: %s\n", journal_file);
+        perror("truncate");
+
+        free(journal_file);
+        journal_file = NULL;
+
+        return -1;
+    }
+
+    free(journal_file);
+    journal_file = NULL;
+
+    m->journal_size = 0;
+
+    return 0; //success
+}
+
+/*!
+ * write a model as an xml document to an open file
+ *
+ * @param   fd  file descriptor of the file
+ * @param   m   pointer to the model
+ *
+ * @return 0 on success, -1 on failure
+ */
+int
+write_xml_model_fd(int fd, struct pmm_model *m)
+{
+    int rc;
+    xmlTextWriterPtr writer;
+    xmlOutputBufferPtr output_buffer;
+
+    //create output buffer
+    output_buffer = xmlOutputBufferCreateFd(fd, NULL);
+    if(output_buffer == NULL) {
+        ERRPRINTF("Error creating xml output buffer.\n");
+        return -1; //fail
+    }
+
+    //create xml writer, which frees the output buffer when it is freed
+    writer = xmlNewTextWriter(output_buffer);
+    if (writer == NULL) {
+        ERRPRINTF("Error creating the xml writer\n");
+        xmlOutputBufferClose(output_buffer);
+        return -1; //fail
+    }
+
+    rc = xmlTextWriterSetIndent(writer, 1);
+    if(rc < 0) {
+        ERRPRINTF("Error setting indent\n");
+        xmlFreeTextWriter(writer);
+        return -1;
+    }
+
+    //write model
+    rc = write_model_xtwp(writer, m);
+
+    xmlFreeTextWriter(writer);
+
+    return rc < 0 ? -1 : 0;
+}
+
+/*!
+ * write a model in the binary model format to an open file
+ *
+ * @param   fd  file descriptor of the file
+ * @param   m   pointer to the model
+ *
+ * @return 0 on success, -1 on failure
+ */
+int
+write_binmodel_fd(int fd, struct pmm_model *m)
+{
+    void *image;
+    size_t size;
+    int rc;
+
+    image = model_to_binmodel(m, &size);
+    if(image == NULL) {
+        ERRPRINTF("Error building binary model.\n");
+        return -1;
+    }
+
+    rc = write_fd_fully(fd, image, size);
+
+    free(image);
+    image = NULL;
+
+    return rc;
+}
+
+/*!
+ * Get the path of the journal of a model, which is kept alongside the
+ * model file
+ *
+ * @param   m   pointer to the model
+ *
+ * @return pointer to newly allocated path or NULL on failure
+ */
+char*
+model_journal_path(struct pmm_model *m)
+{
+    char *journal_file;
+
+    if(asprintf(&journal_file, "%s.journal", m->model_path) < 0) {
+        ERRPRINTF("Error allocating journal path.\n");
+        return NULL;
+    }
+
+    return journal_file;
+}
+
+/*!
+ * Append a record of the benchmarks inserted into a model since its last
+ * record to the journal of the model, and sync it to disk. Each record also
+ * holds the complete state and the interval stack of the model as they are
+ * after the benchmarks were inserted, so replaying the journal over the
+ * model file restores the model without rewriting the model file each time
+ * a benchmark is made.
+ *
+ * Records are written as a line giving the length of the record, followed by
+ * the record as an xml document, so that a record cut short by a crash can be
+ * detected and ignored when the journal is replayed.
+ *
+ * @param   m   pointer to the model
+ *
+ * @return 0 on success, -1 on failure
+ *
+ * @pre the caller does not hold the model mutex and no other thread writes
+ * the model or its journal
+ */
+int
+append_model_journal(struct pmm_model *m)
+{
+    char *journal_file;
+    char header[32];
+    int header_len;
+    int rc;
+    int journal_fd;
+    int n_recorded;
+
+    xmlBufferPtr buffer;
+    xmlTextWriterPtr writer;
+
+    buffer = xmlBufferCreate();
+    if(buffer == NULL) {
+        ERRPRINTF("Error creating xml buffer.\n");
+        return -1;
+    }
+
+    writer = xmlNewTextWriterMemory(buffer, 0);
+    if(writer == NULL) {
+        ERRPRINTF("Error creating the xml writer\n");
+
+        xmlBufferFree(buffer);
+        return -1;
+    }
+
+    //the record is built under the model mutex, and written and synced
+    //after it is released, so benchmarks are not held up by the disk
+    pthread_mutex_lock(&(m->mutex));
+
+    if(m->n_unjournalled == 0) {
+        pthread_mutex_unlock(&(m->mutex));
+
+        xmlFreeTextWriter(writer);
+        xmlBufferFree(buffer);
+        return 0; //nothing new to record
+    }
+
+    rc = write_journal_record_xtwp(writer, m);
+    if(rc >= 0) {
+        //benchmarks inserted from now on go in the next record. Should the
+        //record fail to reach the disk its sequence number is just skipped
+        //and its benchmarks stay pending for the next record
+        m->journal_seq++;
+        n_recorded = m->n_unjournalled;
+    }
+
+    pthread_mutex_unlock(&(m->mutex));
+
+    //freeing the writer flushes the record to the buffer
+    xmlFreeTextWriter(writer);
+
+    if(rc < 0) {
+        ERRPRINTF("Error writing journal record.\n");
+
+        xmlBufferFree(buffer);
+        return -1;
+    }
+
+    header_len = snprintf(header, sizeof header, "%d\n",
+                          xmlBufferLength(buffer));
+
+    journal_file = model_journal_path(m);
+    if(journal_file == NULL) {
+        ERRPRINTF("Error getting journal path of model: %s\n", m->model_path);
+
+        xmlBufferFree(buffer);
+        return -1;
+    }
+
+    journal_fd = open(journal_file, O_WRONLY|O_APPEND|O_CREAT, S_IRUSR|S_IWUSR);
+    if(journal_fd < 0) {
+        ERRPRINTF("Error opening journal: %s\n", journal_file);
+        perror("open");
+
+        xmlBufferFree(buffer);
+        free(journal_file);
+        journal_file = NULL;
+
+        return -1;
+    }
+
+    if(write_fd_fully(journal_fd, header, header_len) < 0 ||
+       write_fd_fully(journal_fd, (const char *)xmlBufferContent(buffer),
+                      xmlBufferLength(buffer)) < 0)
+    {
+        ERRPRINTF("Error appending record to journal: %s\n", journal_file);
+
+        close(journal_fd);
+        rc = -1;
+    }
+    else if(sync_close_file(journal_fd) < 0) {
+        ERRPRINTF("Error syncing journal: %s\n", journal_file);
+
+        rc = -1;
+    }
+    //the first record may have created the journal, make sure the directory
+    //entry is on disk too
+    else if(m->journal_size == 0 && sync_parent_dir(journal_file) < 0) {
+        ERRPRINTF("Error syncing parent dir of: %s.\n", journal_file);
+
+        rc = -1;
+    }
+
+    if(rc < 0) {
+        //cut off what was written of the record, so it is neither replayed
+        //along with the record that will hold its benchmarks nor, if torn,
+        //hides the records after it from replay
+        if(truncate(journal_file, m->journal_size) < 0) {
+            ERRPRINTF("Error truncating journal: %s\n", journal_file);
+            perror("truncate");
+        }
 
-    //close and free lock
-    if(close(hist_fd) < 0) {
-        ERRPRINTF("Error closing file: %s\n.", h->load_path);
+        xmlBufferFree(buffer);
+        free(journal_file);
+        journal_file = NULL;
 
         return -1;
     }
 
-    //sync dir so we are sure everything is committed to the filesystem
-    if(sync_parent_dir(h->load_path) < 0) {
-        ERRPRINTF("Error syncing parent dir of: %s.\n", h->load_path);
+    m->journal_size += header_len + xmlBufferLength(buffer);
 
-        return -1;
-    }
+    //the benchmarks of the record are on disk, those inserted since are not
+    pthread_mutex_lock(&(m->mutex));
+    release_unjournalled(m, n_recorded);
+    pthread_mutex_unlock(&(m->mutex));
+
+    xmlBufferFree(buffer);
+    free(journal_file);
+    journal_file = NULL;
 
     return 0; //success
 }
 
-
-#define TIME_STR_SIZE 256   /*!< size of ISO 8601 time string */
 /*!
+ * Write a journal record of a model to an xmlTextWriterPtr object
  *
- * Write load history to the xmlTextWriterPtr
- *
- * @param   writer  an xmlTextWriter pointer
- * @param   h       pointer to load load history structure
+ * @param   writer      xmlTextWriter pointer
+ * @param   m           pointer to the model
  *
- * @return 0 on success, -1 on failure
+ * @returns 0 on success, -1 on failure
  */
-int write_loadhistory_xtwp(xmlTextWriterPtr writer, struct pmm_loadhistory *h)
+int
+write_journal_record_xtwp(xmlTextWriterPtr writer, struct pmm_model *m)
 {
     int rc;
     int i;
-    char time_str[TIME_STR_SIZE+1] = "";
-    struct tm time_tm;
 
-    // start document with standard version/enconding
     rc = xmlTextWriterStartDocument(writer, NULL, "ISO-8859-1", NULL);
     if (rc < 0) {
         ERRPRINTF("Error @ xmlTextWriterStartDocument\n");
         return rc;
     }
 
-    // start root element loadhistory
-    rc = xmlTextWriterStartElement(writer, BAD_CAST "loadhistory");
+    rc = xmlTextWriterStartElement(writer, BAD_CAST "journal_record");
     if (rc < 0) {
-        ERRPRINTF("Error @ xmlTextWriterStartElement (loadhistory)\n");
+        ERRPRINTF("Error @ xmlTextWriterStartElement (journal_record)\n");
         return rc;
     }
 
-    i = h->start_i;
-    while(i != h->end_i) {
-
-        // Start an element named load as child of loadhistory.
-        rc = xmlTextWriterStartElement(writer, BAD_CAST "load");
-        if (rc < 0) {
-            ERRPRINTF("Error @ xmlTextWriterStartElement (load)\n");
-            return rc;
-        }
-
-        // convert time_t value to ISO 8601
-        localtime_r(&(h->history[i].time), &time_tm);
-        if(0 == strftime(time_str, TIME_STR_SIZE,
-                         "%Y-%m-%dT%H:%M:%S%z",
-                         &time_tm))
-        {
-            ERRPRINTF("Error converting time_t to ISO 8601 string.\n");
-            return -1;
-        }
-
-        // Add an element with name "time" and value to load.
-        rc = xmlTextWriterWriteFormatElement(writer, BAD_CAST "time",
-                "%s", time_str);
-        if (rc < 0) {
-            ERRPRINTF("Error @ xmlTextWriterWriteFormatElement (time)\n");
-            return rc;
-        }
-
-        // Add a comment with the human readable version of the time value
-        //rc = xmlTextWriterWriteFormatComment(writer, "%s",
-        //      ctime((time_t*)&(h->history[i].time)));
-        //if(rc < 0) {
-        //  ERRPRINTF("Error @ xmlTextWriterFormatComment (time)\n");
-        //  return rc;
-        //}
-
-
-        // Add an element with name one_min and value to load
-        rc = xmlTextWriterWriteFormatElement(writer, BAD_CAST "one_min",
-                "%f", h->history[i].load[0]);
-        if (rc < 0) {
-            ERRPRINTF("Error @ xmlTextWriterWriteFormatElement (one_min)\n");
-            return rc;
-        }
-        // Add an element with name five_min and value to load
-        rc = xmlTextWriterWriteFormatElement(writer, BAD_CAST "five_min",
-                "%f", h->history[i].load[1]);
-        if (rc < 0) {
-            ERRPRINTF("Error @ xmlTextWriterWriteFormatElement (five_min)\n");
-            return rc;
-        }
-        // Add an element with name fifteen_min and value to load
-        rc = xmlTextWriterWriteFormatElement(writer, BAD_CAST "fifteen_min",
-                "%f", h->history[i].load[2]);
-        if (rc < 0) {
-            ERRPRINTF("Error @ xmlTextWriterWriteFormatElement (fifteen_min)\n");
-            return rc;
-        }
+    // the sequence number must come first, it decides if the record is
+    // replayed at all
+    rc = xmlTextWriterWriteFormatElement(writer, BAD_CAST "sequence",
+            "%lu", m->journal_seq + 1);
+    if (rc < 0) {
+        ERRPRINTF("Error @ xmlTextWriterWriteFormatElement (sequence)\n");
+        return rc;
+    }
 
-        // Close the load element.
-        rc = xmlTextWriterEndElement(writer);
-        if (rc < 0) {
-            ERRPRINTF("Error @ xmlTextWriterEndElement\n");
+    for(i=0; i<m->n_unjournalled; i++) {
+        rc = write_benchmark_xtwp(writer, m->unjournalled[i]);
+        if(rc < 0) {
+            ERRPRINTF("Error in write_benchmark_xtwp.\n");
             return rc;
         }
+    }
 
-        i = (i + 1) % h->size_mod;
+    rc = xmlTextWriterWriteFormatElement(writer, BAD_CAST "complete",
+            "%d", m->complete);
+    if (rc < 0) {
+        ERRPRINTF("Error @ xmlTextWriterWriteFormatElement (complete)\n");
+        return rc;
+    }
 
+    rc = write_interval_list_xtwp(writer, m->interval_list);
+    if(rc < 0) {
+        ERRPRINTF("Error in write_interval_list_xtwp.\n");
+        return rc;
     }
 
-    // Close the root element named loadhistory (and all other open tags).
+    // Close the journal_record element (and all other open tags).
     rc = xmlTextWriterEndDocument(writer);
     if (rc < 0) {
         ERRPRINTF("Error @ xmlTextWriterEndDocument\n");
@@ -2244,251 +4057,265 @@ int write_loadhistory_xtwp(xmlTextWriterPtr writer, struct pmm_loadhistory *h)
 }
 
 /*!
- * Check if a file descriptor is locked
+ * Replay the journal of a model, applying the records that are newer than
+ * the model file to the model. Replay stops at a record that was cut short,
+ * as a crash while appending to the journal leaves.
  *
- * @param   fd  the file descriptor to check
- * @param   type    the type of lock to test FD_WRLCK, FD_RDLCK, FD_RWLCK
+ * @param   m   pointer to the model, already holding the model file contents
+ *              or an initialised bench list
  *
- * @return -1 on error, 0 if file is not locked, pid of owning process if file
- * is locked
+ * @return 0 on success (including when the model has no journal), -1 on
+ * failure
  */
-int check_lock(int fd, int type)
+int
+replay_model_journal(struct pmm_model *m)
 {
-    struct flock fl;
-
-    fl.l_type = type;
-    fl.l_whence = SEEK_SET;
-    fl.l_start = 0;
-    fl.l_len = 0;
-    fl.l_pid = 0;
+    char *journal_file;
+    char *buf, *end;
+    long off, len;
+    ssize_t n;
+    int journal_fd;
+    int replayed;
+    struct stat file_stats;
+    xmlDocPtr doc;
 
-    if(fcntl(fd, F_GETLK, &fl) == -1) {
-        ERRPRINTF("Error checking lock status on fd: %d\n", fd);
-        perror("fcntl\n");
+    journal_file = model_journal_path(m);
+    if(journal_file == NULL) {
+        ERRPRINTF("Error getting journal path of model: %s\n", m->model_path);
         return -1;
     }
 
+    journal_fd = open(journal_file, O_RDONLY);
+    if(journal_fd < 0) {
+        if(errno == ENOENT) { //no journal, nothing to replay
+            free(journal_file);
+            journal_file = NULL;
 
-    if(fl.l_type == F_UNLCK) {
-        return 0;
-    }
-    else {
-        return fl.l_pid;
-    }
-}
-
-/*!
- * write all models in the configuration
- *
- * @param   cfg     pointer to the configuration
- *
- * @return 0 on success, -1 on failure
- */
-int
-write_models(struct pmm_config *cfg)
-{
-    int i;
-    int ret = 0;
-
-    LOGPRINTF("Writing models to disk.\n");
-
+            m->journal_size = 0;
 
-    for(i=0; i<cfg->used; i++) {
-        if(write_model(cfg->routines[i]->model) < 0) {
-            ERRPRINTF("Error writing model for routine: %s.\n",
-                      cfg->routines[i]->name);
-            ret = -1;
+            return 0;
         }
-    }
-
-    return ret;
-}
-
-/*!
- * write an individual model to disk
- *
- * @param   m   pointer to the model
- *
- * @return 0 on success, -1 on failure
- */
-int
-write_model(struct pmm_model *m)
-{
-    char *temp_file;
-
-    int rc;
-    xmlTextWriterPtr writer;
-    xmlOutputBufferPtr output_buffer;
-
-    struct flock fl;
-    int temp_fd, model_fd;
-
-    DBGPRINTF("writing model file: %s\n", m->model_path);
 
-    // create file name for mkstemp
-    if(asprintf(&temp_file, "%s.XXXXXX", m->model_path)
-       > PATH_MAX)
-    {
-        ERRPRINTF("filename too long: %s\n", temp_file);
+        ERRPRINTF("Error opening journal: %s\n", journal_file);
+        perror("open");
 
-        free(temp_file);
-        temp_file = NULL;
-        return -1; //fail
-    }
+        free(journal_file);
+        journal_file = NULL;
 
-    //open temp file
-    temp_fd = mkstemp(temp_file);
-    if(temp_fd == -1) {
-        ERRPRINTF("Error opening temp file for writing: %s\n", temp_file);
-        perror("mkstemp");
-        return -1; //fail
+        return -1;
     }
 
+    if(fstat(journal_fd, &file_stats) < 0) {
+        ERRPRINTF("Error getting size of journal: %s\n", journal_file);
+        perror("fstat");
 
-    //create output buffer
-    output_buffer = xmlOutputBufferCreateFd(temp_fd, NULL);
-    if(output_buffer == NULL) {
-        ERRPRINTF("Error creating xml output buffer.\n");
-
-        unlink(temp_file);
-        close(temp_fd);
-        free(temp_file);
-        temp_file = NULL;
+        close(journal_fd);
+        free(journal_file);
+        journal_file = NULL;
 
-        return -1; //fail
+        return -1;
     }
 
-    //create xml writer
-    writer = xmlNewTextWriter(output_buffer);
-    if (writer == NULL) {
-        ERRPRINTF("Error creating the xml writer\n");
+    buf = malloc(file_stats.st_size + 1);
+    if(buf == NULL) {
+        ERRPRINTF("Error allocating memory for journal: %s\n", journal_file);
 
-        unlink(temp_file);
-        close(temp_fd);
-        free(temp_file);
-        temp_file = NULL;
+        close(journal_fd);
+        free(journal_file);
+        journal_file = NULL;
 
-        return -1; //fail
+        return -1;
     }
 
-    rc = xmlTextWriterSetIndent(writer, 1);
-    if(rc < 0) {
-        ERRPRINTF("Error setting indent\n");
+    off = 0;
+    while(off < file_stats.st_size) {
+        n = read(journal_fd, &(buf[off]), file_stats.st_size - off);
+        if(n < 0 && errno == EINTR) {
+            continue;
+        }
+        if(n <= 0) {
+            break;
+        }
+        off += n;
+    }
+    buf[off] = '\0';
 
-        xmlFreeTextWriter(writer);
-        unlink(temp_file);
-        close(temp_fd);
-        free(temp_file);
-        temp_file = NULL;
+    close(journal_fd);
 
-        return -1;
-    }
+    // the size of what was read, a journal may be appended to meanwhile
+    m->journal_size = off;
 
-    //write model
-    rc = write_model_xtwp(writer, m);
-    if(rc < 0) {
-        ERRPRINTF("Error writing model, partial model saved in: %s\n",
-                   temp_file);
+    replayed = 0;
+    off = 0;
+    while(off < m->journal_size) {
+        len = strtol(&(buf[off]), &end, 10);
+        if(end == &(buf[off]) || *end != '\n' || len <= 0 ||
+           len > m->journal_size - (end + 1 - buf))
+        {
+            break; //record cut short
+        }
 
-        xmlFreeTextWriter(writer);
-        close(temp_fd);
-        free(temp_file);
-        temp_file = NULL;
+        doc = xmlReadMemory(end + 1, len, journal_file, NULL,
+                            XML_PARSE_NOBLANKS);
+        if(doc == NULL) {
+            break; //record cut short
+        }
 
-        return -1;
-    }
+        if(apply_journal_record(m, doc) < 0) {
+            ERRPRINTF("Error applying record at offset %ld of journal: %s\n",
+                      off, journal_file);
 
-    xmlFreeTextWriter(writer);
+            xmlFreeDoc(doc);
+            free(buf);
+            buf = NULL;
+            free(journal_file);
+            journal_file = NULL;
 
-    if(fsync(temp_fd) < 0) {
-        ERRPRINTF("Error syncing data for file, remove:%s manually.\n",
-                  temp_file);
-        perror("fsync");
+            return -1;
+        }
 
-        close(temp_fd);
-        free(temp_file);
-        temp_file = NULL;
+        xmlFreeDoc(doc);
 
-        return -1;
+        replayed++;
+        off = (end + 1 - buf) + len;
+    }
 
+    if(off < m->journal_size) {
+        LOGPRINTF("Ignoring incomplete record at end of journal: %s\n",
+                  journal_file);
     }
 
-    //close temp file
-    if(close(temp_fd) < 0) {
-        ERRPRINTF("Error closing file, remove:%s manually\n", temp_file);
+    DBGPRINTF("Read %d records from journal: %s\n", replayed, journal_file);
 
-        free(temp_file);
-        temp_file = NULL;
-        return -1;
-    }
+    free(buf);
+    buf = NULL;
+    free(journal_file);
+    journal_file = NULL;
 
-    //open model file
-    model_fd = open(m->model_path, O_WRONLY|O_CREAT, S_IRWXU);
-    if(model_fd < 0) {
-        ERRPRINTF("Error opening model file: %s.\n", m->model_path);
+    return 0; //success
+}
 
-        free(temp_file);
-        temp_file = NULL;
+/*!
+ * Apply a journal record to a model, if the model does not already contain
+ * it. The benchmarks of the record are inserted into the model and the
+ * complete state and the interval stack of the model are replaced by those
+ * of the record.
+ *
+ * @param   m       pointer to the model
+ * @param   doc     pointer to the xml document of the record
+ *
+ * @return 0 on success, -1 on failure
+ */
+int
+apply_journal_record(struct pmm_model *m, xmlDocPtr doc)
+{
+    xmlNodePtr root, cnode;
+    char *key;
+    unsigned long seq;
+    struct pmm_benchmark *b;
 
+    root = xmlDocGetRootElement(doc);
+    if(root == NULL ||
+       xmlStrcmp(root->name, (const xmlChar *) "journal_record"))
+    {
+        ERRPRINTF("Journal record has wrong type.\n");
         return -1;
     }
 
-    //set up a write lock
-    fl.l_type = F_WRLCK;
-    fl.l_whence = SEEK_SET;
-    fl.l_start = 0;
-    fl.l_len = 0;
-    fl.l_pid = 0;
-
-    //get write lock on model file so reading processes will block
-    if(fcntl(model_fd, F_SETLKW, &fl) == -1) {
-        ERRPRINTF("Error aquiring lock on model file: %s\n", m->model_path);
-        perror("fcntl");
-
-        close(model_fd);
-        free(temp_file);
-        temp_file = NULL;
+    cnode = root->xmlChildrenNode;
 
+    // first node must be the sequence number
+    if(cnode == NULL ||
+       xmlStrcmp(cnode->name, (const xmlChar *) "sequence"))
+    {
+        ERRPRINTF("First element of journal record must be sequence.\n");
         return -1;
     }
 
-    //rename temp file to model file
-    //TODO if we port to windows, this will not work
-    if(rename(temp_file, m->model_path) < 0) {
-        ERRPRINTF("Error renaming %s to %s, leaving %s on filesystem\n",
-                  temp_file, m->model_path, temp_file);
-
-        close(model_fd);
-        free(temp_file);
-        temp_file = NULL;
+    key = (char *)xmlNodeListGetString(doc, cnode->xmlChildrenNode, 1);
+    seq = strtoul(key, NULL, 10);
+    free(key);
+    key = NULL;
 
-        return -1;
+    if(seq <= m->journal_seq) {
+        return 0; //model file already holds this record
     }
 
-    free(temp_file);
-    temp_file = NULL;
+    cnode = cnode->next;
 
-    //close and free lock
-    if(close(model_fd) < 0) {
-        ERRPRINTF("Error closing file: %s\n.", m->model_path);
+    while(cnode != NULL) {
 
-        return -1;
-    }
+        if(!xmlStrcmp(cnode->name, (const xmlChar *) "benchmark")) {
 
+            b = parse_benchmark(m->bench_list, doc, cnode);
+            if(b == NULL) {
+                ERRPRINTF("Error parsing benchmark.\n");
+                return -1;
+            }
 
-    //sync dir so we are sure everything is committed to the filesystem
-    if(sync_parent_dir(m->model_path) < 0) {
-        ERRPRINTF("Error syncing parent dir of: %s.\n", m->model_path);
+            if(insert_bench_into_list(m->bench_list, b) < 0) {
+                free_benchmark(&b);
+                ERRPRINTF("Error inserting bench into bench list.\n");
+                return -1;
+            }
+        }
+        else if(!xmlStrcmp(cnode->name, (const xmlChar *) "complete")) {
+            key = (char *)xmlNodeListGetString(doc, cnode->xmlChildrenNode, 1);
+            m->complete = atoi(key);
+            free(key);
+            key = NULL;
+        }
+        else if(!xmlStrcmp(cnode->name, (const xmlChar *) "interval_list")) {
 
-        return -1;
+            free_interval_list(&(m->interval_list));
+            m->interval_list = new_interval_list();
+
+            if(parse_interval_list(m, doc, cnode) < 0) {
+                ERRPRINTF("Error parsing interval list.\n");
+                return -1;
+            }
+        }
+
+        cnode = cnode->next;
     }
 
-    m->unwritten_num_execs = 0;
-    m->unwritten_time_spend = 0;
+    m->journal_seq = seq;
 
     return 0; //success
 }
 
+/*!
+ * write a buffer to a file descriptor, retrying partial writes
+ *
+ * @param   fd      file descriptor
+ * @param   buf     pointer to the buffer
+ * @param   len     number of bytes to write
+ *
+ * @return 0 on success, -1 on failure
+ */
+int
+write_fd_fully(int fd, const char *buf, size_t len)
+{
+    ssize_t n;
+
+    while(len > 0) {
+        n = write(fd, buf, len);
+        if(n < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+
+            perror("write");
+            return -1;
+        }
+
+        buf += n;
+        len -= n;
+    }
+
+    return 0;
+}
+
 /*!
  * attempt to sync and close an open file descriptor.
  *
@@ -2591,7 +4418,6 @@ sync_parent_dir(char *file_path)
 int write_model_xtwp(xmlTextWriterPtr writer, struct pmm_model *m)
 {
     int rc;
-    struct pmm_interval *i;
 
     // start document with standard version/enconding
     rc = xmlTextWriterStartDocument(writer, NULL, "ISO-8859-1", NULL);
@@ -2631,8 +4457,22 @@ int write_model_xtwp(xmlTextWriterPtr writer, struct pmm_model *m)
         return rc;
     }
 
-    // write the parameter definitions from the parent routine
-    rc = write_paramdef_set_xtwp(writer, m->parent_routine->pd_set);
+    // Add the sequence number of the last journal record the model contains
+    rc = xmlTextWriterWriteFormatElement(writer, BAD_CAST "journal_sequence",
+            "%lu", m->journal_seq);
+    if (rc < 0) {
+        ERRPRINTF("Error @ xmlTextWriterWriteFormatElement "
+                  "(journal_sequence)\n");
+        return rc;
+    }
+
+    // write the parameter definitions from the parent routine, or those
+    // read with the model
+    if(get_model_paramdef_set(m) == NULL) {
+        ERRPRINTF("Model has no parameter definitions.\n");
+        return -1;
+    }
+    rc = write_paramdef_set_xtwp(writer, get_model_paramdef_set(m));
     if(rc < 0) {
         ERRPRINTF("Error in write_paramdef_set_xtwp.\n");
         return rc;
@@ -2645,6 +4485,38 @@ int write_model_xtwp(xmlTextWriterPtr writer, struct pmm_model *m)
         return rc;
     }
 
+    // write the interval list
+    rc = write_interval_list_xtwp(writer, m->interval_list);
+    if(rc < 0) {
+        ERRPRINTF("Error in write_interval_list_xtwp.\n");
+        return rc;
+    }
+
+    // Close the root element named model (and all other open tags).
+    rc = xmlTextWriterEndDocument(writer);
+    if (rc < 0) {
+        ERRPRINTF("Error @ xmlTextWriterEndDocument\n");
+        return rc;
+    }
+
+    return 0; //success
+}
+
+/*!
+ * Write an interval list to an xmlTextWriterPtr object, from the top of the
+ * stack to the bottom
+ *
+ * @param   writer      xmlTextWriter pointer
+ * @param   il          pointer to the interval list
+ *
+ * @returns 0 on success, -1 on failure
+ */
+int write_interval_list_xtwp(xmlTextWriterPtr writer,
+                             struct pmm_interval_list *il)
+{
+    int rc;
+    struct pmm_interval *i;
+
     // start interval_list element
     rc = xmlTextWriterStartElement(writer, BAD_CAST "interval_list");
     if (rc < 0) {
@@ -2652,7 +4524,7 @@ int write_model_xtwp(xmlTextWriterPtr writer, struct pmm_model *m)
         return rc;
     }
 
-    i = m->interval_list->top;
+    i = il->top;
     while(i != NULL) {
 
         rc = write_interval_xtwp(writer, i);
@@ -2672,13 +4544,6 @@ int write_model_xtwp(xmlTextWriterPtr writer, struct pmm_model *m)
         return rc;
     }
 
-    // Close the root element named model (and all other open tags).
-    rc = xmlTextWriterEndDocument(writer);
-    if (rc < 0) {
-        ERRPRINTF("Error @ xmlTextWriterEndDocument\n");
-        return rc;
-    }
-
     return 0; //success
 }
 
@@ -2815,6 +4680,16 @@ write_paramdef_set_xtwp(xmlTextWriterPtr writer,
         }
     }
 
+    if(pd_set->complexity_formula != NULL) {
+        // add an element with name "complexity" and value of the formula
+        rc = xmlTextWriterWriteFormatElement(writer, BAD_CAST "complexity",
+                "%s", pd_set->complexity_formula);
+        if (rc < 0) {
+            ERRPRINTF("Error @ xmlTextWriterWriteFormatElement (complexity)\n");
+            return rc;
+        }
+    }
+
     // Close the parameters element.
     rc = xmlTextWriterEndElement(writer);
     if (rc < 0) {
@@ -3054,6 +4929,23 @@ write_benchmark_xtwp(xmlTextWriterPtr writer, struct pmm_benchmark *b)
         return rc;
     }
 
+    // placement is only recorded if the benchmark was pinned or reniced
+    if(b->cpuset != NULL || b->numa_node != -1 || b->nice != 0) {
+        rc = write_placement_xtwp(writer, b);
+        if(rc < 0) {
+            ERRPRINTF("Error writing placement.\n");
+            return rc;
+        }
+    }
+
+    if(b->n_metrics > 0) {
+        rc = write_metrics_xtwp(writer, b);
+        if(rc < 0) {
+            ERRPRINTF("Error writing metrics.\n");
+            return rc;
+        }
+    }
+
     // Close the benchmark element.
     rc = xmlTextWriterEndElement(writer);
     if (rc < 0) {
@@ -3064,6 +4956,114 @@ write_benchmark_xtwp(xmlTextWriterPtr writer, struct pmm_benchmark *b)
     return 0; //success
 }
 
+/*!
+ * Write the placement of a benchmark to an xmlTextWriterPtr object
+ *
+ * @param   writer  xmlTextWriter pointer
+ * @param   b       pointer to the benchmark
+ *
+ * @return 0 on success -1 on error
+ */
+int
+write_placement_xtwp(xmlTextWriterPtr writer, struct pmm_benchmark *b)
+{
+    int rc;
+
+    rc = xmlTextWriterStartElement(writer, BAD_CAST "placement");
+    if (rc < 0) {
+        ERRPRINTF("Error @ xmlTextWriterStartElement (placement)\n");
+        return rc;
+    }
+
+    if(b->cpuset != NULL) {
+        rc = xmlTextWriterWriteFormatElement(writer, BAD_CAST "cpuset",
+                "%s", b->cpuset);
+        if (rc < 0) {
+            ERRPRINTF("Error @ xmlTextWriterWriteFormatElement (cpuset)\n");
+            return rc;
+        }
+    }
+
+    rc = xmlTextWriterWriteFormatElement(writer, BAD_CAST "numa_node",
+            "%d", b->numa_node);
+    if (rc < 0) {
+        ERRPRINTF("Error @ xmlTextWriterWriteFormatElement (numa_node)\n");
+        return rc;
+    }
+
+    rc = xmlTextWriterWriteFormatElement(writer, BAD_CAST "nice",
+            "%d", b->nice);
+    if (rc < 0) {
+        ERRPRINTF("Error @ xmlTextWriterWriteFormatElement (nice)\n");
+        return rc;
+    }
+
+    rc = xmlTextWriterEndElement(writer);
+    if (rc < 0) {
+        ERRPRINTF("Error @ xmlTextWriterEndElement\n");
+        return rc;
+    }
+
+    return 0;
+}
+
+/*!
+ * Write the additional metrics of a benchmark to an xmlTextWriterPtr object
+ *
+ * @param   writer  xmlTextWriter pointer
+ * @param   b       pointer to the benchmark
+ *
+ * @return 0 on success -1 on error
+ */
+int
+write_metrics_xtwp(xmlTextWriterPtr writer, struct pmm_benchmark *b)
+{
+    int rc;
+    int i;
+
+    rc = xmlTextWriterStartElement(writer, BAD_CAST "metrics");
+    if (rc < 0) {
+        ERRPRINTF("Error @ xmlTextWriterStartElement (metrics)\n");
+        return rc;
+    }
+
+    for(i=0; i<b->n_metrics; i++) {
+        rc = xmlTextWriterStartElement(writer, BAD_CAST "metric");
+        if (rc < 0) {
+            ERRPRINTF("Error @ xmlTextWriterStartElement (metric)\n");
+            return rc;
+        }
+
+        rc = xmlTextWriterWriteFormatElement(writer, BAD_CAST "name",
+                "%s", b->metrics[i].name);
+        if (rc < 0) {
+            ERRPRINTF("Error @ xmlTextWriterWriteFormatElement (name)\n");
+            return rc;
+        }
+
+        rc = xmlTextWriterWriteFormatElement(writer, BAD_CAST "value",
+                "%.17g", b->metrics[i].value);
+        if (rc < 0) {
+            ERRPRINTF("Error @ xmlTextWriterWriteFormatElement (value)\n");
+            return rc;
+        }
+
+        rc = xmlTextWriterEndElement(writer);
+        if (rc < 0) {
+            ERRPRINTF("Error @ xmlTextWriterEndElement\n");
+            return rc;
+        }
+    }
+
+    rc = xmlTextWriterEndElement(writer);
+    if (rc < 0) {
+        ERRPRINTF("Error @ xmlTextWriterEndElement\n");
+        return rc;
+    }
+
+    return 0;
+}
+
 /*!
  * Write a timeval to an xmlTextWriterPtr object
  *
@@ -3098,10 +5098,22 @@ write_timeval_xtwp(xmlTextWriterPtr writer, struct timeval *t)
 }
 
 /*!
- * initialized libxml2 parser
+ * initialized libxml2 parser, only the first call in a process has an
+ * effect so it may be called wherever parsing is about to start
  */
 void
 xmlparser_init()
+{
+    static pthread_once_t once = PTHREAD_ONCE_INIT;
+
+    pthread_once(&once, xmlparser_init_once);
+}
+
+/*!
+ * initialize libxml2 parser, called once only by xmlparser_init
+ */
+void
+xmlparser_init_once()
 {
     xmlInitParser();
 }
@@ -33,12 +33,18 @@ int parse_config(struct pmm_config *cfg);
 int parse_history(struct pmm_loadhistory *h);
 int parse_model(struct pmm_model *m);
 int parse_models(struct pmm_config *c);
+int load_model(struct pmm_model *m);
+int load_models(struct pmm_model **models, int n,
+                int (*load)(struct pmm_model *m), int *rc);
 
 int write_loadhistory(struct pmm_loadhistory *h);
 int write_loadhistory_xtwp(xmlTextWriterPtr writer, struct pmm_loadhistory *h);
 int write_models(struct pmm_config *cfg);
 int write_model(struct pmm_model *m);
 int write_model_xtwp(xmlTextWriterPtr writer, struct pmm_model *m);
+char* model_journal_path(struct pmm_model *m);
+int append_model_journal(struct pmm_model *m);
+int replay_model_journal(struct pmm_model *m);
 int write_bench_list_xtwp(xmlTextWriterPtr writer,
                           struct pmm_bench_list *bench_list);
 int write_benchmark_xtwp(xmlTextWriterPtr writer, struct pmm_benchmark *b);
@@ -50,6 +56,8 @@ write_paramdef_xtwp(xmlTextWriterPtr writer, struct pmm_paramdef *pd);
 
 int
 write_parameter_array_xtwp(xmlTextWriterPtr writer, int *p, int n);
+int write_interval_list_xtwp(xmlTextWriterPtr writer,
+                             struct pmm_interval_list *il);
 int write_interval_xtwp(xmlTextWriterPtr writer, struct pmm_interval *i);
 int write_timeval_xtwp(xmlTextWriterPtr writer, struct timeval *t);
 
@@ -38,7 +38,6 @@
 
 
 #include "pmm_model.h"
-#include "pmm_octave.h"
 #include "pmm_cfgparser.h"
 #include "pmm_log.h"
 #include "pmm_param.h"
@@ -157,9 +156,7 @@ correlate_models(struct pmm_model *approx_model, struct pmm_model *base_model)
     int **base_points;
 
     struct pmm_benchmark *b, *b_avg;
-    struct pmm_octave_data *oct_data;
-
-    octave_init();
+    struct pmm_delaunay *tri;
 
     b = base_model->bench_list->first;
 
@@ -167,19 +164,15 @@ correlate_models(struct pmm_model *approx_model, struct pmm_model *base_model)
 
     base_points = malloc(n * sizeof *base_points);
     base_speed = malloc(n * sizeof *base_speed);
+    approx_speed = malloc(n * sizeof *approx_speed);
 
-    if(base_speed == NULL || base_points == NULL) {
+    if(base_speed == NULL || base_points == NULL || approx_speed == NULL) {
         ERRPRINTF("Error allocating memory.\n");
         return -1.0;
     }
 
-    oct_data = fill_octave_input_matrices(approx_model, PMM_ALL);
-    if(oct_data == NULL) {
-        ERRPRINTF("Error preparing octave input data.\n");
-        return -1.0;
-    }
-
-    if(octave_triangulate(oct_data) < 0) {
+    tri = triangulate_model(approx_model, PMM_ALL);
+    if(tri == NULL) {
         ERRPRINTF("Error calcuating triangulation of data.\n");
         return -1.0;
     }
@@ -209,14 +202,14 @@ correlate_models(struct pmm_model *approx_model, struct pmm_model *base_model)
         return -1.0;
     }
 
-    approx_speed = octave_interp_array(oct_data, base_points,
-                                       base_model->n_p, n);
-
-    if(approx_speed == NULL) {
-        ERRPRINTF("Error interpolating approximation\n");
-        return -1.0;
+    for(i=0; i<n; i++) {
+        if(delaunay_interpolate(tri, base_points[i], &approx_speed[i]) < 0) {
+            approx_speed[i] = NAN;
+        }
     }
 
+    free_delaunay(&tri);
+
     correlation = gsl_stats_correlation(base_speed, 1, approx_speed, 1, n);
 
     for(j=0; j<base_model->n_p; j++)
@@ -255,6 +248,8 @@ main(int argc, char **argv)
 
     struct pmm_comp_options opts;
     struct pmm_model *approx_model, *base_model;
+    struct pmm_model *models[2];
+    int load_rc[2];
     int ret;
 
     double correlation;
@@ -281,7 +276,16 @@ main(int argc, char **argv)
     xmlparser_init();
 
 
-    ret = parse_model(approx_model);
+    // parse the two model files concurrently
+    models[0] = approx_model;
+    models[1] = base_model;
+
+    if(load_models(models, 2, parse_model, load_rc) < 0) {
+        ERRPRINTF("Error loading models.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    ret = load_rc[0];
     if(ret == -1) {
         ERRPRINTF("Error file does not exist:%s\n", approx_model->model_path);
         exit(EXIT_FAILURE);
@@ -291,7 +295,7 @@ main(int argc, char **argv)
         exit(EXIT_FAILURE);
     }
 
-    ret = parse_model(base_model);
+    ret = load_rc[1];
     if(ret == -1) {
         ERRPRINTF("Error file does not exist:%s\n", base_model->model_path);
         exit(EXIT_FAILURE);
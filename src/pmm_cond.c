@@ -37,12 +37,15 @@
 #include <sys/stat.h>       // for stat
 #include <unistd.h>         // for stat
 #include <sys/param.h>      // for MAXPATHLEN
+#include <time.h>           // for clock_gettime, localtime_r, mktime
 
 #include "pmm_model.h"
 #include "pmm_cond.h"
 
 int ttystat(char *line, int sz);
 int num_users();
+time_t time_of_day(time_t now, int days, int secs);
+time_t cond_time_now();
 
 /*!
  * checks that the tty a user is logged into (as per utmp) exists in /dev
@@ -157,6 +160,107 @@ int cond_idle() {
     }
 }
 
+/*!
+ * test system for idleness while benchmarks are executing. The load of the
+ * benchmarks themselves is allowed for by permitting one runnable process per
+ * active (not paused) benchmark on top of the idle threshold. The 1 minute
+ * load is used so that a change in load is detected promptly.
+ *
+ * @param   n_active    number of benchmarks executing and not paused
+ *
+ * @return 0 if not idle, 1 if idle
+ */
+int
+cond_idle_running(int n_active)
+{
+    double loadavg[3];
+
+    if(!getloadavg(loadavg, 3)) {
+        printf("Error, could not retreive system load averages.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if(loadavg[0] < n_active + 0.10) {
+        return 1;
+    }
+    else {
+        return 0;
+    }
+}
+
+/*!
+ * get the current time for testing time conditions. This reads the same
+ * clock as the scheduler waits on, time() may lag it slightly, which would
+ * see a time window as still closed when the scheduler wakes for it
+ *
+ * @return the current time
+ */
+time_t
+cond_time_now()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    return ts.tv_sec;
+}
+
+/*!
+ * find the absolute time of a time of day, some days after the day of a
+ * given time. mktime is used so that daylight saving changes are respected
+ *
+ * @param   now     reference time
+ * @param   days    number of days after the day of now
+ * @param   secs    time of day in seconds after midnight
+ *
+ * @return the absolute time
+ */
+time_t
+time_of_day(time_t now, int days, int secs)
+{
+    struct tm tm_t;
+
+    localtime_r(&now, &tm_t);
+
+    tm_t.tm_mday += days;
+    tm_t.tm_hour = secs/3600;
+    tm_t.tm_min = (secs%3600)/60;
+    tm_t.tm_sec = secs%60;
+    tm_t.tm_isdst = -1;
+
+    return mktime(&tm_t);
+}
+
+/*!
+ * test if a time lies inside the daily window of a periodic routine. A
+ * window whose end is before its start wraps over midnight, a window whose
+ * start and end are equal spans the whole day
+ *
+ * @param   r       pointer to the routine
+ * @param   now     time to test
+ *
+ * @return 1 if the time is inside the window, 0 if not
+ */
+int
+cond_periodic(struct pmm_routine *r, time_t now)
+{
+    struct tm tm_t;
+    int secs;
+
+    localtime_r(&now, &tm_t);
+    secs = tm_t.tm_hour*3600 + tm_t.tm_min*60 + tm_t.tm_sec;
+
+    if(r->period_start == r->period_end) {
+        return 1;
+    }
+    else if(r->period_start < r->period_end) {
+        return secs >= r->period_start && secs < r->period_end;
+    }
+    else {
+        return secs >= r->period_start || secs < r->period_end;
+    }
+}
+
 /*!
  * check if conditions for execution of a routine are satisfied and
  * set executable parameter of routine accordingly
@@ -169,7 +273,6 @@ int cond_idle() {
 int
 check_conds(struct pmm_routine *r)
 {
-    // TODO add CC_UNTIL and CC_PERIODIC to this function ...
     // TODO permit multiple conditions in one routine
     // TODO permit system wide conditions applicable to all routines
     //
@@ -178,6 +281,16 @@ check_conds(struct pmm_routine *r)
         r->executable = 1;
 
     }
+    else if(r->condition == CC_UNTIL) {
+        if(cond_time_now() < r->until) {
+            r->executable = 1;
+        }
+    }
+    else if(r->condition == CC_PERIODIC) {
+        if(cond_periodic(r, cond_time_now())) {
+            r->executable = 1;
+        }
+    }
     else if(r->condition == CC_IDLE) {
         if(cond_idle()) {
             r->executable = 1;
@@ -192,3 +305,71 @@ check_conds(struct pmm_routine *r)
     return r->executable;
 }
 
+/*!
+ * find the time at which the conditions of a routine that are not
+ * satisfied now will next be satisfied. Conditions that depend only on the
+ * clock can be waited for exactly, others must be polled
+ *
+ * @param   r       pointer to the routine
+ * @param   now     current time
+ *
+ * @return time the conditions are next satisfied, 0 if the conditions must
+ * be polled or (time_t)-1 if they will never be satisfied again
+ */
+time_t
+next_cond_time(struct pmm_routine *r, time_t now)
+{
+    time_t t;
+
+    switch(r->condition) {
+        case CC_NOW:
+            return now;
+        case CC_UNTIL:
+            return now < r->until ? now : (time_t)-1;
+        case CC_PERIODIC:
+            if(cond_periodic(r, now)) {
+                return now;
+            }
+
+            t = time_of_day(now, 0, r->period_start);
+            if(t <= now) {
+                t = time_of_day(now, 1, r->period_start);
+            }
+            return t;
+        case CC_IDLE:
+        case CC_NOUSERS:
+            return 0;
+        default:
+            return (time_t)-1;
+    }
+}
+
+/*!
+ * check if the conditions for execution of a routine still hold while a
+ * benchmark of the routine is executing. Unlike check_conds() the executable
+ * toggle of the routine is not modified.
+ *
+ * @param   r           pointer to the routine
+ * @param   n_active    number of benchmarks executing and not paused,
+ *                      including that of the routine if it is not paused
+ *
+ * @return 0 if the conditions do not hold, 1 if they do
+ */
+int
+check_running_conds(struct pmm_routine *r, int n_active)
+{
+    switch(r->condition) {
+        case CC_NOW:
+            return 1;
+        case CC_UNTIL:
+            return cond_time_now() < r->until;
+        case CC_PERIODIC:
+            return cond_periodic(r, cond_time_now());
+        case CC_IDLE:
+            return cond_idle_running(n_active);
+        case CC_NOUSERS:
+            return !cond_users();
+        default:
+            return 0;
+    }
+}
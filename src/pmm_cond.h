@@ -26,6 +26,11 @@
 
 int cond_users();
 int cond_idle();
+int cond_idle_running(int n_active);
+time_t cond_time_now();
+int cond_periodic(struct pmm_routine *r, time_t now);
 int check_conds(struct pmm_routine *r);
+time_t next_cond_time(struct pmm_routine *r, time_t now);
+int check_running_conds(struct pmm_routine *r, int n_active);
 
 #endif /*PMM_COND_H_*/
@@ -0,0 +1,174 @@
+/*
+    Copyright (C) 2008-2010 Robert Higgins
+        Author: Robert Higgins <robert.higgins@ucd.ie>
+
+    This file is part of PMM.
+
+    PMM is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMM is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+ *
+ * @file pmm_convert.c
+ *
+ * @brief Program to convert model files between formats
+ *
+ * This file contains the pmm_convert program, which reads a model file of
+ * any format, along with its journal, and writes it out in the xml or the
+ * binary model format
+ */
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+
+
+#include "pmm_model.h"
+#include "pmm_cfgparser.h"
+#include "pmm_log.h"
+
+/*!
+ * structure storing options for pmm_convert tool
+ */
+typedef struct pmm_convert_options {
+    enum pmm_model_format format;
+    char *input_file;
+    char *output_file;
+} PMM_Convert_Options;
+
+
+/*!
+ * print command line usage for pmm_convert tool
+ */
+void
+usage()
+{
+    printf("Usage: pmm_convert [-b | -x] input output\n");
+    printf("Options:\n");
+    printf("  -b             : write output in the binary format (default)\n");
+    printf("  -x             : write output in the xml format\n");
+    printf("\n");
+}
+
+/*!
+ * parse arguments for pmm_convert tool
+ *
+ * @param   opts    pointer to options structure
+ * @param   argc    number of command line arguments
+ * @param   argv    command line arguments character array pointer
+ */
+void
+parse_args(struct pmm_convert_options *opts, int argc, char **argv)
+{
+    int c;
+    int option_index;
+
+    opts->format = MF_BINARY;
+    opts->input_file = (void*)NULL;
+    opts->output_file = (void*)NULL;
+
+    while(1) {
+        static struct option long_options[] =
+        {
+            {"binary", no_argument, 0, 'b'},
+            {"xml", no_argument, 0, 'x'},
+            {"help", no_argument, 0, 'h'},
+            {0, 0, 0, 0}
+        };
+
+        option_index = 0;
+
+        c = getopt_long(argc, argv, "bxh", long_options, &option_index);
+
+        // getopt_long returns -1 when arg list is exhausted
+        if(c == -1) {
+            break;
+        }
+
+        switch(c) {
+            case 'b':
+                opts->format = MF_BINARY;
+                break;
+
+            case 'x':
+                opts->format = MF_XML;
+                break;
+
+            case 'h':
+                usage();
+                exit(EXIT_SUCCESS);
+
+            default:
+                usage();
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    if(argc - optind != 2) {
+        fprintf(stderr, "Error: input and output files must be specified.\n");
+        usage();
+        exit(EXIT_FAILURE);
+    }
+
+    opts->input_file = argv[optind];
+    opts->output_file = argv[optind+1];
+
+    return;
+}
+
+int
+main(int argc, char **argv)
+{
+
+    struct pmm_convert_options opts;
+    struct pmm_model *model;
+    int ret;
+
+    parse_args(&opts, argc, argv);
+
+    xmlparser_init();
+
+    model = new_model();
+    if(model == NULL) {
+        ERRPRINTF("Error allocating new model.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    model->model_path = opts.input_file;
+
+    ret = parse_model(model);
+    if(ret == -1) {
+        ERRPRINTF("Error file does not exist:%s\n", model->model_path);
+        exit(EXIT_FAILURE);
+    }
+    else if(ret < -1) {
+        ERRPRINTF("Error parsing model:%s\n", model->model_path);
+        exit(EXIT_FAILURE);
+    }
+
+    // write the model, with any journalled benchmarks, to the output path
+    model->model_path = opts.output_file;
+    model->format = opts.format;
+
+    if(write_model(model) < 0) {
+        ERRPRINTF("Error writing model:%s\n", model->model_path);
+        exit(EXIT_FAILURE);
+    }
+
+    xmlparser_cleanup();
+
+    return 0;
+}
@@ -0,0 +1,1076 @@
+/*
+    Copyright (C) 2008-2010 Robert Higgins
+        Author: Robert Higgins <robert.higgins@ucd.ie>
+
+    This file is part of PMM.
+
+    PMM is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMM is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+ * @file    pmm_delaunay.c
+ * @brief   Delaunay triangulation and interpolation of scattered points
+ *
+ * Points are added to the triangulation one at a time by the Bowyer-Watson
+ * algorithm: the simplices whose circumspheres contain the new point are
+ * removed and the cavity they leave is filled with simplices joining the new
+ * point to the cavity boundary. Points are located by walking from simplex to
+ * neighbouring simplex towards the target, starting from the simplex found by
+ * the previous search, so that searches for nearby points are short.
+ */
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>     // for malloc/free
+#include <string.h>     // for memcpy
+#include <math.h>       // for fabs
+
+#include "pmm_delaunay.h"
+#include "pmm_log.h"
+
+//! distance of the enclosing simplex from the unit box, in box widths
+#define PMM_DELAUNAY_SUPER 1.0e4
+//! tolerance of barycentric coordinates and circumsphere tests
+#define PMM_DELAUNAY_EPS 1.0e-10
+//! relative size of a pivot below which a simplex is taken to be degenerate
+#define PMM_DELAUNAY_SINGULAR 1.0e-13
+//! initial number of simplex slots
+#define PMM_DELAUNAY_INIT_SIMPLICES 64
+
+int
+delaunay_grow_points(struct pmm_delaunay *d);
+int
+delaunay_grow_simplices(struct pmm_delaunay *d);
+int
+delaunay_new_simplex(struct pmm_delaunay *d);
+void
+delaunay_free_simplex(struct pmm_delaunay *d, int s);
+int
+delaunay_geometry(struct pmm_delaunay *d, int s);
+void
+delaunay_barycentric(struct pmm_delaunay *d, int s, double *x, double *lambda);
+int
+delaunay_in_sphere(struct pmm_delaunay *d, int s, double *x);
+void
+delaunay_scale(struct pmm_delaunay *d, int *p, double *x);
+int
+delaunay_insert_scaled(struct pmm_delaunay *d, double *x, double y);
+int
+delaunay_interpolate_scaled(struct pmm_delaunay *d, double *x, double *y);
+
+/*!
+ * Create a new triangulation, holding only the enclosing simplex
+ *
+ * @param   n       number of dimensions
+ * @param   lo      pointer to array of the lower bounds of the box that
+ *                  points will be scaled from
+ * @param   hi      pointer to array of the upper bounds of the box
+ *
+ * @return pointer to a newly allocated triangulation or NULL on failure
+ */
+struct pmm_delaunay*
+new_delaunay(int n, double *lo, double *hi)
+{
+    struct pmm_delaunay *d;
+    int i, j, s;
+    double base, side;
+
+    if(n <= 0) {
+        ERRPRINTF("Number of dimensions must be greater than 0.\n");
+        return NULL;
+    }
+
+    d = malloc(sizeof *d);
+    if(d == NULL) {
+        ERRPRINTF("Error allocating memory.\n");
+        return NULL;
+    }
+
+    d->n = n;
+    d->n_pts = 0;
+    d->pts_capacity = 0;
+    d->x = NULL;
+    d->y = NULL;
+    d->n_simplices = 0;
+    d->simplex_capacity = 0;
+    d->verts = NULL;
+    d->nbrs = NULL;
+    d->inv = NULL;
+    d->centre = NULL;
+    d->r2 = NULL;
+    d->mark = NULL;
+    d->stamp = 0;
+    d->free_slots = NULL;
+    d->n_free = 0;
+    d->work = NULL;
+    d->last = 0;
+    d->version = 0;
+
+    d->lo = malloc(n * sizeof *(d->lo));
+    d->scale = malloc(n * sizeof *(d->scale));
+    d->work = malloc((n*n + 3*n + 1) * sizeof *(d->work));
+    if(d->lo == NULL || d->scale == NULL || d->work == NULL) {
+        ERRPRINTF("Error allocating memory.\n");
+        free_delaunay(&d);
+        return NULL;
+    }
+
+    for(i=0; i<n; i++) {
+        d->lo[i] = lo[i];
+        d->scale[i] = hi[i] > lo[i] ? 1.0/(hi[i] - lo[i]) : 1.0;
+    }
+
+    // the enclosing simplex has one vertex far below the unit box and one
+    // far along each axis from it, so that it contains the box with a wide
+    // margin
+    base = -PMM_DELAUNAY_SUPER;
+    side = 2.0 * n * (1.0 + PMM_DELAUNAY_SUPER);
+
+    for(i=0; i<=n; i++) {
+        if(d->n_pts == d->pts_capacity && delaunay_grow_points(d) < 0) {
+            free_delaunay(&d);
+            return NULL;
+        }
+
+        for(j=0; j<n; j++) {
+            d->x[i*n+j] = base;
+        }
+        if(i > 0) {
+            d->x[i*n+i-1] += side;
+        }
+        d->y[i] = 0.0;
+
+        d->n_pts++;
+    }
+
+    s = delaunay_new_simplex(d);
+    if(s < 0) {
+        free_delaunay(&d);
+        return NULL;
+    }
+
+    for(i=0; i<=n; i++) {
+        d->verts[s*(n+1)+i] = i;
+        d->nbrs[s*(n+1)+i] = -1;
+    }
+
+    if(delaunay_geometry(d, s) < 0) {
+        ERRPRINTF("Enclosing simplex is degenerate.\n");
+        free_delaunay(&d);
+        return NULL;
+    }
+
+    d->last = s;
+
+    return d;
+}
+
+/*!
+ * Free a triangulation
+ *
+ * @param   d   pointer to address of the triangulation
+ */
+void
+free_delaunay(struct pmm_delaunay **d)
+{
+    free((*d)->lo);
+    free((*d)->scale);
+    free((*d)->x);
+    free((*d)->y);
+    free((*d)->verts);
+    free((*d)->nbrs);
+    free((*d)->inv);
+    free((*d)->centre);
+    free((*d)->r2);
+    free((*d)->mark);
+    free((*d)->free_slots);
+    free((*d)->work);
+
+    free(*d);
+    *d = NULL;
+}
+
+/*!
+ * Double the capacity of the point arrays of a triangulation
+ *
+ * @param   d   pointer to the triangulation
+ *
+ * @return 0 on success, -1 on failure
+ */
+int
+delaunay_grow_points(struct pmm_delaunay *d)
+{
+    int capacity;
+    double *x, *y;
+
+    capacity = d->pts_capacity > 0 ? 2*d->pts_capacity : 2*(d->n+1);
+
+    x = realloc(d->x, capacity * d->n * sizeof *x);
+    if(x == NULL) {
+        ERRPRINTF("Error reallocating points.\n");
+        return -1;
+    }
+    d->x = x;
+
+    y = realloc(d->y, capacity * sizeof *y);
+    if(y == NULL) {
+        ERRPRINTF("Error reallocating point values.\n");
+        return -1;
+    }
+    d->y = y;
+
+    d->pts_capacity = capacity;
+
+    return 0;
+}
+
+/*!
+ * Double the capacity of the simplex arrays of a triangulation
+ *
+ * @param   d   pointer to the triangulation
+ *
+ * @return 0 on success, -1 on failure
+ */
+int
+delaunay_grow_simplices(struct pmm_delaunay *d)
+{
+    int capacity, n;
+    void *tmp;
+
+    n = d->n;
+    capacity = d->simplex_capacity > 0 ? 2*d->simplex_capacity
+                                       : PMM_DELAUNAY_INIT_SIMPLICES;
+
+#define PMM_DELAUNAY_REALLOC(a, count) \
+    tmp = realloc((a), (size_t)capacity * (count) * sizeof *(a)); \
+    if(tmp == NULL) { \
+        ERRPRINTF("Error reallocating simplices.\n"); \
+        return -1; \
+    } \
+    (a) = tmp;
+
+    PMM_DELAUNAY_REALLOC(d->verts, n+1);
+    PMM_DELAUNAY_REALLOC(d->nbrs, n+1);
+    PMM_DELAUNAY_REALLOC(d->inv, n*n);
+    PMM_DELAUNAY_REALLOC(d->centre, n);
+    PMM_DELAUNAY_REALLOC(d->r2, 1);
+    PMM_DELAUNAY_REALLOC(d->mark, 1);
+    PMM_DELAUNAY_REALLOC(d->free_slots, 1);
+
+#undef PMM_DELAUNAY_REALLOC
+
+    memset(&(d->mark[d->simplex_capacity]), 0,
+           (capacity - d->simplex_capacity) * sizeof *(d->mark));
+
+    d->simplex_capacity = capacity;
+
+    return 0;
+}
+
+/*!
+ * Get a slot for a new simplex, reusing a freed slot if there is one
+ *
+ * @param   d   pointer to the triangulation
+ *
+ * @return index of the slot or -1 on failure
+ */
+int
+delaunay_new_simplex(struct pmm_delaunay *d)
+{
+    int s;
+
+    if(d->n_free > 0) {
+        s = d->free_slots[--(d->n_free)];
+    }
+    else {
+        if(d->n_simplices == d->simplex_capacity &&
+           delaunay_grow_simplices(d) < 0)
+        {
+            return -1;
+        }
+
+        s = d->n_simplices++;
+    }
+
+    d->mark[s] = 0;
+
+    return s;
+}
+
+/*!
+ * Free the slot of a simplex for reuse
+ *
+ * @param   d   pointer to the triangulation
+ * @param   s   index of the simplex
+ */
+void
+delaunay_free_simplex(struct pmm_delaunay *d, int s)
+{
+    d->verts[s*(d->n+1)] = -1;
+    d->free_slots[d->n_free++] = s;
+}
+
+/*!
+ * Calculate the inverse edge matrix and circumsphere of a simplex whose
+ * vertices have been set.
+ *
+ * The edge matrix T has as its columns the vectors from the first vertex to
+ * each other vertex, so the barycentric coordinates of x are T^-1 (x - v0).
+ * The circumcentre c = v0 + w satisfies 2 T^T w = b where b holds the squared
+ * lengths of the edges, hence w = T^-T b / 2.
+ *
+ * @param   d   pointer to the triangulation
+ * @param   s   index of the simplex
+ *
+ * @return 0 on success, -1 if the simplex is degenerate
+ */
+int
+delaunay_geometry(struct pmm_delaunay *d, int s)
+{
+    int n, i, j, k, piv;
+    int *v;
+    double *a, *inv, *b, *v0, *vi;
+    double max, f, tmp;
+
+    n = d->n;
+    v = &(d->verts[s*(n+1)]);
+    inv = &(d->inv[s*n*n]);
+    a = d->work;
+    b = &(d->work[n*n]);
+    v0 = &(d->x[v[0]*n]);
+
+    // a = T, inv = identity
+    max = 0.0;
+    for(j=0; j<n; j++) {
+        vi = &(d->x[v[j+1]*n]);
+        b[j] = 0.0;
+        for(i=0; i<n; i++) {
+            a[i*n+j] = vi[i] - v0[i];
+            inv[i*n+j] = i == j ? 1.0 : 0.0;
+            b[j] += a[i*n+j] * a[i*n+j];
+
+            if(fabs(a[i*n+j]) > max) {
+                max = fabs(a[i*n+j]);
+            }
+        }
+    }
+
+    // Gauss-Jordan elimination with partial pivoting
+    for(k=0; k<n; k++) {
+        piv = k;
+        for(i=k+1; i<n; i++) {
+            if(fabs(a[i*n+k]) > fabs(a[piv*n+k])) {
+                piv = i;
+            }
+        }
+
+        if(fabs(a[piv*n+k]) <= PMM_DELAUNAY_SINGULAR * max) {
+            return -1;
+        }
+
+        if(piv != k) {
+            for(j=0; j<n; j++) {
+                tmp = a[k*n+j]; a[k*n+j] = a[piv*n+j]; a[piv*n+j] = tmp;
+                tmp = inv[k*n+j]; inv[k*n+j] = inv[piv*n+j]; inv[piv*n+j] = tmp;
+            }
+        }
+
+        f = 1.0 / a[k*n+k];
+        for(j=0; j<n; j++) {
+            a[k*n+j] *= f;
+            inv[k*n+j] *= f;
+        }
+
+        for(i=0; i<n; i++) {
+            if(i == k || a[i*n+k] == 0.0) {
+                continue;
+            }
+
+            f = a[i*n+k];
+            for(j=0; j<n; j++) {
+                a[i*n+j] -= f * a[k*n+j];
+                inv[i*n+j] -= f * inv[k*n+j];
+            }
+        }
+    }
+
+    // circumcentre relative to v0 is w = T^-T b / 2
+    d->r2[s] = 0.0;
+    for(i=0; i<n; i++) {
+        f = 0.0;
+        for(j=0; j<n; j++) {
+            f += inv[j*n+i] * b[j];
+        }
+        f *= 0.5;
+
+        d->centre[s*n+i] = v0[i] + f;
+        d->r2[s] += f * f;
+    }
+
+    return 0;
+}
+
+/*!
+ * Calculate the barycentric coordinates of a point with respect to a simplex
+ *
+ * @param   d       pointer to the triangulation
+ * @param   s       index of the simplex
+ * @param   x       pointer to the scaled coordinates of the point
+ * @param   lambda  pointer to an array of n+1 doubles to store the
+ *                  coordinates in, one for each vertex of the simplex
+ */
+void
+delaunay_barycentric(struct pmm_delaunay *d, int s, double *x, double *lambda)
+{
+    int n, i, j;
+    double *inv, *v0;
+    double sum;
+
+    n = d->n;
+    inv = &(d->inv[s*n*n]);
+    v0 = &(d->x[d->verts[s*(n+1)]*n]);
+
+    sum = 0.0;
+    for(i=0; i<n; i++) {
+        lambda[i+1] = 0.0;
+        for(j=0; j<n; j++) {
+            lambda[i+1] += inv[i*n+j] * (x[j] - v0[j]);
+        }
+        sum += lambda[i+1];
+    }
+    lambda[0] = 1.0 - sum;
+}
+
+/*!
+ * Test if a point lies strictly inside the circumsphere of a simplex
+ *
+ * @param   d   pointer to the triangulation
+ * @param   s   index of the simplex
+ * @param   x   pointer to the scaled coordinates of the point
+ *
+ * @return 1 if the point is inside the circumsphere, 0 otherwise
+ */
+int
+delaunay_in_sphere(struct pmm_delaunay *d, int s, double *x)
+{
+    int i;
+    double d2, t;
+
+    d2 = 0.0;
+    for(i=0; i<d->n; i++) {
+        t = x[i] - d->centre[s*d->n+i];
+        d2 += t * t;
+    }
+
+    return d2 < d->r2[s] * (1.0 - PMM_DELAUNAY_EPS);
+}
+
+/*!
+ * Scale a parameter point into the unit box of a triangulation
+ *
+ * @param   d   pointer to the triangulation
+ * @param   p   pointer to the parameter array
+ * @param   x   pointer to an array of n doubles to store the scaled point in
+ */
+void
+delaunay_scale(struct pmm_delaunay *d, int *p, double *x)
+{
+    int i;
+
+    for(i=0; i<d->n; i++) {
+        x[i] = ((double)p[i] - d->lo[i]) * d->scale[i];
+    }
+}
+
+/*!
+ * Find the simplex of a triangulation that contains a point.
+ *
+ * The search walks from the simplex found by the previous search, each step
+ * crossing the face opposite the vertex with the most negative barycentric
+ * coordinate. Should the walk fail to finish, all simplices are tested.
+ *
+ * @param   d       pointer to the triangulation
+ * @param   x       pointer to the scaled coordinates of the point
+ * @param   lambda  pointer to an array of n+1 doubles where the barycentric
+ *                  coordinates of the point in the simplex found are stored
+ *
+ * @return index of the simplex containing the point or -1 if the point is
+ * outside the enclosing simplex
+ */
+int
+delaunay_locate(struct pmm_delaunay *d, double *x, double *lambda)
+{
+    int n, s, i, k, steps, max_steps;
+
+    n = d->n;
+
+    s = d->last;
+    if(s < 0 || s >= d->n_simplices || d->verts[s*(n+1)] < 0) {
+        for(s=0; s<d->n_simplices && d->verts[s*(n+1)] < 0; s++);
+    }
+
+    max_steps = d->n_simplices - d->n_free + 1;
+
+    for(steps=0; steps<max_steps; steps++) {
+        delaunay_barycentric(d, s, x, lambda);
+
+        k = 0;
+        for(i=1; i<=n; i++) {
+            if(lambda[i] < lambda[k]) {
+                k = i;
+            }
+        }
+
+        if(lambda[k] >= -PMM_DELAUNAY_EPS) {
+            d->last = s;
+            return s;
+        }
+
+        s = d->nbrs[s*(n+1)+k];
+        if(s < 0) {
+            return -1;
+        }
+    }
+
+    DBGPRINTF("Walk did not terminate, testing all simplices.\n");
+
+    for(s=0; s<d->n_simplices; s++) {
+        if(d->verts[s*(n+1)] < 0) {
+            continue;
+        }
+
+        delaunay_barycentric(d, s, x, lambda);
+
+        for(i=0; i<=n && lambda[i] >= -PMM_DELAUNAY_EPS; i++);
+
+        if(i > n) {
+            d->last = s;
+            return s;
+        }
+    }
+
+    return -1;
+}
+
+/*!
+ * Test if the vertices of two simplices, excluding one vertex of each,
+ * are the same
+ *
+ * @param   n       number of dimensions
+ * @param   a       pointer to the vertices of the first simplex
+ * @param   skip_a  position of the vertex of the first simplex to exclude
+ * @param   b       pointer to the vertices of the second simplex
+ * @param   skip_b  position of the vertex of the second simplex to exclude
+ *
+ * @return 1 if the remaining vertices are the same, 0 otherwise
+ */
+int
+delaunay_same_face(int n, int *a, int skip_a, int *b, int skip_b)
+{
+    int i, j, found;
+
+    for(i=0; i<=n; i++) {
+        if(i == skip_a) {
+            continue;
+        }
+
+        found = 0;
+        for(j=0; j<=n && !found; j++) {
+            found = j != skip_b && b[j] == a[i];
+        }
+
+        if(!found) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/*!
+ * Insert a point into a triangulation by the Bowyer-Watson algorithm.
+ *
+ * The cavity of simplices whose circumspheres contain the point is grown
+ * outwards from the simplex containing the point. Where rounding leaves the
+ * point not strictly inside the cavity across some boundary face, the
+ * simplex beyond that face is added to the cavity too, so that the new
+ * simplices joining the point to the cavity boundary are never inverted or
+ * flat. If the point coincides with an existing point, the value of that
+ * point is replaced instead.
+ *
+ * Only the simplices around the new point change, so a triangulation can be
+ * kept up to date as points arrive at a cost proportional to the size of the
+ * cavity rather than to the number of points.
+ *
+ * @param   d   pointer to the triangulation
+ * @param   p   pointer to the parameter array of the point
+ * @param   y   value at the point
+ *
+ * @return index of the point in the triangulation or -1 on failure
+ */
+int
+delaunay_insert(struct pmm_delaunay *d, int *p, double y)
+{
+    double *x;
+
+    x = &(d->work[d->n*d->n+d->n]);
+
+    delaunay_scale(d, p, x);
+
+    return delaunay_insert_scaled(d, x, y);
+}
+
+/*!
+ * Insert a point that is already scaled into a triangulation
+ *
+ * @param   d   pointer to the triangulation
+ * @param   x   pointer to the scaled coordinates of the point, which must not
+ *              be in the first n*n+n or last n+1 elements of the workspace
+ * @param   y   value at the point
+ *
+ * @return index of the point in the triangulation or -1 on failure
+ */
+int
+delaunay_insert_scaled(struct pmm_delaunay *d, double *x, double y)
+{
+    int n, s, c, i, j, k, q, t, nb, pos;
+    int n_cavity, n_new, changed;
+    int *cavity, *new_s, *new_k;
+    double *lambda;
+
+    n = d->n;
+    lambda = &(d->work[n*n+2*n]);
+
+    s = delaunay_locate(d, x, lambda);
+    if(s < 0) {
+        ERRPRINTF("Point is outside the enclosing simplex.\n");
+        return -1;
+    }
+
+    for(i=0; i<=n; i++) {
+        if(lambda[i] > 1.0 - PMM_DELAUNAY_EPS) {
+            q = d->verts[s*(n+1)+i];
+            d->y[q] = y;
+            return q;
+        }
+    }
+
+    if(d->n_pts == d->pts_capacity && delaunay_grow_points(d) < 0) {
+        return -1;
+    }
+    q = d->n_pts;
+    memcpy(&(d->x[q*n]), x, n * sizeof *x);
+    d->y[q] = y;
+    x = &(d->x[q*n]);
+
+    cavity = malloc(d->simplex_capacity * sizeof *cavity);
+    if(cavity == NULL) {
+        ERRPRINTF("Error allocating memory.\n");
+        return -1;
+    }
+
+    d->stamp++;
+
+    // grow the cavity through faces to simplices whose circumspheres contain
+    // the point
+    n_cavity = 0;
+    cavity[n_cavity++] = s;
+    d->mark[s] = d->stamp;
+
+    for(c=0; c<n_cavity; c++) {
+        for(i=0; i<=n; i++) {
+            nb = d->nbrs[cavity[c]*(n+1)+i];
+            if(nb >= 0 && d->mark[nb] != d->stamp &&
+               delaunay_in_sphere(d, nb, x))
+            {
+                d->mark[nb] = d->stamp;
+                cavity[n_cavity++] = nb;
+            }
+        }
+    }
+
+    // make the cavity star shaped from the point
+    do {
+        changed = 0;
+
+        for(c=0; c<n_cavity; c++) {
+            delaunay_barycentric(d, cavity[c], x, lambda);
+
+            for(i=0; i<=n; i++) {
+                nb = d->nbrs[cavity[c]*(n+1)+i];
+                if((nb >= 0 && d->mark[nb] == d->stamp) ||
+                   lambda[i] > PMM_DELAUNAY_EPS)
+                {
+                    continue;
+                }
+
+                if(nb < 0) {
+                    ERRPRINTF("Cavity reached the enclosing simplex.\n");
+                    free(cavity);
+                    return -1;
+                }
+
+                d->mark[nb] = d->stamp;
+                cavity[n_cavity++] = nb;
+                changed = 1;
+            }
+        }
+    } while(changed);
+
+    // one new simplex for each face on the boundary of the cavity
+    n_new = 0;
+    for(c=0; c<n_cavity; c++) {
+        for(i=0; i<=n; i++) {
+            nb = d->nbrs[cavity[c]*(n+1)+i];
+            if(nb < 0 || d->mark[nb] != d->stamp) {
+                n_new++;
+            }
+        }
+    }
+
+    new_s = malloc(2 * n_new * sizeof *new_s);
+    if(new_s == NULL) {
+        ERRPRINTF("Error allocating memory.\n");
+        free(cavity);
+        return -1;
+    }
+    new_k = &(new_s[n_new]);
+
+    j = 0;
+    for(c=0; c<n_cavity; c++) {
+        for(i=0; i<=n; i++) {
+            nb = d->nbrs[cavity[c]*(n+1)+i];
+            if(nb >= 0 && d->mark[nb] == d->stamp) {
+                continue;
+            }
+
+            t = delaunay_new_simplex(d);
+            if(t < 0) {
+                free(cavity);
+                free(new_s);
+                return -1;
+            }
+
+            // the new simplex takes the face and puts the point in place of
+            // the vertex opposite it
+            memcpy(&(d->verts[t*(n+1)]), &(d->verts[cavity[c]*(n+1)]),
+                   (n+1) * sizeof *(d->verts));
+            d->verts[t*(n+1)+i] = q;
+
+            for(k=0; k<=n; k++) {
+                d->nbrs[t*(n+1)+k] = -1;
+            }
+            d->nbrs[t*(n+1)+i] = nb;
+
+            if(nb >= 0) {
+                for(k=0; k<=n; k++) {
+                    if(d->nbrs[nb*(n+1)+k] == cavity[c]) {
+                        d->nbrs[nb*(n+1)+k] = t;
+                    }
+                }
+            }
+
+            new_s[j] = t;
+            new_k[j] = i;
+            j++;
+        }
+    }
+
+    // new simplices are neighbours across the faces that include the point
+    for(j=0; j<n_new; j++) {
+        t = new_s[j];
+        for(k=0; k<=n; k++) {
+            if(k == new_k[j] || d->nbrs[t*(n+1)+k] >= 0) {
+                continue;
+            }
+
+            for(c=j+1; c<n_new; c++) {
+                for(pos=0; pos<=n; pos++) {
+                    if(pos != new_k[c] && d->nbrs[new_s[c]*(n+1)+pos] < 0 &&
+                       delaunay_same_face(n, &(d->verts[t*(n+1)]), k,
+                                          &(d->verts[new_s[c]*(n+1)]), pos))
+                    {
+                        break;
+                    }
+                }
+
+                if(pos <= n) {
+                    d->nbrs[t*(n+1)+k] = new_s[c];
+                    d->nbrs[new_s[c]*(n+1)+pos] = t;
+                    break;
+                }
+            }
+        }
+    }
+
+    for(c=0; c<n_cavity; c++) {
+        delaunay_free_simplex(d, cavity[c]);
+    }
+
+    d->n_pts++;
+
+    for(j=0; j<n_new; j++) {
+        if(delaunay_geometry(d, new_s[j]) < 0) {
+            ERRPRINTF("Degenerate simplex created inserting point.\n");
+            free(cavity);
+            free(new_s);
+            return -1;
+        }
+    }
+
+    d->last = new_s[0];
+
+    free(cavity);
+    free(new_s);
+
+    return q;
+}
+
+/*!
+ * Interpolate the values at the points of a triangulation at a point, by
+ * weighting the values at the vertices of the enclosing simplex by the
+ * barycentric coordinates of the point.
+ *
+ * @param   d   pointer to the triangulation
+ * @param   p   pointer to the parameter array of the point
+ * @param   y   pointer to where the interpolated value is stored
+ *
+ * @return 0 on success, -1 if the point is outside the convex hull of the
+ * points of the triangulation
+ */
+int
+delaunay_interpolate(struct pmm_delaunay *d, int *p, double *y)
+{
+    double *x;
+
+    x = &(d->work[d->n*d->n+d->n]);
+
+    delaunay_scale(d, p, x);
+
+    return delaunay_interpolate_scaled(d, x, y);
+}
+
+/*!
+ * Interpolate at a point that is already scaled
+ *
+ * @param   d   pointer to the triangulation
+ * @param   x   pointer to the scaled coordinates of the point
+ * @param   y   pointer to where the interpolated value is stored
+ *
+ * @return 0 on success, -1 if the point is outside the convex hull of the
+ * points of the triangulation
+ */
+int
+delaunay_interpolate_scaled(struct pmm_delaunay *d, double *x, double *y)
+{
+    int n, s, i, v;
+    double *lambda;
+    double sum, weight;
+
+    n = d->n;
+    lambda = &(d->work[n*n+2*n]);
+
+    s = delaunay_locate(d, x, lambda);
+    if(s < 0) {
+        return -1;
+    }
+
+    // points on the boundary of the hull may be located in a simplex outside
+    // it, which is fine as long as the enclosing vertices carry no weight
+    sum = 0.0;
+    weight = 0.0;
+    for(i=0; i<=n; i++) {
+        v = d->verts[s*(n+1)+i];
+
+        if(v <= n) {
+            if(lambda[i] > PMM_DELAUNAY_EPS) {
+                return -1;
+            }
+            continue;
+        }
+
+        sum += lambda[i] * d->y[v];
+        weight += lambda[i];
+    }
+
+    if(weight <= 0.0) {
+        return -1;
+    }
+
+    *y = sum / weight;
+
+    return 0;
+}
+
+/*!
+ * Interpolate at a point as though that point had not been inserted into the
+ * triangulation.
+ *
+ * Removing a point from a Delaunay triangulation leaves the simplices that
+ * did not have it as a vertex unchanged and retriangulates the star of the
+ * point using only the vertices of its link. The point lies in its own star,
+ * so interpolating in a triangulation of just the link vertices gives the
+ * same value as a triangulation of all the other points would, without
+ * disturbing this one.
+ *
+ * @param   d   pointer to the triangulation
+ * @param   p   pointer to the parameter array of the point
+ * @param   y   pointer to where the interpolated value is stored
+ *
+ * @return 0 on success, -1 if the point is outside the convex hull of the
+ * other points of the triangulation or on failure
+ */
+int
+delaunay_interpolate_excluding(struct pmm_delaunay *d, int *p, double *y)
+{
+    struct pmm_delaunay *link;
+    int n, s, i, j, k, q, v, nb, ret;
+    int n_star, n_link, star_capacity, link_capacity;
+    int *star, *link_v, *tmp;
+    double *x, *lambda, *lo, *hi;
+
+    n = d->n;
+    x = &(d->work[n*n+n]);
+    lambda = &(d->work[n*n+2*n]);
+
+    delaunay_scale(d, p, x);
+
+    s = delaunay_locate(d, x, lambda);
+    if(s < 0) {
+        return -1;
+    }
+
+    q = -1;
+    for(i=0; i<=n; i++) {
+        if(lambda[i] > 1.0 - PMM_DELAUNAY_EPS) {
+            q = d->verts[s*(n+1)+i];
+        }
+    }
+
+    // p is not a point of the triangulation
+    if(q < 0) {
+        return delaunay_interpolate_scaled(d, x, y);
+    }
+
+    star_capacity = 4*(n+1);
+    link_capacity = 4*(n+1);
+    star = malloc(star_capacity * sizeof *star);
+    link_v = malloc(link_capacity * sizeof *link_v);
+    if(star == NULL || link_v == NULL) {
+        ERRPRINTF("Error allocating memory.\n");
+        free(star);
+        free(link_v);
+        return -1;
+    }
+
+    // collect the simplices around q, crossing only faces that include q,
+    // and the real points of their vertices other than q
+    d->stamp++;
+    n_star = 0;
+    n_link = 0;
+    star[n_star++] = s;
+    d->mark[s] = d->stamp;
+
+    for(i=0; i<n_star; i++) {
+        for(j=0; j<=n; j++) {
+            v = d->verts[star[i]*(n+1)+j];
+
+            if(v == q) {
+                continue;
+            }
+
+            nb = d->nbrs[star[i]*(n+1)+j];
+            if(nb >= 0 && d->mark[nb] != d->stamp) {
+                if(n_star == star_capacity) {
+                    star_capacity *= 2;
+                    tmp = realloc(star, star_capacity * sizeof *star);
+                    if(tmp == NULL) {
+                        ERRPRINTF("Error reallocating memory.\n");
+                        free(star);
+                        free(link_v);
+                        return -1;
+                    }
+                    star = tmp;
+                }
+
+                d->mark[nb] = d->stamp;
+                star[n_star++] = nb;
+            }
+
+            if(v <= n) {
+                continue;
+            }
+
+            for(k=0; k<n_link && link_v[k] != v; k++);
+
+            if(k == n_link) {
+                if(n_link == link_capacity) {
+                    link_capacity *= 2;
+                    tmp = realloc(link_v, link_capacity * sizeof *link_v);
+                    if(tmp == NULL) {
+                        ERRPRINTF("Error reallocating memory.\n");
+                        free(star);
+                        free(link_v);
+                        return -1;
+                    }
+                    link_v = tmp;
+                }
+
+                link_v[n_link++] = v;
+            }
+        }
+    }
+
+    free(star);
+
+    // the link points are already scaled, so triangulate them in the unit box
+    lo = malloc(2 * n * sizeof *lo);
+    if(lo == NULL) {
+        ERRPRINTF("Error allocating memory.\n");
+        free(link_v);
+        return -1;
+    }
+    hi = &(lo[n]);
+
+    for(i=0; i<n; i++) {
+        lo[i] = 0.0;
+        hi[i] = 1.0;
+    }
+
+    link = new_delaunay(n, lo, hi);
+    free(lo);
+
+    if(link == NULL) {
+        free(link_v);
+        return -1;
+    }
+
+    ret = 0;
+    for(i=0; i<n_link && ret == 0; i++) {
+        if(delaunay_insert_scaled(link, &(d->x[link_v[i]*n]),
+                                  d->y[link_v[i]]) < 0)
+        {
+            ret = -1;
+        }
+    }
+
+    if(ret == 0) {
+        ret = delaunay_interpolate_scaled(link, &(d->x[q*n]), y);
+    }
+
+    free_delaunay(&link);
+    free(link_v);
+
+    return ret;
+}
@@ -0,0 +1,100 @@
+/*
+    Copyright (C) 2008-2010 Robert Higgins
+        Author: Robert Higgins <robert.higgins@ucd.ie>
+
+    This file is part of PMM.
+
+    PMM is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMM is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+ * @file   pmm_delaunay.h
+ * @brief  Delaunay triangulation and interpolation of scattered points
+ *
+ * Data structures and functions for interpolating the value of a function
+ * known at a set of points in n dimensions, by locating the simplex of a
+ * Delaunay triangulation of the points that encloses the interpolation point
+ * and weighting the values at its vertices by barycentric coordinates.
+ */
+
+#ifndef PMM_DELAUNAY_H_
+#define PMM_DELAUNAY_H_
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#define PMM_ALL 0 /*!< use all points */
+#define PMM_AVG 1 /*!< use average of points with identical parameters */
+#define PMM_MAX 2 /*!< use maximum of points with identical parameters */
+
+/*!
+ * Delaunay triangulation of a set of points in n dimensions.
+ *
+ * Points are scaled into the unit box given when the triangulation is
+ * created, and are triangulated inside a large enclosing simplex whose n+1
+ * vertices are the first points of the triangulation. Simplices are stored
+ * in arrays indexed by simplex, with slots of deleted simplices reused.
+ */
+typedef struct pmm_delaunay {
+    int n;                  /*!< number of dimensions */
+
+    double *lo;             /*!< lower corner of the box points are scaled
+                                 from */
+    double *scale;          /*!< scale of each dimension into the unit box */
+
+    int n_pts;              /*!< number of points, including the vertices of
+                                 the enclosing simplex */
+    int pts_capacity;       /*!< number of points the arrays can hold */
+    double *x;              /*!< scaled coordinates of the points, n each */
+    double *y;              /*!< value at each point */
+
+    int n_simplices;        /*!< number of simplex slots in use or freed */
+    int simplex_capacity;   /*!< number of simplex slots the arrays can hold */
+    int *verts;             /*!< vertices of each simplex, n+1 each, the first
+                                 is -1 if the slot is free */
+    int *nbrs;              /*!< neighbour of each simplex opposite each of
+                                 its vertices, or -1 */
+    double *inv;            /*!< inverse of the edge matrix of each simplex,
+                                 n*n each, giving barycentric coordinates */
+    double *centre;         /*!< circumcentre of each simplex, n each */
+    double *r2;             /*!< squared circumradius of each simplex */
+    int *mark;              /*!< per simplex marks used during insertion */
+    int stamp;              /*!< current value of a set mark */
+    double *work;           /*!< workspace of n*n + 3n + 1 doubles */
+
+    int *free_slots;        /*!< stack of free simplex slots */
+    int n_free;             /*!< number of free simplex slots */
+
+    int last;               /*!< simplex that the last point located was in,
+                                 where the next search starts */
+
+    unsigned long version;  /*!< version of the data that was triangulated */
+} PMM_Delaunay;
+
+struct pmm_delaunay*
+new_delaunay(int n, double *lo, double *hi);
+void
+free_delaunay(struct pmm_delaunay **d);
+
+int
+delaunay_insert(struct pmm_delaunay *d, int *p, double y);
+int
+delaunay_locate(struct pmm_delaunay *d, double *x, double *lambda);
+int
+delaunay_interpolate(struct pmm_delaunay *d, int *p, double *y);
+int
+delaunay_interpolate_excluding(struct pmm_delaunay *d, int *p, double *y);
+
+#endif /*PMM_DELAUNAY_H_*/
+
@@ -46,17 +46,32 @@
 #include <unistd.h>         // for fcntl, select
 #include <errno.h>          // for perror, errno, etc
 #include <libgen.h>         // for basename
+#include <string.h>         // for strtok_r
+#include <stdio.h>          // for fopen, fgets
+#include <sys/resource.h>   // for setpriority
+#include <limits.h>         // for PATH_MAX
+#include <sys/syscall.h>    // for SYS_set_mempolicy
+#ifdef HAVE_SETAFFINITY
+#include <sched.h>          // for sched_setaffinity, cpu_set_t
+#endif
 
 #include "pmm_model.h"
+#include "pmm_cond.h"
 #include "pmm_selector.h"
 #include "pmm_cfgparser.h"
 #include "pmm_log.h"
 #include "pmm_util.h"
+#include "pmm_executor.h"
+#include "pmm_modelwriter.h"
 
-//! daemon executing variable or not
+//! number of execution slots currently running a benchmark
 extern int executing_benchmark;
-//! mutex for accessing executing_benchmark variable
+//! number of executing benchmarks stopped while their conditions fail
+extern int paused_benchmark;
+//! mutex for accessing executing_benchmark variable and execution slots
 extern pthread_mutex_t executing_benchmark_mutex;
+//! condition the main loop waits on for scheduling events
+extern pthread_cond_t scheduler_cond;
 
 /* TODO
 extern volatile sig_atomic_t sig_cleanup_received;
@@ -70,17 +85,88 @@ extern int signal_quit;
 extern pthread_mutex_t signal_quit_mutex;
 
 
+//! mempolicy mode binding memory to a node set (see set_mempolicy(2))
+#define PMM_MPOL_BIND 2
+//! maximum number of numa nodes we can bind benchmarks to
+#define PMM_MAX_NUMA_NODES 1024
+//! number of lines in the original five value benchmark output
+#define PMM_LEGACY_RECORD_LINES 3
+//! maximum length of a parameter line written to a worker
+#define PMM_WORKER_LINE_MAX 1024
+//! number of longs in a numa node mask
+#define PMM_NODEMASK_LONGS (PMM_MAX_NUMA_NODES/(8*sizeof(unsigned long)))
+//! maximum seconds to wait in select() before checking for quit/timeout
+#define PMM_SELECT_WAIT_SECS 5
+//! interference above which a benchmark is logged as measured under load
+#define PMM_INTERFERENCE_LOG 0.1
+
+/*!
+ * Placement of a benchmark process. This is resolved in the parent before
+ * forking so that the child only has to make system calls before the exec
+ * of the benchmark.
+ */
+struct pmm_placement {
+#ifdef HAVE_SETAFFINITY
+    int pin;                        //!< toggle set if cpus should be applied
+    cpu_set_t cpus;                 //!< cpus to pin benchmark to
+#endif
+    int numa_node;                  //!< numa node to bind memory to or -1
+    unsigned long nodemask[PMM_NODEMASK_LONGS]; //!< mask of numa_node
+    int nice;                       //!< nice value to set, if set_nice
+    int set_nice;                   //!< toggle set if nice should be applied
+};
+
+/*!
+ * State of a running benchmark that is stopped while the execution conditions
+ * of its routine do not hold.
+ */
+struct pmm_pause {
+    int paused;                     //!< toggle set while benchmark is stopped
+    int n_pauses;                   //!< number of times benchmark was stopped
+    struct timeval stopped_at;      //!< time benchmark was last stopped
+};
+
 /* local functions */
-int my_popen(char *cmd, char **args, int n, pid_t *pid);
+int my_popen(char *cmd, char **args, int n, struct pmm_placement *pl,
+             int *in_fd, pid_t *pid);
+int init_placement(struct pmm_placement *pl, struct pmm_routine *r,
+                   struct pmm_exec_slot *slot);
+int apply_placement(struct pmm_placement *pl);
+char* placement_cpuset(struct pmm_routine *r, struct pmm_exec_slot *slot);
+int execute_benchmark(struct pmm_routine *r, struct pmm_exec_slot *s,
+                      int *params, char **output_p);
+int execute_worker_benchmark(struct pmm_routine *r, struct pmm_exec_slot *s,
+                             int *params, char **output_p);
+struct pmm_worker* start_worker(struct pmm_routine *r,
+                                struct pmm_exec_slot *s);
+int write_worker_params(struct pmm_worker *w, int *params, int n_p);
+int read_worker_record(struct pmm_worker *w, struct pmm_routine *r,
+                       struct pmm_pause *p, char **output_p);
 int set_non_blocking(int fd);
 struct pmm_benchmark* parse_bench_output(char *output, int n_p, int *rargs);
-
-int read_benchmark_output(int fd, char **output_p, pid_t bench_pid);
+int parse_result_record(char *output, struct pmm_benchmark *b,
+                        struct timeval *wall_t, struct timeval *used_t,
+                        long long *complexity);
+int result_record_lines(char *output);
+
+int read_benchmark_output(int fd, char **output_p, pid_t bench_pid,
+                          struct pmm_routine *r, struct pmm_pause *p);
+void init_pause(struct pmm_pause *p);
+int pause_on_conds(struct pmm_routine *r, pid_t pid, struct pmm_pause *p,
+                   struct timeval *start);
+void end_pause(struct pmm_pause *p);
+int set_select_wait(struct timeval *tv, struct timeval *start, int timeout);
+struct pmm_benchmark* init_timed_out_benchmark(int *params, int n_p,
+                                               int timeout);
 
 void sig_childexit(int sig);
 double calculate_flops(struct timeval tv, long long int complexity);
 double timeval_to_seconds(struct timeval tv);
-void set_executing_benchmark(int i);
+void release_exec_slot(struct pmm_exec_slot *slot);
+#ifdef HAVE_SETAFFINITY
+int parse_cpu_list(char *list, cpu_set_t *set);
+int set_exec_slot_affinity(struct pmm_exec_slot *slot);
+#endif
 char*
 pmm_bench_exit_status_to_string(int bench_status);
 
@@ -122,18 +208,27 @@ int set_non_blocking(int fd) {
  * @param   cmd     string with the full path of the program
  * @param   args    array of strings with all arguments of the program
  * @param   n       number of arguments in arg vector
+ * @param   pl      pointer to placement to apply to the child before exec,
+ *                  or NULL
+ * @param   in_fd   pointer to an int which will be set to a file descriptor
+ *                  of a pipe to the standard input of the program, or NULL if
+ *                  the standard input should not be redirected
  * @param   pid     pointer to the pid which will be set to the pid of the
  *                  external program
  *
+ * The program is executed as the leader of a new process group.
+ *
  * @return file descriptor of the pipe opened to the command cmd.
  *
  * TODO test for file not found
  *
  */
 int
-my_popen(char *cmd, char **args, int n, pid_t *pid)
+my_popen(char *cmd, char **args, int n, struct pmm_placement *pl, int *in_fd,
+         pid_t *pid)
 {
     int p[2]; // this is our pipe of file descriptors
+    int q[2]; // pipe to the standard input of the command
     char **argv;
     int i;
 
@@ -142,6 +237,24 @@ my_popen(char *cmd, char **args, int n, pid_t *pid)
         return -1;
     }
 
+    // other benchmark threads may fork concurrently, make sure their
+    // children do not inherit this pipe, or we would not see EOF until they
+    // also terminate
+    fcntl(p[0], F_SETFD, FD_CLOEXEC);
+    fcntl(p[1], F_SETFD, FD_CLOEXEC);
+
+    if(in_fd != NULL) {
+        if(pipe(q) < 0) {
+            ERRPRINTF("Error creating pipe.\n");
+            close(p[0]);
+            close(p[1]);
+            return -1;
+        }
+
+        fcntl(q[0], F_SETFD, FD_CLOEXEC);
+        fcntl(q[1], F_SETFD, FD_CLOEXEC);
+    }
+
 
     /* build up argv for calling command */
     argv = malloc((n+2) * sizeof *argv);
@@ -164,8 +277,17 @@ my_popen(char *cmd, char **args, int n, pid_t *pid)
 
     if((*pid = fork()) > 0) { // parent
 
+        // also set the process group here, so it exists before we might
+        // need to kill it, no matter which of parent/child runs first
+        setpgid(*pid, *pid);
+
         close(p[1]); // close write pipe
 
+        if(in_fd != NULL) {
+            close(q[0]); // close read end of the input pipe
+            *in_fd = q[1];
+        }
+
         free(argv); //this has been copied into the child so we can free
         argv = NULL;
 
@@ -173,6 +295,9 @@ my_popen(char *cmd, char **args, int n, pid_t *pid)
     }
     else if(*pid  == 0) { // child
 
+        // put the benchmark in its own process group so that it can be
+        // killed along with any processes it starts itself
+        setpgid(0, 0);
 
         close(p[0]); // close read pipe
 
@@ -184,6 +309,18 @@ my_popen(char *cmd, char **args, int n, pid_t *pid)
 
         close(p[1]);
 
+        // duplicate STDIN to read end of the input pipe
+        if(in_fd != NULL) {
+            close(q[1]);
+            dup2(q[0], STDIN_FILENO);
+            close(q[0]);
+        }
+
+        // pin, bind and renice before the benchmark starts
+        if(pl != NULL && apply_placement(pl) < 0) {
+            ERRPRINTF("child: could not apply placement, exiting.\n");
+            exit(EXIT_FAILURE);
+        }
 
         // call the command 'cmd' using argv[]
         execv(cmd, argv);
@@ -196,6 +333,11 @@ my_popen(char *cmd, char **args, int n, pid_t *pid)
     else { // error
         close(p[0]);
         close(p[1]);
+        if(in_fd != NULL) {
+            close(q[0]);
+            close(q[1]);
+        }
+        free(argv);
         ERRPRINTF("Error forking.\n");
         return -1;
     }
@@ -219,6 +361,45 @@ void sig_childexit(int sig)
     //wait(0);
 }
 
+/*!
+ * Create the benchmark recorded for a point where the benchmark was killed
+ * because it exceeded the timeout of its routine. The benchmark has zero
+ * speed, an execution time of the timeout and is marked with the
+ * PMM_METRIC_TIMED_OUT metric.
+ *
+ * @param   params      pointer to the parameters of the point
+ * @param   n_p         number of parameters
+ * @param   timeout     timeout of the routine in seconds
+ *
+ * @return pointer to a newly allocated benchmark or NULL on failure
+ */
+struct pmm_benchmark*
+init_timed_out_benchmark(int *params, int n_p, int timeout)
+{
+    struct pmm_benchmark *b;
+
+    b = init_zero_benchmark(params, n_p);
+    if(b == NULL) {
+        ERRPRINTF("Error allocating zero speed benchmark.\n");
+        return NULL;
+    }
+
+    b->complexity = 0;
+    b->wall_t.tv_sec = timeout;
+    b->wall_t.tv_usec = 0;
+    b->used_t.tv_sec = 0;
+    b->used_t.tv_usec = 0;
+    b->seconds = (double)timeout;
+
+    if(add_benchmark_metric(b, PMM_METRIC_TIMED_OUT, 1.) < 0) {
+        ERRPRINTF("Error adding timed out metric.\n");
+        free_benchmark(&b);
+        return NULL;
+    }
+
+    return b;
+}
+
 /*!
  * Given the output of a benchmark execution parse and create a new
  * benchmark structure storing all the information gained
@@ -240,32 +421,45 @@ parse_bench_output(char *output, int n_p, int *rargs)
     int rc;
     struct pmm_benchmark *b;
 
-    rc = sscanf(output, "%ld %ld\n%ld %ld\n%lld", &(wall_t.tv_sec),
-                &(wall_t.tv_usec), &(used_t.tv_sec), &(used_t.tv_usec),
-                &complexity);
+    b = new_benchmark();
 
-    if(rc != 5) {
-        ERRPRINTF("Error parsing output\n");
+    if(b == NULL) {
+        ERRPRINTF("Errory allocating benchmark structure.\n");
         return NULL;
     }
 
+    // versioned key/value record, or the original five value output
+    if(strncmp(output, PMM_RESULT_MAGIC, strlen(PMM_RESULT_MAGIC)) == 0) {
+        if(parse_result_record(output, b, &wall_t, &used_t, &complexity) < 0) {
+            ERRPRINTF("Error parsing result record\n");
+            free_benchmark(&b);
+            return NULL;
+        }
+    }
+    else {
+        rc = sscanf(output, "%ld %ld\n%ld %ld\n%lld", &(wall_t.tv_sec),
+                    &(wall_t.tv_usec), &(used_t.tv_sec), &(used_t.tv_usec),
+                    &complexity);
+
+        if(rc != 5) {
+            ERRPRINTF("Error parsing output\n");
+            free_benchmark(&b);
+            return NULL;
+        }
+    }
+
     LOGPRINTF("wall secs: %ld usecs: %ld\n", wall_t.tv_sec, wall_t.tv_usec);
     LOGPRINTF("used secs: %ld usecs: %ld\n", used_t.tv_sec, used_t.tv_usec);
 
     if(wall_t.tv_sec == 0 && wall_t.tv_usec == 0) {
         ERRPRINTF("Zero execution wall-time parsed from bench output.\n");
+        free_benchmark(&b);
         return NULL;
     }
 
     if(complexity == 0) {
         ERRPRINTF("Zero complexity value parsed from bench output.\n");
-        return NULL;
-    }
-
-    b = new_benchmark();
-
-    if(b == NULL) {
-        ERRPRINTF("Errory allocating benchmark structure.\n");
+        free_benchmark(&b);
         return NULL;
     }
 
@@ -274,6 +468,7 @@ parse_bench_output(char *output, int n_p, int *rargs)
     b->p = init_param_array_copy(rargs, b->n_p);
     if(b->p == NULL) {
         ERRPRINTF("Error copying benchmark parameters.\n");
+        free_benchmark(&b);
         return NULL;
     }
 
@@ -291,6 +486,124 @@ parse_bench_output(char *output, int n_p, int *rargs)
     return b;
 }
 
+/*!
+ * Parse a versioned result record (see print_result_record() in pmm_util.c).
+ * Timing and complexity keys are returned through the arguments, any other
+ * key is added to the metrics of the benchmark.
+ *
+ * @param   output      pointer to the record
+ * @param   b           pointer to the benchmark to add metrics to
+ * @param   wall_t      pointer to timeval to store wall time
+ * @param   used_t      pointer to timeval to store used time
+ * @param   complexity  pointer to store complexity
+ *
+ * @return 0 on success, -1 on failure
+ */
+int
+parse_result_record(char *output, struct pmm_benchmark *b,
+                    struct timeval *wall_t, struct timeval *used_t,
+                    long long *complexity)
+{
+    char key[PMM_METRIC_NAME_MAX];
+    char value[64];
+    char *pos;
+    int version, n, i;
+    int found = 0; // bitmask of required keys found
+
+    if(sscanf(output, PMM_RESULT_MAGIC " %d %d", &version, &n) != 2) {
+        ERRPRINTF("Malformed result record header.\n");
+        return -1;
+    }
+
+    if(version != PMM_RESULT_VERSION) {
+        ERRPRINTF("Unsupported result record version: %d\n", version);
+        return -1;
+    }
+
+    pos = strchr(output, '\n');
+
+    for(i=0; i<n; i++) {
+        if(pos == NULL) {
+            ERRPRINTF("Result record truncated at line %d of %d.\n", i, n);
+            return -1;
+        }
+        pos++;
+
+        if(sscanf(pos, "%63s %63s", key, value) != 2) {
+            ERRPRINTF("Malformed result record line %d.\n", i);
+            return -1;
+        }
+
+        if(strcmp(key, "wall_secs") == 0) {
+            wall_t->tv_sec = strtol(value, NULL, 10);
+            found |= 1;
+        }
+        else if(strcmp(key, "wall_usecs") == 0) {
+            wall_t->tv_usec = strtol(value, NULL, 10);
+            found |= 2;
+        }
+        else if(strcmp(key, "used_secs") == 0) {
+            used_t->tv_sec = strtol(value, NULL, 10);
+            found |= 4;
+        }
+        else if(strcmp(key, "used_usecs") == 0) {
+            used_t->tv_usec = strtol(value, NULL, 10);
+            found |= 8;
+        }
+        else if(strcmp(key, "complexity") == 0) {
+            *complexity = strtoll(value, NULL, 10);
+            found |= 16;
+        }
+        else {
+            if(add_benchmark_metric(b, key, strtod(value, NULL)) < 0) {
+                ERRPRINTF("Error adding metric %s.\n", key);
+                return -1;
+            }
+        }
+
+        pos = strchr(pos, '\n');
+    }
+
+    if(found != 31) {
+        ERRPRINTF("Result record missing timing or complexity keys.\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+/*!
+ * Get the number of lines in a result record, so the end of a record can be
+ * found in a stream.
+ *
+ * @param   output  pointer to the (partially read) record
+ *
+ * @return number of lines in the record, or -1 if the first line has not been
+ * read yet
+ */
+int
+result_record_lines(char *output)
+{
+    int version, n;
+
+    if(strchr(output, '\n') == NULL) {
+        return -1;
+    }
+
+    if(strncmp(output, PMM_RESULT_MAGIC, strlen(PMM_RESULT_MAGIC)) == 0) {
+        if(sscanf(output, PMM_RESULT_MAGIC " %d %d", &version, &n) != 2 ||
+           n < 0)
+        {
+            // malformed, let parse_bench_output() report it
+            return 1;
+        }
+
+        return n + 1;
+    }
+
+    return PMM_LEGACY_RECORD_LINES;
+}
+
 
 /*!
  * calculate (FL)OPS (floating point operations per second or any other
@@ -323,6 +636,7 @@ double timeval_to_seconds(struct timeval tv)
  *
  * @param   r           pointer to routine that will be executed
  * @param   params      pointer to array of parameters
+ * @param   slot        pointer to the execution slot of the benchmark
  * @param   bench_pid   pointer to pid_t to store spawned process pid
  *
  * @return int index of file descriptor that points to the stdout of the
@@ -330,13 +644,19 @@ double timeval_to_seconds(struct timeval tv)
  */
 int
 spawn_benchmark_process(struct pmm_routine *r, int *params,
-                        pid_t *bench_pid)
+                        struct pmm_exec_slot *slot, pid_t *bench_pid)
 {
 
     char **arg_strings;
     int arg_n;
     int i, j;
     int fd;
+    struct pmm_placement pl;
+
+    if(init_placement(&pl, r, slot) < 0) {
+        ERRPRINTF("Error resolving placement of benchmark.\n");
+        return -1;
+    }
 
     LOGPRINTF("exe_path:%s\n", r->exe_path);
     print_params(PMM_LOG, params, r->pd_set->n_p);
@@ -414,7 +734,7 @@ spawn_benchmark_process(struct pmm_routine *r, int *params,
         tmp_args = NULL;
 
         //copy the routine parameters in the array after the static arguments
-        for(i=0; i<arg_n; i++, j++) {
+        for(i=0; i<r->pd_set->n_p; i++, j++) {
             arg_strings[j] = malloc((1+snprintf(NULL, 0, "%d", params[i])) *
                                     sizeof *arg_strings[j]);
 
@@ -439,9 +759,9 @@ spawn_benchmark_process(struct pmm_routine *r, int *params,
         }
     }
 
-    fd = my_popen(r->exe_path, arg_strings, arg_n, bench_pid);
+    fd = my_popen(r->exe_path, arg_strings, arg_n, &pl, NULL, bench_pid);
 
-    for(i=0; i>arg_n; i++) {
+    for(i=0; i<arg_n; i++) {
         free(arg_strings[i]);
         arg_strings[i] = NULL;
     }
@@ -455,7 +775,9 @@ spawn_benchmark_process(struct pmm_routine *r, int *params,
 /*!
  * clean up a benchmark process
  *
- * closes file handles and kills the process
+ * closes file handles, kills the process group of the benchmark (so that
+ * processes started by the benchmark do not outlive it) and reaps the
+ * benchmark process
  *
  * @param   fp              file pointer to the benchmarks standard output
  * @param   bench_pid       benchmark process id
@@ -464,14 +786,158 @@ spawn_benchmark_process(struct pmm_routine *r, int *params,
 void
 cleanup_benchmark_process(FILE *fp, pid_t bench_pid)
 {
-    //send kill don't bother calling waitpid on benchmark
-    if(kill(bench_pid, SIGKILL) != 0) {
+    int status;
+
+    if(kill(-bench_pid, SIGKILL) != 0 && kill(bench_pid, SIGKILL) != 0) {
         ERRPRINTF("error sending kill to benchmark.\n");
     }
 
     if(fclose(fp) < 0) {
         ERRPRINTF("Error closing file pointer to command\n");
     }
+
+    if(waitpid(bench_pid, &status, 0) != bench_pid) {
+        ERRPRINTF("Error waiting for benchmark to terminate.\n");
+    }
+}
+
+/*!
+ * Set the time select() should wait for output of a benchmark, so that it
+ * returns no later than the timeout of the benchmark.
+ *
+ * @param   tv          pointer to the timeval to set
+ * @param   start       pointer to the time the benchmark was started
+ * @param   timeout     timeout of the benchmark in seconds or -1 for none
+ *
+ * @return 1 if the benchmark may continue, 0 if the timeout has expired
+ */
+int
+set_select_wait(struct timeval *tv, struct timeval *start, int timeout)
+{
+    struct timeval now, elapsed, remaining;
+
+    tv->tv_sec = PMM_SELECT_WAIT_SECS;
+    tv->tv_usec = 0;
+
+    if(timeout <= 0) {
+        return 1;
+    }
+
+    gettimeofday(&now, NULL);
+    timersub(&now, start, &elapsed);
+
+    remaining.tv_sec = timeout;
+    remaining.tv_usec = 0;
+
+    if(!timercmp(&elapsed, &remaining, <)) {
+        return 0;
+    }
+
+    timersub(&remaining, &elapsed, &remaining);
+    if(timercmp(&remaining, tv, <)) {
+        *tv = remaining;
+    }
+
+    return 1;
+}
+
+/*!
+ * Initialize the pause state of a benchmark that is about to run
+ *
+ * @param   p       pointer to the pause state
+ */
+void
+init_pause(struct pmm_pause *p)
+{
+    p->paused = 0;
+    p->n_pauses = 0;
+    timerclear(&(p->stopped_at));
+}
+
+/*!
+ * Stop a running benchmark when the execution conditions of its routine no
+ * longer hold and continue it when they hold again. The whole process group
+ * of the benchmark is signalled. The time spent stopped is added to the start
+ * time of the benchmark so that it does not count towards the timeout.
+ *
+ * @param   r       pointer to the routine
+ * @param   pid     pid of the benchmark process (group leader)
+ * @param   p       pointer to the pause state of the benchmark
+ * @param   start   pointer to the start time of the benchmark
+ *
+ * @return 0 if the benchmark may carry on (running or stopped), 1 if the
+ * conditions of the routine will never hold again
+ */
+int
+pause_on_conds(struct pmm_routine *r, pid_t pid, struct pmm_pause *p,
+               struct timeval *start)
+{
+    int n_active;
+    struct timeval now, stopped;
+
+    pthread_mutex_lock(&executing_benchmark_mutex);
+    n_active = executing_benchmark - paused_benchmark;
+    pthread_mutex_unlock(&executing_benchmark_mutex);
+
+    if(check_running_conds(r, n_active)) {
+        if(p->paused) {
+            LOGPRINTF("conditions of routine %s hold again, continuing "
+                      "benchmark pid:%d\n", r->name, (int)pid);
+
+            if(kill(-pid, SIGCONT) != 0 && kill(pid, SIGCONT) != 0) {
+                ERRPRINTF("error sending SIGCONT to benchmark process:%d\n",
+                          (int)pid);
+            }
+
+            gettimeofday(&now, NULL);
+            timersub(&now, &(p->stopped_at), &stopped);
+            timeradd(start, &stopped, start);
+
+            end_pause(p);
+        }
+    }
+    else if(!p->paused) {
+        if(next_cond_time(r, cond_time_now()) == (time_t)-1) {
+            return 1;
+        }
+
+        LOGPRINTF("conditions of routine %s no longer hold, stopping "
+                  "benchmark pid:%d\n", r->name, (int)pid);
+
+        if(kill(-pid, SIGSTOP) != 0 && kill(pid, SIGSTOP) != 0) {
+            ERRPRINTF("error sending SIGSTOP to benchmark process:%d\n",
+                      (int)pid);
+            return 0;
+        }
+
+        gettimeofday(&(p->stopped_at), NULL);
+        p->paused = 1;
+        p->n_pauses++;
+
+        pthread_mutex_lock(&executing_benchmark_mutex);
+        paused_benchmark++;
+        pthread_mutex_unlock(&executing_benchmark_mutex);
+    }
+
+    return 0;
+}
+
+/*!
+ * Mark a stopped benchmark as no longer stopped, either because it has been
+ * continued or because it has been killed.
+ *
+ * @param   p       pointer to the pause state of the benchmark
+ */
+void
+end_pause(struct pmm_pause *p)
+{
+    if(p->paused) {
+        p->paused = 0;
+
+        pthread_mutex_lock(&executing_benchmark_mutex);
+        paused_benchmark--;
+        pthread_mutex_unlock(&executing_benchmark_mutex);
+    }
 }
 
 /*!
@@ -482,12 +948,19 @@ cleanup_benchmark_process(FILE *fp, pid_t bench_pid)
  * @param   output_p    pointer to a character array where output will be
  *                      stored
  * @param   bench_pid   process id of the benchmark process
+ * @param   r           pointer to the routine, whose timeout and execution
+ *                      conditions are enforced while the benchmark runs
+ * @param   p           pointer to the pause state of the benchmark
  *
  * @return 0 on success, -1 if there was an error reading (output_p
- * also set to NULL) 1 if a quit signal was received while waiting for output
+ * also set to NULL) 1 if a quit signal was received while waiting for output,
+ * 2 if the benchmark was killed because it exceeded the timeout, 3 if it was
+ * killed because the execution conditions of the routine will never hold
+ * again
  */
 int
-read_benchmark_output(int fd, char **output_p, pid_t bench_pid)
+read_benchmark_output(int fd, char **output_p, pid_t bench_pid,
+                      struct pmm_routine *r, struct pmm_pause *p)
 {
     FILE *fp;
     int reading;
@@ -501,9 +974,12 @@ read_benchmark_output(int fd, char **output_p, pid_t bench_pid)
 
     // variables for select()
     struct timeval tv_select_wait;
+    struct timeval tv_start;
     fd_set read_set;
     int select_ret;
 
+    gettimeofday(&tv_start, NULL);
+
     set_non_blocking(fd);
 
     fp = (void *)NULL;
@@ -530,8 +1006,23 @@ read_benchmark_output(int fd, char **output_p, pid_t bench_pid)
         // inside the loop
         FD_ZERO(&read_set);
         FD_SET(fd, &read_set);
-        tv_select_wait.tv_sec = 5;
-        tv_select_wait.tv_usec = 0;
+
+        // a stopped benchmark does not time out
+        if(!set_select_wait(&tv_select_wait, &tv_start,
+                            p->paused ? -1 : r->timeout))
+        {
+            LOGPRINTF("benchmark exceeded timeout of %d seconds, killing "
+                      "pid:%d\n", r->timeout, (int)bench_pid);
+
+            cleanup_benchmark_process(fp, bench_pid);
+
+            free(output);
+            output = NULL;
+
+            *output_p = NULL;
+
+            return 2;
+        }
 
         //DBGPRINTF("select() waiting on file descriptor for %ld.%ld secs.\n",
         //        tv_select_wait.tv_sec, tv_select_wait.tv_usec);
@@ -619,23 +1110,20 @@ read_benchmark_output(int fd, char **output_p, pid_t bench_pid)
             }
         }
 
-        /*
-           if(sig_pause_received) {
-        // send pause signal to benchmark process
-        if(kill(bench_pid, SIGSTOP) != 0) {
-        perror("[benchmark]"); //TODO
-        ERRPRINTF("error sending SIGSTOP to benchmark process:%d", bench_pid);
-        }
-        }
+        // stop or continue the benchmark as its execution conditions change
+        if(reading && pause_on_conds(r, bench_pid, p, &tv_start)) {
+            LOGPRINTF("conditions of routine %s will not hold again, "
+                      "killing benchmark pid:%d\n", r->name, (int)bench_pid);
 
-        if(sig_unpause_received) {
-        // send unpause signal to benchmark process
-        if(kill(bench_pid, SIGCONT) != 0) {
-        perror("[benchmark]"); //TODO
-        ERRPRINTF("error sending SIGCONT to benchmark process:%d", bench_pid);
-        }
+            cleanup_benchmark_process(fp, bench_pid);
+
+            free(output);
+            output = NULL;
+
+            *output_p = NULL;
+
+            return 3;
         }
-        */
 
         //check that global shutdown variable has not been called before
         //returning to select at start of while
@@ -672,105 +1160,604 @@ read_benchmark_output(int fd, char **output_p, pid_t bench_pid)
 }
 
 /*!
- * Given a routine to benchmark, select a point, execute the benchmark and
- * insert the new point into the model. Set the global 'executing_benchark' to
- * false/0 when the operation is complete (or has failed).
+ * Execute a benchmark process for a single point and collect its output.
  *
- * @param   scheduled_r     void pointer to a routine structure that has been
- *                          scheduled for a benchmark execution
+ * @param   r           pointer to the routine
+ * @param   s           pointer to the execution slot
+ * @param   params      pointer to the parameters of the point
+ * @param   output_p    pointer to a character array where output will be
+ *                      stored
  *
- * @return void pointer to an integer with value of: 0 on success, 1 on quit from signal, -1 on failure
+ * @return 0 on success, -1 on failure, 1 if a quit signal was received, 2 if
+ * the benchmark exceeded the timeout of the routine, 3 if the result was
+ * discarded because the execution conditions of the routine failed while the
+ * benchmark ran
  */
-void*
-benchmark(void *scheduled_r)
+int
+execute_benchmark(struct pmm_routine *r, struct pmm_exec_slot *s, int *params,
+                  char **output_p)
 {
-    // TODO decompose some of the fuctionality of this to make it more legible
-    int *ret;
-    int temp_ret;
-    struct pmm_routine *r;
-    struct pmm_benchmark *bmark;
-    int *rargs = NULL; //new benchmark point
-
     pid_t bench_pid;
     int bench_status;
-
     int fd;
+    int ret;
     char *output;
+    struct pmm_pause pause;
 
-    r = (struct pmm_routine*)scheduled_r;
+    fd = spawn_benchmark_process(r, params, s, &bench_pid);
+    if(fd == -1) {
+        ERRPRINTF("Error spawning benchmark process, fd:%d pid:%d\n", (int)fd,
+                   bench_pid);
 
-    ret = (int*)malloc(sizeof *ret);
+        //TODO send kill to bench_pid, just to be sure?
 
-    //evaluate current performance model approximation and pick new
-    //point on the approximation to measure with benchmark, TODO if model
-    //proves to be complete set complete status and return immidiately
-    if(r->construction_method == CM_NAIVE) {
-        rargs = multi_naive_select_new_bench(r);
-    }
-    else if(r->construction_method == CM_NAIVE_BISECT) {
-        rargs = naive_1d_bisect_select_new_bench(r);
-    }
-    else if(r->construction_method == CM_GBBP) {
-    //  rargs = multi_gbbp_select_new_bench(r);
-        rargs = multi_gbbp_diagonal_select_new_bench(r);
-    }
-    else if(r->construction_method == CM_GBBP_NAIVE) {
-        rargs = multi_gbbp_naive_select_new_bench(r);
-    }
-    else if(r->construction_method == CM_RAND) {
-        rargs = multi_random_select_new_bench(r);
-    }
-    else { // default
-        //rargs = naive_select_new_bench(r);
+        return -1;
     }
 
-    if(rargs == NULL) {
-        ERRPRINTF("Error selecting new benchmark point.\n");
-        set_executing_benchmark(0);
-        *ret = -1;
-
-        return (void *)ret;
-    }
 
-    // take routine and execute it passing in the parameters
-    // of the performance model coordinate experiment at
-    //
-    //LOGPRINTF("benchmark thread: started\n");
+    //LOGPRINTF("filedescriptor returned from popen: %d pid:%d\n", (int)fd,
+    //        bench_pid);
 
 
-    //LOGPRINTF("exe_path:%s\n", r->exe_path);
-    //print_params(rargs, r->n_p);
+    init_pause(&pause);
 
+    ret = read_benchmark_output(fd, &output, bench_pid, r, &pause);
+    end_pause(&pause);
+    if(ret == -1) {
+        ERRPRINTF("Error reading benchmark output.\n");
+        return -1;
+    }
+    else if(ret == 1 || ret == 2 || ret == 3) {
+        return ret;
+    }
 
-    fd = spawn_benchmark_process(r, rargs, &bench_pid);
-    if(fd == -1) {
-        ERRPRINTF("Error spawning benchmark process, fd:%d pid:%d\n", (int)fd,
-                   bench_pid);
 
-        free(rargs);
-        rargs = NULL;
+    //wait for bench to terminate (and retrieve exit status)
+    if(waitpid(bench_pid, &bench_status, 0) != bench_pid) {
+        ERRPRINTF("Error waiting for benchmark to terminate.\n");
+    }
 
-        //TODO send kill to bench_pid, just to be sure?
 
-        set_executing_benchmark(0);
-        *ret = -1; //failure
+    //check exit status
+    if(WEXITSTATUS(bench_status) != PMM_EXIT_SUCCESS) {
+        ERRPRINTF("benchmark exited with abnormal status:%s.\n",
+                  pmm_bench_exit_status_to_string(WEXITSTATUS(bench_status)));
+
+        ERRPRINTF("output was:\n--------\n%s---------\n", output);
+
+        free(output);
+        output = NULL;
+
+        return -1;
+    }
+
+    // the benchmark timed itself, including the time it was stopped for
+    // and any interference that stopped it, so its result is contaminated
+    if(pause.n_pauses > 0) {
+        LOGPRINTF("benchmark was stopped %d time(s), discarding result.\n",
+                  pause.n_pauses);
+
+        free(output);
+        output = NULL;
+
+        return 3;
+    }
+
+    *output_p = output;
+
+    return 0;
+}
+
+/*!
+ * Measure a single point with the persistent worker process of a routine,
+ * starting the worker if it is not running yet. The parameters are written
+ * to the worker as one line and a result record, in the same format as the
+ * output of an exec benchmark, is read back.
+ *
+ * If the worker fails or exceeds the timeout of the routine it is stopped, it
+ * will be restarted on the next benchmark of the routine. A worker started in
+ * another slot is restarted if its cpus differ from those of slot s.
+ *
+ * @param   r           pointer to the routine
+ * @param   s           pointer to the execution slot
+ * @param   params      pointer to the parameters of the point
+ * @param   output_p    pointer to a character array where output will be
+ *                      stored
+ *
+ * @return 0 on success, -1 on failure, 1 if a quit signal was received, 2 if
+ * the worker exceeded the timeout of the routine, 3 if the result was
+ * discarded because the execution conditions of the routine failed while the
+ * worker measured it
+ */
+int
+execute_worker_benchmark(struct pmm_routine *r, struct pmm_exec_slot *s,
+                         int *params, char **output_p)
+{
+    int ret;
+    struct pmm_pause pause;
+    char *cpuset;
+
+    // a worker is pinned to the cpus of the slot it was started in, restart
+    // it when it is scheduled in a slot with a different placement
+    if(r->worker != NULL && r->worker->slot != s->id) {
+        cpuset = placement_cpuset(r, s);
+
+        if((cpuset == NULL) != (r->worker->cpuset == NULL) ||
+           (cpuset != NULL && strcmp(cpuset, r->worker->cpuset) != 0))
+        {
+            LOGPRINTF("restarting worker of routine %s in slot %d.\n",
+                      r->name, s->id);
+            stop_worker(&(r->worker));
+        }
+        else {
+            r->worker->slot = s->id;
+        }
+    }
+
+    if(r->worker == NULL) {
+        r->worker = start_worker(r, s);
+        if(r->worker == NULL) {
+            ERRPRINTF("Error starting worker for routine %s.\n", r->name);
+            return -1;
+        }
+    }
+
+    if(write_worker_params(r->worker, params, r->pd_set->n_p) < 0) {
+        ERRPRINTF("Error writing parameters to worker.\n");
+        stop_worker(&(r->worker));
+        return -1;
+    }
+
+    init_pause(&pause);
+
+    ret = read_worker_record(r->worker, r, &pause, output_p);
+    if(ret == -1) {
+        ERRPRINTF("Error reading result record from worker.\n");
+        stop_worker(&(r->worker));
+        end_pause(&pause);
+        return -1;
+    }
+    else if(ret == 2) {
+        LOGPRINTF("worker exceeded timeout of %d seconds.\n", r->timeout);
+        stop_worker(&(r->worker));
+        end_pause(&pause);
+        return 2;
+    }
+    else if(ret == 3) {
+        LOGPRINTF("conditions of routine %s will not hold again.\n", r->name);
+        stop_worker(&(r->worker));
+        end_pause(&pause);
+        return 3;
+    }
+    else if(ret == 1) {
+        // worker is killed, stopped or not, when the daemon shuts down
+        end_pause(&pause);
+        return 1;
+    }
+
+    // the record timed a measurement that was stopped, it is contaminated
+    if(pause.n_pauses > 0) {
+        LOGPRINTF("worker was stopped %d time(s), discarding result.\n",
+                  pause.n_pauses);
+
+        free(*output_p);
+        *output_p = NULL;
+
+        return 3;
+    }
+
+    return 0;
+}
+
+/*!
+ * Start the persistent worker process of a routine. The worker is executed
+ * with the static arguments of the routine only, parameters are streamed to
+ * its standard input.
+ *
+ * @param   r       pointer to the routine
+ * @param   s       pointer to the execution slot the worker is started from
+ *
+ * @return pointer to a newly allocated worker structure or NULL on failure
+ */
+struct pmm_worker*
+start_worker(struct pmm_routine *r, struct pmm_exec_slot *s)
+{
+    struct pmm_worker *w;
+    struct pmm_placement pl;
+    char **arg_strings = NULL;
+    char *tmp_args = NULL, *tok, *last = NULL;
+    int arg_n = 0;
+
+    if(init_placement(&pl, r, s) < 0) {
+        ERRPRINTF("Error resolving placement of worker.\n");
+        return NULL;
+    }
+
+    // tokenise static arguments on space, no quoted arguments supported
+    if(r->exe_args != NULL) {
+        tmp_args = strdup(r->exe_args);
+        if(tmp_args == NULL) {
+            ERRPRINTF("Error duplicating exe arg string.\n");
+            return NULL;
+        }
+
+        arg_strings = malloc(((strlen(tmp_args)+1)/2+1) * sizeof *arg_strings);
+        if(arg_strings == NULL) {
+            ERRPRINTF("Error allocating argument array.\n");
+            free(tmp_args);
+            return NULL;
+        }
+
+        for(tok = strtok_r(tmp_args, " ", &last); tok != NULL;
+            tok = strtok_r(NULL, " ", &last))
+        {
+            arg_strings[arg_n++] = tok;
+        }
+    }
+
+    w = malloc(sizeof *w);
+    if(w == NULL) {
+        ERRPRINTF("Error allocating worker.\n");
+        free(tmp_args);
+        free(arg_strings);
+        return NULL;
+    }
+
+    LOGPRINTF("starting worker for routine %s: %s\n", r->name, r->exe_path);
+
+    w->from_fd = my_popen(r->exe_path, arg_strings, arg_n, &pl, &(w->to_fd),
+                          &(w->pid));
+
+    free(tmp_args);
+    tmp_args = NULL;
+    free(arg_strings);
+    arg_strings = NULL;
+
+    if(w->from_fd < 0) {
+        ERRPRINTF("Error spawning worker process.\n");
+        free(w);
+        return NULL;
+    }
+
+    w->slot = s->id;
+    w->cpuset = placement_cpuset(r, s);
+
+    // note, SIGPIPE is blocked in all daemon threads, so if the worker dies
+    // write_worker_params() fails with EPIPE rather than killing the daemon
+
+    return w;
+}
+
+/*!
+ * Stop the worker process of a routine, closing its standard input and
+ * killing its process group, and free the worker structure.
+ *
+ * @param   w       pointer to the address of the worker
+ */
+void
+stop_worker(struct pmm_worker **w)
+{
+    int status;
+
+    LOGPRINTF("stopping worker pid:%d\n", (int)(*w)->pid);
+
+    close((*w)->to_fd);
+    close((*w)->from_fd);
+
+    if(kill(-(*w)->pid, SIGKILL) != 0 && kill((*w)->pid, SIGKILL) != 0) {
+        ERRPRINTF("error sending kill to worker.\n");
+    }
+    waitpid((*w)->pid, &status, 0);
+
+    free(*w);
+    *w = NULL;
+}
+
+/*!
+ * Stop the worker processes of all routines in a configuration
+ *
+ * @param   cfg     pointer to the configuration
+ */
+void
+stop_workers(struct pmm_config *cfg)
+{
+    int i;
+
+    for(i=0; i<cfg->used; i++) {
+        if(cfg->routines[i]->worker != NULL) {
+            stop_worker(&(cfg->routines[i]->worker));
+        }
+    }
+}
+
+/*!
+ * Write a parameter tuple to a worker process as a single line of space
+ * separated integers.
+ *
+ * @param   w       pointer to the worker
+ * @param   params  pointer to the parameter array
+ * @param   n_p     number of parameters
+ *
+ * @return 0 on success, -1 on failure
+ */
+int
+write_worker_params(struct pmm_worker *w, int *params, int n_p)
+{
+    char line[PMM_WORKER_LINE_MAX];
+    int len, i, written;
+
+    len = 0;
+    for(i=0; i<n_p; i++) {
+        len += snprintf(&line[len], sizeof line - len, i == 0 ? "%d" : " %d",
+                        params[i]);
+        if(len >= (int)sizeof line - 1) {
+            ERRPRINTF("Parameter line too long.\n");
+            return -1;
+        }
+    }
+    line[len++] = '\n';
+
+    written = 0;
+    while(written < len) {
+        i = write(w->to_fd, &line[written], len - written);
+        if(i < 0) {
+            if(errno == EINTR)
+                continue;
+            perror("write");
+            return -1;
+        }
+        written += i;
+    }
+
+    return 0;
+}
+
+/*!
+ * Read a result record from a worker process. A record is complete when the
+ * number of lines given by result_record_lines() have been read.
+ *
+ * @param   w           pointer to the worker
+ * @param   r           pointer to the routine, whose timeout and execution
+ *                      conditions are enforced while the worker measures
+ * @param   p           pointer to the pause state of the worker
+ * @param   output_p    pointer to a character array where the record will
+ *                      be stored
+ *
+ * @return 0 on success, -1 on failure (including the worker exiting), 1 if
+ * a quit signal was received while waiting for the record, 2 if the record
+ * was not complete within the timeout, 3 if the execution conditions of the
+ * routine will never hold again
+ */
+int
+read_worker_record(struct pmm_worker *w, struct pmm_routine *r,
+                   struct pmm_pause *p, char **output_p)
+{
+    char *output, *tmp_output;
+    int output_index, output_size;
+    int lines, record_lines;
+    int r_count, i;
+    int status;
+
+    struct timeval tv_select_wait;
+    struct timeval tv_start;
+    fd_set read_set;
+    int select_ret;
+
+    gettimeofday(&tv_start, NULL);
+
+    output_size = 512;
+    output = calloc(output_size, sizeof *output);
+    if(output == NULL) {
+        ERRPRINTF("Error allocating memory.\n");
+        return -1;
+    }
+    output_index = 0;
+    lines = 0;
+    record_lines = -1;
+
+    while(record_lines < 0 || lines < record_lines) {
+
+        FD_ZERO(&read_set);
+        FD_SET(w->from_fd, &read_set);
+
+        // a stopped worker does not time out
+        if(!set_select_wait(&tv_select_wait, &tv_start,
+                            p->paused ? -1 : r->timeout))
+        {
+            free(output);
+            return 2;
+        }
+
+        select_ret = select(w->from_fd+1, &read_set, NULL, NULL,
+                            &tv_select_wait);
+        if(select_ret < 0) {
+            if(errno == EINTR)
+                continue;
+
+            ERRPRINTF("Error waiting for worker output.\n");
+            free(output);
+            return -1;
+        }
+        else if(select_ret > 0) {
+
+            // grow buffer so there is always room for a terminating null
+            if(output_size - output_index < 128) {
+                tmp_output = realloc(output, 2 * output_size * sizeof *output);
+                if(tmp_output == NULL) {
+                    ERRPRINTF("Error reallocating mem. to read buffer.\n");
+                    free(output);
+                    return -1;
+                }
+                output = tmp_output;
+                output_size = 2 * output_size;
+            }
+
+            r_count = read(w->from_fd, &output[output_index],
+                           output_size - output_index - 1);
+            if(r_count < 0) {
+                if(errno == EINTR || errno == EAGAIN)
+                    continue;
+
+                perror("read");
+                free(output);
+                return -1;
+            }
+            else if(r_count == 0) {
+                output[output_index] = '\0';
+
+                if(waitpid(w->pid, &status, WNOHANG) == w->pid &&
+                   WIFEXITED(status))
+                {
+                    ERRPRINTF("worker exited with status:%s.\n",
+                              pmm_bench_exit_status_to_string(
+                                                WEXITSTATUS(status)));
+                }
+                ERRPRINTF("worker output ended, output was:\n--------\n%s"
+                          "---------\n", output);
+
+                free(output);
+                return -1;
+            }
+
+            for(i=output_index; i<output_index+r_count; i++) {
+                if(output[i] == '\n') {
+                    lines++;
+                }
+            }
+            output_index += r_count;
+            output[output_index] = '\0';
+
+            if(record_lines < 0) {
+                record_lines = result_record_lines(output);
+            }
+        }
+
+        // stop or continue the worker as its execution conditions change
+        if((record_lines < 0 || lines < record_lines) &&
+           pause_on_conds(r, w->pid, p, &tv_start))
+        {
+            free(output);
+            return 3;
+        }
+
+        pthread_mutex_lock(&signal_quit_mutex);
+        if(signal_quit) {
+            pthread_mutex_unlock(&signal_quit_mutex);
+
+            LOGPRINTF("signal_quit set, abandoning worker record.\n");
+
+            free(output);
+            return 1;
+        }
+        pthread_mutex_unlock(&signal_quit_mutex);
+    }
+
+    *output_p = output;
+
+    return 0;
+}
+
+/*!
+ * Given an execution slot holding a routine to benchmark, select a point,
+ * execute the benchmark and insert the new point into the model. The slot is
+ * released when the operation is complete (or has failed).
+ *
+ * @param   slot    void pointer to the execution slot structure that a
+ *                  routine has been scheduled into
+ *
+ * @return void pointer to an integer with value of: 0 on success, 1 on quit from signal, -1 on failure
+ */
+void*
+benchmark(void *slot)
+{
+    // TODO decompose some of the fuctionality of this to make it more legible
+    int *ret;
+    int temp_ret;
+    struct pmm_exec_slot *s;
+    struct pmm_routine *r;
+    struct pmm_benchmark *bmark;
+    int *rargs = NULL; //new benchmark point
+    char *cpuset;
+    struct pmm_load_snapshot load_start, load_end;
+    double interference;
+    int n_active;
+
+    char *output;
+
+    s = (struct pmm_exec_slot*)slot;
+    r = s->routine;
+
+    ret = (int*)malloc(sizeof *ret);
+
+#ifdef HAVE_SETAFFINITY
+    // pin this thread to the cpus of the slot, the benchmark process spawned
+    // below inherits the affinity
+    if(set_exec_slot_affinity(s) < 0) {
+        ERRPRINTF("Error setting affinity of execution slot %d.\n", s->id);
+        release_exec_slot(s);
+        *ret = -1;
 
         return (void *)ret;
     }
+#endif
 
+    //evaluate current performance model approximation and pick new
+    //point on the approximation to measure with benchmark, TODO if model
+    //proves to be complete set complete status and return immidiately.
+    //Selection may change the model, so the model writer must not be
+    //serialising it meanwhile
+    pthread_mutex_lock(&(r->model->mutex));
 
-    //LOGPRINTF("filedescriptor returned from popen: %d pid:%d\n", (int)fd,
-    //        bench_pid);
+    if(r->construction_method == CM_NAIVE) {
+        rargs = multi_naive_select_new_bench(r);
+    }
+    else if(r->construction_method == CM_NAIVE_BISECT) {
+        rargs = naive_1d_bisect_select_new_bench(r);
+    }
+    else if(r->construction_method == CM_GBBP) {
+    //  rargs = multi_gbbp_select_new_bench(r);
+        rargs = multi_gbbp_diagonal_select_new_bench(r);
+    }
+    else if(r->construction_method == CM_GBBP_NAIVE) {
+        rargs = multi_gbbp_naive_select_new_bench(r);
+    }
+    else if(r->construction_method == CM_RAND) {
+        rargs = multi_random_select_new_bench(r);
+    }
+    else { // default
+        //rargs = naive_select_new_bench(r);
+    }
+
+    pthread_mutex_unlock(&(r->model->mutex));
+
+    if(rargs == NULL) {
+        ERRPRINTF("Error selecting new benchmark point.\n");
+        release_exec_slot(s);
+        *ret = -1;
+
+        return (void *)ret;
+    }
+
+    take_load_snapshot(&load_start);
+
+    // take routine and execute it passing in the parameters
+    // of the performance model coordinate experiment at
+    if(r->protocol == BP_SERVER) {
+        temp_ret = execute_worker_benchmark(r, s, rargs, &output);
+    }
+    else {
+        temp_ret = execute_benchmark(r, s, rargs, &output);
+    }
 
+    take_load_snapshot(&load_end);
 
-    temp_ret = read_benchmark_output(fd, &output, bench_pid);
     if(temp_ret == -1) {
-        ERRPRINTF("Error reading benchmark output.\n");
+        ERRPRINTF("Error executing benchmark.\n");
 
         free(rargs);
         rargs = NULL;
 
-        set_executing_benchmark(0);
+        release_exec_slot(s);
         *ret = -1; //failure
 
         return (void *)ret;
@@ -781,65 +1768,98 @@ benchmark(void *scheduled_r)
         free(rargs);
         rargs = NULL;
 
-        set_executing_benchmark(0);
+        release_exec_slot(s);
         *ret = 1; //sigquit received
 
         return (void *)ret;
     }
+    else if(temp_ret == 3) {
+        LOGPRINTF("Benchmark conditions failed during execution, no result "
+                  "recorded.\n");
 
+        free(rargs);
+        rargs = NULL;
 
-    //wait for bench to terminate (and retrieve exit status)
-    if(waitpid(bench_pid, &bench_status, 0) != bench_pid) {
-        ERRPRINTF("Error waiting for benchmark to terminate.\n");
-    }
+        release_exec_slot(s);
+        *ret = 1;
 
+        return (void *)ret;
+    }
+    else if(temp_ret == 2) {
+        LOGPRINTF("Benchmark timed out, recording zero speed.\n");
 
-    //check exit status
-    if(WEXITSTATUS(bench_status) != PMM_EXIT_SUCCESS) {
-        ERRPRINTF("benchmark exited with abnormal status:%s.\n",
-                  pmm_bench_exit_status_to_string(WEXITSTATUS(bench_status)));
+        bmark = init_timed_out_benchmark(rargs, r->pd_set->n_p, r->timeout);
+        if(bmark == NULL) {
+            ERRPRINTF("Error creating timed out benchmark.\n");
 
-        ERRPRINTF("output was:\n--------\n%s---------\n", output);
+            free(rargs);
+            rargs = NULL;
 
-        free(output);
-        output = NULL;
+            release_exec_slot(s);
+            *ret = -1; //failure
 
-        free(rargs);
-        rargs = NULL;
+            return (void *)ret;
+        }
+    }
+    else {
+        DBGPRINTF("---output---\n%s------------\n", output);
 
-        set_executing_benchmark(0);
-        *ret = -1; //failure
+        //parse benchmark output
+        bmark = parse_bench_output(output, r->pd_set->n_p, rargs);
 
-        return (void *)ret;
+        free(output);
+        output = NULL;
 
-    }
+        if(bmark == NULL) {
+            ERRPRINTF("Error parsing benchmark output\n");
 
-    DBGPRINTF("---output---\n%s------------\n", output);
+            free(rargs);
+            rargs = NULL;
 
+            release_exec_slot(s);
+            *ret = -1; //failure
 
-    //parse benchmark output
-    if((bmark = parse_bench_output(output, r->pd_set->n_p, rargs)) == NULL) {
-        ERRPRINTF("Error parsing benchmark output\n");
+            return (void *)ret;
+        }
 
-        free(output);
-        output = NULL;
+        //tag the benchmark with the interference of other work during its
+        //execution, the active benchmarks (this one included) are not
+        //interference
+        pthread_mutex_lock(&executing_benchmark_mutex);
+        n_active = executing_benchmark - paused_benchmark;
+        pthread_mutex_unlock(&executing_benchmark_mutex);
 
-        free(rargs);
-        rargs = NULL;
+        interference = calc_interference(r->parent_config->loadhistory,
+                                         &load_start, &load_end, n_active);
 
-        set_executing_benchmark(0);
-        *ret = -1; //failure
+        DBGPRINTF("benchmark interference:%f\n", interference);
+        if(interference > PMM_INTERFERENCE_LOG) {
+            LOGPRINTF("benchmark measured under interference of %.2f.\n",
+                      interference);
+        }
 
-        return (void *)ret;
+        if(add_benchmark_metric(bmark, PMM_METRIC_INTERFERENCE,
+                                interference) < 0) {
+            ERRPRINTF("Error adding interference metric.\n");
+        }
     }
 
-
-    free(output);
-    output = NULL;
+    //record the placement the benchmark was executed with
+    cpuset = r->worker != NULL ? r->worker->cpuset : placement_cpuset(r, s);
+    if(cpuset != NULL) {
+        if(!set_str(&(bmark->cpuset), cpuset)) {
+            ERRPRINTF("Error setting benchmark cpuset.\n");
+        }
+    }
+    bmark->numa_node = r->numa_node;
+    bmark->nice = r->nice;
 
     //DBGPRINTF("bmark:%p\n", bmark);
 
-    //TODO might need a mutex here
+    //insert the benchmark and update the model under the model mutex, the
+    //model writer thread records the changes on disk in the background
+    pthread_mutex_lock(&(r->model->mutex));
+
     temp_ret = 0;
     if(r->construction_method == CM_NAIVE) {
 
@@ -860,7 +1880,7 @@ benchmark(void *scheduled_r)
 
         DBGPRINTF("Inserting benchmark with GBBP.\n");
 
-        temp_ret = multi_gbbp_insert_bench(NULL, r, bmark);
+        temp_ret = multi_gbbp_insert_bench(r, bmark);
 
     }
     else { // default, including CM_RAND
@@ -869,11 +1889,13 @@ benchmark(void *scheduled_r)
 
     // check if benchmark insertion failed
     if(temp_ret < 0) {
+        pthread_mutex_unlock(&(r->model->mutex));
+
         //interval processing failed, bench added though so we will write
         //the model to save the result of the execution
         if(temp_ret == -1) {
             ERRPRINTF("Interval error when inserting new benchmark.\n");
-            write_model(r->model);
+            wake_modelwriter();
         }
         else {
             ERRPRINTF("Error inserting new benchmark.\n");
@@ -882,7 +1904,7 @@ benchmark(void *scheduled_r)
         free(rargs);
         rargs = NULL;
 
-        set_executing_benchmark(0);
+        release_exec_slot(s);
 
         *ret = -1; //failure
 
@@ -899,66 +1921,361 @@ benchmark(void *scheduled_r)
     }
 
     //update number of unwritten benchmarks and the time spent benchmarking
-    //since last write
+    //since last write, the writer compacts the model when they pass the
+    //thresholds of the configuration
     r->model->unwritten_time_spend += timeval_to_double(&(bmark->wall_t));
     r->model->unwritten_num_execs += 1;
 
-    //TODO write model here? why not!
-    if(r->model->complete == 1 ||
-       r->model->unwritten_num_execs >= r->parent_config->num_execs_threshold ||
-       r->model->unwritten_time_spend >= r->parent_config->time_spend_threshold)
-    {
-        DBGPRINTF("Writing model ...\n");
-        temp_ret = write_model(r->model);
-        if(temp_ret < 0) {
-            ERRPRINTF("Error writing model to disk.\n");
-
-            free(rargs);
-            rargs = NULL;
+    pthread_mutex_unlock(&(r->model->mutex));
 
-            set_executing_benchmark(0);
-            *ret = -1; //failure
-
-            return (void *)ret;
-        }
-    }
-    else {
-        DBGPRINTF("Not writing model "
-                  "(unwritten_num_execs/thres:%d/%d "
-                  "unwritten_time_spend/thres:%f/%d) ...\n",
-                  r->model->unwritten_num_execs,
-                  r->parent_config->num_execs_threshold,
-                  r->model->unwritten_time_spend,
-                  r->parent_config->time_spend_threshold);
-    }
+    wake_modelwriter();
 
     free(rargs);
     rargs = NULL;
 
     LOGPRINTF("benchmark thread: finished.\n");
 
-    set_executing_benchmark(0);
+    release_exec_slot(s);
     *ret = 1;
 
     return (void *)ret;
 }
 
 /*!
- * set the executing_benchmark variable via mutex
+ * Get the cpu list a benchmark of a routine is pinned to, the routine cpuset
+ * takes precedence over the cpuset of the execution slot.
+ *
+ * @param   r       pointer to the routine
+ * @param   slot    pointer to the execution slot
+ *
+ * @return pointer to the cpu list string or NULL if the benchmark is not
+ * pinned
+ */
+char*
+placement_cpuset(struct pmm_routine *r, struct pmm_exec_slot *slot)
+{
+    if(r->cpuset != NULL) {
+        return r->cpuset;
+    }
+
+    return slot->cpuset;
+}
+
+/*!
+ * Resolve the cpus, numa node mask and nice value a benchmark of a routine
+ * should be executed with. If a numa node is set, the cpus are restricted to
+ * those of the node.
+ *
+ * @param   pl      pointer to the placement to initialise
+ * @param   r       pointer to the routine
+ * @param   slot    pointer to the execution slot
+ *
+ * @return 0 on success, -1 on failure
+ */
+int
+init_placement(struct pmm_placement *pl, struct pmm_routine *r,
+               struct pmm_exec_slot *slot)
+{
+    char *cpuset;
+#ifdef HAVE_SETAFFINITY
+    char node_path[PATH_MAX];
+    char node_cpus[4096];
+    cpu_set_t node_set;
+    FILE *fp;
+#endif
+
+    cpuset = placement_cpuset(r, slot);
+
+#ifdef HAVE_SETAFFINITY
+    pl->pin = 0;
+    CPU_ZERO(&(pl->cpus));
+
+    if(cpuset != NULL) {
+        if(parse_cpu_list(cpuset, &(pl->cpus)) < 0) {
+            ERRPRINTF("Error parsing cpuset: %s\n", cpuset);
+            return -1;
+        }
+        pl->pin = 1;
+    }
+
+    // restrict cpus to those of the numa node
+    if(r->numa_node >= 0) {
+        snprintf(node_path, PATH_MAX,
+                 "/sys/devices/system/node/node%d/cpulist", r->numa_node);
+
+        fp = fopen(node_path, "r");
+        if(fp == NULL) {
+            ERRPRINTF("Error opening %s\n", node_path);
+            return -1;
+        }
+        if(fgets(node_cpus, sizeof node_cpus, fp) == NULL) {
+            ERRPRINTF("Error reading %s\n", node_path);
+            fclose(fp);
+            return -1;
+        }
+        fclose(fp);
+
+        node_cpus[strcspn(node_cpus, "\n")] = '\0';
+
+        if(parse_cpu_list(node_cpus, &node_set) < 0) {
+            ERRPRINTF("Error parsing cpus of numa node %d.\n", r->numa_node);
+            return -1;
+        }
+
+        if(pl->pin) {
+            CPU_AND(&(pl->cpus), &(pl->cpus), &node_set);
+            if(CPU_COUNT(&(pl->cpus)) == 0) {
+                ERRPRINTF("cpuset %s has no cpus on numa node %d.\n",
+                          cpuset, r->numa_node);
+                return -1;
+            }
+        }
+        else {
+            CPU_OR(&(pl->cpus), &(pl->cpus), &node_set);
+            pl->pin = 1;
+        }
+    }
+#else
+    if(cpuset != NULL) {
+        LOGPRINTF("No sched_setaffinity support, ignoring cpuset %s\n",
+                  cpuset);
+    }
+#endif /* HAVE_SETAFFINITY */
+
+    pl->numa_node = r->numa_node;
+    memset(pl->nodemask, 0, sizeof pl->nodemask);
+    if(pl->numa_node >= 0) {
+        if(pl->numa_node >= PMM_MAX_NUMA_NODES) {
+            ERRPRINTF("numa_node %d exceeds maximum %d.\n", pl->numa_node,
+                      PMM_MAX_NUMA_NODES-1);
+            return -1;
+        }
+        pl->nodemask[pl->numa_node/(8*sizeof(unsigned long))] |=
+            1UL << (pl->numa_node%(8*sizeof(unsigned long)));
+    }
+
+    pl->nice = r->nice;
+    pl->set_nice = (r->nice != 0);
+
+    return 0;
+}
+
+/*!
+ * Apply a placement to the calling process. This is called in the child
+ * after fork, so only system calls are made here.
+ *
+ * @param   pl      pointer to the placement
+ *
+ * @return 0 on success, -1 on failure
+ */
+int
+apply_placement(struct pmm_placement *pl)
+{
+#ifdef HAVE_SETAFFINITY
+    if(pl->pin) {
+        if(sched_setaffinity(0, sizeof pl->cpus, &(pl->cpus)) < 0) {
+            perror("sched_setaffinity");
+            return -1;
+        }
+    }
+#endif
+
+    if(pl->numa_node >= 0) {
+#ifdef SYS_set_mempolicy
+        // maxnode is one greater than the number of bits in the mask
+        if(syscall(SYS_set_mempolicy, PMM_MPOL_BIND, pl->nodemask,
+                   (unsigned long)PMM_MAX_NUMA_NODES+1) < 0)
+        {
+            perror("set_mempolicy");
+            return -1;
+        }
+#endif
+    }
+
+    if(pl->set_nice) {
+        if(setpriority(PRIO_PROCESS, 0, pl->nice) < 0) {
+            perror("setpriority");
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/*!
+ * Allocate and initialise the execution slots of the daemon, as many as
+ * the configured maximum number of concurrent benchmarks.
+ *
+ * @param   cfg     pointer to the configuration
+ *
+ * @return pointer to an array of execution slots or NULL on failure
+ */
+struct pmm_exec_slot*
+new_exec_slots(struct pmm_config *cfg)
+{
+    struct pmm_exec_slot *slots;
+    int i;
+
+    slots = malloc(cfg->max_concurrent_benchmarks * sizeof *slots);
+    if(slots == NULL) {
+        ERRPRINTF("Error allocating memory for execution slots.\n");
+        return NULL;
+    }
+
+    for(i=0; i<cfg->max_concurrent_benchmarks; i++) {
+        slots[i].id = i;
+        slots[i].executing = 0;
+        slots[i].thread_id = 0;
+        slots[i].routine = NULL;
+
+        // slots without a cpuset are not pinned
+        if(i < cfg->n_slot_cpusets) {
+            slots[i].cpuset = cfg->slot_cpusets[i];
+        }
+        else {
+            slots[i].cpuset = NULL;
+        }
+    }
+
+    if(cfg->n_slot_cpusets > cfg->max_concurrent_benchmarks) {
+        LOGPRINTF("Ignoring %d slot cpusets in excess of "
+                  "max_concurrent_benchmarks.\n",
+                  cfg->n_slot_cpusets - cfg->max_concurrent_benchmarks);
+    }
+
+    return slots;
+}
+
+/*!
+ * free an array of execution slots. The cpusets belong to the config and are
+ * not freed.
  *
- * @param   i   value to set variable with
+ * @param   slots   pointer to address of the slot array
  */
 void
-set_executing_benchmark(int i)
+free_exec_slots(struct pmm_exec_slot **slots)
+{
+    free(*slots);
+    *slots = NULL;
+}
+
+/*!
+ * mark an execution slot and the routine it holds as no longer executing,
+ * via mutex, and wake the main loop so it may join the slot thread and reuse
+ * the slot
+ *
+ * @param   slot    pointer to the execution slot
+ */
+void
+release_exec_slot(struct pmm_exec_slot *slot)
 {
     //TODO check return codes
     LOGPRINTF("locking executing_benchmark.\n");
     pthread_mutex_lock (&executing_benchmark_mutex);
-    executing_benchmark = i;
+
+    slot->routine->executing = 0;
+    slot->executing = 0;
+    executing_benchmark--;
+
+    // let the main loop join this thread and refill the slot at once
+    pthread_cond_signal(&scheduler_cond);
+
     LOGPRINTF("unlocking executing_benchmark.\n");
     pthread_mutex_unlock (&executing_benchmark_mutex);
 }
 
+#ifdef HAVE_SETAFFINITY
+/*!
+ * parse a cpu list string of the form "0-3,8,10-11" into a cpu set
+ *
+ * @param   list    pointer to the cpu list string
+ * @param   set     pointer to the cpu set to fill
+ *
+ * @return 0 on success, -1 on a malformed list
+ */
+int
+parse_cpu_list(char *list, cpu_set_t *set)
+{
+    char *copy, *tok, *saveptr;
+    int first, last, cpu, n;
+
+    CPU_ZERO(set);
+
+    copy = malloc(strlen(list) + 1);
+    if(copy == NULL) {
+        ERRPRINTF("Error allocating memory.\n");
+        return -1;
+    }
+    strcpy(copy, list);
+
+    for(tok = strtok_r(copy, ",", &saveptr); tok != NULL;
+        tok = strtok_r(NULL, ",", &saveptr))
+    {
+        n = sscanf(tok, "%d-%d", &first, &last);
+        if(n == 1) {
+            last = first;
+        }
+        else if(n != 2) {
+            ERRPRINTF("Malformed cpu list: %s\n", list);
+            free(copy);
+            return -1;
+        }
+
+        if(first < 0 || last < first || last >= CPU_SETSIZE) {
+            ERRPRINTF("Invalid cpu range in cpu list: %s\n", list);
+            free(copy);
+            return -1;
+        }
+
+        for(cpu=first; cpu<=last; cpu++) {
+            CPU_SET(cpu, set);
+        }
+    }
+
+    free(copy);
+    copy = NULL;
+
+    if(CPU_COUNT(set) == 0) {
+        ERRPRINTF("Empty cpu list.\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+/*!
+ * Set the affinity of the calling thread to the cpus of an execution slot.
+ * Processes forked by the thread afterwards inherit this affinity.
+ *
+ * @param   slot    pointer to the execution slot
+ *
+ * @return 0 on success (or if the slot has no cpuset), -1 on failure
+ */
+int
+set_exec_slot_affinity(struct pmm_exec_slot *slot)
+{
+    cpu_set_t set;
+
+    if(slot->cpuset == NULL) {
+        return 0;
+    }
+
+    if(parse_cpu_list(slot->cpuset, &set) < 0) {
+        ERRPRINTF("Error parsing cpuset of slot %d.\n", slot->id);
+        return -1;
+    }
+
+    if(sched_setaffinity(0, sizeof set, &set) < 0) {
+        perror("sched_setaffinity");
+        return -1;
+    }
+
+    DBGPRINTF("slot %d pinned to cpus: %s\n", slot->id, slot->cpuset);
+
+    return 0;
+}
+#endif /* HAVE_SETAFFINITY */
+
 /*!
  * convert benchmark exit status to a string
  *
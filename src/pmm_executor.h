@@ -24,5 +24,40 @@
 #include "config.h"
 #endif
 
-void *benchmark(void *scheduled_r);
+#include <pthread.h>
+#include <sys/types.h>
+
+#include "pmm_model.h"
+
+/*!
+ * structure describing a benchmark execution slot of the daemon. Each slot
+ * runs at most one benchmark thread at a time.
+ */
+typedef struct pmm_exec_slot {
+    int id;                         //!< index of slot
+    int executing;                  //!< toggle set while a benchmark runs
+    pthread_t thread_id;            //!< benchmark thread of slot (0 if none)
+    char *cpuset;                   //!< cpu list slot is pinned to or NULL
+    struct pmm_routine *routine;    //!< routine benchmarked in slot
+} PMM_Exec_Slot;
+
+/*!
+ * structure describing a persistent benchmark process of a routine using the
+ * server protocol
+ */
+typedef struct pmm_worker {
+    pid_t pid;                      //!< pid of worker process
+    int to_fd;                      //!< pipe to standard input of worker
+    int from_fd;                    //!< pipe from standard output of worker
+    int slot;                       //!< id of slot worker is placed for
+    char *cpuset;                   //!< cpu list worker was pinned to or NULL
+} PMM_Worker;
+
+struct pmm_exec_slot* new_exec_slots(struct pmm_config *cfg);
+void free_exec_slots(struct pmm_exec_slot **slots);
+
+void stop_worker(struct pmm_worker **w);
+void stop_workers(struct pmm_config *cfg);
+
+void *benchmark(void *slot);
 #endif /*PMM_EXECUTOR_H_*/
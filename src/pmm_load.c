@@ -27,12 +27,17 @@
 #include "config.h"
 #endif
 
-#include <stdlib.h>     // for malloc/free
+#include <stdlib.h>     // for malloc/free, getloadavg
+#include <stdio.h>      // for fopen/fscanf
 #include <time.h>       // for time_t
+#include <unistd.h>     // for sysconf
 
 #include "pmm_load.h"
 #include "pmm_log.h"
 
+//! file with the cumulative cpu time counters of the system
+#define PMM_PROC_STAT "/proc/stat"
+
 /*!
  * Allocates and initialises memory for a new load history structure. This is
  * a circular array arrangement with pointers to the beginning and end.
@@ -251,3 +256,120 @@ void free_loadhistory(struct pmm_loadhistory **h) {
     *h = NULL;
 }
 
+/*!
+ * Record the time, 1 minute load average and the cumulative cpu time
+ * counters of the system. The cpu counters are read from /proc/stat where it
+ * exists, elsewhere only the load average is recorded.
+ *
+ * @param   s   pointer to the snapshot to fill
+ *
+ * @return 0 on success, -1 if the load average could not be read
+ */
+int
+take_load_snapshot(struct pmm_load_snapshot *s)
+{
+    FILE *fp;
+    double loadavg[3];
+    unsigned long long v[8];
+    int i;
+
+    s->time = time(NULL);
+    s->have_cpustat = 0;
+
+    // the first line of /proc/stat holds the counters summed over all cpus:
+    // user nice system idle iowait irq softirq steal ...
+    fp = fopen(PMM_PROC_STAT, "r");
+    if(fp != NULL) {
+        if(fscanf(fp, "cpu %llu %llu %llu %llu %llu %llu %llu %llu",
+                  &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7]) == 8)
+        {
+            s->total = 0;
+            for(i=0; i<8; i++) {
+                s->total += v[i];
+            }
+            s->iowait = v[4];
+            s->steal = v[7];
+            s->have_cpustat = 1;
+        }
+        fclose(fp);
+    }
+
+    if(getloadavg(loadavg, 1) < 1) {
+        ERRPRINTF("Error, could not retreive system load average.\n");
+        s->load = 0.0;
+        return -1;
+    }
+    s->load = loadavg[0];
+
+    return 0;
+}
+
+/*!
+ * Estimate the interference of other work with a benchmark that ran between
+ * two snapshots, as the fraction of the capacity of the system that was not
+ * available to benchmarks. Three sources are summed:
+ *
+ * - load in excess of the active benchmarks, averaged over the start and end
+ *   snapshots and any load history samples taken between them, per cpu
+ * - the fraction of cpu time stolen by a hypervisor
+ * - the fraction of cpu time spent waiting for i/o
+ *
+ * @param   h           pointer to the load history or NULL
+ * @param   start       pointer to the snapshot taken before the benchmark
+ * @param   end         pointer to the snapshot taken after the benchmark
+ * @param   n_active    number of benchmarks that were active, including the
+ *                      one measured
+ *
+ * @return interference between 0 (none) and 1 (system fully occupied)
+ */
+double
+calc_interference(struct pmm_loadhistory *h, struct pmm_load_snapshot *start,
+                  struct pmm_load_snapshot *end, int n_active)
+{
+    double load_sum, interference;
+    unsigned long long total;
+    long n_cpus;
+    int n, i;
+
+    load_sum = start->load + end->load;
+    n = 2;
+
+    if(h != NULL && pthread_rwlock_rdlock(&(h->history_rwlock)) == 0) {
+        for(i=h->start_i; i!=h->end_i; i=(i+1)%h->size_mod) {
+            if(h->history[i].time > start->time &&
+               h->history[i].time < end->time)
+            {
+                load_sum += h->history[i].load[0];
+                n++;
+            }
+        }
+        pthread_rwlock_unlock(&(h->history_rwlock));
+    }
+
+    n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if(n_cpus < 1) {
+        n_cpus = 1;
+    }
+
+    interference = (load_sum/n - n_active) / n_cpus;
+    if(interference < 0.0) {
+        interference = 0.0;
+    }
+
+    if(start->have_cpustat && end->have_cpustat && end->total > start->total) {
+        total = end->total - start->total;
+
+        if(end->steal >= start->steal) {
+            interference += (double)(end->steal - start->steal) / total;
+        }
+        if(end->iowait >= start->iowait) {
+            interference += (double)(end->iowait - start->iowait) / total;
+        }
+    }
+
+    if(interference > 1.0) {
+        interference = 1.0;
+    }
+
+    return interference;
+}
@@ -62,6 +62,18 @@ typedef struct pmm_load {
     double load[3]; /*!< 1, 5 & 15 minute load averages TODO use float? */
 } PMM_Load;
 
+/*!
+ * snapshot of the system state at the start or end of a benchmark, used to
+ * estimate the interference of other work with the benchmark
+ */
+typedef struct pmm_load_snapshot {
+    time_t time;                    /*!< time of snapshot */
+    double load;                    /*!< 1 minute load average */
+    int have_cpustat;               /*!< toggle set if cpu counters were read */
+    unsigned long long total;       /*!< total cpu time (/proc/stat ticks) */
+    unsigned long long iowait;      /*!< cpu time idle waiting for i/o */
+    unsigned long long steal;       /*!< cpu time stolen by the hypervisor */
+} PMM_Load_Snapshot;
 
 struct pmm_load* new_load();
 struct pmm_loadhistory* new_loadhistory();
@@ -70,6 +82,10 @@ void add_load(struct pmm_loadhistory *h, struct pmm_load *l);
 int check_loadhistory(struct pmm_loadhistory *h);
 void print_loadhistory(const char *output, struct pmm_loadhistory *h);
 void print_load(const char *output, struct pmm_load *l);
+int take_load_snapshot(struct pmm_load_snapshot *s);
+double calc_interference(struct pmm_loadhistory *h,
+                         struct pmm_load_snapshot *start,
+                         struct pmm_load_snapshot *end, int n_active);
 
 
 #endif /*PMM_LOAD_H_*/
@@ -29,15 +29,19 @@
 
 
 #include <pthread.h>   // for pthreads
+#include <errno.h>     // for ETIMEDOUT
+#include <time.h>      // for clock_gettime
 #include <stdio.h>      //for perror
 #include <stdlib.h>     // for getloadavg/exit
 
 #include "pmm_load.h"
 #include "pmm_log.h"
 #include "pmm_cfgparser.h"
+#include "pmm_scheduler.h"
 
 extern int signal_quit;
 extern pthread_mutex_t signal_quit_mutex;
+extern pthread_cond_t signal_quit_cond;
 
 /*!
  * load monitor thread
@@ -58,8 +62,7 @@ loadmonitor(void *loadhistory)
     int rc;
 
     int sleep_for = 60; //number of seconds we wish to sleep for
-    int sleep_for_counter = 0; //counter for how long we have slept
-    int sleep_for_fraction = 5; //sleep in 5 second fractions
+    struct timespec wake_at; //time to wake from sleep at
 
     int write_period = 10*60; //write the history to disk every 10 minutes
     int write_period_counter=0; //counter for writing history to disk
@@ -97,33 +100,34 @@ loadmonitor(void *loadhistory)
         // unlock the rwlock
         rc = pthread_rwlock_unlock(&(h->history_rwlock));
 
-        //sleep for a total of "sleep_for" seconds, in sleep_for_fraction
-        //segments ...
-        sleep_for_counter = 0;
-        while(sleep_for_counter<=sleep_for) {
-
-            //check we have not received the quit signal
-            pthread_mutex_lock(&signal_quit_mutex);
-            if(signal_quit) {
-                pthread_mutex_unlock(&signal_quit_mutex);
-
-                // write load history to file using xml ...
-                LOGPRINTF("signal_quit set, writing history file ...\n");
-                if(write_loadhistory(h) < 0) {
-                    perror("[loadmonitor]"); //TODO
-                    ERRPRINTF("Error writing history.\n");
-                    exit(EXIT_FAILURE);
-                }
-
-                return (void*)0;
-            }
+        //routine conditions may depend on the new sample
+        wake_scheduler();
+
+        //sleep for "sleep_for" seconds, or until the quit signal is received
+        clock_gettime(CLOCK_REALTIME, &wake_at);
+        wake_at.tv_sec += sleep_for;
+
+        pthread_mutex_lock(&signal_quit_mutex);
+        rc = 0;
+        while(!signal_quit && rc != ETIMEDOUT) {
+            rc = pthread_cond_timedwait(&signal_quit_cond, &signal_quit_mutex,
+                                        &wake_at);
+        }
+
+        if(signal_quit) {
             pthread_mutex_unlock(&signal_quit_mutex);
 
-            //sleep for fraction and add to
-            sleep(sleep_for_fraction);
+            // write load history to file using xml ...
+            LOGPRINTF("signal_quit set, writing history file ...\n");
+            if(write_loadhistory(h) < 0) {
+                perror("[loadmonitor]"); //TODO
+                ERRPRINTF("Error writing history.\n");
+                exit(EXIT_FAILURE);
+            }
 
-            sleep_for_counter += sleep_for_fraction;
+            return (void*)0;
         }
+        pthread_mutex_unlock(&signal_quit_mutex);
 
         write_period_counter += sleep_for;
 
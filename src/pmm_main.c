@@ -35,7 +35,8 @@
 // TODO platform specific code follows, need to fix this
 #include <unistd.h>     // for fork,setsid,getpid
 #include <sys/time.h>
-#include <time.h>       // for nanosleep
+#include <time.h>       // for clock_gettime
+#include <errno.h>      // for ETIMEDOUT
 #include <paths.h>
 #include <sys/types.h>  // for kill,umask,getpid
 #include <sys/stat.h>   // for umask
@@ -44,6 +45,7 @@
 #include "pmm_model.h"
 #include "pmm_load.h"
 #include "pmm_loadmonitor.h"
+#include "pmm_modelwriter.h"
 #include "pmm_argparser.h"
 #include "pmm_cfgparser.h"
 #include "pmm_scheduler.h"
@@ -51,11 +53,17 @@
 #include "pmm_log.h"
 
 //global variables
-int executing_benchmark;
-pthread_mutex_t executing_benchmark_mutex;
+int executing_benchmark; // number of occupied execution slots
+int paused_benchmark; // number of executing benchmarks stopped by conditions
+pthread_mutex_t executing_benchmark_mutex = PTHREAD_MUTEX_INITIALIZER;
+// signalled, with executing_benchmark_mutex, when the main loop should
+// reconsider the execution slots (slot released, load sample, quit)
+pthread_cond_t scheduler_cond = PTHREAD_COND_INITIALIZER;
 
 int signal_quit = 0;
 pthread_mutex_t signal_quit_mutex = PTHREAD_MUTEX_INITIALIZER;
+// broadcast, with signal_quit_mutex, when signal_quit is set
+pthread_cond_t signal_quit_cond = PTHREAD_COND_INITIALIZER;
 
 volatile sig_atomic_t sig_cleanup_received = 0;
 volatile sig_atomic_t sig_pause_received = 0;
@@ -142,12 +150,15 @@ void* signal_handler(void* arg)
                 }
 
                 signal_quit = 1;
+                pthread_cond_broadcast(&signal_quit_cond);
 
                 if(pthread_mutex_unlock(&signal_quit_mutex) != 0) {
                     ERRPRINTF("Error unlocking signal_quit_mutex\n");
                     exit(EXIT_FAILURE);
                 }
 
+                wake_scheduler();
+
                 return NULL; //we are done processing signals
 
                 break;
@@ -158,12 +169,15 @@ void* signal_handler(void* arg)
                 }
 
                 signal_quit = 1;
+                pthread_cond_broadcast(&signal_quit_cond);
 
                 if(pthread_mutex_unlock(&signal_quit_mutex) != 0) {
                     ERRPRINTF("Error unlocking signal_quit_mutex\n");
                     exit(EXIT_FAILURE);
                 }
 
+                wake_scheduler();
+
                 return NULL; //we are done processing signals
 
                 break;
@@ -219,9 +233,12 @@ void redirect_output(char* logfile) {
  * - read configuration file, models and load history
  * - launch load monitoring thread
  * - enter main loop
- *   - if not executing benchmark
- *      - clean up previous benchmark execution
- *      - pick a new benchmark launch benchmarking thread
+ *   - clean up benchmark threads that have finished with their slot
+ *   - while there is a free execution slot
+ *      - pick a new benchmark launch benchmarking thread in the slot
+ *   - wait for an event: a slot being released, a load sample or a
+ *     termination signal. If routines are only waiting on their execution
+ *     conditions, wake after the main sleep period to check them again.
  *
  * All the while checking for termination signals, handling shutdown and so on.
  */
@@ -230,12 +247,15 @@ int main(int argc, char **argv) {
     struct pmm_config *cfg;
     struct pmm_routine *scheduled_r = NULL;
     int scheduled_status = 0;
+    struct timespec wake_at;
 
     int rc;
 
     // benchmark thread variables
+    int i;
     int b_thread_rc;
-    pthread_t b_thread_id = 0;
+    int benchmark_failed = 0;
+    struct pmm_exec_slot *slots;
     pthread_attr_t b_thread_attr;
     void *b_thread_return;
 
@@ -244,6 +264,11 @@ int main(int argc, char **argv) {
     pthread_t l_thread_id = 0;
     pthread_attr_t l_thread_attr;
 
+    // model writer thread variables
+    int w_thread_rc;
+    pthread_t w_thread_id = 0;
+    pthread_attr_t w_thread_attr;
+
     // signal handler thread
     sigset_t signal_set;
     int s_thread_rc;
@@ -335,70 +360,98 @@ int main(int argc, char **argv) {
     }
 
 
+    // launch thread to write benchmarked models to disk
+    pthread_attr_init(&w_thread_attr);
+    pthread_attr_setdetachstate(&w_thread_attr, PTHREAD_CREATE_JOINABLE);
+
+    LOGPRINTF("Starting model writer thread.\n");
+    w_thread_rc = pthread_create(&w_thread_id, &w_thread_attr,
+                                 modelwriter, (void *)cfg);
+
+    if(w_thread_rc != 0) {
+        ERRPRINTF("Error creating thread, return code: %d", w_thread_rc);
+        exit(EXIT_FAILURE);
+    }
+
+
     // possibly launch server thread (listens for requests from an cli utility
     // and from api calls, all over sockets)
 
     // initialize some benchmarking variables
     executing_benchmark = 0;
+    paused_benchmark = 0;
+
+    slots = new_exec_slots(cfg);
+    if(slots == NULL) {
+        ERRPRINTF("Error creating execution slots.\n");
+        exit(EXIT_FAILURE);
+    }
 
     pthread_attr_init(&b_thread_attr);
 
     pthread_attr_setdetachstate(&b_thread_attr, PTHREAD_CREATE_JOINABLE);
-    pthread_mutex_init(&executing_benchmark_mutex, NULL);
+
+    // the main loop holds executing_benchmark_mutex except while waiting
+    pthread_mutex_lock(&executing_benchmark_mutex);
 
     // main loop
     for(;;) {
         //DBGPRINTF("main loop: ...\n");
 
-        //DBGPRINTF("main loop: locking executing_benchmark.\n");
-        pthread_mutex_lock(&executing_benchmark_mutex);
-
-        // if no benchmark is executing
-        if(!executing_benchmark) {
+        // join any benchmark threads that have finished with their slot
+        for(i=0; i<cfg->max_concurrent_benchmarks && !benchmark_failed; i++) {
 
-            //DBGPRINTF("main loop: no benchmark executing.\n");
+            if(slots[i].executing || slots[i].thread_id == 0) {
+                continue;
+            }
 
-            // join any previous benchmark thread (should be finished by now)
-            if(b_thread_id != 0) {
+            DBGPRINTF("main loop: Joining benchmark thread of slot %d.\n", i);
 
-                DBGPRINTF("main loop: Joining previous benchmark thread.\n");
+            b_thread_rc = pthread_join(slots[i].thread_id, &b_thread_return);
 
-                b_thread_rc = pthread_join(b_thread_id, &b_thread_return);
+            if(b_thread_rc != 0) {
+                perror("[main]"); //TODO
+                ERRPRINTF("Error joining previous thread.\n");
+            }
 
-                if(b_thread_rc != 0) {
-                    perror("[main]"); //TODO
-                    ERRPRINTF("Error joining previous thread.\n");
-                }
+            if(*(int*)b_thread_return == 1) { //quit signal
+                LOGPRINTF("Benchmark quit successful.\n");
+            }
+            else if(*(int*)b_thread_return == -1) { //failure
+                ERRPRINTF("Benchmark failure. Shutting down ...\n");
+                //trigger shutdown
+                kill(getpid(), SIGINT);
 
-                if(*(int*)b_thread_return == 1) { //quit signal
-                    LOGPRINTF("Benchmark quit successful.\n");
-                }
-                else if(*(int*)b_thread_return == -1) { //failure
-                    ERRPRINTF("Benchmark failure. Shutting down ...\n");
-                    //trigger shutdown
-                    kill(getpid(), SIGINT);
+                benchmark_failed = 1;
+            }
 
-                    free(b_thread_return);
-                    b_thread_return = NULL;
+            //thread has been finished and cleaned up, reset slot
+            slots[i].thread_id = 0;
+            slots[i].routine = NULL;
 
-                    break;
-                }
+            free(b_thread_return);
+            b_thread_return = NULL;
 
-                //thread has been finished and cleaned up, reset b_thread_id
-                b_thread_id = 0;
+            if(cfg->pause == 1 && !benchmark_failed) {
+                printf("Press enter to continue ...");
+                getchar();
+            }
+        }
 
-                free(b_thread_return);
-                b_thread_return = NULL;
+        if(benchmark_failed) {
+            pthread_mutex_unlock(&executing_benchmark_mutex);
+            break;
+        }
 
-                if(cfg->pause == 1) {
-                    printf("Press enter to continue ...");
-                    getchar();
-                }
+        // fill free execution slots with schedulable routines
+        scheduled_status = 1;
+        while(executing_benchmark < cfg->max_concurrent_benchmarks) {
 
-            }
+            //DBGPRINTF("main loop: free execution slot.\n");
 
             scheduled_status = schedule_routine(&scheduled_r, cfg->routines,
-                                                cfg->used);
+                                                cfg->used,
+                                                cfg->scheduling_policy);
 
             DBGPRINTF("schedule status: %i\n", scheduled_status);
 
@@ -413,46 +466,46 @@ int main(int argc, char **argv) {
 
                 //TODO if all models are built we no longer need to attempt
                 //to schedule one this scheduling loop should be terminated
+                break;
             }
             else if(scheduled_status > 1) {
                 DBGPRINTF("Currently no schedule-able routine.\n");
+                break;
             }
-            else {
-                DBGPRINTF("main loop: routine picked for execution: %s\n",
-                        scheduled_r->name);
-                print_routine(PMM_DBG, scheduled_r);
-
-
-                //launch benchmarking thread TODO seperate into function
-                b_thread_rc = pthread_create(&b_thread_id, &b_thread_attr,
-                                             benchmark, (void *)scheduled_r);
-                if(b_thread_rc != 0) {
-                    ERRPRINTF("Error pthread_create: rc:%d\n", b_thread_rc);
-                } else {
-                    //thread was created successfully
-                    executing_benchmark = 1;
-                }
 
+            // find a free slot, one must exist as executing_benchmark is
+            // less than the number of slots
+            for(i=0; i<cfg->max_concurrent_benchmarks; i++) {
+                if(!slots[i].executing && slots[i].thread_id == 0) {
+                    break;
+                }
             }
-            //DBGPRINTF("[main]: unlocking executing_benchmark.\n");
-            pthread_mutex_unlock(&executing_benchmark_mutex);
 
-        }
-        else {
-            //DBGPRINTF("[main]: unlocking executing_benchmark.\n");
-            pthread_mutex_unlock(&executing_benchmark_mutex);
+            DBGPRINTF("main loop: routine picked for execution in slot %d: "
+                      "%s\n", i, scheduled_r->name);
+            print_routine(PMM_DBG, scheduled_r);
 
-            //DBGPRINTF("main loop: benchmarking executing, do nothing ...\n");
+            slots[i].routine = scheduled_r;
 
-            /* here we are going to recheck that the currently executing bench
-             * mark still satisfies the executing conditions and pause/unpause
-             * or cancel as required */
+            //launch benchmarking thread TODO seperate into function
+            b_thread_rc = pthread_create(&(slots[i].thread_id), &b_thread_attr,
+                                         benchmark, (void *)&(slots[i]));
+            if(b_thread_rc != 0) {
+                ERRPRINTF("Error pthread_create: rc:%d\n", b_thread_rc);
+                slots[i].thread_id = 0;
+                slots[i].routine = NULL;
+                break;
+            } else {
+                //thread was created successfully
+                slots[i].executing = 1;
+                scheduled_r->executing = 1;
+                executing_benchmark++;
+            }
         }
 
-        // sleep for a period
-        nanosleep(&(cfg->ts_main_sleep_period), NULL);
-
-
+        /* executing benchmarks are stopped and continued by their benchmark
+         * threads as their execution conditions change, see pause_on_conds()
+         * in pmm_executor.c */
 
         //check signals
 
@@ -460,24 +513,59 @@ int main(int argc, char **argv) {
         pthread_mutex_lock(&signal_quit_mutex);
         if(signal_quit) {
             pthread_mutex_unlock(&signal_quit_mutex);
+            pthread_mutex_unlock(&executing_benchmark_mutex);
             LOGPRINTF("signal_quit set, breaking from main loop ...\n");
             break;
         }
         // remember to release mutex
         pthread_mutex_unlock(&signal_quit_mutex);
 
+        // wait for the next event. executing_benchmark_mutex is held from
+        // the checks above until we wait, so no event can be missed
+        if(executing_benchmark < cfg->max_concurrent_benchmarks &&
+           scheduled_status > 1 &&
+           schedule_wake_time(cfg->routines, cfg->used,
+                              &(cfg->ts_main_sleep_period), &wake_at))
+        {
+            // routines are waiting on execution conditions, sleep until the
+            // next time window opens or poll conditions which are not
+            // evented (e.g. users logged in)
+            DBGPRINTF("main loop: waiting until %ld.\n", (long)wake_at.tv_sec);
+            pthread_cond_timedwait(&scheduler_cond, &executing_benchmark_mutex,
+                                   &wake_at);
+        }
+        else {
+            pthread_cond_wait(&scheduler_cond, &executing_benchmark_mutex);
+        }
     }
 
-    //join benchmark thread, they will see global variable and exit promptly
-    if(b_thread_id != 0)pthread_join(b_thread_id, NULL);
+    //join benchmark threads, they will see global variable and exit promptly
+    for(i=0; i<cfg->max_concurrent_benchmarks; i++) {
+        if(slots[i].thread_id != 0) {
+            pthread_join(slots[i].thread_id, &b_thread_return);
+            free(b_thread_return);
+            b_thread_return = NULL;
+        }
+    }
     pthread_join(l_thread_id, NULL);
     pthread_join(s_thread_id, NULL);
 
+    //stop the model writer, any models it has yet to write are written below
+    stop_modelwriter();
+    pthread_join(w_thread_id, NULL);
+
+    free_exec_slots(&slots);
+
+    //stop persistent benchmark processes
+    stop_workers(cfg);
+
     //write models
     write_models(cfg);
 
     pthread_mutex_destroy(&signal_quit_mutex);
     pthread_mutex_destroy(&executing_benchmark_mutex);
+    pthread_cond_destroy(&signal_quit_cond);
+    pthread_cond_destroy(&scheduler_cond);
     pthread_rwlock_destroy(&(cfg->loadhistory->history_rwlock));
     //pthread_exit(NULL); this allows a thread to continue executing after the
     //main has finished, don't think we want this here ...
@@ -34,13 +34,33 @@
 #include <time.h>           // for mktime/etc.
 #include <ctype.h>          // for isdigit
 #include <string.h>         // for strcpy/memset
+#include <pthread.h>        // for pthread_mutex_t
+#include <math.h>           // for log/exp
 
 #include "pmm_model.h"
-#include "pmm_octave.h"
 #include "pmm_interval.h"
 #include "pmm_param.h"
 #include "pmm_load.h"
 #include "pmm_log.h"
+#include "pmm_muparse.h"
+
+//! serialises use of the cached interpolation data of models, the averaged
+//! points of 1-D models and the triangulations of others, which are rebuilt,
+//! updated and walked as models are looked up and benchmarks inserted from
+//! several threads at once
+static pthread_mutex_t interpolation_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+#ifdef HAVE_MUPARSER
+//! serialises evaluation of complexity formulae, whose parsers hold the
+//! values of their variables
+static pthread_mutex_t complexity_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+//! initial number of benchmarks the index of a bench list can hold
+#define PMM_BENCH_LIST_INIT_CAPACITY 64
+
+//! initial number of unjournalled benchmarks a model can hold
+#define PMM_UNJOURNALLED_INIT_CAPACITY 8
 
 /*
  * TODO model completion should be a member of the benchmark structure,
@@ -86,6 +106,11 @@ struct pmm_config* new_config() {
 
     c->pause = 0;
 
+    c->max_concurrent_benchmarks = 1;
+    c->scheduling_policy = SP_PRIORITY;
+    c->slot_cpusets = NULL;
+    c->n_slot_cpusets = 0;
+
     return c;
 }
 
@@ -108,14 +133,26 @@ new_routine()
     r->pd_set = new_paramdef_set();
 
     r->condition = CC_INVALID;
+    r->until = (time_t)-1;
+    r->period_start = -1;
+    r->period_end = -1;
     r->priority = -1;
     r->executable = -1;
+    r->executing = 0;
 
     r->construction_method = CM_INVALID;
     r->min_sample_num = -1;
     r->min_sample_time = -1;
     r->max_completion = -1;
 
+    r->cpuset = NULL;
+    r->numa_node = -1;
+    r->nice = 0;
+    r->timeout = -1;
+
+    r->protocol = BP_EXEC;
+    r->worker = NULL;
+
     r->model = new_model();
 
     r->model->parent_routine = r;
@@ -136,11 +173,20 @@ struct pmm_model* new_model()
     m = malloc(sizeof *m);
 
     m->model_path = (void *)NULL;
+    m->format = MF_XML;
     m->unwritten_num_execs = 0;
     m->unwritten_time_spend = 0.0;
 
     m->mtime = 0;
 
+    m->journal_seq = 0;
+    m->journal_size = 0;
+    m->snapshot_size = 0;
+    m->n_unjournalled = 0;
+    m->unjournalled_capacity = 0;
+    m->unjournalled = (void *)NULL;
+    pthread_mutex_init(&(m->mutex), NULL);
+
     m->n_p = -1;
     m->completion = 0;
     m->complete = 0;
@@ -150,6 +196,9 @@ struct pmm_model* new_model()
 
     m->interval_list = new_interval_list();
 
+    m->pd_set = (void *)NULL;
+    m->triangulation = (void *)NULL;
+
     m->parent_routine = (void *)NULL;
 
     return m;
@@ -169,6 +218,11 @@ new_bench_list(struct pmm_model *m,
 {
     struct pmm_bench_list *bl;
 
+    if(n_p <= 0) {
+        ERRPRINTF("Number of parameters must be greater than 0.\n");
+        return NULL;
+    }
+
     bl = malloc(sizeof *bl);
 
     if(bl == NULL) {
@@ -180,11 +234,368 @@ new_bench_list(struct pmm_model *m,
     bl->n_p = n_p;
     bl->first = NULL;
     bl->last = NULL;
+    bl->capacity = 0;
+    bl->index = NULL;
+    bl->params = NULL;
+    bl->flops = NULL;
+    bl->seconds = NULL;
+    bl->n_points = 0;
+    bl->points_capacity = 0;
+    bl->points = NULL;
+    bl->version = 0;
+    bl->n_avg = 0;
+    bl->avg_capacity = 0;
+    bl->avg_p = NULL;
+    bl->avg_flops = NULL;
+    bl->avg_version = 0;
     bl->parent_model = m;
 
+    bl->slab = new_slab(slab_align(sizeof(struct pmm_benchmark))
+                        + n_p * sizeof(int));
+    if(bl->slab == NULL) {
+        ERRPRINTF("Error allocating benchmark slab.\n");
+        free(bl);
+        return NULL;
+    }
+
     return bl;
 }
 
+/*!
+ * Grow the index arrays of a bench list, doubling their capacity
+ *
+ * @param   bl  pointer to the bench list
+ *
+ * @return 0 on success, -1 on failure
+ */
+int
+grow_bench_list_index(struct pmm_bench_list *bl)
+{
+    int capacity;
+    struct pmm_benchmark **index;
+    int *params;
+    double *flops, *seconds;
+
+    capacity = bl->capacity > 0 ? 2*bl->capacity : PMM_BENCH_LIST_INIT_CAPACITY;
+
+    index = realloc(bl->index, capacity * sizeof *index);
+    if(index == NULL) {
+        ERRPRINTF("Error reallocating bench list index.\n");
+        return -1;
+    }
+    bl->index = index;
+
+    params = realloc(bl->params, capacity * bl->n_p * sizeof *params);
+    if(params == NULL) {
+        ERRPRINTF("Error reallocating bench list parameters.\n");
+        return -1;
+    }
+    bl->params = params;
+
+    flops = realloc(bl->flops, capacity * sizeof *flops);
+    if(flops == NULL) {
+        ERRPRINTF("Error reallocating bench list speeds.\n");
+        return -1;
+    }
+    bl->flops = flops;
+
+    seconds = realloc(bl->seconds, capacity * sizeof *seconds);
+    if(seconds == NULL) {
+        ERRPRINTF("Error reallocating bench list times.\n");
+        return -1;
+    }
+    bl->seconds = seconds;
+
+    bl->capacity = capacity;
+
+    return 0;
+}
+
+/*!
+ * Grow the point hash index of a bench list, doubling its capacity and
+ * reinserting the points it holds
+ *
+ * @param   bl  pointer to the bench list
+ *
+ * @return 0 on success, -1 on failure
+ */
+int
+grow_bench_list_points(struct pmm_bench_list *bl)
+{
+    int i, old_capacity;
+    struct pmm_bench_point *old_points, *e;
+
+    old_capacity = bl->points_capacity;
+    old_points = bl->points;
+
+    bl->points_capacity = old_capacity > 0 ? 2*old_capacity
+                                           : PMM_BENCH_LIST_INIT_CAPACITY;
+
+    bl->points = malloc(bl->points_capacity * sizeof *(bl->points));
+    if(bl->points == NULL) {
+        ERRPRINTF("Error allocating bench list point index.\n");
+        bl->points = old_points;
+        bl->points_capacity = old_capacity;
+        return -1;
+    }
+
+    for(i=0; i<bl->points_capacity; i++) {
+        bl->points[i].first = NULL;
+    }
+
+    for(i=0; i<old_capacity; i++) {
+        if(old_points[i].first != NULL) {
+            e = bench_list_point_slot(bl, old_points[i].first->p,
+                                      old_points[i].hash);
+            *e = old_points[i];
+        }
+    }
+
+    free(old_points);
+
+    return 0;
+}
+
+/*!
+ * Find the slot of the point hash index of a bench list that holds a point,
+ * or the empty slot where it would be inserted, by linear probing
+ *
+ * @param   bl      pointer to the bench list
+ * @param   p       pointer to the parameter array of the point
+ * @param   hash    hash of the parameter array
+ *
+ * @return pointer to the slot
+ *
+ * @pre the index has been allocated and is not full
+ */
+struct pmm_bench_point*
+bench_list_point_slot(struct pmm_bench_list *bl, int *p, unsigned int hash)
+{
+    unsigned int mask, i;
+    struct pmm_bench_point *e;
+
+    mask = (unsigned int)bl->points_capacity - 1;
+
+    for(i = hash & mask; ; i = (i + 1) & mask) {
+        e = &(bl->points[i]);
+
+        if(e->first == NULL ||
+           (e->hash == hash && params_cmp(e->first->p, p, bl->n_p) == 0))
+        {
+            return e;
+        }
+    }
+}
+
+/*!
+ * Get the entry of the point hash index of a bench list for a point
+ *
+ * @param   bl  pointer to the bench list
+ * @param   p   pointer to the parameter array of the point
+ *
+ * @return pointer to the entry, owned by the bench list, or NULL if there are
+ * no benchmarks at the point
+ */
+struct pmm_bench_point*
+get_bench_point(struct pmm_bench_list *bl, int *p)
+{
+    struct pmm_bench_point *e;
+
+    if(bl->n_points == 0) {
+        return NULL;
+    }
+
+    e = bench_list_point_slot(bl, p, params_hash(p, bl->n_p));
+
+    return e->first != NULL ? e : NULL;
+}
+
+/*!
+ * Remove an entry from the point hash index of a bench list. Following
+ * entries of the probe sequence are shifted back so that no tombstones are
+ * needed.
+ *
+ * @param   bl  pointer to the bench list
+ * @param   e   pointer to the entry to remove
+ */
+void
+remove_bench_point(struct pmm_bench_list *bl, struct pmm_bench_point *e)
+{
+    unsigned int mask, hole, i, home;
+
+    mask = (unsigned int)bl->points_capacity - 1;
+    hole = (unsigned int)(e - bl->points);
+
+    for(i = (hole + 1) & mask; bl->points[i].first != NULL; i = (i + 1) & mask)
+    {
+        home = bl->points[i].hash & mask;
+
+        // move the entry into the hole unless its home lies cyclically
+        // between the hole and its current slot
+        if(((i - home) & mask) >= ((i - hole) & mask)) {
+            bl->points[hole] = bl->points[i];
+            hole = i;
+        }
+    }
+
+    bl->points[hole].first = NULL;
+    bl->n_points--;
+}
+
+/*!
+ * Find the position in the sorted index of a bench list of the first
+ * benchmark with parameters not less than a target, by binary search
+ *
+ * @param   bl  pointer to the bench list
+ * @param   p   pointer to the target parameter array
+ *
+ * @return position of the first benchmark with parameters equal to or greater
+ * than p, or the size of the list if there is no such benchmark
+ */
+int
+bench_list_lower_bound(struct pmm_bench_list *bl, int *p)
+{
+    int lo, hi, mid;
+
+    lo = 0;
+    hi = bl->size;
+
+    while(lo < hi) {
+        mid = lo + (hi - lo)/2;
+
+        if(params_cmp(&(bl->params[mid*bl->n_p]), p, bl->n_p) < 0) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+/*!
+ * Find the range of positions in the sorted index of a bench list holding
+ * benchmarks with parameters matching a target
+ *
+ * @param   bl      pointer to the bench list
+ * @param   p       pointer to the target parameter array
+ * @param   start   pointer to int set to the first matching position, or -1
+ *                  if there is no match
+ *
+ * @return number of matching benchmarks, which follow start consecutively
+ */
+int
+bench_list_find(struct pmm_bench_list *bl, int *p, int *start)
+{
+    struct pmm_bench_point *e;
+
+    e = get_bench_point(bl, p);
+    if(e == NULL) {
+        *start = -1;
+        return 0;
+    }
+
+    *start = bench_list_lower_bound(bl, p);
+
+    return e->stats.n;
+}
+
+/*!
+ * Find the position of a benchmark in the sorted index of a bench list
+ *
+ * @param   bl  pointer to the bench list
+ * @param   b   pointer to the benchmark
+ *
+ * @return position of the benchmark or -1 if it is not in the list
+ */
+int
+bench_list_index_of(struct pmm_bench_list *bl, struct pmm_benchmark *b)
+{
+    int i, start, n;
+
+    n = bench_list_find(bl, b->p, &start);
+
+    for(i=start; i<start+n; i++) {
+        if(bl->index[i] == b) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/*!
+ * Reset the running statistics of a point to describe no benchmarks
+ *
+ * @param   s   pointer to the statistics
+ */
+void
+init_bench_stats(struct pmm_bench_stats *s)
+{
+    s->n = 0;
+    s->mean_flops = 0.0;
+    s->m2_flops = 0.0;
+    s->min_flops = 0.0;
+    s->max_flops = 0.0;
+    s->seconds = 0.0;
+    s->wall_t.tv_sec = 0;
+    s->wall_t.tv_usec = 0;
+    s->used_t.tv_sec = 0;
+    s->used_t.tv_usec = 0;
+    s->interference = 0.0;
+}
+
+/*!
+ * Add a benchmark to the running statistics of its point, updating the
+ * speed mean and sum of squared differences by Welford's method
+ *
+ * @param   s   pointer to the statistics
+ * @param   b   pointer to the benchmark
+ */
+void
+add_bench_to_stats(struct pmm_bench_stats *s, struct pmm_benchmark *b)
+{
+    double delta;
+
+    s->n++;
+
+    delta = b->flops - s->mean_flops;
+    s->mean_flops += delta / s->n;
+    s->m2_flops += delta * (b->flops - s->mean_flops);
+
+    if(s->n == 1 || b->flops < s->min_flops) {
+        s->min_flops = b->flops;
+    }
+    if(s->n == 1 || b->flops > s->max_flops) {
+        s->max_flops = b->flops;
+    }
+
+    s->seconds += b->seconds;
+    timeval_add(&(s->wall_t), &(b->wall_t), &(s->wall_t));
+    timeval_add(&(s->used_t), &(b->used_t), &(s->used_t));
+    s->interference += get_benchmark_interference(b);
+}
+
+/*!
+ * Get the running statistics of the benchmarks at a point of a bench list
+ *
+ * @param   bl  pointer to the bench list
+ * @param   p   pointer to the parameter array of the point
+ *
+ * @return pointer to the statistics, owned by the bench list, or NULL if
+ * there are no benchmarks at the point
+ */
+struct pmm_bench_stats*
+get_bench_stats(struct pmm_bench_list *bl, int *p)
+{
+    struct pmm_bench_point *e;
+
+    e = get_bench_point(bl, p);
+
+    return e != NULL ? &(e->stats) : NULL;
+}
+
 /*!
  * Initialise the model benchmark list with zero speed benchmarks at relevant
  * points. For each parameter definition if the end value of a parameter is
@@ -211,36 +622,25 @@ init_bench_list(struct pmm_model *m, struct pmm_paramdef_set *pd_set)
     int all_nonzero_end;
     struct pmm_benchmark *b;
 
-    m->bench_list = malloc(sizeof *(m->bench_list));
+    m->bench_list = new_bench_list(m, pd_set->n_p);
     if(m->bench_list == NULL) {
         ERRPRINTF("Error allocating memory.\n");
         return -1; //failure;
     }
 
-    m->bench_list->size = 0;
-    m->bench_list->n_p = pd_set->n_p;
-
-    m->bench_list->first = NULL;
-    m->bench_list->last = NULL;
-
-    m->bench_list->parent_model = m;
-
     // check if any parameters are set to nonzero end (bench at this point
     // instead of assuming it to have zero speed)
     all_nonzero_end = 1;
     for(i=0; i<pd_set->n_p; i++) {
         if(pd_set->pd_array[i].nonzero_end != 1) {
-            b = new_benchmark();
-
-            b->n_p = pd_set->n_p;
-
-            b->p = init_param_array_start(pd_set);
-            if(b->p == NULL) {
+            b = new_list_benchmark(m->bench_list);
+            if(b == NULL) {
                 ERRPRINTF("Error allocating memory.\n");
-                free_benchmark(&b);
                 return -1; //failure
             }
 
+            set_param_array_start(b->p, pd_set);
+
             b->p[i] = pd_set->pd_array[i].end;
 
             b->flops = 0.;
@@ -260,15 +660,14 @@ init_bench_list(struct pmm_model *m, struct pmm_paramdef_set *pd_set)
     // at the end,end...,end point, so set a zero speed benchmark here.
     if(all_nonzero_end != 1) {
 
-        b = new_benchmark();
-
-        b->n_p = pd_set->n_p;
-        b->p = init_param_array_end(pd_set);
-        if(b->p == NULL) {
-            ERRPRINTF("Error initialising end parameters.\n");
+        b = new_list_benchmark(m->bench_list);
+        if(b == NULL) {
+            ERRPRINTF("Error allocating memory.\n");
             return -1;
         }
 
+        set_param_array_end(b->p, pd_set);
+
         b->flops = 0.;
 
 
@@ -322,7 +721,54 @@ new_benchmark()
     struct pmm_benchmark *b;
 
     b = malloc(sizeof *b);
+    if(b == NULL) {
+        ERRPRINTF("Error allocating memory.\n");
+        return NULL;
+    }
+
+    init_benchmark(b);
+
+    return b;
+}
+
+/*!
+ * Allocate a benchmark from the slab of a bench list. The parameter array of
+ * the benchmark is stored inline and is sized for the parameters of the list,
+ * it must not be reassigned.
+ *
+ * @param   bl  pointer to the bench list
+ *
+ * @return pointer to the benchmark with default values and n_p set, or NULL
+ * on failure
+ */
+struct pmm_benchmark*
+new_list_benchmark(struct pmm_bench_list *bl)
+{
+    struct pmm_benchmark *b;
+
+    b = slab_alloc(bl->slab);
+    if(b == NULL) {
+        ERRPRINTF("Error allocating benchmark from slab.\n");
+        return NULL;
+    }
+
+    init_benchmark(b);
+
+    b->slab = bl->slab;
+    b->n_p = bl->n_p;
+    b->p = (int *)((char *)b + slab_align(sizeof *b));
 
+    return b;
+}
+
+/*!
+ * Set the members of a benchmark to failsafe values
+ *
+ * @param   b   pointer to the benchmark
+ */
+void
+init_benchmark(struct pmm_benchmark *b)
+{
     b->n_p = -1;
     b->p = (void *)NULL; //init when assigning parameters
 
@@ -336,10 +782,17 @@ new_benchmark()
     b->used_t.tv_sec = -1;
     b->used_t.tv_usec = -1;
 
+    b->cpuset = (void *)NULL;
+    b->numa_node = -1;
+    b->nice = 0;
+
+    b->n_metrics = 0;
+    b->metrics = (void *)NULL;
+
+    b->slab = (void *)NULL;
+
     b->next = (void *)NULL; //set when inserting into model
     b->previous = (void *)NULL;
-
-    return b;
 }
 
 /*!
@@ -379,6 +832,35 @@ init_zero_benchmark(int *params, int n_p)
     return b;
 }
 
+/*!
+ * Initialize and return a benchmark structure with zero speed, allocated from
+ * the slab of a bench list, in a position described by the parameter array
+ * argument (params).
+ *
+ * @param   bl          pointer to the bench list
+ * @param   params      pointer to parameter array describing benchmark position
+ *
+ * @return  pointer to a newly allocated benchmark structure with zero speed in
+ * given position
+ */
+struct pmm_benchmark*
+init_list_zero_benchmark(struct pmm_bench_list *bl, int *params)
+{
+    struct pmm_benchmark *b;
+
+    b = new_list_benchmark(bl);
+    if(b == NULL) {
+        ERRPRINTF("Error allocating new zero speed benchmark.\n");
+        return NULL;
+    }
+
+    set_param_array_copy(b->p, params, b->n_p);
+
+    b->flops = 0.;
+
+    return b;
+}
+
 /*!
  * This function adds a pmm_routine structure to the routines array of
  * the pmm_config structure. The array is reallocated as required, adding
@@ -479,26 +961,89 @@ insert_bench_into_sorted_list(struct pmm_benchmark **list_start,
 }
 
 /*!
+ * Insert a benchmark into a bench list, keeping the list and its index
+ * sorted. The position is found by binary search of the index, a new
+ * benchmark is placed before any benchmarks with equal parameters.
+ *
+ * @param   bl  pointer to the bench list
+ * @param   b   pointer to the benchmark to insert
+ *
  * @return 0 on success, -1 on failure
  */
 int
 insert_bench_into_list(struct pmm_bench_list *bl,
                        struct pmm_benchmark *b)
 {
-    int ret;
+    int pos, ret, unique;
+    unsigned int hash;
+    struct pmm_bench_point *e;
 
-    if((ret = insert_bench_into_sorted_list(&(bl->first), &(bl->last), b)) < 0)
+    if(bl->size == bl->capacity && grow_bench_list_index(bl) < 0) {
+        ERRPRINTF("Error growing bench list index.\n");
+        return -1;
+    }
+    // keep the point index at most half full so probe sequences stay short
+    if(2*(bl->n_points+1) > bl->points_capacity &&
+       grow_bench_list_points(bl) < 0)
     {
+        ERRPRINTF("Error growing bench list point index.\n");
+        return -1;
+    }
+
+    hash = params_hash(b->p, bl->n_p);
+    e = bench_list_point_slot(bl, b->p, hash);
+
+    unique = e->first == NULL;
+
+    pos = bench_list_lower_bound(bl, b->p);
+
+    if(pos < bl->size) {
+        ret = insert_bench_into_sorted_list_before(&(bl->first), &(bl->last),
+                                                   bl->index[pos], b);
+    }
+    else {
+        ret = insert_bench_into_sorted_list_after(&(bl->first), &(bl->last),
+                                                  bl->last, b);
+    }
+
+    if(ret < 0) {
         print_bench_list(PMM_ERR, bl);
         print_benchmark(PMM_ERR, b);
         ERRPRINTF("Error inserting bench into list.\n");
         return -1;
     }
 
+    memmove(&(bl->index[pos+1]), &(bl->index[pos]),
+            (bl->size - pos) * sizeof *(bl->index));
+    memmove(&(bl->params[(pos+1)*bl->n_p]), &(bl->params[pos*bl->n_p]),
+            (bl->size - pos) * bl->n_p * sizeof *(bl->params));
+    memmove(&(bl->flops[pos+1]), &(bl->flops[pos]),
+            (bl->size - pos) * sizeof *(bl->flops));
+    memmove(&(bl->seconds[pos+1]), &(bl->seconds[pos]),
+            (bl->size - pos) * sizeof *(bl->seconds));
+
+    bl->index[pos] = b;
+    memcpy(&(bl->params[pos*bl->n_p]), b->p, bl->n_p * sizeof *(bl->params));
+    bl->flops[pos] = b->flops;
+    bl->seconds[pos] = b->seconds;
+
+    if(unique) {
+        e->hash = hash;
+        init_bench_stats(&(e->stats));
+        bl->n_points++;
+    }
+
+    // b was placed before any other benchmarks at its point
+    e->first = b;
+    add_bench_to_stats(&(e->stats), b);
+
     // in any case, if we reach this point, a benchmark has been inserted
     bl->size++;
+    bl->version++;
     bl->parent_model->completion++;
-    bl->parent_model->unique_benches += ret;
+    bl->parent_model->unique_benches += unique;
+
+    update_model_triangulation(bl->parent_model, b->p, e->stats.mean_flops);
 
     return 0;
 
@@ -507,7 +1052,8 @@ insert_bench_into_list(struct pmm_bench_list *bl,
 
 /*!
  * Add benchmark to a model in the appropriate substructure of
- * the model
+ * the model. The benchmark is also remembered as new to the model, so that
+ * the next record appended to the model journal contains it.
  *
  * @param   m   pointer to the model
  * @param   b   pointer to the benchmark
@@ -521,6 +1067,22 @@ int
 insert_bench(struct pmm_model *m, struct pmm_benchmark *b)
 {
     int ret;
+    int capacity;
+    struct pmm_benchmark **unjournalled;
+
+    // make room to remember b until it is appended to the model journal
+    if(m->n_unjournalled == m->unjournalled_capacity) {
+        capacity = m->unjournalled_capacity > 0 ?
+                   2*m->unjournalled_capacity : PMM_UNJOURNALLED_INIT_CAPACITY;
+
+        unjournalled = realloc(m->unjournalled, capacity * sizeof *unjournalled);
+        if(unjournalled == NULL) {
+            ERRPRINTF("Error reallocating unjournalled benchmarks.\n");
+            return -1;
+        }
+        m->unjournalled = unjournalled;
+        m->unjournalled_capacity = capacity;
+    }
 
     ret = insert_bench_into_list(m->bench_list, b);
     if(ret < 0) {
@@ -528,9 +1090,33 @@ insert_bench(struct pmm_model *m, struct pmm_benchmark *b)
         return ret;
     }
 
+    m->unjournalled[m->n_unjournalled++] = b;
+
     return ret;
 }
 
+/*!
+ * Forget the first benchmarks remembered as new to a model, once they have
+ * reached the disk in the model file or a journal record. Benchmarks
+ * inserted after those are still remembered.
+ *
+ * @param   m   pointer to the model
+ * @param   n   number of benchmarks on disk
+ *
+ * @pre the caller holds the model mutex
+ */
+void
+release_unjournalled(struct pmm_model *m, int n)
+{
+    if(n <= 0) {
+        return;
+    }
+
+    memmove(&(m->unjournalled[0]), &(m->unjournalled[n]),
+            (m->n_unjournalled - n) * sizeof *(m->unjournalled));
+    m->n_unjournalled -= n;
+}
+
 
 /*!
  *
@@ -585,19 +1171,16 @@ int is_benchmark_at_origin(int n, struct pmm_paramdef *pd_array,
 int
 isempty_model(struct pmm_model *m)
 {
-    struct pmm_benchmark *b;
-
+    int i;
 
-    b = m->bench_list->first;
-    if(b == NULL) {
+    if(m->bench_list->size == 0) {
         ERRPRINTF("Mesh model not initialized.\n");
     }
 
-    while(b != NULL) {
-        if(b->flops != 0.0) {
+    for(i=0; i<m->bench_list->size; i++) {
+        if(m->bench_list->flops[i] != 0.0) {
             return 0;
         }
-        b=b->next;
     }
 
     //list is empty of experimental points
@@ -701,6 +1284,7 @@ benchmark_on_axis(struct pmm_model *m,
  */
 int copy_benchmark(struct pmm_benchmark *dst, struct pmm_benchmark *src)
 {
+    int i;
 
     dst->n_p = src->n_p;
 
@@ -718,6 +1302,24 @@ int copy_benchmark(struct pmm_benchmark *dst, struct pmm_benchmark *src)
     copy_timeval(&dst->wall_t, &src->wall_t);
     copy_timeval(&dst->used_t, &src->used_t);
 
+    if(src->cpuset != NULL) {
+        if(!set_str(&(dst->cpuset), src->cpuset)) {
+            ERRPRINTF("Error copying cpuset.\n");
+            return -1;
+        }
+    }
+    dst->numa_node = src->numa_node;
+    dst->nice = src->nice;
+
+    for(i=0; i<src->n_metrics; i++) {
+        if(add_benchmark_metric(dst, src->metrics[i].name,
+                                src->metrics[i].value) < 0)
+        {
+            ERRPRINTF("Error copying metric.\n");
+            return -1;
+        }
+    }
+
     dst->next = (void *)NULL;
     dst->previous = (void *)NULL;
 
@@ -725,6 +1327,94 @@ int copy_benchmark(struct pmm_benchmark *dst, struct pmm_benchmark *src)
 }
 
 
+/*!
+ * Add a named metric to the metrics array of a benchmark
+ *
+ * @param   b       pointer to the benchmark
+ * @param   name    name of the metric (copied)
+ * @param   value   value of the metric
+ *
+ * @return 0 on success, -1 on failure
+ */
+int add_benchmark_metric(struct pmm_benchmark *b, char *name, double value)
+{
+    struct pmm_metric *temp;
+
+    temp = realloc(b->metrics, (b->n_metrics+1) * sizeof *(b->metrics));
+    if(temp == NULL) {
+        ERRPRINTF("Error reallocating metrics array.\n");
+        return -1;
+    }
+    b->metrics = temp;
+
+    b->metrics[b->n_metrics].name = NULL;
+    if(!set_str(&(b->metrics[b->n_metrics].name), name)) {
+        ERRPRINTF("Error setting metric name.\n");
+        return -1;
+    }
+    b->metrics[b->n_metrics].value = value;
+
+    b->n_metrics++;
+
+    return 0;
+}
+
+/*!
+ * Get the value of a named metric of a benchmark
+ *
+ * @param   b       pointer to the benchmark
+ * @param   name    name of the metric
+ * @param   value   pointer to a double where the value will be stored
+ *
+ * @return 0 if the metric was found, -1 if it was not
+ */
+int get_benchmark_metric(struct pmm_benchmark *b, char *name, double *value)
+{
+    int i;
+
+    for(i=0; i<b->n_metrics; i++) {
+        if(strcmp(b->metrics[i].name, name) == 0) {
+            *value = b->metrics[i].value;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+/*!
+ * Get the interference of other work with a benchmark
+ *
+ * @param   b       pointer to the benchmark
+ *
+ * @return the interference metric of the benchmark, or 0 if it has none
+ */
+double get_benchmark_interference(struct pmm_benchmark *b)
+{
+    double value;
+
+    if(get_benchmark_metric(b, PMM_METRIC_INTERFERENCE, &value) < 0) {
+        return 0.0;
+    }
+
+    return value;
+}
+
+/*!
+ * Test if a benchmark was recorded for a point where the benchmark exceeded
+ * the timeout of its routine
+ *
+ * @param   b       pointer to the benchmark
+ *
+ * @return 1 if the benchmark timed out, 0 if it did not
+ */
+int is_benchmark_timed_out(struct pmm_benchmark *b)
+{
+    double value;
+
+    return get_benchmark_metric(b, PMM_METRIC_TIMED_OUT, &value) == 0 &&
+           value != 0.;
+}
 /*!
  * Insert benchmark into a sorted list in a position directly before a
  * certain benchmark.
@@ -851,58 +1541,33 @@ remove_bench_from_sorted_list(struct pmm_benchmark **list_first,
                               struct pmm_benchmark *b)
 {
 
-    if(b == *list_first && b == *list_last) { //list only has one point
-        if(b->next != NULL || b->previous != NULL) {
-            ERRPRINTF("benchmark is both first and last of list, but has "
-                      "non-NULL next / previous pointers.\n");
-            return -1;
-        }
-
-        *list_first = NULL;
-        *list_last = NULL;
-
+    if(b->previous != NULL) {
+        b->previous->next = b->next;
     }
     else if(b == *list_first) { //b is first in the list
-        if(b->next != NULL) {
-            ERRPRINTF("benchmark is first in list but has non-NULL next "
-                      "pointer.\n");
-            return -1;
-        }
-
-        *list_first = b->previous;
-
-        if(b->previous != NULL) {
-            b->previous->next = NULL;
-            b->previous = NULL;
-        }
+        *list_first = b->next;
     }
-    else if(b == *list_last) { //b is last in list
-        if(b->previous != NULL) {
-            ERRPRINTF("benchmark is last in list but has non-NULL previous"
-                      "pointer.\n");
-            return -1;
-        }
-
-        *list_last = b->next;
-
-        if(b->next != NULL) {
-            b->next->previous = NULL;
-            b->next = NULL;
-        }
+    else {
+        ERRPRINTF("benchmark is not first in list but has NULL previous "
+                  "pointer.\n");
+        return -1;
     }
-    else { //b is at some point in the middle of the list
-        if(b->next == NULL || b->previous == NULL) {
-            ERRPRINTF("benchmark not at start / end of list but has NULL next "
-                      "/ previous pointers.\n");
-            return -1;
-        }
 
+    if(b->next != NULL) {
         b->next->previous = b->previous;
-        b->previous->next = b->next;
-        b->next = NULL;
-        b->previous = NULL;
+    }
+    else if(b == *list_last) { //b is last in the list
+        *list_last = b->previous;
+    }
+    else {
+        ERRPRINTF("benchmark is not last in list but has NULL next "
+                  "pointer.\n");
+        return -1;
     }
 
+    b->next = NULL;
+    b->previous = NULL;
+
     return 0; //success
 }
 
@@ -922,15 +1587,53 @@ int
 remove_bench_from_bench_list(struct pmm_bench_list *bl,
                              struct pmm_benchmark *b)
 {
+    int i, pos, n;
+    struct pmm_bench_point *e;
+
+    pos = bench_list_index_of(bl, b);
+    if(pos < 0) {
+        ERRPRINTF("Benchmark not found in bench list index.\n");
+        return -1;
+    }
 
     if(remove_bench_from_sorted_list(&(bl->first), &(bl->last), b) < 0) {
         ERRPRINTF("Error removing benchmark from bench list.\n");
         return -1;
     }
 
+    memmove(&(bl->index[pos]), &(bl->index[pos+1]),
+            (bl->size - pos - 1) * sizeof *(bl->index));
+    memmove(&(bl->params[pos*bl->n_p]), &(bl->params[(pos+1)*bl->n_p]),
+            (bl->size - pos - 1) * bl->n_p * sizeof *(bl->params));
+    memmove(&(bl->flops[pos]), &(bl->flops[pos+1]),
+            (bl->size - pos - 1) * sizeof *(bl->flops));
+    memmove(&(bl->seconds[pos]), &(bl->seconds[pos+1]),
+            (bl->size - pos - 1) * sizeof *(bl->seconds));
+
     bl->size--;
+    bl->version++;
     bl->parent_model->completion--;
 
+    e = get_bench_point(bl, b->p);
+    n = e->stats.n - 1;
+
+    // the point is no longer in the list if b was its only benchmark,
+    // otherwise rebuild its statistics from the remaining benchmarks as the
+    // running values cannot be reliably unwound
+    if(n == 0) {
+        remove_bench_point(bl, e);
+        bl->parent_model->unique_benches--;
+    }
+    else {
+        pos = bench_list_lower_bound(bl, b->p);
+
+        e->first = bl->index[pos];
+        init_bench_stats(&(e->stats));
+        for(i=pos; i<pos+n; i++) {
+            add_bench_to_stats(&(e->stats), bl->index[i]);
+        }
+    }
+
     return 0; //success
 }
 
@@ -1102,10 +1805,14 @@ get_sublist_from_bench_list(struct pmm_bench_list *bl,
                             struct pmm_benchmark **first,
                             struct pmm_benchmark **last)
 {
+    int start, n;
+
+    n = bench_list_find(bl, param, &start);
 
-    return search_sorted_bench_list(SEARCH_FORWARDS, bl->first, param, bl->n_p,
-                                    first, last);
+    *first = n > 0 ? bl->index[start] : NULL;
+    *last = n > 1 ? bl->index[start+n-1] : NULL;
 
+    return n;
 }
 
 /*!
@@ -1325,6 +2032,8 @@ avg_bench_list(struct pmm_benchmark *start, struct pmm_benchmark *end,
                    struct pmm_benchmark *avg_b)
 {
     double divisor = 0.0;
+    double interference = 0.0;
+    struct pmm_benchmark *this;
 
     zero_benchmark(avg_b); //zero ret_b benchmark data
 
@@ -1332,6 +2041,22 @@ avg_bench_list(struct pmm_benchmark *start, struct pmm_benchmark *end,
 
     div_bench(avg_b, divisor, avg_b);
 
+    //the average carries the mean interference of its benchmarks so that
+    //comparisons with it use a load-adjusted speed band
+    for(this = start; ; this = this->next) {
+        interference += get_benchmark_interference(this);
+        if(this == end) {
+            break;
+        }
+    }
+
+    if(interference > 0.0) {
+        if(add_benchmark_metric(avg_b, PMM_METRIC_INTERFERENCE,
+                                interference/divisor) < 0) {
+            ERRPRINTF("Error adding interference metric to average.\n");
+        }
+    }
+
     return;
 }
 
@@ -1596,18 +2321,11 @@ struct pmm_benchmark*
 get_first_bench_from_bench_list(struct pmm_bench_list *bl,
                                 int *p)
 {
-    struct pmm_benchmark *b;
-
-    b = bl->first;
+    struct pmm_bench_point *e;
 
-    while(b != NULL) {
-        if(params_cmp(b->p, p, bl->n_p == 0)) {
-            return b;
-        }
-        b = b->next;
-    }
+    e = get_bench_point(bl, p);
 
-    return b; //b should be NULL at this point
+    return e != NULL ? e->first : NULL;
 
 }
 
@@ -1732,14 +2450,51 @@ get_avg_aligned_bench(struct pmm_model *m, int *param)
 struct pmm_benchmark*
 get_avg_bench(struct pmm_model *m, int *p)
 {
-    struct pmm_benchmark *b;
+    struct pmm_bench_point *e;
+    struct pmm_bench_stats *s;
+    struct pmm_benchmark *ret_b;
 
-    b = (void *)NULL;
+    e = get_bench_point(m->bench_list, p);
+    if(e == NULL) {
+        return NULL;
+    }
+    s = &(e->stats);
 
-    b = get_avg_bench_from_sorted_bench_list(m->bench_list->first, p);
+    ret_b = new_benchmark();
 
-    return b;
+    if(s->n == 1) {
+        copy_benchmark(ret_b, e->first);
+        return ret_b;
+    }
 
+    // the average is taken from the running statistics of the point rather
+    // than by summing its benchmarks
+    ret_b->n_p = m->n_p;
+    ret_b->p = init_param_array_copy(p, ret_b->n_p);
+    if(ret_b->p == NULL) {
+        ERRPRINTF("Error copying parameter array.\n");
+        free_benchmark(&ret_b);
+        return NULL;
+    }
+
+    ret_b->complexity = e->first->complexity;
+
+    ret_b->flops = s->mean_flops;
+    ret_b->seconds = s->seconds / s->n;
+
+    copy_timeval(&(ret_b->wall_t), &(s->wall_t));
+    copy_timeval(&(ret_b->used_t), &(s->used_t));
+    timeval_div(&(ret_b->wall_t), (double)s->n);
+    timeval_div(&(ret_b->used_t), (double)s->n);
+
+    if(s->interference > 0.0) {
+        if(add_benchmark_metric(ret_b, PMM_METRIC_INTERFERENCE,
+                                s->interference / s->n) < 0) {
+            ERRPRINTF("Error adding interference metric to average.\n");
+        }
+    }
+
+    return ret_b;
 }
 
 /*!
@@ -1760,38 +2515,19 @@ void
 calc_bench_exec_stats(struct pmm_model *m, int *param,
                       double *time_spent, int *num_execs)
 {
-    struct pmm_benchmark *b;
-    struct pmm_benchmark *first, *last;
-
-    *num_execs = 0;
-    first = NULL;
-    last = NULL;
-
-    //allocate bench and zero ... don't care about copying param array
-    b = new_benchmark();
-    zero_benchmark(b);
-
+    struct pmm_bench_stats *s;
 
-    // find a sublist of matching benchmarks
-    get_sublist_from_bench_list(m->bench_list, param, &first, &last);
+    s = get_bench_stats(m->bench_list, param);
 
-    if(first == NULL) {
-        // nothing found, leave b empty
-    }
-    else if(last == NULL) {
-        // only one bench found in boundary (only need the wall_t)
-        copy_timeval(&(b->wall_t), &(first->wall_t));
-        *num_execs = 1;
+    if(s == NULL) {
+        *num_execs = 0;
+        *time_spent = 0.0;
     }
     else {
-        // sum the benchmarks found between first and last
-        *num_execs = sum_bench_list(first, last, b);
+        *num_execs = s->n;
+        *time_spent = timeval_to_double(&(s->wall_t));
     }
 
-    *time_spent = timeval_to_double(&(b->wall_t));
-
-    free_benchmark(&b);
-
     return;
 }
 
@@ -1814,276 +2550,1038 @@ calc_model_stats(struct pmm_model *m)
     while(b != NULL) {
         total_time += timeval_to_double(&(b->wall_t));
 
-        b = b->next;
+        b = b->next;
+    }
+
+    return total_time;
+}
+
+/*!
+ * Function removes benchmarks from a model that have parameters that match
+ * a target set. Removed benchmarks are all not deallocated, their addresses
+ * are stored in an array passed to the function as removed_array
+ *
+ * @param   m               pointer to the model
+ * @param   p               pointer to an array of parameters
+ * @param   removed_array   pointer to unallocated array of benchmarks
+ *
+ * @return the number of benchmarks found and removed from the model or -1 on
+ * error
+ *
+ * @pre removed_array is unallocated
+ * @post removed_array is allocated with a size matching the number of
+ * benchmarks found and removed
+ */
+int
+remove_benchmarks_at_param(struct pmm_model *m, int *p,
+                           struct pmm_benchmark ***removed_array)
+{
+    int n, c;
+
+    struct pmm_benchmark *first, *last, *this, *temp;
+
+
+    n = get_sublist_from_bench_list(m->bench_list, p, &first, &last);
+
+    if(n == 0) {
+        return 0; //nothing found
+    }
+
+    DBGPRINTF("allocating remove_array of %d elemenets of size %lu.\n",
+              n, sizeof(*removed_array));
+
+    (*removed_array) = malloc(n * sizeof *(*removed_array));
+    if((*removed_array) == NULL) {
+        ERRPRINTF("Error allocating memory.\n");
+        return -1;
+    }
+
+    this = first;
+    c = 0;
+    while(c < n) {
+        DBGPRINTF("removing %p temporarily\n", this);
+        print_benchmark(PMM_DBG, this);
+
+        // store the next as this will be unplugged by remove_bench_...
+        temp = this->next;
+
+        //remove benchmarks between first/last from model
+        remove_bench_from_bench_list(m->bench_list, this);
+
+
+        DBGPRINTF("saving %p at position %d in removed_array %p\n",
+                this, c, (*removed_array));
+
+        //add removed to array
+        (*removed_array)[c] = this;
+        c++;
+
+        this = temp; //next
+    }
+
+
+    return n;
+}
+
+/*!
+ * find_oldapprox will find the approximation of performance at a target point
+ * in a model, ignoring any data points that happen to be at that target point.
+ * The main use of this function is to find what the approximation of a model
+ * was before a data point was added to the model.
+ *
+ * @param   m   pointer to the model
+ * @param   p   pointer to a parameter array describing the target point
+ *
+ * @return a pointer to a newly allocated benchmark that gives an approximation
+ * of the model at the target point, ignoring any data at the exact point or
+ * NULL on error
+ */
+struct pmm_benchmark *
+find_oldapprox(struct pmm_model *m, int *p)
+{
+    struct pmm_benchmark *b;
+    struct pmm_benchmark **removed_benchmarks_array; //array of pointers
+    int i;
+    int n_removed;
+
+    // models of 2 or more parameters can be interpolated around the point
+    // without taking its benchmarks out of the model
+    if(m->n_p > 1) {
+        pthread_mutex_lock(&interpolation_mutex);
+        b = interpolate_delaunay_model(m, p, 1);
+        pthread_mutex_unlock(&interpolation_mutex);
+
+        if(b == NULL) {
+            ERRPRINTF("Error looking up model.\n");
+        }
+
+        return b;
+    }
+
+    // remove benchmarks from model with matching parameter to p
+    n_removed = remove_benchmarks_at_param(m, p, &removed_benchmarks_array);
+
+
+    //lookup version of model with benchmarks removed
+    b = lookup_model(m, p);
+    if(b == NULL) {
+        ERRPRINTF("Error looking up model.\n");
+    }
+
+    //re-insert removed benchmarks back into model, directly into the list
+    //as they are not new to the model
+    for(i=0; i<n_removed; i++) {
+        insert_bench_into_list(m->bench_list, removed_benchmarks_array[i]);
+    }
+
+    //return approximation b
+    return b;
+}
+
+/*!
+ * Call the appropriate lookup function to find value of model
+ * given a set of parameters. The complexity and predicted execution time at
+ * the point are also set in the benchmark returned, as described by
+ * lookup_model_batch(), which gives the same results.
+ *
+ * @param   m       pointer to model
+ * @param   p       array of parameters
+ *
+ * @return  newly allocated benchmark describing performance at
+ * p or NULL on failure
+ */
+struct pmm_benchmark* lookup_model(struct pmm_model *m, int *p)
+{
+    struct pmm_benchmark *b;
+    double complexity;
+
+    b = NULL;
+
+    if(m->n_p == 1) {
+        pthread_mutex_lock(&interpolation_mutex);
+        b = interpolate_1d_model(m->bench_list, p);
+        pthread_mutex_unlock(&interpolation_mutex);
+    }
+    else {
+        // n-dimensional interpolation within the delaunay triangulation
+        pthread_mutex_lock(&interpolation_mutex);
+        b = interpolate_delaunay_model(m, p, 0);
+        pthread_mutex_unlock(&interpolation_mutex);
+    }
+
+    if(b != NULL) {
+        estimate_model_complexity(m, p, 1, &complexity);
+        if(complexity > 0.) {
+            b->complexity = (long long int)complexity;
+        }
+        b->seconds = predict_point_seconds(m, p, b->flops, complexity);
+    }
+
+    return b;
+}
+
+/*!
+ * Get the parameter definitions of a model, those stored with the model or
+ * otherwise those of its routine
+ *
+ * @param   m       pointer to the model
+ *
+ * @return pointer to the parameter definitions or NULL if the model has none
+ */
+struct pmm_paramdef_set*
+get_model_paramdef_set(struct pmm_model *m)
+{
+    if(m->pd_set != NULL) {
+        return m->pd_set;
+    }
+
+    if(m->parent_routine != NULL) {
+        return m->parent_routine->pd_set;
+    }
+
+    return NULL;
+}
+
+/*!
+ * Evaluate the complexity formula declared for the routine of a model at
+ * a number of points. The formula is compiled once, when the parameter
+ * definitions are parsed.
+ *
+ * @param   m           pointer to the model
+ * @param   p           pointer to the parameter arrays of the points, n_p
+ *                      consecutive values for each point
+ * @param   n           number of points
+ * @param   complexity  pointer to array of n doubles where the complexity at
+ *                      each point is stored
+ *
+ * @return 0 on success, -1 if there is no complexity formula or it cannot be
+ * evaluated
+ */
+int
+calc_model_complexity(struct pmm_model *m, int *p, int n, double *complexity)
+{
+#ifdef HAVE_MUPARSER
+    struct pmm_paramdef_set *pd_set;
+    int i, ret;
+
+    pd_set = get_model_paramdef_set(m);
+    if(pd_set == NULL || pd_set->complexity_parser == NULL) {
+        return -1;
+    }
+
+    ret = 0;
+
+    pthread_mutex_lock(&complexity_mutex);
+
+    for(i=0; i<n && ret == 0; i++) {
+        ret = evaluate_constraint_with_params(pd_set->complexity_parser,
+                                              &(p[i*m->n_p]),
+                                              &(complexity[i]));
+    }
+
+    pthread_mutex_unlock(&complexity_mutex);
+
+    return ret;
+#else
+    (void)m;
+    (void)p;
+    (void)n;
+    (void)complexity;
+
+    return -1;
+#endif
+}
+
+/*!
+ * Predict the wall clock time a benchmark at a point will take, from the
+ * benchmarks already in the model. This is lookup_model_batch() at a single
+ * point, which describes how the time is predicted.
+ *
+ * @param   m       pointer to the model
+ * @param   p       pointer to the parameter array of the point
+ *
+ * @return predicted execution time in seconds or -1 if the model does not hold
+ * enough data for a prediction
+ */
+double
+predict_bench_seconds(struct pmm_model *m, int *p)
+{
+    double flops, seconds;
+
+    if(lookup_model_batch(m, p, 1, &flops, &seconds) < 0) {
+        return -1.;
+    }
+
+    return seconds;
+}
+
+/*!
+ * Fit c = a*(p_0*p_1*...*p_n)^k, in log-log space, to the complexity
+ * reported by the benchmarks of a model, with k = 1 if they do not determine
+ * it.
+ *
+ * @param   m       pointer to the model
+ * @param   a       pointer to where the log of the coefficient is stored
+ * @param   k       pointer to where the exponent is stored
+ *
+ * @return number of benchmarks the fit was made to, 0 if no benchmarks report
+ * their complexity
+ */
+int
+fit_model_complexity(struct pmm_model *m, double *a, double *k)
+{
+    struct pmm_benchmark *b;
+    double x, y, sx, sy, sxx, sxy;
+    double d;
+    int n, j;
+
+    n = 0;
+    sx = sy = sxx = sxy = 0.;
+
+    for(b=m->bench_list->first; b!=NULL; b=b->next) {
+        if(b->complexity <= 0 || b->flops <= 0.) {
+            continue;
+        }
+
+        x = 0.;
+        for(j=0; j<m->n_p; j++) {
+            if(b->p[j] <= 0) {
+                break;
+            }
+            x += log((double)b->p[j]);
+        }
+        if(j < m->n_p) {
+            continue;
+        }
+
+        y = log((double)b->complexity);
+
+        n++;
+        sx += x;
+        sy += y;
+        sxx += x*x;
+        sxy += x*y;
+    }
+
+    if(n == 0) {
+        return 0;
+    }
+
+    // least squares slope, if the benchmarks span more than one size
+    d = n*sxx - sx*sx;
+    if(n > 1 && d > 1e-9*n*sxx) {
+        *k = (n*sxy - sx*sy)/d;
+    }
+    else {
+        *k = 1.;
+    }
+    *a = (sy - *k*sx)/n;
+
+    return n;
+}
+
+/*!
+ * Find the benchmark of a model with a positive speed that is nearest to a
+ * point, by euclidean distance in parameter space
+ *
+ * @param   m       pointer to the model
+ * @param   p       pointer to the parameter array of the point
+ *
+ * @return pointer to the benchmark, in place, or NULL if no benchmark has a
+ * positive speed
+ */
+struct pmm_benchmark*
+find_nearest_bench(struct pmm_model *m, int *p)
+{
+    struct pmm_bench_list *bl;
+    int *bp;
+    double d, nearest_d;
+    int i, j, nearest;
+
+    bl = m->bench_list;
+
+    nearest = -1;
+    nearest_d = 0.;
+
+    // scan the contiguous speed and parameter arrays of the index
+    for(i=0; i<bl->size; i++) {
+        if(bl->flops[i] <= 0.) {
+            continue;
+        }
+
+        bp = &(bl->params[i*bl->n_p]);
+
+        d = 0.;
+        for(j=0; j<m->n_p; j++) {
+            d += ((double)bp[j] - p[j]) * ((double)bp[j] - p[j]);
+        }
+
+        if(nearest < 0 || d < nearest_d) {
+            nearest = i;
+            nearest_d = d;
+        }
+    }
+
+    return nearest < 0 ? NULL : bl->index[nearest];
+}
+
+/*!
+ * Estimate the complexity of a model at a number of points, from the
+ * complexity formula of its routine if it declares one, otherwise by fitting
+ * c = a*(p_0*p_1*...*p_n)^k to the complexity reported by the benchmarks of
+ * the model (see fit_model_complexity).
+ *
+ * @param   m           pointer to the model
+ * @param   p           pointer to the parameter arrays of the points, n_p
+ *                      consecutive values for each point
+ * @param   n           number of points
+ * @param   complexity  pointer to array of n doubles where the complexity at
+ *                      each point is stored, -1 where it cannot be estimated
+ *
+ * @return 0 on success, -1 if there is neither a formula nor benchmarks
+ * reporting their complexity
+ */
+int
+estimate_model_complexity(struct pmm_model *m, int *p, int n,
+                          double *complexity)
+{
+    double a, k, x_p;
+    int *p_i;
+    int i, j, fitted;
+
+    if(calc_model_complexity(m, p, n, complexity) == 0) {
+        return 0;
+    }
+
+    fitted = fit_model_complexity(m, &a, &k) > 0;
+
+    for(i=0; i<n; i++) {
+        p_i = &(p[i*m->n_p]);
+
+        complexity[i] = -1.;
+
+        if(!fitted) {
+            continue;
+        }
+
+        x_p = 0.;
+        for(j=0; j<m->n_p && p_i[j] > 0; j++) {
+            x_p += log((double)p_i[j]);
+        }
+
+        if(j == m->n_p) {
+            complexity[i] = exp(a + k*x_p);
+        }
+    }
+
+    return fitted ? 0 : -1;
+}
+
+/*!
+ * Predict the execution time at a point of a model, given the speed
+ * interpolated there and the complexity estimated there.
+ *
+ * The time at a point that has been benchmarked is the average measured
+ * there. Elsewhere it is the complexity divided by the speed. Where the
+ * interpolation gives no positive speed, e.g. beyond the measured range, the
+ * speed of the nearest benchmark is used instead.
+ *
+ * @param   m           pointer to the model
+ * @param   p           pointer to the parameter array of the point
+ * @param   flops       speed interpolated at the point
+ * @param   complexity  complexity estimated at the point, or -1
+ *
+ * @return predicted time in seconds, or -1 if there is not enough data for a
+ * prediction
+ */
+double
+predict_point_seconds(struct pmm_model *m, int *p, double flops,
+                      double complexity)
+{
+    struct pmm_bench_stats *stats;
+    struct pmm_benchmark *nearest;
+
+    stats = get_bench_stats(m->bench_list, p);
+    if(stats != NULL && stats->n > 0 && stats->seconds > 0.) {
+        return stats->seconds / stats->n;
+    }
+
+    if(!(complexity > 0.)) {
+        return -1.;
+    }
+
+    if(!(flops > 0.)) {
+        nearest = find_nearest_bench(m, p);
+        if(nearest == NULL) {
+            return -1.;
+        }
+        flops = nearest->flops;
+    }
+
+    return complexity/flops;
+}
+
+/*!
+ * Evaluate a model at many points in one call, storing the speed and
+ * predicted execution time at each point in arrays provided by the caller.
+ *
+ * The speed is interpolated as by lookup_model, for single parameter models
+ * by a merged search of the averaged points (fastest when the points are in
+ * increasing order) and otherwise within the triangulation of the model,
+ * walking from the simplex of the previous point.
+ *
+ * The execution time at each point is predicted by predict_point_seconds()
+ * from the complexity given by estimate_model_complexity().
+ *
+ * @param   m       pointer to the model
+ * @param   p       pointer to the parameter arrays of the points, n_p
+ *                  consecutive values for each point
+ * @param   n       number of points
+ * @param   flops   pointer to array of n doubles where the speed at each
+ *                  point is stored, NAN where it cannot be interpolated
+ * @param   seconds pointer to array of n doubles where the predicted time at
+ *                  each point is stored, -1 where there is not enough data
+ *                  for a prediction, or NULL if times are not wanted
+ *
+ * @return 0 on success, -1 on failure
+ */
+int
+lookup_model_batch(struct pmm_model *m, int *p, int n, double *flops,
+                   double *seconds)
+{
+    struct pmm_delaunay *tri;
+    int i, ret;
+
+    ret = 0;
+
+    pthread_mutex_lock(&interpolation_mutex);
+
+    if(m->n_p == 1) {
+        ret = interpolate_1d_model_batch(m->bench_list, p, n, flops);
+    }
+    else {
+        tri = get_model_triangulation(m);
+
+        if(tri == NULL) {
+            ret = -1;
+        }
+        else {
+            for(i=0; i<n; i++) {
+                if(delaunay_interpolate(tri, &(p[i*m->n_p]), &(flops[i])) < 0) {
+                    flops[i] = NAN;
+                }
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&interpolation_mutex);
+
+    if(ret < 0) {
+        ERRPRINTF("Error interpolating model.\n");
+        return -1;
+    }
+
+    if(seconds == NULL) {
+        return 0;
+    }
+
+    // the complexity is stored in seconds until the time at each point is
+    // found
+    estimate_model_complexity(m, p, n, seconds);
+
+    for(i=0; i<n; i++) {
+        seconds[i] = predict_point_seconds(m, &(p[i*m->n_p]), flops[i],
+                                           seconds[i]);
+    }
+
+    return 0;
+}
+
+/*!
+ * Build a Delaunay triangulation of the unique points of a model.
+ *
+ * Points are scaled into the box given by the parameter definitions of the
+ * model, or of its routine, or failing both by the bounding box of the
+ * benchmarks, so that parameters with very different ranges are treated
+ * evenly.
+ *
+ * @param   m       pointer to the model
+ * @param   mode    value to take at each point, the average (PMM_AVG or
+ *                  PMM_ALL) or the maximum (PMM_MAX) speed of the benchmarks
+ *                  there
+ *
+ * @return pointer to a newly allocated triangulation or NULL on failure
+ */
+struct pmm_delaunay*
+triangulate_model(struct pmm_model *m, int mode)
+{
+    struct pmm_bench_list *bl;
+    struct pmm_paramdef_set *pd_set;
+    struct pmm_bench_point *e;
+    struct pmm_delaunay *d;
+    double *lo, *hi;
+    int i, j;
+
+    bl = m->bench_list;
+
+    lo = malloc(m->n_p * sizeof *lo);
+    hi = malloc(m->n_p * sizeof *hi);
+    if(lo == NULL || hi == NULL) {
+        ERRPRINTF("Error allocating memory.\n");
+        free(lo);
+        free(hi);
+        return NULL;
+    }
+
+    pd_set = get_model_paramdef_set(m);
+
+    if(pd_set != NULL && pd_set->n_p == m->n_p) {
+        for(j=0; j<m->n_p; j++) {
+            lo[j] = pd_set->pd_array[j].start;
+            hi[j] = pd_set->pd_array[j].end;
+
+            if(lo[j] > hi[j]) {
+                lo[j] = pd_set->pd_array[j].end;
+                hi[j] = pd_set->pd_array[j].start;
+            }
+        }
+    }
+    else {
+        for(j=0; j<m->n_p; j++) {
+            lo[j] = bl->size > 0 ? bl->params[j] : 0.0;
+            hi[j] = lo[j];
+        }
+
+        for(i=1; i<bl->size; i++) {
+            for(j=0; j<m->n_p; j++) {
+                if(bl->params[i*m->n_p+j] < lo[j]) {
+                    lo[j] = bl->params[i*m->n_p+j];
+                }
+                if(bl->params[i*m->n_p+j] > hi[j]) {
+                    hi[j] = bl->params[i*m->n_p+j];
+                }
+            }
+        }
+    }
+
+    d = new_delaunay(m->n_p, lo, hi);
+
+    free(lo);
+    free(hi);
+
+    if(d == NULL) {
+        ERRPRINTF("Error creating triangulation.\n");
+        return NULL;
+    }
+
+    // insert each unique point once, in sorted order so that successive
+    // points are near each other and the walks to locate them are short
+    for(i=0; i<bl->size; i++) {
+        if(i > 0 && params_cmp(&(bl->params[i*m->n_p]),
+                               &(bl->params[(i-1)*m->n_p]), m->n_p) == 0)
+        {
+            continue;
+        }
+
+        e = get_bench_point(bl, &(bl->params[i*m->n_p]));
+
+        if(delaunay_insert(d, &(bl->params[i*m->n_p]),
+                           mode == PMM_MAX ? e->stats.max_flops
+                                           : e->stats.mean_flops) < 0)
+        {
+            ERRPRINTF("Error inserting point into triangulation.\n");
+            free_delaunay(&d);
+            return NULL;
+        }
+    }
+
+    d->version = bl->version;
+
+    return d;
+}
+
+/*!
+ * Add a point to the cached triangulation of a model after a benchmark has
+ * been inserted at it.
+ *
+ * A triangulation that was current before the insertion is updated in place,
+ * so that a model being built can be looked up continuously without being
+ * triangulated again after every benchmark. A triangulation that was already
+ * out of date, for instance because benchmarks were removed, is left to be
+ * rebuilt when it is next used.
+ *
+ * @param   m       pointer to the model
+ * @param   p       pointer to the parameter array of the point
+ * @param   flops   new average speed at the point
+ */
+void
+update_model_triangulation(struct pmm_model *m, int *p, double flops)
+{
+    pthread_mutex_lock(&interpolation_mutex);
+
+    if(m->triangulation != NULL) {
+        if(m->triangulation->version + 1 == m->bench_list->version &&
+           delaunay_insert(m->triangulation, p, flops) >= 0)
+        {
+            m->triangulation->version = m->bench_list->version;
+        }
+        else {
+            free_delaunay(&(m->triangulation));
+        }
+    }
+
+    pthread_mutex_unlock(&interpolation_mutex);
+}
+
+/*!
+ * Get the cached triangulation of the average speeds at the benchmarked
+ * points of a model, rebuilding it if it has fallen out of date.
+ *
+ * @param   m       pointer to the model
+ *
+ * @return pointer to the triangulation, owned by the model, or NULL on
+ * failure
+ *
+ * @pre the caller holds interpolation_mutex
+ */
+struct pmm_delaunay*
+get_model_triangulation(struct pmm_model *m)
+{
+    if(m->triangulation != NULL &&
+       m->triangulation->version != m->bench_list->version)
+    {
+        free_delaunay(&(m->triangulation));
+    }
+
+    if(m->triangulation == NULL) {
+        m->triangulation = triangulate_model(m, PMM_AVG);
+        if(m->triangulation == NULL) {
+            ERRPRINTF("Error triangulating model.\n");
+            return NULL;
+        }
+    }
+
+    return m->triangulation;
+}
+
+/*!
+ * Find the speed approximation given by a model of 2 or more parameters at
+ * a point, by linear interpolation within the Delaunay triangulation of the
+ * average speed at each benchmarked point. The triangulation is cached in the
+ * model, kept up to date as benchmarks are inserted and rebuilt only when it
+ * has fallen out of date.
+ *
+ * @param   m       pointer to the model
+ * @param   p       pointer to parameter array
+ * @param   exclude if non-zero, interpolate as though there were no
+ *                  benchmarks at p
+ *
+ * @return pointer to a newly allocated benchmark structure which describes
+ * the flops performance at the point p, which is NAN if p is outside the
+ * convex hull of the benchmarks, or NULL on failure
+ *
+ * @pre the caller holds interpolation_mutex
+ */
+struct pmm_benchmark*
+interpolate_delaunay_model(struct pmm_model *m, int *p, int exclude)
+{
+    struct pmm_benchmark *b;
+    double flops;
+    int ret;
+
+    if(get_model_triangulation(m) == NULL) {
+        return NULL;
+    }
+
+    if(exclude) {
+        ret = delaunay_interpolate_excluding(m->triangulation, p, &flops);
+    }
+    else {
+        ret = delaunay_interpolate(m->triangulation, p, &flops);
+    }
+
+    if(ret < 0) {
+        DBGPRINTF("Interpolation point outside convex hull of benchmarks.\n");
+        flops = NAN;
+    }
+
+    b = new_benchmark();
+    if(b == NULL) {
+        ERRPRINTF("Error allocating benchmark.\n");
+        return NULL;
+    }
+
+    b->n_p = m->n_p;
+    b->p = init_param_array_copy(p, b->n_p);
+    if(b->p == NULL) {
+        ERRPRINTF("Error copying parameter array\n");
+        free_benchmark(&b);
+        return NULL;
     }
 
-    return total_time;
+    b->flops = flops;
+
+    DBGPRINTF("-------- INTERPOLATED BENCH --------\n");
+    print_benchmark(PMM_DBG, b);
+
+    return b;
 }
 
 /*!
- * Function removes benchmarks from a model that have parameters that match
- * a target set. Removed benchmarks are all not deallocated, their addresses
- * are stored in an array passed to the function as removed_array
- *
- * @param   m               pointer to the model
- * @param   p               pointer to an array of parameters
- * @param   removed_array   pointer to unallocated array of benchmarks
+ * Bring the averaged points of a single parameter bench list up to date with
+ * its benchmarks, if they have changed since the averages were last taken.
  *
- * @return the number of benchmarks found and removed from the model or -1 on
- * error
+ * @param   bl  pointer to the bench list
  *
- * @pre removed_array is unallocated
- * @post removed_array is allocated with a size matching the number of
- * benchmarks found and removed
+ * @return 0 on success, -1 on failure
  */
 int
-remove_benchmarks_at_param(struct pmm_model *m, int *p,
-                           struct pmm_benchmark ***removed_array)
+update_bench_list_averages(struct pmm_bench_list *bl)
 {
-    int n, c;
-
-    struct pmm_benchmark *first, *last, *this, *temp;
-
-
-    n = get_sublist_from_bench_list(m->bench_list, p, &first, &last);
+    struct pmm_bench_point *e;
+    int i, capacity;
+    int *avg_p;
+    double *avg_flops;
 
-    if(n == 0) {
-        return 0; //nothing found
-    }
-
-    DBGPRINTF("allocating remove_array of %d elemenets of size %lu.\n",
-              n, sizeof(*removed_array));
-
-    (*removed_array) = malloc(n * sizeof *(*removed_array));
-    if((*removed_array) == NULL) {
-        ERRPRINTF("Error allocating memory.\n");
-        return -1;
+    if(bl->avg_version == bl->version) {
+        return 0;
     }
 
-    this = first;
-    c = 0;
-    while(c < n) {
-        DBGPRINTF("removing %p temporarily\n", this);
-        print_benchmark(PMM_DBG, this);
+    if(bl->n_points > bl->avg_capacity) {
+        capacity = bl->avg_capacity > 0 ? bl->avg_capacity : 64;
+        while(capacity < bl->n_points) {
+            capacity *= 2;
+        }
 
-        // store the next as this will be unplugged by remove_bench_...
-        temp = this->next;
+        avg_p = realloc(bl->avg_p, capacity * sizeof *avg_p);
+        if(avg_p == NULL) {
+            ERRPRINTF("Error reallocating averaged points.\n");
+            return -1;
+        }
+        bl->avg_p = avg_p;
 
-        //remove benchmarks between first/last from model
-        remove_bench_from_bench_list(m->bench_list, this);
+        avg_flops = realloc(bl->avg_flops, capacity * sizeof *avg_flops);
+        if(avg_flops == NULL) {
+            ERRPRINTF("Error reallocating averaged points.\n");
+            return -1;
+        }
+        bl->avg_flops = avg_flops;
 
+        bl->avg_capacity = capacity;
+    }
 
-        DBGPRINTF("saving %p at position %d in removed_array %p\n",
-                this, c, (*removed_array));
+    // the parameters are sorted so the first of each run of equal values is
+    // a new point
+    bl->n_avg = 0;
+    for(i=0; i<bl->size; i++) {
+        if(bl->n_avg > 0 && bl->params[i] == bl->avg_p[bl->n_avg-1]) {
+            continue;
+        }
 
-        //add removed to array
-        (*removed_array)[c] = this;
-        c++;
+        e = get_bench_point(bl, &(bl->params[i]));
 
-        this = temp; //next
+        bl->avg_p[bl->n_avg] = bl->params[i];
+        bl->avg_flops[bl->n_avg] = e->stats.mean_flops;
+        bl->n_avg++;
     }
 
+    bl->avg_version = bl->version;
 
-    return n;
+    return 0;
 }
 
 /*!
- * find_oldapprox will find the approximation of performance at a target point
- * in a model, ignoring any data points that happen to be at that target point.
- * The main use of this function is to find what the approximation of a model
- * was before a data point was added to the model.
+ * Interpolate the averaged points of a single parameter bench list at a
+ * point.
  *
- * @param   m   pointer to the model
- * @param   p   pointer to a parameter array describing the target point
+ * Speed below the first point is taken to be that of the first point and
+ * speed beyond the last point is taken to be zero. Between points the speed
+ * is linearly interpolated.
  *
- * @return a pointer to a newly allocated benchmark that gives an approximation
- * of the model at the target point, ignoring any data at the exact point or
- * NULL on error
+ * @param   bl      pointer to the bench list, with averages up to date
+ * @param   p       parameter to interpolate at
+ * @param   hint    pointer to the position of the averaged point at or after
+ *                  the previous parameter looked up, updated on return. If
+ *                  parameters are looked up in increasing order the search
+ *                  only covers the points between them
+ *
+ * @return the interpolated speed
  */
-struct pmm_benchmark *
-find_oldapprox(struct pmm_model *m, int *p)
+double
+interpolate_1d_averages(struct pmm_bench_list *bl, int p, int *hint)
 {
-    struct pmm_benchmark *b;
-    struct pmm_benchmark **removed_benchmarks_array; //array of pointers
-    int i;
-    int n_removed;
+    int lo, hi, mid, step;
+    double x1, x2, y1, y2;
 
-    // remove benchmarks from model with matching parameter to p
-    n_removed = remove_benchmarks_at_param(m, p, &removed_benchmarks_array);
+    lo = 0;
+    hi = bl->n_avg;
 
+    // gallop forwards from the hint to bound the search
+    if(*hint > 0 && *hint <= bl->n_avg && bl->avg_p[*hint-1] < p) {
+        lo = *hint;
 
-    //lookup version of model with benchmarks removed
-    b = lookup_model(m, p);
-    if(b == NULL) {
-        ERRPRINTF("Error looking up model.\n");
-    }
+        for(step=1; lo+step-1 < bl->n_avg && bl->avg_p[lo+step-1] < p;
+            step*=2)
+        {
+            lo += step;
+        }
 
-    //re-insert removed benchmarks back into model
-    for(i=0; i<n_removed; i++) {
-        insert_bench(m, removed_benchmarks_array[i]);
+        if(lo+step-1 < bl->n_avg) {
+            hi = lo+step-1;
+        }
     }
 
-    //return approximation b
-    return b;
-}
+    // find the first point at or after p
+    while(lo < hi) {
+        mid = lo + (hi - lo)/2;
 
-/*!
- * Call the appropriate lookup function to find value of model
- * given a set of parameters
- *
- * @param   m       pointer to model
- * @param   p       array of parameters
- *
- * @return  newly allocated benchmark describing performance at
- * p or NULL on failure
- */
-struct pmm_benchmark* lookup_model(struct pmm_model *m, int *p)
-{
-    struct pmm_benchmark *b;
+        if(bl->avg_p[mid] < p) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
 
-    b = NULL;
+    *hint = lo;
 
-    if(m->n_p == 1) {
-        b = interpolate_1d_model(m->bench_list, p);
+    //we have not found a benchmark greater than the target, at minimum, the
+    //model will have a zero speed benchmark at paramdef.end so we can assume
+    //that the target is greater than this and speed is zero
+    //
+    //TODO this may not be best if nonzero end is set and the end bench is
+    //not actually 0 speed.
+    if(lo == bl->n_avg) {
+        return 0.0;
     }
-    else {
-#ifdef ENABLE_OCTAVE
-        // n-dimensional interpolation within boundaries via octave
-        b = interpolate_griddatan(m, p);
-#else
-        ERRPRINTF("Cannot interpolate 2D+ models without octave support "
-                  "compiled.\n");
-        return NULL;
-#endif /* ENABLE_OCTAVE */
+
+    // the point has been benchmarked, or is smaller than the first point, in
+    // which case we assume its speed is equal to the first
+    if(bl->avg_p[lo] == p || lo == 0) {
+        return bl->avg_flops[lo];
     }
 
-    return b;
+    // yb = m(xb - x1) + y1 where m = (y2 - y1)/(x2 - x1)
+    x1 = bl->avg_p[lo-1];
+    x2 = bl->avg_p[lo];
+    y1 = bl->avg_flops[lo-1];
+    y2 = bl->avg_flops[lo];
+
+    return (y2 - y1)/(x2 - x1) * ((double)p - x1) + y1;
 }
 
 /*!
  * Find the speed approximation given by a 1-D or single parameter model at
- * a point described by the parameter array p (size of 1!).
+ * a point described by the parameter array p (size of 1!), interpolating
+ * between the average speeds at the benchmarked points either side of it.
  *
  * @param   bl      pointer to the bench list
  * @param   p       pointer to parameter array
  *
  * @return pointer to a newly allocated benchmark structure which describes
  * the flops performance at the point p.
- *
- *
- * TODO this does not use the average of benchmarks with the same parameters
  */
 struct pmm_benchmark*
 interpolate_1d_model(struct pmm_bench_list *bl,
                      int *p)
 {
-    struct pmm_benchmark *b, *cur;
+    struct pmm_benchmark *b;
+    int hint;
 
     if(bl->n_p != 1) {
         ERRPRINTF("1d interpolation cannot use %dd data.\n", bl->n_p);
         return NULL;
     }
 
+    if(update_bench_list_averages(bl) < 0) {
+        ERRPRINTF("Error averaging benchmarks.\n");
+        return NULL;
+    }
+
     b = new_benchmark();
     b->n_p = bl->n_p;
 
     b->p = init_param_array_copy(p, b->n_p);
     if(b->p == NULL) {
         ERRPRINTF("Error copying parameter array\n");
+        free_benchmark(&b);
         return NULL;
-        //TODO this error is not caught as NULL is spec'd as OK return
     }
 
+    hint = 0;
+    b->flops = interpolate_1d_averages(bl, p[0], &hint);
 
-    cur = bl->first;
-
-    while(cur) {
-        if(cur->p[0] < p[0]) {
-            // if model parameter is less than target skip to next bench in
-            // model
-        }
-        else if(cur->p[0] == p[0]) {
-            // we got lucky
-            b->flops = cur->flops;
-
-            DBGPRINTF("benchmark at interpolation point: %f\n", b->flops);
-            return b;
-        }
-        else if(cur->p[0] > p[0]) {
-            // our search has passed the target, we can now interpolate between
-            // cur (greater than target) and cur->previous (less than target)
-
-            if(cur->previous != NULL) {
-                //let's interpolate!
-                //
-                // the formula to calcuate the flops is as follows:
-                //
-                // x1,y1 are p[0] and flops of previous
-                // x2,y2 are p[0] and flops of cur
-                // xb,yb are p[0] and flops of b;
-                //
-                //
-                // m = (y2 - y1)/(x2 - x1) (formula for slope)
-                //
-                // y - y1 = m(x - x1) (formula for a line)
-                //
-                // yb = m(xb - x1) + y1
-                //
-                {
-                    int x1, x2, xb;
-                    double y1, y2, yb;
-
-                    double m;
-
-                    x1=cur->p[0];
-                    x2=cur->previous->p[0];
-                    xb=b->p[0];
-
-                    y1=cur->flops;
-                    y2=cur->previous->flops;
-
-                    m = ((double)(y2-y1))/((double)(x2-x1));
-
-                    yb = m*((double)(xb-x1)) + (double)y1;
+    DBGPRINTF("interpolated to:%f\n", b->flops);
 
-                    b->flops = yb;
+    return b;
+}
 
-                    DBGPRINTF("interploated between %d and %d to %f\n",
-                             x1, x2, b->flops);
-                    return b;
+/*!
+ * Find the speed approximation given by a 1-D or single parameter model at
+ * many points at once. Points given in increasing order are found most
+ * quickly.
+ *
+ * @param   bl      pointer to the bench list
+ * @param   p       pointer to array of the parameter of each point
+ * @param   n       number of points
+ * @param   flops   pointer to array of n doubles where the speed at each
+ *                  point is stored
+ *
+ * @return 0 on success, -1 on failure
+ */
+int
+interpolate_1d_model_batch(struct pmm_bench_list *bl, int *p, int n,
+                           double *flops)
+{
+    int i, hint;
 
+    if(bl->n_p != 1) {
+        ERRPRINTF("1d interpolation cannot use %dd data.\n", bl->n_p);
+        return -1;
+    }
 
-                }
-            }
-            else {
-                //cur has no preivous, i.e. it is the first benchmark in the
-                //list model. We will assume speed for a smaller size is
-                //equal to the first benchmark.
-                b->flops = cur->flops;
-                DBGPRINTF("< than first bench, interpolated to:%f\n", b->flops);
-                return b;
-            }
-        }
-        cur = cur->next;
+    if(update_bench_list_averages(bl) < 0) {
+        ERRPRINTF("Error averaging benchmarks.\n");
+        return -1;
     }
 
-    //we have searched through the model and not found a benchmark
-    //greater than the target, at minimum, the model will have a zero
-    //speed benchmark at paramdef.end so we can assume that the target is
-    //greater than this and speed is zero
-    //
-    //TODO this may not be best if nonzero end is set and the end bench is
-    //not actually 0 speed.
-    //
+    hint = 0;
+    for(i=0; i<n; i++) {
+        flops[i] = interpolate_1d_averages(bl, p[i], &hint);
+    }
 
-    b->flops = .0;
-    return b;
+    return 0;
 }
 
-
 #define MAX_CMP(x,y) (x) > (y) ? (x) : (y)
 #define MIN_CMP(x,y) (x) < (y) ? (x) : (y)
 #define PMM_PERC 0.05 // percentage threshold for GBBP
+#define PMM_MAX_INTERFERENCE 0.5 // interference at which cut bands stop growing
+
+/*!
+ * Calculate the band of speeds a benchmark represents. A benchmark measured
+ * without interference from other work is a single speed. Interference can
+ * only have slowed a benchmark, so the band of a benchmark measured under
+ * interference i extends upwards from the measured speed to the speed it
+ * would have had with the whole system, flops/(1-i).
+ *
+ * @param   b   pointer to the benchmark
+ * @param   lo  pointer to the lower speed of the band
+ * @param   hi  pointer to the upper speed of the band
+ */
+void
+bench_cut_band(struct pmm_benchmark *b, double *lo, double *hi)
+{
+    double interference;
+
+    interference = get_benchmark_interference(b);
+    if(interference > PMM_MAX_INTERFERENCE) {
+        interference = PMM_MAX_INTERFERENCE;
+    }
+
+    *lo = b->flops;
+    *hi = b->flops/(1.0 - interference);
+}
 
 /*!
  *
@@ -2110,35 +3608,29 @@ interpolate_1d_model(struct pmm_bench_list *bl,
  *              b1              b2
  * \endverbatim
  *
- * @param   h   pointer to the load history
  * @param   b1  pointer to first benchmark point
  * @param   b2  pointer to second benchmark point
  *
  * @returns 1 if the values of the model at b1 contain the values of
  * the model at b2, 0 otherwise
  */
-int bench_cut_contains(struct pmm_loadhistory *h, struct pmm_benchmark *b1,
-                       struct pmm_benchmark *b2) {
+int bench_cut_contains(struct pmm_benchmark *b1, struct pmm_benchmark *b2) {
 
-    //for now we just test if b1->flops and b2->flops are within a percent
-    //of eachother
-    //
-
-    double max, min;
-
-    (void)h; //TODO unused
-
-    DBGPRINTF("b1->flops:%f b2->flops:%f\n", b1->flops, b2->flops);
+    //the cut of a benchmark is its load-adjusted speed band (interference
+    //is derived from the load history when the benchmark is executed),
+    //widened by a percentage
 
-    max = MAX_CMP(b1->flops, b2->flops);
-    min = MIN_CMP(b1->flops, b2->flops);
+    double lo1, hi1, lo2, hi2;
 
-    DBGPRINTF("max:%f min:%f\n", max, min);
+    bench_cut_band(b1, &lo1, &hi1);
+    bench_cut_band(b2, &lo2, &hi2);
 
-    DBGPRINTF("max/min %f min/max %f\n", max/min, min/max);
+    DBGPRINTF("b1:%f-%f b2:%f-%f\n", lo1, hi1, lo2, hi2);
 
-
-    if(max/min <= 1+PMM_PERC && min/max >= 1-PMM_PERC) {
+    //zero speeds never contain each other
+    if(lo1 > 0.0 && lo2 > 0.0 &&
+       lo1/(1+PMM_PERC) <= lo2 && hi2 <= hi1*(1+PMM_PERC))
+    {
         DBGPRINTF("b1 contains b2\n");
         return 1; //true
     }
@@ -2146,16 +3638,6 @@ int bench_cut_contains(struct pmm_loadhistory *h, struct pmm_benchmark *b1,
         DBGPRINTF("b1 does not contain b2\n");
         return 0; //false
     }
-
-    //TODO implement bench_cut_contains properly (i.e. using loadhistory)
-    //take t0, the optimal execution time of the benchmark
-
-    //using the load history band caculate the upper and lower execution times
-    //of the benchmark
-
-    //convert execution times into speed of computation (divide by size)
-
-    //compare upper and lower execution speeds
 }
 
 /*!
@@ -2184,32 +3666,25 @@ int bench_cut_contains(struct pmm_loadhistory *h, struct pmm_benchmark *b1,
  *              b1              b2
  * \endverbatim
  *
- * @param   h   pointer to the load history
  * @param   b1  pointer to first benchmark point
  * @param   b2  pointer to second benchmark point
  *
  * @return 1 if values of model at b1 intersect values of model at b2, 0
  * otherwise
  */
-int bench_cut_intersects(struct pmm_loadhistory *h, struct pmm_benchmark *b1,
-                         struct pmm_benchmark *b2) {
-    //for now we just test if b1->flops and b2->flops are within a percent
-    //of eachother ... same as 'bench_cut_contains'
-
-    double max, min;
-
-    (void)h; //TODO unused
+int bench_cut_intersects(struct pmm_benchmark *b1, struct pmm_benchmark *b2) {
 
-    DBGPRINTF("b1->flops:%f b2->flops:%f\n", b1->flops, b2->flops);
+    double lo1, hi1, lo2, hi2;
 
-    max = MAX_CMP(b1->flops, b2->flops);
-    min = MIN_CMP(b1->flops, b2->flops);
+    bench_cut_band(b1, &lo1, &hi1);
+    bench_cut_band(b2, &lo2, &hi2);
 
-    DBGPRINTF("max:%f min:%f\n", max, min);
+    DBGPRINTF("b1:%f-%f b2:%f-%f\n", lo1, hi1, lo2, hi2);
 
-    DBGPRINTF("max/min %f min/max %f\n", max/min, min/max);
-
-    if(max/min <= 1+PMM_PERC && min/max >= 1-PMM_PERC) {
+    //zero speeds never intersect each other
+    if(lo1 > 0.0 && lo2 > 0.0 &&
+       lo1/(1+PMM_PERC) <= hi2 && lo2 <= hi1*(1+PMM_PERC))
+    {
         DBGPRINTF("b1 intersects b2\n");
         return 1; //true
     }
@@ -2217,8 +3692,6 @@ int bench_cut_intersects(struct pmm_loadhistory *h, struct pmm_benchmark *b1,
         DBGPRINTF("b1 does not intersects b2\n");
         return 0; //false
     }
-
-    //TODO implement bench_cut_intersects properly (i.e. using loadhistory)
 }
 
 /*!
@@ -2249,49 +3722,49 @@ int bench_cut_intersects(struct pmm_loadhistory *h, struct pmm_benchmark *b1,
  *  |           ^     size      ^
  *              b1              b2
  * \endverbatim
- * @param   h   pointer to the load history
  * @param   b1  pointer to first benchmark point
  * @param   b2  pointer to second benchmark point
  *
  * @returns 1 if the values of the model at b1 are greater than the values of
  * the model at b2, 0 otherwise
  */
-int bench_cut_greater(struct pmm_loadhistory *h, struct pmm_benchmark *b1,
-                      struct pmm_benchmark *b2) {
+int bench_cut_greater(struct pmm_benchmark *b1, struct pmm_benchmark *b2) {
+
+    double lo1, hi1, lo2, hi2;
 
-    (void)h; //TODO unused
+    bench_cut_band(b1, &lo1, &hi1);
+    bench_cut_band(b2, &lo2, &hi2);
 
-    if(b1->flops > b2->flops*(1.0 + PMM_PERC)) {
+    if(lo1 > hi2*(1.0 + PMM_PERC)) {
         return 1; //b1 greater than b2 (by a percentage)
     }
     else {
         return 0; //false
     }
-    //TODO implement bench_cut_greater properly (i.e. using loadhistory)
 }
 
 /*!
  * This function performs the inverse of of bench_cut_greater
  *
- * @param   h   pointer to the load history
  * @param   b1  pointer to first benchmark point
  * @param   b2  pointer to second benchmark point
  *
  * @returns 1 if the values of the model at b1 are less than the values of
  * the model at b2, 0 otherwise
  */
-int bench_cut_less(struct pmm_loadhistory *h, struct pmm_benchmark *b1,
-                   struct pmm_benchmark *b2) {
+int bench_cut_less(struct pmm_benchmark *b1, struct pmm_benchmark *b2) {
 
-    (void)h; //TODO unused
+    double lo1, hi1, lo2, hi2;
 
-    if(b1->flops < b2->flops*(1.0 - PMM_PERC)) {
+    bench_cut_band(b1, &lo1, &hi1);
+    bench_cut_band(b2, &lo2, &hi2);
+
+    if(hi1 < lo2*(1.0 - PMM_PERC)) {
         return 1; //b1 less than b2 (by a percentage)
     }
     else {
         return 0; //false
     }
-    //TODO implement bench_cut_less properly (i.e. using loadhistory)
 }
 
 /*!
@@ -2322,6 +3795,50 @@ construction_method_to_string(enum pmm_construction_method method)
     }
 }
 
+/*!
+ * convert a benchmark protocol enum to a char array description
+ *
+ * @param   protocol    the benchmark protocol
+ *
+ * @returns pointer to a character array describing the protocol
+ */
+char*
+benchmark_protocol_to_string(enum pmm_benchmark_protocol protocol)
+{
+    switch (protocol) {
+        case BP_EXEC:
+            return "exec";
+        case BP_SERVER:
+            return "server";
+        case BP_INVALID:
+            return "invalid";
+        default:
+            return "unknown";
+    }
+}
+
+/*!
+ * convert a scheduling policy enum to a char array description
+ *
+ * @param   policy  the scheduling policy
+ *
+ * @returns pointer to a character array describing the policy
+ */
+char*
+scheduling_policy_to_string(enum pmm_scheduling_policy policy)
+{
+    switch (policy) {
+        case SP_PRIORITY:
+            return "priority";
+        case SP_COST:
+            return "cost";
+        case SP_INVALID:
+            return "invalid";
+        default:
+            return "unknown";
+    }
+}
+
 /*!
  * convert a construction condition enum to a char array description
  *
@@ -2489,6 +4006,17 @@ print_benchmark(const char *output, struct pmm_benchmark *b) {
     SWITCHPRINTF(output, "used sec:%ld used usec:%ld\n", b->used_t.tv_sec,
                  b->used_t.tv_usec);
 
+    if(b->cpuset != NULL)
+        SWITCHPRINTF(output, "cpuset: %s\n", b->cpuset);
+    if(b->numa_node != -1)
+        SWITCHPRINTF(output, "numa_node: %d\n", b->numa_node);
+    if(b->nice != 0)
+        SWITCHPRINTF(output, "nice: %d\n", b->nice);
+    for(i=0; i<b->n_metrics; i++) {
+        SWITCHPRINTF(output, "%s: %g\n", b->metrics[i].name,
+                     b->metrics[i].value);
+    }
+
     SWITCHPRINTF(output, "previous:%p\n", b->previous);
 
     SWITCHPRINTF(output, "current:%p\n", b);
@@ -2515,6 +4043,12 @@ void print_routine(const char *output, struct pmm_routine *r) {
     print_paramdef_set(output, r->pd_set);
 
     SWITCHPRINTF(output, "condition: %s\n", construction_condition_to_string(r->condition));
+    if(r->condition == CC_UNTIL)
+        SWITCHPRINTF(output, "until:%s", ctime(&(r->until)));
+    if(r->condition == CC_PERIODIC)
+        SWITCHPRINTF(output, "period:%02d:%02d-%02d:%02d\n",
+                     r->period_start/3600, (r->period_start%3600)/60,
+                     r->period_end/3600, (r->period_end%3600)/60);
     SWITCHPRINTF(output, "priority:%d\n", r->priority);
     SWITCHPRINTF(output, "executable:%d\n", r->executable);
 
@@ -2524,6 +4058,14 @@ void print_routine(const char *output, struct pmm_routine *r) {
     SWITCHPRINTF(output, "construction method: %s\n",
                  construction_method_to_string(r->construction_method));
 
+    if(r->cpuset != NULL)
+        SWITCHPRINTF(output, "cpuset:%s\n", r->cpuset);
+    SWITCHPRINTF(output, "numa_node:%d\n", r->numa_node);
+    SWITCHPRINTF(output, "nice:%d\n", r->nice);
+    SWITCHPRINTF(output, "timeout:%d\n", r->timeout);
+    SWITCHPRINTF(output, "protocol:%s\n",
+                 benchmark_protocol_to_string(r->protocol));
+
     //print_model(output, r->model);
     SWITCHPRINTF(output, "model completion:%d\n", r->model->completion);
 
@@ -2699,6 +4241,19 @@ int check_routine(struct pmm_routine *r) {
     }
     */
 
+    if(r->condition == CC_UNTIL && r->until == (time_t)-1) {
+        ERRPRINTF("Until time for routine not set.\n");
+        print_routine(PMM_ERR, r);
+        ret = 0;
+    }
+
+    if(r->condition == CC_PERIODIC &&
+       (r->period_start < 0 || r->period_end < 0)) {
+        ERRPRINTF("Benchmarking period for routine not set correctly.\n");
+        print_routine(PMM_ERR, r);
+        ret = 0;
+    }
+
     if(r->priority < 0) {
         ERRPRINTF("Priority for routine not set correctly.\n");
         print_routine(PMM_ERR, r);
@@ -2736,6 +4291,14 @@ void print_config(const char *output, struct pmm_config *cfg) {
 
     SWITCHPRINTF(output, "pause: %d\n", cfg->pause);
 
+    SWITCHPRINTF(output, "max concurrent benchmarks: %d\n",
+                 cfg->max_concurrent_benchmarks);
+    for(i=0; i<cfg->n_slot_cpusets; i++) {
+        SWITCHPRINTF(output, "slot %d cpuset: %s\n", i, cfg->slot_cpusets[i]);
+    }
+    SWITCHPRINTF(output, "scheduling policy: %s\n",
+                 scheduling_policy_to_string(cfg->scheduling_policy));
+
     for(i=0; i<cfg->used; i++) {
         print_routine(output, cfg->routines[i]);
     }
@@ -2761,6 +4324,13 @@ void free_config(struct pmm_config **cfg) {
     free((*cfg)->routines);
     (*cfg)->routines = NULL;
 
+    for(i=0; i<(*cfg)->n_slot_cpusets; i++) {
+        free((*cfg)->slot_cpusets[i]);
+        (*cfg)->slot_cpusets[i] = NULL;
+    }
+    free((*cfg)->slot_cpusets);
+    (*cfg)->slot_cpusets = NULL;
+
     free(*cfg);
     *cfg = NULL;
 }
@@ -2787,6 +4357,11 @@ void free_routine(struct pmm_routine **r) {
     free((*r)->exe_path);
     (*r)->exe_path = NULL;
 
+    if((*r)->cpuset != NULL) {
+        free((*r)->cpuset);
+        (*r)->cpuset = NULL;
+    }
+
     //free paramdef set
     if((*r)->pd_set != NULL)
         free_paramdef_set(&(*r)->pd_set);
@@ -2811,9 +4386,17 @@ void free_model(struct pmm_model **m) {
     if((*m)->pd_set != NULL)
         free_paramdef_set(&((*m)->pd_set));
 
+    if((*m)->triangulation != NULL)
+        free_delaunay(&((*m)->triangulation));
+
+    free((*m)->unjournalled);
+    (*m)->unjournalled = NULL;
+
     free((*m)->model_path);
     (*m)->model_path = NULL;
 
+    pthread_mutex_destroy(&((*m)->mutex));
+
     free(*m);
     *m = NULL;
 }
@@ -2826,7 +4409,20 @@ void free_model(struct pmm_model **m) {
 void free_bench_list(struct pmm_bench_list **bl)
 {
 
-    free_benchmark_list_backwards(&((*bl)->first));
+    // walk forwards from the first benchmark, walking backwards from it
+    // would only free the first
+    free_benchmark_list_forwards(&((*bl)->first));
+
+    free((*bl)->index);
+    free((*bl)->params);
+    free((*bl)->flops);
+    free((*bl)->seconds);
+    free((*bl)->points);
+    free((*bl)->avg_p);
+    free((*bl)->avg_flops);
+
+    // benchmarks from the slab were released above, the slab may be freed
+    free_slab(&((*bl)->slab));
 
     free(*bl);
     *bl = NULL;
@@ -2880,10 +4476,29 @@ void free_benchmark_list_backwards(struct pmm_benchmark **first_b) {
  */
 void free_benchmark(struct pmm_benchmark **b)
 {
-    free((*b)->p);
+    int i;
+
+    if((*b)->slab == NULL) {
+        free((*b)->p);
+    }
     (*b)->p = NULL;
 
-    free(*b);
+    free((*b)->cpuset);
+    (*b)->cpuset = NULL;
+
+    for(i=0; i<(*b)->n_metrics; i++) {
+        free((*b)->metrics[i].name);
+        (*b)->metrics[i].name = NULL;
+    }
+    free((*b)->metrics);
+    (*b)->metrics = NULL;
+
+    if((*b)->slab != NULL) {
+        slab_free((*b)->slab, *b);
+    }
+    else {
+        free(*b);
+    }
     *b = NULL;
 }
 
@@ -35,10 +35,13 @@
 #endif
 
 #include <sys/time.h>           // for timeval
+#include <pthread.h>            // for pthread_mutex_t
 
 #include "pmm_interval.h"
 #include "pmm_param.h"
 #include "pmm_load.h"
+#include "pmm_slab.h"
+#include "pmm_delaunay.h"
 
 /*!
  * enumeration fo different model construction conditions that must be
@@ -55,6 +58,16 @@ typedef enum pmm_construction_condition {
 
 
 
+/*!
+ * enumeration of policies by which the next routine to benchmark is chosen
+ */
+typedef enum pmm_scheduling_policy {
+    SP_PRIORITY,    /*!< highest priority, then least complete routine */
+    SP_COST,        /*!< greatest expected model improvement per second of
+                         predicted benchmark runtime */
+    SP_INVALID      /*!< invalid policy */
+} PMM_Scheduling_Policy;
+
 /*!
  * structure to hold the configuration of the benchmarking server
  */
@@ -86,6 +99,18 @@ typedef struct pmm_config {
     int pause;                              /**< toggle pause after a
                                                  benchmark */
 
+    int max_concurrent_benchmarks;          /**< number of benchmark execution
+                                                 slots, i.e. maximum number of
+                                                 benchmarks run at once */
+    char **slot_cpusets;                    /**< array of cpu lists (e.g.
+                                                 "0-7,16"), one per execution
+                                                 slot, or NULL */
+    int n_slot_cpusets;                     /**< number of elements in the
+                                                 slot_cpusets array */
+
+    enum pmm_scheduling_policy scheduling_policy; /**< policy choosing the
+                                                       next routine */
+
 } PMM_Config;
 
 /*!
@@ -106,6 +131,51 @@ typedef enum pmm_construction_method {
 } PMM_Construction_Method;
 
 
+/*!
+ * enumeration of protocols by which benchmarks are executed and their results
+ * are read
+ */
+typedef enum pmm_benchmark_protocol {
+    BP_EXEC,        /*!< execute the benchmark binary once for each point,
+                         passing parameters as arguments */
+    BP_SERVER,      /*!< execute the benchmark binary once and stream
+                         parameters to it, reading back a result per point */
+    BP_INVALID      /*!< invalid protocol */
+} PMM_Benchmark_Protocol;
+
+/*!
+ * enumeration of the formats a model file may be written in
+ */
+typedef enum pmm_model_format {
+    MF_XML,         /*!< indented xml document */
+    MF_BINARY,      /*!< binary format of pmm_binmodel.h, which may be mapped
+                         into memory */
+    MF_INVALID      /*!< invalid format */
+} PMM_Model_Format;
+
+struct pmm_worker;
+
+/*!
+ * an additional named measurement reported by a benchmark, e.g. the number of
+ * repetitions, a hardware counter or the peak resident set size
+ */
+typedef struct pmm_metric {
+    char *name;                 //!< name of metric
+    double value;               //!< value of metric
+} PMM_Metric;
+
+/*!
+ * name of the metric that marks a benchmark recorded for a point where the
+ * benchmark exceeded the timeout of its routine and was killed
+ */
+#define PMM_METRIC_TIMED_OUT "timed_out"
+
+/*!
+ * name of the metric giving the fraction of system capacity taken by other
+ * work while a benchmark executed (see calc_interference())
+ */
+#define PMM_METRIC_INTERFERENCE "interference"
+
 /*!
  * Benchmark structure, storing information routine tests.
  *
@@ -126,15 +196,70 @@ typedef struct pmm_benchmark {
 
     struct timeval used_t;      //!< kernel and user mode execution time summed
 
+    char *cpuset;               //!< cpu list benchmark was pinned to or NULL
+    int numa_node;              //!< numa node memory was bound to or -1
+    int nice;                   //!< nice value benchmark was executed with
+
+    int n_metrics;              //!< number of additional metrics
+    struct pmm_metric *metrics; //!< array of additional metrics or NULL
+
+    struct pmm_slab *slab;      //!< slab the benchmark was allocated from, with
+                                //!< p stored inline, or NULL if malloc'd
+
     struct pmm_benchmark *previous; //!< pointer to previous bench in list
     struct pmm_benchmark *next;     //!< pointer to next bench in list
 } PMM_Benchmark;
 
 
+/*!
+ * running statistics of the benchmarks at a single parameter point
+ *
+ * Speed mean and variance are maintained with Welford's method so they can be
+ * updated as each benchmark is added, without revisiting earlier samples. The
+ * sample variance of the speed is m2_flops/(n-1) when n is at least 2.
+ */
+typedef struct pmm_bench_stats {
+    int n;                      //!< number of benchmarks at the point
+
+    double mean_flops;          //!< mean speed of the benchmarks
+    double m2_flops;            //!< sum of squared differences from the mean
+    double min_flops;           //!< lowest speed of the benchmarks
+    double max_flops;           //!< highest speed of the benchmarks
+
+    double seconds;             //!< total execution time in seconds
+    struct timeval wall_t;      //!< total wall clock execution time
+    struct timeval used_t;      //!< total kernel and user mode execution time
+    double interference;        //!< total interference of the benchmarks
+} PMM_Bench_Stats;
+
+/*!
+ * entry of the hash index of the unique points of a benchmark list
+ */
+typedef struct pmm_bench_point {
+    unsigned int hash;              //!< hash of the point's parameters
+    struct pmm_benchmark *first;    //!< first benchmark at the point in sorted
+                                    //!< order, NULL if the entry is empty
+    struct pmm_bench_stats stats;   //!< statistics of the point's benchmarks
+} PMM_Bench_Point;
+
 /*!
  * structure describing a list of benchmarks
  *
- * Benchmarks are doubly linked.
+ * Benchmarks are doubly linked in sorted order. Beside the list, not in
+ * place of it, a contiguous sorted index holds the benchmarks and, as
+ * parallel arrays, their parameters, speeds and times, so that benchmarks
+ * can be found by binary search and scanned without chasing list pointers.
+ * A hash index of the unique points finds the benchmarks and running
+ * statistics at an exact point in constant time.
+ *
+ * The linked list is kept for code that walks benchmarks through ->next and
+ * ->previous, so each benchmark is reachable both ways. The index costs a
+ * pointer, a copy of the n_p parameters and two doubles per benchmark, and
+ * as the arrays grow by doubling up to twice that, i.e.
+ * (sizeof(void*) + n_p*sizeof(int) + 2*sizeof(double)) * capacity bytes on
+ * top of the benchmarks themselves and their list pointers. The speeds and
+ * times are copied when a benchmark is inserted, so a benchmark must not be
+ * changed while it is in the list.
  */
 typedef struct pmm_bench_list {
     int size;                       /*!< number of benchmarks stored in the list */
@@ -143,6 +268,39 @@ typedef struct pmm_bench_list {
     struct pmm_benchmark *first;    /*!< first element of the list */
     struct pmm_benchmark *last;     /*!< last element of the list */
 
+    int capacity;                   /*!< number of benchmarks the index arrays
+                                         can hold */
+    struct pmm_benchmark **index;   /*!< benchmarks of the list in sorted
+                                         order */
+    int *params;                    /*!< parameters of the benchmarks in sorted
+                                         order, n_p consecutive values each */
+    double *flops;                  /*!< speed of the benchmarks in sorted
+                                         order */
+    double *seconds;                /*!< execution time of the benchmarks in
+                                         sorted order */
+
+    int n_points;                   /*!< number of unique points in the list */
+    int points_capacity;            /*!< number of entries in the point hash
+                                         index, a power of two */
+    struct pmm_bench_point *points; /*!< open addressing hash index of the
+                                         unique points, keyed on parameters */
+
+    struct pmm_slab *slab;          /*!< slab that benchmarks of the list may
+                                         be allocated from */
+
+    unsigned long version;          /*!< incremented whenever a benchmark is
+                                         inserted or removed */
+
+    int n_avg;                      /*!< number of averaged points, for single
+                                         parameter lists */
+    int avg_capacity;               /*!< number of averaged points the arrays
+                                         can hold */
+    int *avg_p;                     /*!< parameter of each unique point in
+                                         increasing order */
+    double *avg_flops;              /*!< average speed at each unique point */
+    unsigned long avg_version;      /*!< version of the list the averaged
+                                         points were taken from */
+
     struct pmm_model *parent_model; /*!< model to which the benchmarks belong */
 } PMM_Bench_List;
 
@@ -152,11 +310,28 @@ typedef struct pmm_bench_list {
  */
 typedef struct pmm_model {
     char *model_path;               /*!< path to model filee */
+    enum pmm_model_format format;   /*!< format the model file is written in,
+                                         any format is read */
     int unwritten_num_execs;        /*!< number of executions since last write */
     double unwritten_time_spend;    /*!< benchmarking time spend since last
                                          write */
     time_t mtime;                   /*!< modified time of the model file */
 
+    unsigned long journal_seq;      /*!< sequence number of the last journal
+                                         record reflected in the model */
+    long journal_size;              /*!< bytes in the journal of the model */
+    long snapshot_size;             /*!< bytes in the model file when it was
+                                         last written */
+    int n_unjournalled;             /*!< number of benchmarks inserted that
+                                         are not yet on disk */
+    int unjournalled_capacity;      /*!< number of benchmarks the unjournalled
+                                         array can hold */
+    struct pmm_benchmark **unjournalled; /*!< benchmarks inserted that are
+                                              not yet on disk, in order */
+    pthread_mutex_t mutex;          /*!< held while the model is changed by
+                                         a benchmark and while it is
+                                         serialised to disk */
+
     int n_p;                        /*!< number of parameters of the model */
 
     int completion;                 /*!< completion state of the model */
@@ -175,6 +350,10 @@ typedef struct pmm_model {
     struct pmm_paramdef_set *pd_set;    /*!< set of parameter definition for
                                              the routine */
 
+    struct pmm_delaunay *triangulation; /*!< cached triangulation of the
+                                             benchmarks, for interpolating
+                                             models of 2 or more parameters */
+
     struct pmm_routine *parent_routine; /*!< routine to which the model
                                              belongs */
 } PMM_Model;
@@ -192,8 +371,16 @@ typedef struct pmm_routine {
 
     //struct pmm_policy *policy; TODO implement policies
     enum pmm_construction_condition condition;  /*!< benchmarking condition */
+    time_t until;       /*!< time after which an until routine is no
+                             longer benchmarked, or -1 if unset */
+    int period_start;   /*!< start of the daily window of a periodic routine
+                             in seconds after midnight, or -1 if unset */
+    int period_end;     /*!< end of the daily window of a periodic routine
+                             in seconds after midnight, or -1 if unset */
     int priority;       /*!< benchmarking priority */
     int executable;     /*!< toggle for executability */
+    int executing;      /*!< toggle set while routine occupies an execution
+                             slot */
 
     enum pmm_construction_method construction_method; /*!< model construction method */
     int min_sample_num;     /*!< minimum samples for each model point */
@@ -201,6 +388,18 @@ typedef struct pmm_routine {
                                  point */
     int max_completion;     /*!< maximum number of model points */
 
+    char *cpuset;       /*!< cpu list to pin benchmarks to or NULL */
+    int numa_node;      /*!< numa node to bind benchmarks to or -1 */
+    int nice;           /*!< nice value to execute benchmarks with (0 leaves
+                             the nice value of the daemon unchanged) */
+
+    int timeout;        /*!< wall-clock seconds after which a benchmark is
+                             killed, or -1 for no limit */
+
+    enum pmm_benchmark_protocol protocol;   /*!< benchmark execution protocol */
+    struct pmm_worker *worker;  /*!< persistent benchmark process of the
+                                     server protocol, or NULL */
+
     struct pmm_model *model;            /*!< pointer to model */
 
     struct pmm_routine *next_routine;   /*!< next routine in routine array/list */
@@ -216,6 +415,10 @@ construction_method_to_string(enum pmm_construction_method method);
 char*
 construction_condition_to_string(enum pmm_construction_condition condition);
 char*
+benchmark_protocol_to_string(enum pmm_benchmark_protocol protocol);
+char*
+scheduling_policy_to_string(enum pmm_scheduling_policy policy);
+char*
 interval_type_to_string(enum pmm_interval_type type);
 
 
@@ -249,6 +452,22 @@ struct pmm_benchmark* new_benchmark();
 struct pmm_bench_list*
 new_bench_list(struct pmm_model *m,
                int n_p);
+struct pmm_benchmark*
+new_list_benchmark(struct pmm_bench_list *bl);
+int grow_bench_list_index(struct pmm_bench_list *bl);
+int grow_bench_list_points(struct pmm_bench_list *bl);
+struct pmm_bench_point*
+bench_list_point_slot(struct pmm_bench_list *bl, int *p, unsigned int hash);
+struct pmm_bench_point*
+get_bench_point(struct pmm_bench_list *bl, int *p);
+void remove_bench_point(struct pmm_bench_list *bl, struct pmm_bench_point *e);
+int bench_list_lower_bound(struct pmm_bench_list *bl, int *p);
+int bench_list_find(struct pmm_bench_list *bl, int *p, int *start);
+int bench_list_index_of(struct pmm_bench_list *bl, struct pmm_benchmark *b);
+void init_bench_stats(struct pmm_bench_stats *s);
+void add_bench_to_stats(struct pmm_bench_stats *s, struct pmm_benchmark *b);
+struct pmm_bench_stats*
+get_bench_stats(struct pmm_bench_list *bl, int *p);
 
 /*
  * init_ functions initialize structures with initial condition data values
@@ -258,16 +477,24 @@ int
 init_bench_list(struct pmm_model *m, struct pmm_paramdef_set *pd_set);
 struct pmm_benchmark*
 init_zero_benchmark(int *params, int n_p);
+struct pmm_benchmark*
+init_list_zero_benchmark(struct pmm_bench_list *bl, int *params);
+void init_benchmark(struct pmm_benchmark *b);
 
 int isempty_model(struct pmm_model *m);
 
 int add_routine(struct pmm_config *c, struct pmm_routine *r);
 int insert_bench(struct pmm_model *m, struct pmm_benchmark *b);
+void release_unjournalled(struct pmm_model *m, int n);
 int
 remove_benchmarks_at_param(struct pmm_model *m, int *p,
                            struct pmm_benchmark ***removed_array);
 
 int copy_benchmark(struct pmm_benchmark *dst, struct pmm_benchmark *src);
+int add_benchmark_metric(struct pmm_benchmark *b, char *name, double value);
+int get_benchmark_metric(struct pmm_benchmark *b, char *name, double *value);
+double get_benchmark_interference(struct pmm_benchmark *b);
+int is_benchmark_timed_out(struct pmm_benchmark *b);
 
 void add_bench(struct pmm_benchmark *a, struct pmm_benchmark *b,
                struct pmm_benchmark *res);
@@ -371,18 +598,48 @@ calc_model_stats(struct pmm_model *m);
 struct pmm_benchmark *
 find_oldapprox(struct pmm_model *m, int *p);
 struct pmm_benchmark* lookup_model(struct pmm_model *m, int *p);
+double predict_bench_seconds(struct pmm_model *m, int *p);
+struct pmm_paramdef_set*
+get_model_paramdef_set(struct pmm_model *m);
+int
+calc_model_complexity(struct pmm_model *m, int *p, int n, double *complexity);
+int
+fit_model_complexity(struct pmm_model *m, double *a, double *k);
+struct pmm_benchmark*
+find_nearest_bench(struct pmm_model *m, int *p);
+int
+estimate_model_complexity(struct pmm_model *m, int *p, int n,
+                          double *complexity);
+double
+predict_point_seconds(struct pmm_model *m, int *p, double flops,
+                      double complexity);
+int
+lookup_model_batch(struct pmm_model *m, int *p, int n, double *flops,
+                   double *seconds);
 struct pmm_benchmark* interpolate_1d_model(struct pmm_bench_list *bl,
                                            int *p);
+int
+interpolate_1d_model_batch(struct pmm_bench_list *bl, int *p, int n,
+                           double *flops);
+int
+update_bench_list_averages(struct pmm_bench_list *bl);
+double
+interpolate_1d_averages(struct pmm_bench_list *bl, int p, int *hint);
+struct pmm_delaunay*
+triangulate_model(struct pmm_model *m, int mode);
+struct pmm_delaunay*
+get_model_triangulation(struct pmm_model *m);
+void
+update_model_triangulation(struct pmm_model *m, int *p, double flops);
+struct pmm_benchmark*
+interpolate_delaunay_model(struct pmm_model *m, int *p, int exclude);
 
 
-int bench_cut_contains(struct pmm_loadhistory *h, struct pmm_benchmark *b1,
-                       struct pmm_benchmark *b2);
-int bench_cut_intersects(struct pmm_loadhistory *h, struct pmm_benchmark *b1,
-                         struct pmm_benchmark *b2);
-int bench_cut_greater(struct pmm_loadhistory *h, struct pmm_benchmark *b1,
-                      struct pmm_benchmark *b2);
-int bench_cut_less(struct pmm_loadhistory *h, struct pmm_benchmark *b1,
-                   struct pmm_benchmark *b2);
+void bench_cut_band(struct pmm_benchmark *b, double *lo, double *hi);
+int bench_cut_contains(struct pmm_benchmark *b1, struct pmm_benchmark *b2);
+int bench_cut_intersects(struct pmm_benchmark *b1, struct pmm_benchmark *b2);
+int bench_cut_greater(struct pmm_benchmark *b1, struct pmm_benchmark *b2);
+int bench_cut_less(struct pmm_benchmark *b1, struct pmm_benchmark *b2);
 
 void print_routine(const char *output, struct pmm_routine *r);
 void print_model(const char *output, struct pmm_model *m);
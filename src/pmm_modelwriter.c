@@ -0,0 +1,196 @@
+/*
+    Copyright (C) 2008-2010 Robert Higgins
+        Author: Robert Higgins <robert.higgins@ucd.ie>
+
+    This file is part of PMM.
+
+    PMM is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMM is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+ * @file    pmm_modelwriter.c
+ * @brief   Code for writing models to disk in the background
+ *
+ * Contains the model writer thread of pmm. Benchmark threads insert their
+ * results into models and wake the writer, which journals the new benchmarks
+ * and compacts the journals into the model files, so benchmarking does not
+ * wait on the disk.
+ */
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <pthread.h>    // for pthreads
+#include <signal.h>     // for kill
+#include <sys/types.h>  // for kill, getpid
+#include <unistd.h>     // for getpid
+
+#include "pmm_model.h"
+#include "pmm_cfgparser.h"
+#include "pmm_modelwriter.h"
+#include "pmm_log.h"
+
+//! set when models may have benchmarks to write, protected by writer_mutex
+static int writer_pending = 0;
+//! set when the writer should exit, protected by writer_mutex
+static int writer_quit = 0;
+static pthread_mutex_t writer_mutex = PTHREAD_MUTEX_INITIALIZER;
+//! signalled, with writer_mutex, when writer_pending or writer_quit is set
+static pthread_cond_t writer_cond = PTHREAD_COND_INITIALIZER;
+
+/*!
+ * model writer thread
+ *
+ * writes the benchmarks inserted into the models of the configuration to
+ * disk until stop_modelwriter() is called. Wakes made while models are being
+ * written are handled by a single further pass over the models, so however
+ * many benchmarks were inserted into a model in the meantime they are
+ * written, and synced, together. Models left to write when the writer stops
+ * are written when the daemon shuts down.
+ *
+ * On failure to write a model the daemon is shut down, as it is on the
+ * failure of a benchmark.
+ *
+ * @param   config  void pointer to the configuration
+ *
+ * @return NULL
+ */
+void*
+modelwriter(void *config)
+{
+    struct pmm_config *cfg;
+    int i;
+
+    cfg = (struct pmm_config*)config;
+
+    for(;;) {
+
+        pthread_mutex_lock(&writer_mutex);
+        while(!writer_pending && !writer_quit) {
+            pthread_cond_wait(&writer_cond, &writer_mutex);
+        }
+
+        if(writer_quit) {
+            pthread_mutex_unlock(&writer_mutex);
+
+            LOGPRINTF("model writer: stopping.\n");
+            return NULL;
+        }
+
+        writer_pending = 0;
+        pthread_mutex_unlock(&writer_mutex);
+
+        for(i=0; i<cfg->used; i++) {
+            if(write_dirty_model(cfg, cfg->routines[i]->model) < 0) {
+                ERRPRINTF("Error writing model for routine: %s. Shutting "
+                          "down ...\n", cfg->routines[i]->name);
+
+                //trigger shutdown
+                kill(getpid(), SIGINT);
+
+                return NULL;
+            }
+        }
+    }
+}
+
+/*!
+ * Wake the model writer so that benchmarks inserted into models are written
+ * to disk
+ */
+void
+wake_modelwriter()
+{
+    pthread_mutex_lock(&writer_mutex);
+    writer_pending = 1;
+    pthread_cond_signal(&writer_cond);
+    pthread_mutex_unlock(&writer_mutex);
+}
+
+/*!
+ * Tell the model writer thread to exit, once any write it is making has
+ * finished
+ */
+void
+stop_modelwriter()
+{
+    pthread_mutex_lock(&writer_mutex);
+    writer_quit = 1;
+    pthread_cond_signal(&writer_cond);
+    pthread_mutex_unlock(&writer_mutex);
+}
+
+/*!
+ * Write the benchmarks inserted into a model since it was last written. They
+ * are appended to the journal of the model, unless the thresholds of the
+ * configuration are met, when the model file is rewritten and the journal
+ * emptied. The model file is not rewritten before the journal has grown as
+ * large as it, so that the bytes written stay linear in the size of the
+ * model. A complete model is always rewritten.
+ *
+ * @param   cfg     pointer to the configuration
+ * @param   m       pointer to the model
+ *
+ * @return 0 on success or if there is nothing to write, -1 on failure
+ */
+int
+write_dirty_model(struct pmm_config *cfg, struct pmm_model *m)
+{
+    int dirty;
+    int compact;
+
+    pthread_mutex_lock(&(m->mutex));
+
+    dirty = m->n_unjournalled > 0;
+
+    compact = m->complete == 1 ||
+              ((m->unwritten_num_execs >= cfg->num_execs_threshold ||
+                m->unwritten_time_spend >= cfg->time_spend_threshold) &&
+               m->journal_size >= m->snapshot_size);
+
+    if(dirty && !compact) {
+        DBGPRINTF("Not writing model "
+                  "(unwritten_num_execs/thres:%d/%d "
+                  "unwritten_time_spend/thres:%f/%d "
+                  "journal/model size:%ld/%ld) ...\n",
+                  m->unwritten_num_execs,
+                  cfg->num_execs_threshold,
+                  m->unwritten_time_spend,
+                  cfg->time_spend_threshold,
+                  m->journal_size,
+                  m->snapshot_size);
+    }
+
+    pthread_mutex_unlock(&(m->mutex));
+
+    if(!dirty) {
+        return 0; //nothing new to write
+    }
+
+    if(compact) {
+        DBGPRINTF("Writing model ...\n");
+
+        if(write_model(m) < 0) {
+            ERRPRINTF("Error writing model to disk.\n");
+            return -1;
+        }
+    }
+    else {
+        if(append_model_journal(m) < 0) {
+            ERRPRINTF("Error appending to model journal.\n");
+            return -1;
+        }
+    }
+
+    return 0; //success
+}
@@ -0,0 +1,49 @@
+/*
+    Copyright (C) 2008-2010 Robert Higgins
+        Author: Robert Higgins <robert.higgins@ucd.ie>
+
+    This file is part of PMM.
+
+    PMM is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMM is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+ * @file   pmm_modelwriter.h
+ * @brief  Background writing of models
+ *
+ * Thread that writes new benchmarks of models to disk on behalf of the
+ * benchmark threads
+ */
+
+#ifndef PMM_MODELWRITER_H_
+#define PMM_MODELWRITER_H_
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "pmm_model.h"
+
+void*
+modelwriter(void *config);
+
+void
+wake_modelwriter();
+
+void
+stop_modelwriter();
+
+int
+write_dirty_model(struct pmm_config *cfg, struct pmm_model *m);
+
+#endif /*PMM_MODELWRITER_H_*/
@@ -30,7 +30,6 @@
 
 #ifdef HAVE_MUPARSER
 
-#include <iostream>
 #include <string>
 #include <muParser.h>
 
@@ -42,48 +41,115 @@ extern "C" {
 }
 
 /*!
- * create a new parameter constraint formula structure for muparser
+ * create a new muparser formula structure for a formula in terms of the
+ * parameters of a set of parameter definitions
  *
  * Initializes muparser object and var array, then links var array to muparser
  * object
  *
- * @param   pd_set  pointer to the set of parameter definitions that
- *                  will contain the constraint formula
+ * @param   pd_set  pointer to the set of parameter definitions that name the
+ *                  variables of the formula
+ * @param   formula formula string
  *
- * @return 0 on success, -1 on failure
+ * @return pointer to the new formula structure or NULL on failure
  */
 extern "C"
-int
-create_param_constraint_muparser(struct pmm_paramdef_set *pd_set)
+struct pmm_param_constraint_muparser*
+create_formula_muparser(struct pmm_paramdef_set *pd_set, char *formula)
 {
+    struct pmm_param_constraint_muparser *parser;
     int i;
     string_type str;
 
-    pd_set->pc_parser = new PMM_Param_Constraint_Muparser;
-    if(pd_set->pc_parser == NULL) {
+    parser = new PMM_Param_Constraint_Muparser;
+    if(parser == NULL) {
         ERRPRINTF("Error allocating memory.\n");
-        return -1;
+        return NULL;
     }
 
-    pd_set->pc_parser->n_p = pd_set->n_p;
-    pd_set->pc_parser->vars = new double[pd_set->pc_parser->n_p];
+    parser->n_p = pd_set->n_p;
+    parser->vars = new double[parser->n_p];
 
 
     // set up parser variables, by name and pointer to element of 'vars'
-    for(i=0; i<pd_set->pc_parser->n_p; i++) {
-        pd_set->pc_parser->vars[i] = 1.0;
+    for(i=0; i<parser->n_p; i++) {
+        parser->vars[i] = 1.0;
         str = pd_set->pd_array[i].name;
 
-        pd_set->pc_parser->p.DefineVar(str,
-                         &(pd_set->pc_parser->vars[i]));
-        DBGPRINTF("setting up variables:\n");
-        std::cout << str << " with value " << pd_set->pc_parser->vars[i] << "\n";
+        parser->p.DefineVar(str, &(parser->vars[i]));
+        DBGPRINTF("setting up variable: %s with value %f\n", str.c_str(),
+                  parser->vars[i]);
+    }
+
+    try {
+        parser->p.SetExpr(formula);
+    }
+    catch (Parser::exception_type &e) {
+        ERRPRINTF("Error setting formula, message: %s\n",
+                  e.GetMsg().c_str());
+
+        free_formula_muparser(&parser);
+        return NULL;
     }
 
-    pd_set->pc_parser->p.SetExpr(pd_set->pc_formula);
+    DBGPRINTF("setting up formula: %s\n", formula);
 
-    DBGPRINTF("setting up formula:\n");
-    std::cout << pd_set->pc_formula << "\n";
+    return parser;
+}
+
+/*!
+ * free a muparser formula structure
+ *
+ * @param   parser  pointer to address of the formula structure
+ */
+extern "C"
+void
+free_formula_muparser(struct pmm_param_constraint_muparser **parser)
+{
+    delete [] (*parser)->vars;
+    delete *parser;
+    *parser = NULL;
+}
+
+/*!
+ * create a new parameter constraint formula structure for muparser
+ *
+ * @param   pd_set  pointer to the set of parameter definitions that
+ *                  will contain the constraint formula
+ *
+ * @return 0 on success, -1 on failure
+ */
+extern "C"
+int
+create_param_constraint_muparser(struct pmm_paramdef_set *pd_set)
+{
+    pd_set->pc_parser = create_formula_muparser(pd_set, pd_set->pc_formula);
+    if(pd_set->pc_parser == NULL) {
+        ERRPRINTF("Error creating parameter constraint parser.\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+/*!
+ * create a new complexity formula structure for muparser
+ *
+ * @param   pd_set  pointer to the set of parameter definitions that
+ *                  will contain the complexity formula
+ *
+ * @return 0 on success, -1 on failure
+ */
+extern "C"
+int
+create_complexity_muparser(struct pmm_paramdef_set *pd_set)
+{
+    pd_set->complexity_parser = create_formula_muparser(pd_set,
+                                                 pd_set->complexity_formula);
+    if(pd_set->complexity_parser == NULL) {
+        ERRPRINTF("Error creating complexity parser.\n");
+        return -1;
+    }
 
     return 0;
 }
@@ -134,8 +200,8 @@ evaluate_constraint(struct pmm_param_constraint_muparser* pc_parser,
         DBGPRINTF("evaluated constraint formula to:%f\n", *value);
     }
     catch (Parser::exception_type &e) {
-        ERRPRINTF("Error evaluating parameter constraint formula, message:\n");
-        std::cout << e.GetMsg() << "\n";
+        ERRPRINTF("Error evaluating parameter constraint formula, "
+                  "message: %s\n", e.GetMsg().c_str());
 
         return -1;
     }
@@ -54,9 +54,18 @@ typedef struct pmm_param_constraint_muparser {
     int n_p;        /*!< length of variable array */
 } PMM_Param_Constraint_Muparser;
 
+struct pmm_param_constraint_muparser*
+create_formula_muparser(struct pmm_paramdef_set *pd_set, char *formula);
+
+void
+free_formula_muparser(struct pmm_param_constraint_muparser **parser);
+
 int
 create_param_constraint_muparser(struct pmm_paramdef_set *pd_set);
 
+int
+create_complexity_muparser(struct pmm_paramdef_set *pd_set);
+
 int
 evaluate_constraint_with_params(struct pmm_param_constraint_muparser* pc_parser,
                                 int* params, double *value);
@@ -43,6 +43,8 @@
 extern "C" {
 #endif
 
+#include "pmm_delaunay.h" // for PMM_ALL/PMM_AVG/PMM_MAX
+
 #ifndef __cplusplus
 typedef struct Matrix {} Matrix;
 typedef struct ColumnVector {} ColumnVector;
@@ -70,10 +72,6 @@ typedef struct pmm_octave_data {
                              cloud described by @a x and @a y */
 } PMM_Octave_Data;
 
-#define PMM_ALL 0 /*!< use all points */
-#define PMM_AVG 1 /*!< use average of points with identical parameters */
-#define PMM_MAX 2 /*!< use maximum of points with identical parameters */
-
 void octave_init();
 struct pmm_octave_data*
 fill_octave_input_matrices(struct pmm_model *m, int mode);
@@ -35,6 +35,7 @@
 
 #include "pmm_log.h"
 #include "pmm_model.h"
+#include "pmm_muparse.h"
 
 
 /*!
@@ -54,6 +55,12 @@ struct pmm_paramdef_set* new_paramdef_set()
     pd_set->pc_formula = (void *)NULL;
     pd_set->pc_max = -1;
     pd_set->pc_min = -1;
+    pd_set->complexity_formula = (void *)NULL;
+
+#ifdef HAVE_MUPARSER
+    pd_set->pc_parser = (void *)NULL;
+    pd_set->complexity_parser = (void *)NULL;
+#endif
 
     return pd_set;
 }
@@ -604,6 +611,38 @@ params_cmp(int *p1, int *p2, int n)
     return 0; // at this point, all parameters are identical
 }
 
+/*!
+ * Hash a parameter array. Elements are combined with FNV-1a and the result is
+ * finalised so that all bits of the hash depend on all bits of the elements,
+ * as parameters are commonly multiples of a power of two stride.
+ *
+ * @param   p   pointer to first element of the array
+ * @param   n   number of elements in the array
+ *
+ * @return hash of the array
+ */
+unsigned int
+params_hash(int *p, int n)
+{
+    unsigned int h;
+    int i;
+
+    h = 2166136261u;
+
+    for(i=0; i<n; i++) {
+        h ^= (unsigned int)p[i];
+        h *= 16777619u;
+    }
+
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+
+    return h;
+}
+
 /*!
  * Step between two points, according to a minimum step size defined in
  * the parameter definitions.
@@ -863,6 +902,10 @@ void print_paramdef_set(const char *output, struct pmm_paramdef_set *pd_set)
 
     SWITCHPRINTF(output, "pc_max:%d\n", pd_set->pc_max);
     SWITCHPRINTF(output, "pc_min:%d\n", pd_set->pc_min);
+
+    if(pd_set->complexity_formula != NULL) {
+        SWITCHPRINTF(output, "complexity:%s\n", pd_set->complexity_formula);
+    }
 }
 
 /*!
@@ -878,6 +921,15 @@ void free_paramdef_set(struct pmm_paramdef_set **pd_set)
 
     free((*pd_set)->pc_formula);
     (*pd_set)->pc_formula = NULL;
+    free((*pd_set)->complexity_formula);
+    (*pd_set)->complexity_formula = NULL;
+
+#ifdef HAVE_MUPARSER
+    if((*pd_set)->pc_parser != NULL)
+        free_formula_muparser(&(*pd_set)->pc_parser);
+    if((*pd_set)->complexity_parser != NULL)
+        free_formula_muparser(&(*pd_set)->complexity_parser);
+#endif
 
     free(*pd_set);
     *pd_set = NULL;
@@ -69,11 +69,17 @@ typedef struct pmm_paramdef_set {
     char *pc_formula;                   /*!< formula for parameter constraint */
     int pc_max;                         /*!< max of parameter constraint */
     int pc_min;                         /*< min of parameter constraint */
+    char *complexity_formula;           /*!< formula for the complexity of
+                                             the routine at a point */
 
 #ifdef HAVE_MUPARSER
     struct pmm_param_constraint_muparser *pc_parser; /*!< muparser structure
                                                           used for parameter
                                                           constraint */
+    struct pmm_param_constraint_muparser *complexity_parser; /*!< muparser
+                                                                  structure
+                                                                  used for
+                                                                  complexity */
 #endif
 
 } PMM_Paramdef_Set;
@@ -100,6 +106,7 @@ void
 set_param_array_copy(int *dst, int *src, int n);
 
 int params_cmp(int *p1, int *p2, int n);
+unsigned int params_hash(int *p, int n);
 
 void
 align_params(int *params, struct pmm_paramdef_set *pd_set);
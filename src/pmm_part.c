@@ -0,0 +1,226 @@
+/*
+    Copyright (C) 2008-2010 Robert Higgins
+        Author: Robert Higgins <robert.higgins@ucd.ie>
+
+    This file is part of PMM.
+
+    PMM is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMM is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+ *
+ * @file pmm_part.c
+ *
+ * @brief Program to partition a problem between processors
+ *
+ * This file contains the pmm_part program, which divides a problem between
+ * processors so that the execution times predicted by their models are equal
+ */
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+#include <sys/time.h>
+
+
+#include "pmm_model.h"
+#include "pmm_partition.h"
+#include "pmm_cfgparser.h"
+#include "pmm_log.h"
+
+/*!
+ * structure storing options for pmm_part tool
+ */
+typedef struct pmm_part_options {
+    int size;
+    int repeats;
+    int n_models;
+    char **model_files;
+} PMM_Part_Options;
+
+
+/*!
+ * print command line usage for pmm_part tool
+ */
+void
+usage()
+{
+    printf("Usage: pmm_part -s size [-r repeats] model ...\n");
+    printf("Options:\n");
+    printf("  -s size        : size of the problem to partition\n");
+    printf("  -r repeats     : time the partitioning over a number of repeats\n");
+    printf("\n");
+}
+
+/*!
+ * parse arguments for pmm_part tool
+ *
+ * @param   opts    pointer to options structure
+ * @param   argc    number of command line arguments
+ * @param   argv    command line arguments character array pointer
+ */
+void
+parse_args(struct pmm_part_options *opts, int argc, char **argv)
+{
+    int c;
+    int option_index;
+
+    opts->size = -1;
+    opts->repeats = 0;
+    opts->n_models = 0;
+    opts->model_files = (void*)NULL;
+
+    while(1) {
+        static struct option long_options[] =
+        {
+            {"size", required_argument, 0, 's'},
+            {"repeats", required_argument, 0, 'r'},
+            {"help", no_argument, 0, 'h'},
+            {0, 0, 0, 0}
+        };
+
+        option_index = 0;
+
+        c = getopt_long(argc, argv, "s:r:h", long_options, &option_index);
+
+        // getopt_long returns -1 when arg list is exhausted
+        if(c == -1) {
+            break;
+        }
+
+        switch(c) {
+            case 's':
+                opts->size = atoi(optarg);
+                break;
+
+            case 'r':
+                opts->repeats = atoi(optarg);
+                break;
+
+            case 'h':
+                usage();
+                exit(EXIT_SUCCESS);
+
+            default:
+                usage();
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    if(opts->size < 0) {
+        fprintf(stderr, "Error: problem size must be specified.\n");
+        usage();
+        exit(EXIT_FAILURE);
+    }
+
+    if(optind >= argc) {
+        fprintf(stderr, "Error: model files must be specified.\n");
+        usage();
+        exit(EXIT_FAILURE);
+    }
+
+    opts->n_models = argc - optind;
+    opts->model_files = &(argv[optind]);
+
+    return;
+}
+
+int
+main(int argc, char **argv)
+{
+
+    struct pmm_part_options opts;
+    struct pmm_model **models;
+    struct timeval start, end;
+    int *parts;
+    int *load_rc;
+    double *seconds;
+    double elapsed;
+    int i, ret;
+
+    parse_args(&opts, argc, argv);
+
+    models = malloc(opts.n_models * sizeof *models);
+    parts = malloc(opts.n_models * sizeof *parts);
+    seconds = malloc(opts.n_models * sizeof *seconds);
+    load_rc = malloc(opts.n_models * sizeof *load_rc);
+    if(models == NULL || parts == NULL || seconds == NULL || load_rc == NULL)
+    {
+        ERRPRINTF("Error allocating memory.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    xmlparser_init();
+
+    for(i=0; i<opts.n_models; i++) {
+        models[i] = new_model();
+        if(models[i] == NULL) {
+            ERRPRINTF("Error allocating new model.\n");
+            exit(EXIT_FAILURE);
+        }
+
+        models[i]->model_path = opts.model_files[i];
+    }
+
+    // parse the model files concurrently
+    if(load_models(models, opts.n_models, parse_model, load_rc) < 0) {
+        ERRPRINTF("Error loading models.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for(i=0; i<opts.n_models; i++) {
+        ret = load_rc[i];
+        if(ret == -1) {
+            ERRPRINTF("Error file does not exist:%s\n", models[i]->model_path);
+            exit(EXIT_FAILURE);
+        }
+        else if(ret < -1) {
+            ERRPRINTF("Error parsing model:%s\n", models[i]->model_path);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if(partition_models(models, opts.n_models, opts.size, parts, seconds) < 0)
+    {
+        ERRPRINTF("Error partitioning problem.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    printf("model part seconds\n");
+    for(i=0; i<opts.n_models; i++) {
+        printf("%s %d %f\n", models[i]->model_path, parts[i], seconds[i]);
+    }
+
+    if(opts.repeats > 0) {
+        gettimeofday(&start, NULL);
+
+        for(i=0; i<opts.repeats; i++) {
+            partition_models(models, opts.n_models, opts.size, parts, NULL);
+        }
+
+        gettimeofday(&end, NULL);
+
+        elapsed = (end.tv_sec - start.tv_sec) +
+                  (end.tv_usec - start.tv_usec)/1000000.0;
+
+        printf("partitioning time:%f us (%d repeats)\n",
+               1000000.0*elapsed/opts.repeats, opts.repeats);
+    }
+
+    xmlparser_cleanup();
+
+    return 0;
+}
@@ -0,0 +1,324 @@
+/*
+    Copyright (C) 2008-2010 Robert Higgins
+        Author: Robert Higgins <robert.higgins@ucd.ie>
+
+    This file is part of PMM.
+
+    PMM is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMM is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+ * @file    pmm_partition.c
+ * @brief   Partitioning of a problem between processors by their models
+ *
+ * The execution time of a part of size x on a processor is its complexity
+ * c(x) divided by the speed s(x) given by the model of the processor. Under
+ * the assumption, made by the GBBP construction too, that this time grows
+ * with x, the largest part a processor can complete within a time T is found
+ * by bisection on x, and the time T at which the parts sum to the problem
+ * size is found by bisection on T. The few units of the problem that the
+ * bisection leaves over are handed out one at a time to the processor that
+ * would finish them first.
+ */
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>     // for malloc/free
+#include <math.h>       // for exp/log/HUGE_VAL
+
+#include "pmm_partition.h"
+#include "pmm_model.h"
+#include "pmm_log.h"
+
+//! maximum number of bisection steps on the execution time
+#define PMM_PARTITION_MAX_STEPS 200
+
+/*!
+ * model of a processor with the fit of the complexity of its benchmarks,
+ * which is made once per partitioning
+ */
+typedef struct pmm_partition_curve {
+    struct pmm_model *m;    /*!< model of the processor */
+    int formula;            /*!< whether the routine declares its complexity */
+    int fitted;             /*!< whether the complexity has been fitted */
+    double a;               /*!< log of the coefficient of the complexity */
+    double k;               /*!< exponent of the complexity */
+} PMM_Partition_Curve;
+
+double
+partition_part_seconds(struct pmm_partition_curve *c, int x);
+int
+partition_max_part(struct pmm_partition_curve *c, int size, double t);
+long long
+partition_sum_parts(struct pmm_partition_curve *curves, int n, int size,
+                    double t, int *parts);
+
+/*!
+ * Predict the execution time of a part of a problem on the processor
+ * described by a model.
+ *
+ * The complexity of the part is given by the complexity formula of the
+ * routine, or taken from the fit to the complexity reported by the benchmarks
+ * of the model, or as x, whichever is available for all of the models being
+ * partitioned between.
+ *
+ * @param   c       pointer to the curve of the processor
+ * @param   x       size of the part
+ *
+ * @return the predicted execution time, 0 for an empty part, HUGE_VAL if the
+ * model gives no speed at x
+ */
+double
+partition_part_seconds(struct pmm_partition_curve *c, int x)
+{
+    double flops, complexity;
+
+    if(x <= 0) {
+        return 0.0;
+    }
+
+    if(lookup_model_batch(c->m, &x, 1, &flops, NULL) < 0 || !(flops > 0.0)) {
+        return HUGE_VAL;
+    }
+
+    if(c->formula) {
+        if(calc_model_complexity(c->m, &x, 1, &complexity) < 0) {
+            return HUGE_VAL;
+        }
+    }
+    else if(c->fitted) {
+        complexity = exp(c->a + c->k*log((double)x));
+    }
+    else {
+        complexity = (double)x;
+    }
+
+    return complexity/flops;
+}
+
+/*!
+ * Find the largest part of a problem that the processor described by a model
+ * can complete within a time.
+ *
+ * @param   c       pointer to the curve of the processor
+ * @param   size    size of the whole problem
+ * @param   t       time available
+ *
+ * @return the size of the largest part, between 0 and size
+ */
+int
+partition_max_part(struct pmm_partition_curve *c, int size, double t)
+{
+    int lo, hi, mid;
+
+    if(partition_part_seconds(c, size) <= t) {
+        return size;
+    }
+
+    // t(lo) <= t < t(hi)
+    lo = 0;
+    hi = size;
+    while(hi - lo > 1) {
+        mid = lo + (hi - lo)/2;
+
+        if(partition_part_seconds(c, mid) <= t) {
+            lo = mid;
+        }
+        else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+/*!
+ * Find the largest part each processor can complete within a time and the
+ * total of those parts.
+ *
+ * @param   curves  pointer to array of curves of the processors
+ * @param   n       number of processors
+ * @param   size    size of the whole problem
+ * @param   t       time available
+ * @param   parts   pointer to array of n integers where the parts are stored
+ *
+ * @return the sum of the parts
+ */
+long long
+partition_sum_parts(struct pmm_partition_curve *curves, int n, int size,
+                    double t, int *parts)
+{
+    long long sum;
+    int i;
+
+    sum = 0;
+    for(i=0; i<n; i++) {
+        parts[i] = partition_max_part(&(curves[i]), size, t);
+        sum += parts[i];
+    }
+
+    return sum;
+}
+
+/*!
+ * Partition a problem between processors so that the execution times their
+ * models predict for each part are equal.
+ *
+ * @param   models  pointer to array of models of the processors, each of a
+ *                  single parameter, the size of the problem
+ * @param   n       number of models
+ * @param   size    size of the whole problem
+ * @param   parts   pointer to array of n integers where the size of the part
+ *                  given to each processor is stored
+ * @param   seconds pointer to array of n doubles where the predicted
+ *                  execution time of each part is stored, or NULL
+ *
+ * @return 0 on success, -1 on failure, including when the models together do
+ * not cover a problem of the size given
+ */
+int
+partition_models(struct pmm_model **models, int n, int size, int *parts,
+                 double *seconds)
+{
+    struct pmm_partition_curve *curves;
+    int *hi_parts;
+    int i, best, step;
+    long long sum;
+    double t_lo, t_hi, t, best_t, complexity;
+
+    if(n <= 0) {
+        ERRPRINTF("No models to partition between.\n");
+        return -1;
+    }
+
+    for(i=0; i<n; i++) {
+        if(models[i]->n_p != 1 || models[i]->bench_list == NULL) {
+            ERRPRINTF("Can only partition with single parameter models.\n");
+            return -1;
+        }
+    }
+
+    curves = malloc(n * sizeof *curves);
+    hi_parts = malloc(n * sizeof *hi_parts);
+    if(curves == NULL || hi_parts == NULL) {
+        ERRPRINTF("Error allocating memory.\n");
+        free(curves);
+        free(hi_parts);
+        return -1;
+    }
+
+    for(i=0; i<n; i++) {
+        curves[i].m = models[i];
+        curves[i].formula = calc_model_complexity(models[i], &size, 1,
+                                                  &complexity) == 0;
+        curves[i].fitted = fit_model_complexity(models[i], &(curves[i].a),
+                                                &(curves[i].k)) > 0;
+        parts[i] = 0;
+    }
+
+    // times are only comparable if every complexity is found the same way
+    for(i=0; i<n && curves[i].formula; i++);
+    if(i < n) {
+        for(i=0; i<n; i++) {
+            curves[i].formula = 0;
+        }
+    }
+
+    for(i=0; i<n && curves[i].fitted; i++);
+    if(i < n) {
+        for(i=0; i<n; i++) {
+            curves[i].fitted = 0;
+        }
+    }
+
+    if(size > 0) {
+
+        // bound the time from above, starting from the slowest processor
+        // taking an even share of the problem
+        t_hi = 0.0;
+        for(i=0; i<n; i++) {
+            t = partition_part_seconds(&(curves[i]), (size + n - 1)/n);
+            if(t < HUGE_VAL && t > t_hi) {
+                t_hi = t;
+            }
+        }
+        if(t_hi <= 0.0) {
+            t_hi = 1.0;
+        }
+
+        while(partition_sum_parts(curves, n, size, t_hi, hi_parts) < size) {
+            t_hi *= 2.0;
+
+            if(t_hi >= HUGE_VAL) {
+                ERRPRINTF("Problem size %d exceeds the range of the models.\n",
+                          size);
+                free(curves);
+                free(hi_parts);
+                return -1;
+            }
+        }
+
+        // parts at t_lo sum to less than size, at t_hi to at least size
+        t_lo = 0.0;
+        for(step=0; step<PMM_PARTITION_MAX_STEPS; step++) {
+            t = 0.5*(t_lo + t_hi);
+            if(t <= t_lo || t >= t_hi) {
+                break;
+            }
+
+            if(partition_sum_parts(curves, n, size, t, parts) < size) {
+                t_lo = t;
+            }
+            else {
+                t_hi = t;
+            }
+        }
+
+        sum = partition_sum_parts(curves, n, size, t_lo, parts);
+
+        // hand out what is left to whichever processor finishes it first
+        for(; sum < size; sum++) {
+            best = -1;
+            best_t = HUGE_VAL;
+            for(i=0; i<n; i++) {
+                t = partition_part_seconds(&(curves[i]), parts[i] + 1);
+                if(best < 0 || t < best_t) {
+                    best = i;
+                    best_t = t;
+                }
+            }
+
+            if(best_t >= HUGE_VAL) {
+                ERRPRINTF("Problem size %d exceeds the range of the models.\n",
+                          size);
+                free(curves);
+                free(hi_parts);
+                return -1;
+            }
+
+            parts[best]++;
+        }
+    }
+
+    if(seconds != NULL) {
+        for(i=0; i<n; i++) {
+            seconds[i] = partition_part_seconds(&(curves[i]), parts[i]);
+        }
+    }
+
+    free(curves);
+    free(hi_parts);
+
+    return 0;
+}
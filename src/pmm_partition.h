@@ -0,0 +1,42 @@
+/*
+    Copyright (C) 2008-2010 Robert Higgins
+        Author: Robert Higgins <robert.higgins@ucd.ie>
+
+    This file is part of PMM.
+
+    PMM is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMM is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+ * @file   pmm_partition.h
+ * @brief  Partitioning of a problem between processors by their models
+ *
+ * Given the functional performance models of a routine on several processors,
+ * a problem of some size is divided between them so that the execution times
+ * predicted by the models for each part are equal.
+ */
+
+#ifndef PMM_PARTITION_H_
+#define PMM_PARTITION_H_
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "pmm_model.h"
+
+int
+partition_models(struct pmm_model **models, int n, int size, int *parts,
+                 double *seconds);
+
+#endif /*PMM_PARTITION_H_*/
@@ -28,43 +28,130 @@
 #include "config.h"
 #endif
 
+#include <pthread.h>    // for pthread_cond_broadcast
+#include <stdlib.h>     // for free
+#include <float.h>      // for DBL_MAX
+#include <time.h>       // for clock_gettime
+
 #include "pmm_model.h"
 #include "pmm_cond.h"
+#include "pmm_param.h"
+#include "pmm_selector.h"
+#include "pmm_scheduler.h"
+#include "pmm_log.h"
+
+//! mutex for accessing executing_benchmark variable and execution slots
+extern pthread_mutex_t executing_benchmark_mutex;
+//! condition the main loop waits on for scheduling events
+extern pthread_cond_t scheduler_cond;
+
+/*!
+ * Calculate the score of a routine under the cost scheduling policy: the
+ * expected improvement of its model per second of benchmarking. The
+ * improvement from a new point is taken to diminish with the number of points
+ * already in the model and is weighted by the routine priority. The runtime
+ * of the next point is predicted from the model.
+ *
+ * @param   r       pointer to the routine
+ *
+ * @return the score, or DBL_MAX if the runtime cannot be predicted so that
+ * routines without enough data for a prediction are benchmarked first
+ */
+double
+cost_schedule_score(struct pmm_routine *r)
+{
+    int *p;
+    double seconds;
+    double weight;
+
+    p = peek_new_bench(r);
+    if(p == NULL) {
+        return DBL_MAX;
+    }
+
+    seconds = predict_bench_seconds(r->model, p);
+
+    DBGPRINTF("routine:%s predicted benchmark seconds:%f\n", r->name,
+              seconds);
+    print_params(PMM_DBG, p, r->pd_set->n_p);
+
+    free(p);
+    p = NULL;
+
+    if(seconds <= 0.) {
+        return DBL_MAX;
+    }
+
+    weight = r->priority > 0 ? (double)r->priority : 1.;
+
+    return weight / ((r->model->completion + 1) * seconds);
+}
 
 /*!
- * Function handles the chosing of the next routine to benchmark.
+ * Function handles the chosing of the next routine to benchmark. Routines
+ * that are currently being benchmarked in another execution slot are not
+ * considered.
+ *
+ * With the SP_PRIORITY policy the routine with the highest priority is
+ * chosen, with the SP_COST policy the routine with the highest
+ * cost_schedule_score(). Ties are broken by picking the least complete
+ * routine.
  *
  * @param   scheduled       pointer to pointer describing routine picked for
  *                          scheduling
  * @param   r               pointer to array of routines from which to pick
  * @param   n               number of routines in array
+ * @param   policy          scheduling policy
  *
  * @return 0 if all routines are already complete (so we don't need to try
  * to schedule them any longer), 1 if there is a schedulable routine, 2 if
  * there are no schedulable routines at present (but some are still incomplete)
  *
+ * @pre executing_benchmark_mutex is held by the caller
  */
 int
-schedule_routine(struct pmm_routine** scheduled, struct pmm_routine** r, int n) {
+schedule_routine(struct pmm_routine** scheduled, struct pmm_routine** r, int n,
+                 enum pmm_scheduling_policy policy) {
 
     int i, status = 0;
+    double score = 0., scheduled_score = 0.;
+    time_t now;
     *scheduled = NULL;
 
+    now = cond_time_now();
+
 
     //iterate over r
     for(i=0; i<n; i++) {
 
         check_conds(r[i]);
 
-        //check routine is executable and model is not complete
-        if(r[i]->executable &&
+        //check routine is executable, not already occupying an execution
+        //slot and model is not complete
+        if(r[i]->executable && !r[i]->executing &&
            !r[i]->model->complete) { //TODO possibly rearrange these checks
+
+            //routines are not executing so their models are not modified
+            //while we look at them
+            if(policy == SP_COST) {
+                score = cost_schedule_score(r[i]);
+            }
+
             //if no routine is scheduled
             if(*scheduled == NULL) {
                 *scheduled = r[i];
+                scheduled_score = score;
                 status = 1;
             }
 
+            //if score is greater change scheduled
+            else if(policy == SP_COST && score != scheduled_score) {
+                if(score > scheduled_score) {
+                    *scheduled = r[i];
+                    scheduled_score = score;
+                }
+            }
+
             //if priority is greater change scheduled
             else if(r[i]->priority > (*scheduled)->priority) {
                 *scheduled = r[i];
@@ -78,10 +165,89 @@ schedule_routine(struct pmm_routine** scheduled, struct pmm_routine** r, int n)
                 }
             }
         }
-        //check if there is routines incomplete and not executable
-        if(!r[i]->model->complete && status == 0)
+        //check if there is routines incomplete and not executable, ignoring
+        //those whose conditions will never be satisfied again
+        if(!r[i]->model->complete && status == 0 &&
+           (r[i]->executing || next_cond_time(r[i], now) != (time_t)-1))
+        {
             status = 2;
+        }
     }
 
     return status;
 }
+
+/*!
+ * Find when the main loop should next reconsider routines that are waiting
+ * on their execution conditions. Routines waiting on a time window are woken
+ * exactly when it opens, routines waiting on conditions that cannot be
+ * evented (e.g. users logged in) are polled every poll period.
+ *
+ * @param   r               pointer to array of routines
+ * @param   n               number of routines in array
+ * @param   poll_period     pointer to the polling period
+ * @param   wake_at         pointer to timespec set to the absolute wake up
+ *                          time
+ *
+ * @return 1 if wake_at was set, 0 if no routine is waiting on a condition
+ * that can become satisfied, i.e. the main loop need only wait for events
+ *
+ * @pre executing_benchmark_mutex is held by the caller
+ */
+int
+schedule_wake_time(struct pmm_routine** r, int n,
+                   struct timespec *poll_period, struct timespec *wake_at)
+{
+    int i, set = 0;
+    struct timespec now, t;
+    time_t cond_time;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    for(i=0; i<n; i++) {
+        if(r[i]->model->complete || r[i]->executing || r[i]->executable) {
+            continue;
+        }
+
+        cond_time = next_cond_time(r[i], now.tv_sec);
+
+        if(cond_time == (time_t)-1) {
+            continue;
+        }
+        else if(cond_time == 0) {
+            t.tv_sec = now.tv_sec + poll_period->tv_sec;
+            t.tv_nsec = now.tv_nsec + poll_period->tv_nsec;
+            if(t.tv_nsec >= 1000000000L) {
+                t.tv_sec++;
+                t.tv_nsec -= 1000000000L;
+            }
+        }
+        else {
+            t.tv_sec = cond_time;
+            t.tv_nsec = 0;
+        }
+
+        if(!set || t.tv_sec < wake_at->tv_sec ||
+           (t.tv_sec == wake_at->tv_sec && t.tv_nsec < wake_at->tv_nsec))
+        {
+            *wake_at = t;
+            set = 1;
+        }
+    }
+
+    return set;
+}
+
+/*!
+ * Wake the main loop so that execution slots and routines are reconsidered
+ * immediately, e.g. after an event that may change what is schedulable.
+ *
+ * @pre executing_benchmark_mutex is not held by the caller
+ */
+void
+wake_scheduler()
+{
+    pthread_mutex_lock(&executing_benchmark_mutex);
+    pthread_cond_broadcast(&scheduler_cond);
+    pthread_mutex_unlock(&executing_benchmark_mutex);
+}
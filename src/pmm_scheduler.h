@@ -24,6 +24,12 @@
 #include "config.h"
 #endif
 
-int schedule_routine(struct pmm_routine** scheduled, struct pmm_routine** r, int n);
+#include "pmm_model.h"
+
+int schedule_routine(struct pmm_routine** scheduled, struct pmm_routine** r, int n,
+                     enum pmm_scheduling_policy policy);
+int schedule_wake_time(struct pmm_routine** r, int n,
+                       struct timespec *poll_period, struct timespec *wake_at);
+void wake_scheduler();
 
 #endif /*PMM_SCHEDULER_H_*/
@@ -104,22 +104,21 @@ init_gbbp_boundary_intervals(struct pmm_routine *r);
 int
 naive_process_interval_list(struct pmm_routine *r, struct pmm_benchmark *b);
 int
-process_interval_list(struct pmm_routine *r, struct pmm_benchmark *b,
-                      struct pmm_loadhistory *h);
+process_interval_list(struct pmm_routine *r, struct pmm_benchmark *b);
 int
 process_interval(struct pmm_routine *r, struct pmm_interval *i,
-                 struct pmm_benchmark *b, struct pmm_loadhistory *h);
+                 struct pmm_benchmark *b);
 int
 process_it_gbbp_empty(struct pmm_routine *r, struct pmm_interval *i);
 int
 process_it_gbbp_climb(struct pmm_routine *r, struct pmm_interval *i,
-                      struct pmm_benchmark *b, struct pmm_loadhistory *h);
+                      struct pmm_benchmark *b);
 int
 process_it_gbbp_bisect(struct pmm_routine *r, struct pmm_interval *i,
-                    struct pmm_benchmark *b, struct pmm_loadhistory *h);
+                    struct pmm_benchmark *b);
 int
 process_it_gbbp_inflect(struct pmm_routine *r, struct pmm_interval *i,
-                     struct pmm_benchmark *b, struct pmm_loadhistory *h);
+                     struct pmm_benchmark *b);
 int
 process_it_point(struct pmm_routine *r, struct pmm_interval *i);
 
@@ -150,8 +149,13 @@ new_projection_interval(int *p, struct pmm_paramdef *pd, int d,
                          int n);
 int
 find_interval_matching_bench(struct pmm_routine *r, struct pmm_benchmark *b,
-                             struct pmm_loadhistory *h,
                              struct pmm_interval **found_i);
+int
+process_timed_out_bench(struct pmm_routine *r, struct pmm_benchmark *b);
+int
+is_param_beyond(int *q, int *p, struct pmm_paramdef_set *pd_set);
+int
+is_param_on_interval(int *p, struct pmm_interval *i);
 
 int
 multi_gbbp_bench_from_interval(struct pmm_routine *r,
@@ -160,19 +164,6 @@ multi_gbbp_bench_from_interval(struct pmm_routine *r,
 
 void mesh_boundary_models(struct pmm_model *m);
 void recurse_mesh(struct pmm_model *m, int *p, int plane, int n_p);
-/*
- * functions to write:
- *
- * bench_cut_greater(a,b) - takes benchmarks, uses history to calculate cuts and
- *                          works out if a is greater than b
- *
- * bench_cut_contains(a,b) - takes benchmarks, uses history to calculate cuts
- *                           and works out if b is contained by a
- *
- * bench_cut_intersects(a,b) - takes benchmarks, uses history to calculate cuts
- *                             and works of it a intersects b
- *
- */
 
 
 /*!
@@ -351,7 +342,9 @@ multi_naive_insert_bench(struct pmm_routine *r, struct pmm_benchmark *b)
     DBGPRINTF("total time spent benchmarking point: %f\n", time_spend);
     DBGPRINTF("total number executions at benchmarking point: %d\n", num_execs);
 
-    if(check_benchmarking_minimums(r, time_spend, num_execs))
+    //a point where the benchmark timed out is not measured again
+    if(is_benchmark_timed_out(b) ||
+       check_benchmarking_minimums(r, time_spend, num_execs))
     {
         DBGPRINTF("benchmarking threshold exceeeded (t:%d, n:%d), processing intervals.\n", r->min_sample_time, r->min_sample_num);
 
@@ -1095,7 +1088,8 @@ init_gbbp_naive_intervals(struct pmm_routine *r)
             else if(proj_i != NULL)
             {
                 // create a zero speed point at end ...
-                zero_b = init_zero_benchmark(proj_i->end, r->pd_set->n_p);
+                zero_b = init_list_zero_benchmark(r->model->bench_list,
+                                                  proj_i->end);
                 if(zero_b == NULL) {
                     ERRPRINTF("Error allocating new benchmark.\n");
                     return -1;
@@ -1428,7 +1422,8 @@ init_gbbp_diagonal_interval(struct pmm_routine *r)
         if(r->pd_set->pc_max != -1) {
 
             // create a zero speed point at interval end ...
-            zero_b = init_zero_benchmark(diag_i->end, r->pd_set->n_p);
+            zero_b = init_list_zero_benchmark(r->model->bench_list,
+                                              diag_i->end);
             if(zero_b == NULL) {
                 ERRPRINTF("Error allocating new benchmark.\n");
                 return -1;
@@ -1881,7 +1876,7 @@ project_diagonal_intervals(struct pmm_model *m)
             else {
                 // create a zero speed point at end ...
                 //
-                zero_b = init_zero_benchmark(b->p, b->n_p);
+                zero_b = init_list_zero_benchmark(m->bench_list, b->p);
                 if(zero_b == NULL) {
                     ERRPRINTF("Error allocating new benchmark.\n");
                     return -1;
@@ -2407,6 +2402,17 @@ naive_1d_bisect_insert_bench(struct pmm_routine *r, struct pmm_benchmark *b)
         ret = -2;
     }
 
+    //a point where the benchmark timed out is not measured again, instead
+    //the construction intervals are cut short at the point
+    if(is_benchmark_timed_out(b)) {
+        if(process_timed_out_bench(r, b) < 0) {
+            ERRPRINTF("Error processing timed out benchmark.\n");
+            ret = -1;
+        }
+
+        return ret;
+    }
+
     //first check time spent benchmarking at this point, if it is less than
     //the threshold, we won't bother processing the interval list (so that
     //the benchmark may be executed again, until it exceeds the threshold
@@ -2421,7 +2427,7 @@ naive_1d_bisect_insert_bench(struct pmm_routine *r, struct pmm_benchmark *b)
         DBGPRINTF("benchmarking threshold exceeeded (t:%d, n:%d), processing intervals.\n", r->min_sample_time, r->min_sample_num);
 
         //find interval
-        if(find_interval_matching_bench(r, b, NULL, &interval) < 0) {
+        if(find_interval_matching_bench(r, b, &interval) < 0) {
             ERRPRINTF("Error searching intervals.\n");
             return -1;
         }
@@ -2544,7 +2550,6 @@ naive_1d_bisect_insert_bench(struct pmm_routine *r, struct pmm_benchmark *b)
  * @return 0 on success, -1 on failure to process intervals, -2 on failure
  * to insert benchmark
  *
- * @param   h   pointer to the load history
  * @param   r   pointer to the routine to which the benchmark is added
  * @param   b   pointer to the benchmark to be added
  *
@@ -2552,8 +2557,7 @@ naive_1d_bisect_insert_bench(struct pmm_routine *r, struct pmm_benchmark *b)
  * to add benchmark to model
  */
 int
-multi_gbbp_insert_bench(struct pmm_loadhistory *h, struct pmm_routine *r,
-                        struct pmm_benchmark *b)
+multi_gbbp_insert_bench(struct pmm_routine *r, struct pmm_benchmark *b)
 {
 
     double time_spend;
@@ -2570,6 +2574,17 @@ multi_gbbp_insert_bench(struct pmm_loadhistory *h, struct pmm_routine *r,
         ret = -2;
     }
 
+    //a point where the benchmark timed out is not measured again, instead
+    //the construction intervals are cut short at the point
+    if(is_benchmark_timed_out(b)) {
+        if(process_timed_out_bench(r, b) < 0) {
+            ERRPRINTF("Error processing timed out benchmark.\n");
+            ret = -1;
+        }
+
+        return ret;
+    }
+
     //first check time spent benchmarking at this point, if it is less than
     //the threshold, we won't bother processing the interval list (so that
     //the benchmark may be executed again, until it exceeds the threshold
@@ -2582,7 +2597,7 @@ multi_gbbp_insert_bench(struct pmm_loadhistory *h, struct pmm_routine *r,
     {
         DBGPRINTF("benchmarking threshold exceeeded (t:%d, n:%d), processing intervals.\n", r->min_sample_time, r->min_sample_num);
 
-        if(process_interval_list(r, b, h) < 0) {
+        if(process_interval_list(r, b) < 0) {
             ERRPRINTF("Error proccessing intervals, inserting bench anyway\n");
             ret = -1;
         }
@@ -2597,6 +2612,261 @@ multi_gbbp_insert_bench(struct pmm_loadhistory *h, struct pmm_routine *r,
     return ret;
 }
 
+/*!
+ * Process a benchmark recorded at a point where the benchmark exceeded the
+ * timeout of the routine. Larger problem sizes are assumed to take at least
+ * as long, so the model is not constructed at or beyond the point: intervals
+ * that start beyond the point are removed and intervals that pass through
+ * the point are replaced by an IT_GBBP_BISECT interval ending at the point
+ * (where the timed out benchmark has zero speed), or shortened to end at the
+ * point if they are still IT_GBBP_EMPTY.
+ *
+ * @param   r   pointer to the routine who's model is being constructed
+ * @param   b   pointer to the timed out benchmark
+ *
+ * @return 0 on success, -1 on failure
+ */
+int
+process_timed_out_bench(struct pmm_routine *r, struct pmm_benchmark *b)
+{
+    struct pmm_model *m;
+    struct pmm_interval *i, *i_prev, *new_i;
+    int *start;
+
+    m = r->model;
+
+    DBGPRINTF("pruning intervals beyond timed out point:\n");
+    print_params(PMM_DBG, b->p, b->n_p);
+
+    start = malloc(b->n_p * sizeof *start);
+    if(start == NULL) {
+        ERRPRINTF("Error allocating memory.\n");
+        return -1;
+    }
+
+    i = m->interval_list->top;
+    while(i != NULL) {
+
+        i_prev = i->previous; //store this as i may be removed
+
+        switch(i->type) {
+            case IT_POINT :
+
+                if(is_param_beyond(i->start, b->p, r->pd_set)) {
+                    remove_interval(m->interval_list, i);
+                }
+
+                break;
+
+            case IT_GBBP_EMPTY :
+            case IT_GBBP_CLIMB :
+            case IT_GBBP_BISECT :
+            case IT_GBBP_INFLECT :
+
+                if(is_param_beyond(i->start, b->p, r->pd_set)) {
+                    remove_interval(m->interval_list, i);
+                }
+                else if(is_param_beyond(i->end, b->p, r->pd_set) &&
+                        is_param_on_interval(b->p, i))
+                {
+                    // an empty interval has not been benchmarked at all yet,
+                    // so it is only shortened
+                    if(i->type == IT_GBBP_EMPTY) {
+                        set_param_array_copy(i->end, b->p, b->n_p);
+                        break;
+                    }
+
+                    // a climb interval has been benchmarked up to its current
+                    // step, bisect from there
+                    if(i->type == IT_GBBP_CLIMB &&
+                       set_params_step_along_climb_interval(start,
+                                    i->climb_step, i, r->pd_set) == 0)
+                    {
+                        align_params(start, r->pd_set);
+
+                        if(is_param_beyond(start, b->p, r->pd_set)) {
+                            set_param_array_copy(start, i->start, b->n_p);
+                        }
+                    }
+                    else {
+                        set_param_array_copy(start, i->start, b->n_p);
+                    }
+
+                    new_i = init_interval(i->plane, i->n_p, IT_GBBP_BISECT,
+                                          start, b->p);
+                    if(new_i == NULL) {
+                        ERRPRINTF("Error initialising new interval.\n");
+
+                        free(start);
+                        start = NULL;
+
+                        return -1;
+                    }
+
+                    if(is_interval_divisible(new_i, r) == 1) {
+                        add_top_interval(m->interval_list, new_i);
+                    }
+                    else {
+                        DBGPRINTF("Interval not divisible, not adding.\n");
+                        free_interval(&new_i);
+                    }
+
+                    remove_interval(m->interval_list, i);
+                }
+
+                break;
+
+            default :
+                break;
+        }
+
+        i = i_prev;
+    }
+
+    free(start);
+    start = NULL;
+
+    if(isempty_interval_list(m->interval_list)) {
+        DBGPRINTF("interval list now empty.\n");
+
+        new_i = new_interval();
+        new_i->type = IT_COMPLETE;
+        add_top_interval(m->interval_list, new_i);
+
+        m->complete = 1;
+    }
+
+    return 0;
+}
+
+/*!
+ * Test if a parameter point lies at or beyond another point, in the direction
+ * of the parameter ranges, in every parameter.
+ *
+ * @param   q       pointer to the parameters being tested
+ * @param   p       pointer to the parameters of the reference point
+ * @param   pd_set  pointer to the parameter definitions
+ *
+ * @return 1 if q lies at or beyond p, 0 otherwise
+ */
+int
+is_param_beyond(int *q, int *p, struct pmm_paramdef_set *pd_set)
+{
+    int j;
+    int direction;
+
+    for(j=0; j<pd_set->n_p; j++) {
+        direction = pd_set->pd_array[j].end >= pd_set->pd_array[j].start ?
+                    1 : -1;
+
+        if(((long long)q[j] - p[j]) * direction < 0) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/*!
+ * Test if a parameter point lies on the line segment between the start and
+ * end points of an interval.
+ *
+ * @param   p       pointer to the parameters being tested
+ * @param   i       pointer to the interval
+ *
+ * @return 1 if p lies on the interval, 0 otherwise
+ */
+int
+is_param_on_interval(int *p, struct pmm_interval *i)
+{
+    int j, k;
+    long long d_p, d_i;
+
+    // find a parameter that varies along the interval to compare others to
+    for(k=0; k<i->n_p; k++) {
+        if(i->start[k] != i->end[k]) {
+            break;
+        }
+    }
+    if(k == i->n_p) {
+        return params_cmp(p, i->start, i->n_p) == 0;
+    }
+
+    // p must lie between start and end in the varying parameter ...
+    d_p = (long long)p[k] - i->start[k];
+    d_i = (long long)i->end[k] - i->start[k];
+    if(d_p * d_i < 0 || (d_p < 0 ? -d_p : d_p) > (d_i < 0 ? -d_i : d_i)) {
+        return 0;
+    }
+
+    // ... and the displacement of p from start must be parallel to the
+    // interval in all others
+    for(j=0; j<i->n_p; j++) {
+        if(((long long)p[j] - i->start[j]) * d_i !=
+           ((long long)i->end[j] - i->start[j]) * d_p)
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/*!
+ * Find the point the next benchmark of a routine will most likely be
+ * executed at, without modifying the construction intervals of its model.
+ *
+ * This is the point described by the top construction interval. When the
+ * interval list has not been initialised yet, or the top interval requires
+ * processing before a point is selected, or points are selected randomly, the
+ * next point is not known.
+ *
+ * @param   r   pointer to the routine
+ *
+ * @return pointer to a newly allocated parameter array describing the point
+ * or NULL if it is not known
+ */
+int*
+peek_new_bench(struct pmm_routine *r)
+{
+    struct pmm_interval *top_i;
+    int *params;
+
+    if(r->construction_method == CM_RAND ||
+       isempty_interval_list(r->model->interval_list))
+    {
+        return NULL;
+    }
+
+    top_i = r->model->interval_list->top;
+
+    switch(top_i->type) {
+        case IT_GBBP_EMPTY :
+        case IT_GBBP_CLIMB :
+        case IT_GBBP_BISECT :
+        case IT_GBBP_INFLECT :
+        case IT_POINT :
+            break;
+        default :
+            return NULL;
+    }
+
+    params = malloc(r->pd_set->n_p * sizeof *params);
+    if(params == NULL) {
+        ERRPRINTF("Error allocating memory.\n");
+        return NULL;
+    }
+
+    if(multi_gbbp_bench_from_interval(r, top_i, params) < 0) {
+        free(params);
+        return NULL;
+    }
+
+    align_params(params, r->pd_set);
+
+    return params;
+}
+
 /*!
  * Find the interval in an interval stack that corresponds to a given benchmark.
  *
@@ -2605,7 +2875,6 @@ multi_gbbp_insert_bench(struct pmm_loadhistory *h, struct pmm_routine *r,
  *
  * @param   r           pointer to routine containing model and parameter definitions
  * @param   b           pointer to benchmark whos interval we are searching for
- * @param   h           pointer to load history
  * @param   found_i     pointer to address that will hold the found interval or point
  *                      to NULL
  *
@@ -2613,7 +2882,6 @@ multi_gbbp_insert_bench(struct pmm_loadhistory *h, struct pmm_routine *r,
  */
 int
 find_interval_matching_bench(struct pmm_routine *r, struct pmm_benchmark *b,
-                             struct pmm_loadhistory *h,
                              struct pmm_interval **found_i)
 {
 
@@ -2621,8 +2889,6 @@ find_interval_matching_bench(struct pmm_routine *r, struct pmm_benchmark *b,
     int *temp_params;
     int done = 0, ret;
 
-    (void)h; //TODO unused
-
     // set found to NULL incase we don't find anything and in case of error
     *found_i = NULL;
 
@@ -2691,13 +2957,11 @@ find_interval_matching_bench(struct pmm_routine *r, struct pmm_benchmark *b,
  *
  * @param   r   pointer to routine
  * @param   b   pointer to benchmark
- * @param   h   load history
  *
  * @return 0 on successful processing of interval, -1 on failure
  */
 int
-process_interval_list(struct pmm_routine *r, struct pmm_benchmark *b,
-                      struct pmm_loadhistory *h)
+process_interval_list(struct pmm_routine *r, struct pmm_benchmark *b)
 {
 
     struct pmm_interval *i, *i_prev;
@@ -2740,7 +3004,7 @@ process_interval_list(struct pmm_routine *r, struct pmm_benchmark *b,
             print_interval(PMM_DBG, i);
             print_params(PMM_DBG, temp_params, r->pd_set->n_p);
 
-            done = process_interval(r, i, b, h);
+            done = process_interval(r, i, b);
             if(done < 0) {
 
                 ERRPRINTF("Error processing interval.\n");
@@ -2775,7 +3039,6 @@ process_interval_list(struct pmm_routine *r, struct pmm_benchmark *b,
  * @param   r   pointer to the routine who's model is being constructed
  * @param   i   pointer to the interval to process
  * @param   b   pointer to the benchmark that is being inserted to the model
- * @param   h   pointer to the load history defining performance fluctuation
  *
  * @return 1 if processing is successful, and no further intervals should be
  * processed, 0 if processing is successful but further intervals should be
@@ -2783,7 +3046,7 @@ process_interval_list(struct pmm_routine *r, struct pmm_benchmark *b,
  */
 int
 process_interval(struct pmm_routine *r, struct pmm_interval *i,
-                 struct pmm_benchmark *b, struct pmm_loadhistory *h)
+                 struct pmm_benchmark *b)
 {
     int done;
 
@@ -2799,19 +3062,19 @@ process_interval(struct pmm_routine *r, struct pmm_interval *i,
         case IT_GBBP_CLIMB :
 
             //if process_ returns failure (<0) set done to -1, otherwise 1
-            done = process_it_gbbp_climb(r, i, b, h) < 0 ? -1 : 1;
+            done = process_it_gbbp_climb(r, i, b) < 0 ? -1 : 1;
 
             break;
 
         case IT_GBBP_BISECT :
 
-            done = process_it_gbbp_bisect(r, i, b, h) < 0 ? -1 : 1;
+            done = process_it_gbbp_bisect(r, i, b) < 0 ? -1 : 1;
 
             break;
 
         case IT_GBBP_INFLECT :
 
-            done = process_it_gbbp_inflect(r, i, b, h) < 0 ? -1 : 1;
+            done = process_it_gbbp_inflect(r, i, b) < 0 ? -1 : 1;
 
             break;
 
@@ -2878,8 +3141,6 @@ process_it_gbbp_empty(struct pmm_routine *r, struct pmm_interval *i)
  * @param   r           pointer to the routine that cotains the model
  * @param   i           pointer to the interval that the benchmark belongs to
  * @param   b           pointer to the benchmark
- * @param   h           pointer to the load history (describes performance
- *                      variance)
  *
  * @pre interval i and benchmark b match, m is the correct model, etc.
  *
@@ -2887,7 +3148,7 @@ process_it_gbbp_empty(struct pmm_routine *r, struct pmm_interval *i)
  */
 int
 process_it_gbbp_climb(struct pmm_routine *r, struct pmm_interval *i,
-                      struct pmm_benchmark *b, struct pmm_loadhistory *h)
+                      struct pmm_benchmark *b)
 
 {
     struct pmm_model *m;
@@ -2979,12 +3240,12 @@ process_it_gbbp_climb(struct pmm_routine *r, struct pmm_interval *i,
         //
         // i.e. if the performance has been decreasing consistantly for the last
         // three benchmarks ...
-        if((bench_cut_greater(h, b_left_0, b_avg) ||
-                                  bench_cut_contains(h, b_left_0, b_avg)) &&
-           (bench_cut_greater(h, b_left_1, b_left_0) ||
-                                  bench_cut_contains(h, b_left_1, b_left_0)) &&
-           (bench_cut_greater(h, b_left_2, b_left_1) ||
-                                  bench_cut_contains(h, b_left_2, b_left_1)))
+        if((bench_cut_greater(b_left_0, b_avg) ||
+                                  bench_cut_contains(b_left_0, b_avg)) &&
+           (bench_cut_greater(b_left_1, b_left_0) ||
+                                  bench_cut_contains(b_left_1, b_left_0)) &&
+           (bench_cut_greater(b_left_2, b_left_1) ||
+                                  bench_cut_contains(b_left_2, b_left_1)))
         {
             DBGPRINTF("performance no longer climbing\n");
             DBGPRINTF("previous bench speeds:\n");
@@ -3124,13 +3385,12 @@ set_params_step_along_climb_interval(int *params, int step,
  * @param   r   pointer to the routine
  * @param   i   pointer to the interval being processed
  * @param   b   pointer to the new benchmark
- * @param   h   pointer to the load history
  *
  * @return 0 on success, -1 on failure
  */
 int
 process_it_gbbp_bisect(struct pmm_routine *r, struct pmm_interval *i,
-                       struct pmm_benchmark *b, struct pmm_loadhistory *h)
+                       struct pmm_benchmark *b)
 {
 
     struct pmm_interval *new_i;
@@ -3182,8 +3442,8 @@ process_it_gbbp_bisect(struct pmm_routine *r, struct pmm_interval *i,
 
 
     //
-    intersects_left = bench_cut_intersects(h, b_left, b_avg);
-    intersects_right = bench_cut_intersects(h, b_right, b_avg);
+    intersects_left = bench_cut_intersects(b_left, b_avg);
+    intersects_right = bench_cut_intersects(b_right, b_avg);
 
     if(intersects_left == 1 && intersects_right == 1) {
         // new benchmark cut intersets l.h.s. and r.h.s.
@@ -3274,7 +3534,7 @@ process_it_gbbp_bisect(struct pmm_routine *r, struct pmm_interval *i,
             return -1;
         }
 
-        if(bench_cut_intersects(h, b_oldapprox, b_avg)) {
+        if(bench_cut_intersects(b_oldapprox, b_avg)) {
             //
             // insersects old approximation, change to
             // recurisve bisect with INFLECT tag, create
@@ -3422,13 +3682,12 @@ process_it_gbbp_bisect(struct pmm_routine *r, struct pmm_interval *i,
  * @param   r   pointer to the routine
  * @param   i   pointer to the interval being processed
  * @param   b   pointer to the new benchmark
- * @param   h   pointer to the load history
  *
  * @return 0 on success, -1 on failure
  */
 int
 process_it_gbbp_inflect(struct pmm_routine *r, struct pmm_interval *i,
-                        struct pmm_benchmark *b, struct pmm_loadhistory *h)
+                        struct pmm_benchmark *b)
 {
 
     struct pmm_interval *new_i;
@@ -3491,7 +3750,7 @@ process_it_gbbp_inflect(struct pmm_routine *r, struct pmm_interval *i,
     }
 
 
-    if(bench_cut_intersects(h, b_oldapprox, b_avg)) {
+    if(bench_cut_intersects(b_oldapprox, b_avg)) {
         //
         // we are on a straight line section of the model
         // no need to add new construction intervals, can
@@ -3500,8 +3759,8 @@ process_it_gbbp_inflect(struct pmm_routine *r, struct pmm_interval *i,
         remove_interval(m->interval_list, i);
     }
     else {
-        intersects_left = bench_cut_intersects(h, b_left, b_avg);
-        intersects_right = bench_cut_intersects(h, b_right, b_avg);
+        intersects_left = bench_cut_intersects(b_left, b_avg);
+        intersects_right = bench_cut_intersects(b_right, b_avg);
 
         // this should never happen, as it would mean model already
         // accurately approximated the benchmark above
@@ -58,8 +58,10 @@ int*
 multi_gbbp_select_new_bench(struct pmm_routine *r);
 
 int
-multi_gbbp_insert_bench(struct pmm_loadhistory *h, struct pmm_routine *r,
-                        struct pmm_benchmark *b);
+multi_gbbp_insert_bench(struct pmm_routine *r, struct pmm_benchmark *b);
+
+int*
+peek_new_bench(struct pmm_routine *r);
 
 
 
@@ -0,0 +1,177 @@
+/*
+    Copyright (C) 2008-2010 Robert Higgins
+        Author: Robert Higgins <robert.higgins@ucd.ie>
+
+    This file is part of PMM.
+
+    PMM is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMM is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+ * @file    pmm_slab.c
+ * @brief   Slab allocator for small fixed size objects
+ *
+ * Objects are carved from chunks that grow geometrically in size. Released
+ * objects are kept on a free list and reused, memory is only returned to the
+ * system when the whole slab is freed.
+ */
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>     // for malloc/free
+
+#include "pmm_slab.h"
+#include "pmm_log.h"
+
+//! number of objects in the first chunk of a slab
+#define PMM_SLAB_INIT_OBJS 32
+//! largest number of objects in a chunk of a slab
+#define PMM_SLAB_MAX_OBJS 4096
+
+/*!
+ * type with the strictest alignment that objects in a slab may need
+ */
+union pmm_slab_align {
+    void *p;
+    long long int ll;
+    double d;
+};
+
+/*!
+ * Round a size up to a multiple of the alignment of slab objects
+ *
+ * @param   size    size in bytes
+ *
+ * @return the rounded size
+ */
+size_t
+slab_align(size_t size)
+{
+    size_t a = sizeof(union pmm_slab_align);
+
+    return (size + a - 1) / a * a;
+}
+
+/*!
+ * Create a new slab of objects of a given size
+ *
+ * @param   size    size of the objects in bytes
+ *
+ * @return pointer to a newly allocated slab or NULL on failure
+ */
+struct pmm_slab*
+new_slab(size_t size)
+{
+    struct pmm_slab *s;
+
+    s = malloc(sizeof *s);
+    if(s == NULL) {
+        ERRPRINTF("Error allocating memory.\n");
+        return NULL;
+    }
+
+    // objects on the free list store the link to the next free object
+    s->size = slab_align(size < sizeof(void *) ? sizeof(void *) : size);
+    s->chunk_objs = PMM_SLAB_INIT_OBJS;
+    s->chunks = NULL;
+    s->next = NULL;
+    s->end = NULL;
+    s->free_list = NULL;
+    s->n_objs = 0;
+
+    return s;
+}
+
+/*!
+ * Allocate an object from a slab. The object is not initialised.
+ *
+ * @param   s   pointer to the slab
+ *
+ * @return pointer to the object or NULL on failure
+ */
+void*
+slab_alloc(struct pmm_slab *s)
+{
+    struct pmm_slab_chunk *c;
+    void *obj;
+
+    if(s->free_list != NULL) {
+        obj = s->free_list;
+        s->free_list = *(void **)obj;
+    }
+    else {
+        if(s->next == s->end) {
+            c = malloc(slab_align(sizeof *c) + s->chunk_objs * s->size);
+            if(c == NULL) {
+                ERRPRINTF("Error allocating slab chunk.\n");
+                return NULL;
+            }
+
+            c->next = s->chunks;
+            s->chunks = c;
+
+            s->next = (char *)c + slab_align(sizeof *c);
+            s->end = s->next + s->chunk_objs * s->size;
+
+            if(s->chunk_objs < PMM_SLAB_MAX_OBJS) {
+                s->chunk_objs *= 2;
+            }
+        }
+
+        obj = s->next;
+        s->next += s->size;
+    }
+
+    s->n_objs++;
+
+    return obj;
+}
+
+/*!
+ * Release an object back to the slab it was allocated from
+ *
+ * @param   s   pointer to the slab
+ * @param   obj pointer to the object
+ */
+void
+slab_free(struct pmm_slab *s, void *obj)
+{
+    *(void **)obj = s->free_list;
+    s->free_list = obj;
+
+    s->n_objs--;
+}
+
+/*!
+ * Free a slab and all the objects allocated from it
+ *
+ * @param   s   pointer to address of the slab
+ */
+void
+free_slab(struct pmm_slab **s)
+{
+    struct pmm_slab_chunk *c, *next;
+
+    if((*s)->n_objs != 0) {
+        DBGPRINTF("Freeing slab with %d objects in use.\n", (*s)->n_objs);
+    }
+
+    for(c = (*s)->chunks; c != NULL; c = next) {
+        next = c->next;
+        free(c);
+    }
+
+    free(*s);
+    *s = NULL;
+}
@@ -0,0 +1,73 @@
+/*
+    Copyright (C) 2008-2010 Robert Higgins
+        Author: Robert Higgins <robert.higgins@ucd.ie>
+
+    This file is part of PMM.
+
+    PMM is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMM is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+ * @file   pmm_slab.h
+ * @brief  Slab allocator for small fixed size objects
+ *
+ * A slab hands out objects of one size from large chunks of memory, so that
+ * structures which are created in great numbers, such as the benchmarks of
+ * a model, do not each need a call to malloc and free.
+ */
+
+#ifndef PMM_SLAB_H_
+#define PMM_SLAB_H_
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stddef.h>     // for size_t
+
+/*!
+ * chunk of memory that objects of a slab are allocated from, objects follow
+ * the header
+ */
+typedef struct pmm_slab_chunk {
+    struct pmm_slab_chunk *next;    /*!< previously allocated chunk */
+} PMM_Slab_Chunk;
+
+/*!
+ * slab of fixed size objects
+ */
+typedef struct pmm_slab {
+    size_t size;                    /*!< size of the objects, rounded up for
+                                         alignment */
+    int chunk_objs;                 /*!< number of objects the next chunk will
+                                         hold */
+    struct pmm_slab_chunk *chunks;  /*!< most recently allocated chunk */
+    char *next;                     /*!< next unused object in newest chunk */
+    char *end;                      /*!< end of the newest chunk */
+    void *free_list;                /*!< objects released for reuse */
+    int n_objs;                     /*!< number of objects in use */
+} PMM_Slab;
+
+size_t
+slab_align(size_t size);
+struct pmm_slab*
+new_slab(size_t size);
+void*
+slab_alloc(struct pmm_slab *s);
+void
+slab_free(struct pmm_slab *s, void *obj);
+void
+free_slab(struct pmm_slab **s);
+
+#endif /*PMM_SLAB_H_*/
+
@@ -28,6 +28,9 @@
 #endif
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
 #include <sys/time.h>
 #include <sys/resource.h>
 #include <libxml/encoding.h>
@@ -56,6 +59,8 @@ void print_xml_results(struct timeval *walltime, struct timeval *usedtime);
 int print_xml_time_element(xmlTextWriterPtr writer, const char *name,
                             struct timeval *time);
 void print_plain_results(struct timeval *walltime, struct timeval *usedtime);
+void print_result_record(long wall_secs, long wall_usecs, long used_secs,
+                         long used_usecs, long long complexity);
 
 // PAPI variables
 #ifdef HAVE_PAPI
@@ -78,14 +83,55 @@ struct rusage usage_temp;
 
 long long pmm_complexity;
 
+// additional metrics reported with the result record
+char pmm_metric_names[PMM_MAX_METRICS][PMM_METRIC_NAME_MAX];
+double pmm_metric_values[PMM_MAX_METRICS];
+int pmm_n_metrics = 0;
+
 #define XMLENCODING "ISO-8859-1"
 
 void pmm_timer_init(long long complexity)
 {
     pmm_complexity = complexity;
+    pmm_n_metrics = 0;
     return;
 }
 
+/*!
+ * Add a named metric to be reported with the next result, e.g. a number of
+ * repetitions, a variance or a hardware counter. Must be called after
+ * pmm_timer_init() and before pmm_timer_result().
+ *
+ * @param   name    name of the metric, without whitespace
+ * @param   value   value of the metric
+ *
+ * @return 0 on success, -1 if the name is invalid or too many metrics have
+ * been added
+ */
+int pmm_timer_add_metric(const char *name, double value)
+{
+    int i;
+
+    if(pmm_n_metrics >= PMM_MAX_METRICS) {
+        return -1;
+    }
+
+    if(name[0] == '\0' || strlen(name) >= PMM_METRIC_NAME_MAX) {
+        return -1;
+    }
+    for(i=0; name[i] != '\0'; i++) {
+        if(isspace((unsigned char)name[i])) {
+            return -1;
+        }
+    }
+
+    strcpy(pmm_metric_names[pmm_n_metrics], name);
+    pmm_metric_values[pmm_n_metrics] = value;
+    pmm_n_metrics++;
+
+    return 0;
+}
+
 void pmm_timer_destroy() {
 
     return;
@@ -140,11 +186,11 @@ void pmm_timer_result() {
 
 
 #ifdef HAVE_PAPI
-    printf("%d %d\n", (int)papi_realtime, (int)(1000000.0*(papi_realtime-
-                                                         (int)papi_realtime)));
-    printf("%d %d\n", (int)papi_usedtime, (int)(1000000.0*(papi_usedtime-
-                                                         (int)papi_usedtime)));
-    printf("%lld\n", papi_complexity);
+    print_result_record((long)papi_realtime,
+                        (long)(1000000.0*(papi_realtime-(int)papi_realtime)),
+                        (long)papi_usedtime,
+                        (long)(1000000.0*(papi_usedtime-(int)papi_usedtime)),
+                        papi_complexity);
 #else
     timersub(&realtime_end, &realtime_start, &realtime_total);
 
@@ -163,10 +209,47 @@ void pmm_timer_result() {
     print_plain_results(&realtime_total, &usedtime_total);
 #endif
 
+    // stdout is a pipe to pmmd, a benchmark using the server protocol will
+    // not exit after this so we must flush the result record
+    fflush(stdout);
 
     return;
 }
 
+/*!
+ * Read the next set of parameters streamed by pmmd to a benchmark that is
+ * using the server protocol. Parameters are sent as a line of space separated
+ * integers. After each set is read the benchmark should time the routine and
+ * call pmm_timer_result() to return the result record.
+ *
+ * @param   n       number of parameters expected
+ * @param   p       pointer to an array of n doubles to store the parameters
+ *
+ * @return 1 if a set of parameters was read, 0 if pmmd has closed the stream
+ * and the benchmark should exit, -1 if the parameter line was malformed
+ */
+int pmm_server_read_params(int n, double *p)
+{
+    char line[1024];
+    char *pos, *end;
+    int i;
+
+    if(fgets(line, sizeof line, stdin) == NULL) {
+        return 0;
+    }
+
+    pos = line;
+    for(i=0; i<n; i++) {
+        p[i] = strtod(pos, &end);
+        if(end == pos) {
+            return -1;
+        }
+        pos = end;
+    }
+
+    return 1;
+}
+
 /*
  * TODO pass up return conditions instead of terminating
  */
@@ -270,9 +353,8 @@ int print_xml_time_element(xmlTextWriterPtr writer, const char *name,
 void print_plain_results(struct timeval *walltime, struct timeval *usedtime) {
     FILE *fp;
 
-    printf("%ld %ld\n", walltime->tv_sec, walltime->tv_usec);
-    printf("%ld %ld\n", usedtime->tv_sec, usedtime->tv_usec);
-    printf("%lld\n", pmm_complexity);
+    print_result_record(walltime->tv_sec, walltime->tv_usec,
+                        usedtime->tv_sec, usedtime->tv_usec, pmm_complexity);
 
     fp = fopen("/tmp/pmm_results", "w");
     fprintf(fp, "%ld %ld\n", walltime->tv_sec, walltime->tv_usec);
@@ -280,4 +362,39 @@ void print_plain_results(struct timeval *walltime, struct timeval *usedtime) {
     fclose(fp);
 }
 
-
+/*!
+ * Print a result record. The record is versioned and made of a header line:
+ *
+ * pmm_result <version> <number of key/value lines>
+ *
+ * followed by that many lines of a key and a value. The keys wall_secs,
+ * wall_usecs, used_secs, used_usecs and complexity are always present,
+ * resource usage of the process and metrics added with
+ * pmm_timer_add_metric() follow.
+ */
+void print_result_record(long wall_secs, long wall_usecs, long used_secs,
+                         long used_usecs, long long complexity)
+{
+    int i;
+
+    printf("%s %d %d\n", PMM_RESULT_MAGIC, PMM_RESULT_VERSION,
+           10 + pmm_n_metrics);
+
+    printf("wall_secs %ld\n", wall_secs);
+    printf("wall_usecs %ld\n", wall_usecs);
+    printf("used_secs %ld\n", used_secs);
+    printf("used_usecs %ld\n", used_usecs);
+    printf("complexity %lld\n", complexity);
+
+    printf("max_rss_kb %ld\n", usage_end.ru_maxrss);
+    printf("minor_faults %ld\n", usage_end.ru_minflt - usage_start.ru_minflt);
+    printf("major_faults %ld\n", usage_end.ru_majflt - usage_start.ru_majflt);
+    printf("voluntary_ctx_switches %ld\n",
+           usage_end.ru_nvcsw - usage_start.ru_nvcsw);
+    printf("involuntary_ctx_switches %ld\n",
+           usage_end.ru_nivcsw - usage_start.ru_nivcsw);
+
+    for(i=0; i<pmm_n_metrics; i++) {
+        printf("%s %.17g\n", pmm_metric_names[i], pmm_metric_values[i]);
+    }
+}
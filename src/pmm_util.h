@@ -39,6 +39,14 @@ extern struct timeval tret;*/
 #define PMM_EXIT_EXEFAIL 4
 #define PMM_EXIT_GENFAIL 5
 
+/*
+ * result record format
+ */
+#define PMM_RESULT_MAGIC "pmm_result"
+#define PMM_RESULT_VERSION 1
+#define PMM_MAX_METRICS 32
+#define PMM_METRIC_NAME_MAX 64
+
 /*
 #define pmm_timersub(a, b, result) {                                          \
   do {                                                                        \
@@ -67,6 +75,9 @@ void pmm_timer_destroy();
 void pmm_timer_start();
 void pmm_timer_stop();
 void pmm_timer_result();
+int pmm_timer_add_metric(const char *name, double value);
+
+int pmm_server_read_params(int n, double *p);
 //void pmm_rusagesub(struct rusage a, struct rusage b, struct rusage result);
 //
 #endif /*PMM_UTIL_H_*/
@@ -55,9 +55,9 @@
 #include <pthread.h>
 #include <libgen.h>
 #include <string.h>
+#include <math.h> // for NAN
 
 #include "pmm_model.h"
-#include "pmm_octave.h"
 #include "pmm_interval.h"
 #include "pmm_log.h"
 #include "pmm_argparser.h"
@@ -122,6 +122,7 @@ main(int argc, char **argv) {
     struct pmm_config *cfg;             // pointer to pmm configuration
 
     struct pmm_model **models;          // array of models to plot
+    int *load_rc;                       // return code of loading each model
     int n_p;                            // number of parameters to models
 
     gnuplot_ctrl *plot_handle;          // handle to the gnuplot process
@@ -167,7 +168,8 @@ main(int argc, char **argv) {
 
 
         models = malloc(options.n_plots * sizeof *models);
-        if(models == NULL) {
+        load_rc = malloc(options.n_plots * sizeof *load_rc);
+        if(models == NULL || load_rc == NULL) {
             ERRPRINTF("Error allocating memory.\n");
             exit(EXIT_FAILURE);
         }
@@ -242,25 +244,25 @@ main(int argc, char **argv) {
         }
 
 
-        // parse models from files on disk
+        // parse models from files on disk, concurrently
+        if(load_models(models, options.n_plots, load_model, load_rc) < 0) {
+            ERRPRINTF("Error loading models.\n");
+            exit(EXIT_FAILURE);
+        }
+
         n_p=0;
         for(i = 0; i < options.n_plots; i++) {
 
-            // if model has not yet been parsed ...
-            if(models[i]->completion == 0) {
-
-                ret = parse_model(models[i]);
-                if(ret == -1) {
-                    ERRPRINTF("Error file does not exist:%s\n",
-                            models[i]->model_path);
-                    exit(EXIT_FAILURE);
-                }
-                else if(ret < -1) {
-                    ERRPRINTF("Error parsing models[%d]: %s.\n",
-                            i, models[i]->model_path);
-                    exit(EXIT_FAILURE);
-                }
-
+            ret = load_rc[i];
+            if(ret == -1) {
+                ERRPRINTF("Error file does not exist:%s\n",
+                        models[i]->model_path);
+                exit(EXIT_FAILURE);
+            }
+            else if(ret < -1) {
+                ERRPRINTF("Error parsing models[%d]: %s.\n",
+                        i, models[i]->model_path);
+                exit(EXIT_FAILURE);
             }
 
             // test number of  parameters are all the same and all not greater
@@ -483,7 +485,17 @@ main(int argc, char **argv) {
 
                 for(i = 0; i < options.n_plots; i++) {
                     empty_model(models[i]);
-                    ret = parse_model(models[i]);
+                }
+
+                if(load_models(models, options.n_plots, load_model,
+                               load_rc) < 0)
+                {
+                    ERRPRINTF("Error loading models.\n");
+                    exit(EXIT_FAILURE);
+                }
+
+                for(i = 0; i < options.n_plots; i++) {
+                    ret = load_rc[i];
                     if(ret == -1) {
                         ERRPRINTF("Error: model file does not exist:%s\n",
                                   models[i]->model_path);
@@ -505,6 +517,9 @@ main(int argc, char **argv) {
             }
         }
 
+        free(load_rc);
+        load_rc = NULL;
+
         gnuplot_close(plot_handle);
     }
 
@@ -562,6 +577,8 @@ test_model_file_modified(struct pmm_model *m)
 
     int ret;
     struct stat file_stats;
+    struct stat journal_stats;
+    char *journal_file;
 
     ret = stat(m->model_path, &file_stats);
     if(ret < 0) {
@@ -569,6 +586,19 @@ test_model_file_modified(struct pmm_model *m)
         return -1;
     }
 
+    // benchmarks are appended to the journal between writes of the model
+    journal_file = model_journal_path(m);
+    if(journal_file != NULL) {
+        if(stat(journal_file, &journal_stats) == 0 &&
+           journal_stats.st_mtime > file_stats.st_mtime)
+        {
+            file_stats.st_mtime = journal_stats.st_mtime;
+        }
+
+        free(journal_file);
+        journal_file = NULL;
+    }
+
     if(m->mtime < file_stats.st_mtime) {
         m->mtime = file_stats.st_mtime;
         return 1;
@@ -600,6 +630,7 @@ empty_model(struct pmm_model *m)
     m->n_p = -1;
     m->completion = 0;
     m->complete = 0;
+    m->journal_seq = 0;
 }
 
 /*!
@@ -750,7 +781,7 @@ plot_slice_interp_model(gnuplot_ctrl *plot_handle, struct pmm_model *model,
     int max, min;
 
 
-    struct pmm_octave_data *oct_data;
+    struct pmm_delaunay *tri;
     double *approx_speeds;
     int **base_points;
     int mode;
@@ -808,16 +839,8 @@ plot_slice_interp_model(gnuplot_ctrl *plot_handle, struct pmm_model *model,
         exit(EXIT_FAILURE);
     }
 
-    octave_init();
-
-    // TODO fill with max, avg or all points in model
-    oct_data = fill_octave_input_matrices(model, mode);
-    if(oct_data == NULL) {
-        ERRPRINTF("Error preparing octave input data.\n");
-        exit(EXIT_FAILURE);
-    }
-
-    if(octave_triangulate(oct_data) < 0) {
+    tri = triangulate_model(model, mode);
+    if(tri == NULL) {
         ERRPRINTF("Error calculating triangulation of data.\n");
         exit(EXIT_FAILURE);
     }
@@ -834,13 +857,15 @@ plot_slice_interp_model(gnuplot_ctrl *plot_handle, struct pmm_model *model,
     }
 
 
-    approx_speeds = octave_interp_array(oct_data, base_points, model->n_p, n);
-
-    if(approx_speeds == NULL) {
-        ERRPRINTF("Error interpolating model.\n");
-        exit(EXIT_FAILURE);
+    // points outside the hull of the benchmarks are not plotted
+    for(i=0; i<n; i++) {
+        if(delaunay_interpolate(tri, base_points[i], &approx_speeds[i]) < 0) {
+            approx_speeds[i] = NAN;
+        }
     }
 
+    free_delaunay(&tri);
+
     y = approx_speeds;
 
     if(model->parent_routine != NULL) {
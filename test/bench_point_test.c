@@ -0,0 +1,280 @@
+/*
+    Copyright (C) 2008-2010 Robert Higgins
+        Author: Robert Higgins <robert.higgins@ucd.ie>
+
+    This file is part of PMM.
+
+    PMM is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMM is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+ * @file    bench_point_test.c
+ * @brief   Test the point hash index of bench lists
+ *
+ * Points are chosen so that their hashes collide on the last slot of the
+ * index, making probe sequences wrap around to the start, then points are
+ * removed from the middle of a probe sequence and the index is grown well
+ * past its initial capacity, checking after each step that every point is
+ * found, that the index has no holes in its probe sequences and that the
+ * parallel arrays of the sorted index match their benchmarks.
+ */
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+
+#include "pmm_model.h"
+#include "pmm_param.h"
+#include "pmm_test.h"
+
+//! initial capacity of the point index, as in pmm_model.c
+#define INIT_CAPACITY 64
+//! number of points inserted to grow the index
+#define N_GROW 1000
+
+int
+find_colliding(unsigned int slot, unsigned int mask, int from);
+void
+check_index(struct pmm_bench_list *bl, int *count, int n_count);
+struct pmm_benchmark*
+remove_point(struct pmm_model *m, int p);
+
+/*!
+ * Find a point whose hash falls on a slot of an index
+ *
+ * @param   slot    slot the hash of the point should fall on
+ * @param   mask    mask of the index
+ * @param   from    value of the parameter to search from
+ *
+ * @return the parameter value of the point
+ */
+int
+find_colliding(unsigned int slot, unsigned int mask, int from)
+{
+    int p;
+
+    for(p=from; ; p++) {
+        if((params_hash(&p, 1) & mask) == slot) {
+            return p;
+        }
+    }
+}
+
+/*!
+ * Check the sorted and point indexes of a single parameter bench list against
+ * the count of benchmarks expected at each point
+ *
+ * @param   bl      pointer to the bench list
+ * @param   count   number of benchmarks expected at each point value
+ * @param   n_count number of point values
+ */
+void
+check_index(struct pmm_bench_list *bl, int *count, int n_count)
+{
+    struct pmm_bench_point *e;
+    unsigned int mask, home, i, j;
+    int p, k, n_points, occupied;
+
+    // the parallel arrays of the sorted index match their benchmarks
+    for(k=0; k<bl->size; k++) {
+        TEST_CHECK(bl->params[k] == bl->index[k]->p[0]);
+        TEST_CHECK(bl->flops[k] == bl->index[k]->flops);
+        TEST_CHECK(bl->seconds[k] == bl->index[k]->seconds);
+    }
+
+    mask = (unsigned int)bl->points_capacity - 1;
+
+    // every entry is reachable from its home slot without crossing a hole
+    occupied = 0;
+    for(i=0; i<(unsigned int)bl->points_capacity; i++) {
+        e = &(bl->points[i]);
+        if(e->first == NULL) {
+            continue;
+        }
+        occupied++;
+
+        TEST_CHECK(e->hash == params_hash(e->first->p, bl->n_p));
+
+        home = e->hash & mask;
+        for(j=home; j!=i; j=(j+1)&mask) {
+            TEST_CHECK(bl->points[j].first != NULL);
+        }
+    }
+
+    n_points = 0;
+    for(p=0; p<n_count; p++) {
+        e = get_bench_point(bl, &p);
+
+        if(count[p] == 0) {
+            TEST_CHECK(e == NULL);
+            continue;
+        }
+
+        n_points++;
+        TEST_CHECK(e != NULL);
+        if(e != NULL) {
+            TEST_CHECK(e->first->p[0] == p);
+            TEST_CHECK(e->stats.n == count[p]);
+        }
+    }
+
+    TEST_CHECK(occupied == n_points);
+    TEST_CHECK(bl->n_points == n_points);
+}
+
+/*!
+ * Remove the first benchmark at a point of a single parameter model
+ *
+ * @param   m   pointer to the model
+ * @param   p   parameter value of the point
+ *
+ * @return pointer to the removed benchmark, to be freed by the caller
+ */
+struct pmm_benchmark*
+remove_point(struct pmm_model *m, int p)
+{
+    struct pmm_benchmark *b;
+
+    b = get_first_bench(m, &p);
+    TEST_CHECK(b != NULL);
+    if(b == NULL) {
+        exit(test_result("bench_point_test"));
+    }
+
+    TEST_CHECK(remove_bench_from_bench_list(m->bench_list, b) == 0);
+
+    return b;
+}
+
+int
+main(void)
+{
+    struct pmm_model *m;
+    struct pmm_benchmark *b;
+    unsigned int mask;
+    int *count;
+    int n_count;
+    int wrap[4], zero[2];
+    int i, p, slot;
+
+    mask = INIT_CAPACITY - 1;
+
+    // points colliding on the last slot, and on the first slot which their
+    // probe sequence wraps around to
+    wrap[0] = find_colliding(mask, mask, 1);
+    for(i=1; i<4; i++) {
+        wrap[i] = find_colliding(mask, mask, wrap[i-1]+1);
+    }
+    zero[0] = find_colliding(0, mask, 1);
+    zero[1] = find_colliding(0, mask, zero[0]+1);
+
+    n_count = 0;
+    for(i=0; i<4; i++) {
+        n_count = wrap[i] >= n_count ? wrap[i]+1 : n_count;
+    }
+    for(i=0; i<2; i++) {
+        n_count = zero[i] >= n_count ? zero[i]+1 : n_count;
+    }
+    if(n_count < N_GROW) {
+        n_count = N_GROW;
+    }
+
+    count = calloc(n_count, sizeof *count);
+    if(count == NULL) {
+        fprintf(stderr, "Error allocating memory.\n");
+        return 1;
+    }
+
+    m = test_new_model(1);
+
+    // collisions, wrapping around the end of the index
+    for(i=0; i<4; i++) {
+        test_add_bench(m, &(wrap[i]), 1e6, 1.0, -1);
+        count[wrap[i]]++;
+    }
+    for(i=0; i<2; i++) {
+        test_add_bench(m, &(zero[i]), 1e6, 1.0, -1);
+        count[zero[i]]++;
+    }
+    // a second benchmark at a point does not take a new slot
+    test_add_bench(m, &(wrap[1]), 2e6, 1.0, -1);
+    count[wrap[1]]++;
+
+    TEST_CHECK(m->bench_list->points_capacity == INIT_CAPACITY);
+
+    // probe sequence runs 63, 0, 1, 2 for the colliding points then 3, 4
+    // for the points whose home is slot 0
+    for(i=0; i<4; i++) {
+        slot = get_bench_point(m->bench_list, &(wrap[i])) -
+               m->bench_list->points;
+        TEST_CHECK(slot == (int)((mask + i) & mask));
+    }
+    for(i=0; i<2; i++) {
+        slot = get_bench_point(m->bench_list, &(zero[i])) -
+               m->bench_list->points;
+        TEST_CHECK(slot == 3 + i);
+    }
+    check_index(m->bench_list, count, n_count);
+
+    // removal in the middle of the probe sequence, at the wrapped slot 0
+    b = remove_point(m, wrap[1]);
+    free_benchmark(&b);
+    count[wrap[1]]--;
+    check_index(m->bench_list, count, n_count);
+
+    b = remove_point(m, wrap[1]);
+    free_benchmark(&b);
+    count[wrap[1]]--;
+    check_index(m->bench_list, count, n_count);
+
+    // entries behind the hole are shifted back towards their homes
+    slot = get_bench_point(m->bench_list, &(wrap[2])) - m->bench_list->points;
+    TEST_CHECK(slot == 0);
+    slot = get_bench_point(m->bench_list, &(zero[1])) - m->bench_list->points;
+    TEST_CHECK(slot == 3);
+
+    // removal at the home slot of the sequence
+    b = remove_point(m, wrap[0]);
+    free_benchmark(&b);
+    count[wrap[0]]--;
+    check_index(m->bench_list, count, n_count);
+
+    // growth well past the initial capacity
+    srand(1);
+    for(i=0; i<N_GROW; i++) {
+        p = rand() % N_GROW;
+        test_add_bench(m, &p, 1e6 + i, 1.0, -1);
+        count[p]++;
+    }
+    TEST_CHECK(m->bench_list->points_capacity > INIT_CAPACITY);
+    TEST_CHECK(2*m->bench_list->n_points <= m->bench_list->points_capacity);
+    check_index(m->bench_list, count, n_count);
+
+    // then remove most of them again, in random order
+    for(i=0; i<3*N_GROW/4; i++) {
+        do {
+            p = rand() % n_count;
+        } while(count[p] == 0);
+
+        b = remove_point(m, p);
+        free_benchmark(&b);
+        count[p]--;
+    }
+    check_index(m->bench_list, count, n_count);
+
+    free_model(&m);
+    free(count);
+
+    return test_result("bench_point_test");
+}
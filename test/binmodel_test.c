@@ -0,0 +1,374 @@
+/*
+    Copyright (C) 2008-2010 Robert Higgins
+        Author: Robert Higgins <robert.higgins@ucd.ie>
+
+    This file is part of PMM.
+
+    PMM is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMM is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+ * @file    binmodel_test.c
+ * @brief   Test conversion of models between xml and binary files
+ *
+ * A model of 1453 benchmarks is written as xml, read back and written as a
+ * binary model, which is read back and written as xml again, and the two xml
+ * files must be identical. Truncated binary files and files with a corrupt
+ * header or section must then be rejected.
+ */
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "pmm_model.h"
+#include "pmm_interval.h"
+#include "pmm_binmodel.h"
+#include "pmm_cfgparser.h"
+#include "pmm_test.h"
+
+//! number of benchmarks in the test model
+#define N_BENCH 1453
+
+void
+build_model(struct pmm_model *m);
+struct pmm_model*
+read_model(const char *path, int rc_expect);
+char*
+dir_path(const char *dir, const char *name);
+void
+check_rejected(const char *path, const char *image, size_t size,
+               const char *what);
+
+/*!
+ * Fill a two parameter model with benchmarks, some sharing a point and some
+ * with metrics and placements, and a stack of intervals of several types
+ *
+ * @param   m   pointer to the model
+ */
+void
+build_model(struct pmm_model *m)
+{
+    struct pmm_benchmark *b;
+    struct pmm_interval *interval;
+    int p[2], q[2];
+    int i;
+
+    for(i=0; i<N_BENCH; i++) {
+        p[0] = 16 * (i % 53);
+        p[1] = 32 * ((i * 7) % 31);
+
+        b = test_add_bench(m, p, 1e6 + 0.25 * i, 0.5 + i / 64.0,
+                           100000LL * (i + 1));
+
+        if(i % 5 == 0) {
+            TEST_CHECK(add_benchmark_metric(b, "cycles", 3.0 * i) == 0);
+            TEST_CHECK(add_benchmark_metric(b, "misses", i / 8.0) == 0);
+        }
+        if(i % 7 == 0) {
+            b->cpuset = malloc(8);
+            if(b->cpuset != NULL) {
+                strcpy(b->cpuset, i % 2 ? "0-3" : "4,6");
+            }
+            b->numa_node = i % 2;
+            b->nice = i % 3;
+        }
+    }
+
+    m->complete = 0;
+    m->journal_seq = 42;
+
+    p[0] = 0; p[1] = 0;
+    q[0] = 832; q[1] = 960;
+
+    interval = new_interval();
+    interval->type = IT_COMPLETE;
+    TEST_CHECK(add_top_interval(m->interval_list, interval) == 0);
+
+    interval = init_interval(0, 2, IT_GBBP_BISECT, p, q);
+    TEST_CHECK(interval != NULL &&
+               add_top_interval(m->interval_list, interval) == 0);
+
+    interval = init_interval(1, 2, IT_GBBP_CLIMB, p, q);
+    TEST_CHECK(interval != NULL);
+    interval->climb_step = 3;
+    TEST_CHECK(add_top_interval(m->interval_list, interval) == 0);
+
+    interval = init_interval(0, 2, IT_POINT, q, NULL);
+    TEST_CHECK(interval != NULL &&
+               add_top_interval(m->interval_list, interval) == 0);
+}
+
+/*!
+ * Read a model from a file and its journal
+ *
+ * @param   path        path of the model file
+ * @param   rc_expect   return code of parse_model expected
+ *
+ * @return pointer to the model, or NULL if it was not read successfully
+ */
+struct pmm_model*
+read_model(const char *path, int rc_expect)
+{
+    struct pmm_model *m;
+    int rc;
+
+    m = new_model();
+    m->model_path = malloc(strlen(path) + 1);
+    if(m->model_path == NULL) {
+        fprintf(stderr, "Error allocating model path.\n");
+        exit(EXIT_FAILURE);
+    }
+    strcpy(m->model_path, path);
+
+    rc = parse_model(m);
+    TEST_CHECK(rc == rc_expect);
+
+    if(rc < 0) {
+        free_model(&m);
+        return NULL;
+    }
+
+    return m;
+}
+
+/*!
+ * Make the path of a file in a directory
+ *
+ * @param   dir     path of the directory
+ * @param   name    name of the file
+ *
+ * @return pointer to the newly allocated path
+ */
+char*
+dir_path(const char *dir, const char *name)
+{
+    char *path;
+
+    path = malloc(strlen(dir) + strlen(name) + 2);
+    if(path == NULL) {
+        fprintf(stderr, "Error allocating path.\n");
+        exit(EXIT_FAILURE);
+    }
+    sprintf(path, "%s/%s", dir, name);
+
+    return path;
+}
+
+/*!
+ * Check that a binary model is rejected when it is read
+ *
+ * @param   path    path to write the model to
+ * @param   image   pointer to the contents of the model file
+ * @param   size    size of the contents
+ * @param   what    description of the damage, reported on failure
+ */
+void
+check_rejected(const char *path, const char *image, size_t size,
+               const char *what)
+{
+    struct pmm_model *m;
+    int failures;
+
+    failures = test_failures;
+
+    TEST_CHECK(test_write_file(path, image, size) == 0);
+
+    m = read_model(path, -2);
+    if(m != NULL) {
+        free_model(&m);
+    }
+
+    if(test_failures != failures) {
+        fprintf(stderr, "binary model not rejected: %s\n", what);
+    }
+}
+
+int
+main(void)
+{
+    char dir[] = "/tmp/pmm_binmodel_test.XXXXXX";
+    char *xml_path, *bin_path, *xml2_path, *bad_path;
+    char *xml, *xml2, *bin, *bad;
+    size_t xml_size, xml2_size, bin_size;
+    struct pmm_binmodel_header *h;
+    struct pmm_binmodel_interval *bi;
+    struct pmm_binmodel_bench *bb;
+    struct pmm_model *m, *r;
+    int start[2] = {0, 0};
+    int end[2] = {1024, 1024};
+    size_t cut[5];
+    int i;
+
+    if(mkdtemp(dir) == NULL) {
+        perror("mkdtemp");
+        return 1;
+    }
+
+    xml_path = dir_path(dir, "model.xml");
+    bin_path = dir_path(dir, "model.bin");
+    xml2_path = dir_path(dir, "model2.xml");
+    bad_path = dir_path(dir, "bad.bin");
+
+    m = test_new_model(2);
+    test_set_paramdefs(m, start, end);
+    build_model(m);
+
+    m->model_path = xml_path;
+    TEST_CHECK(write_model(m) == 0);
+    m->model_path = NULL;
+    free_model(&m);
+
+    // xml to binary
+    r = read_model(xml_path, 0);
+    if(r == NULL) {
+        return test_result("binmodel_test");
+    }
+    TEST_CHECK(r->completion == N_BENCH);
+    TEST_CHECK(r->interval_list->size == 4);
+
+    free(r->model_path);
+    r->model_path = bin_path;
+    r->format = MF_BINARY;
+    TEST_CHECK(write_model(r) == 0);
+    r->model_path = NULL;
+    free_model(&r);
+
+    // binary to xml
+    r = read_model(bin_path, 0);
+    if(r == NULL) {
+        return test_result("binmodel_test");
+    }
+    TEST_CHECK(r->completion == N_BENCH);
+    TEST_CHECK(r->journal_seq == 42);
+    TEST_CHECK(r->interval_list->size == 4);
+
+    free(r->model_path);
+    r->model_path = xml2_path;
+    r->format = MF_XML;
+    TEST_CHECK(write_model(r) == 0);
+    r->model_path = NULL;
+    free_model(&r);
+
+    xml = test_read_file(xml_path, &xml_size);
+    xml2 = test_read_file(xml2_path, &xml2_size);
+    bin = test_read_file(bin_path, &bin_size);
+    TEST_CHECK(xml != NULL && xml2 != NULL && bin != NULL);
+    if(xml == NULL || xml2 == NULL || bin == NULL) {
+        return test_result("binmodel_test");
+    }
+
+    TEST_CHECK(xml_size == xml2_size && memcmp(xml, xml2, xml_size) == 0);
+
+    bad = malloc(bin_size);
+    if(bad == NULL) {
+        fprintf(stderr, "Error allocating memory.\n");
+        return 1;
+    }
+    h = (void *)bad;
+
+    // truncated files, from just the magic to one byte short
+    cut[0] = 8;
+    cut[1] = sizeof *h - 1;
+    cut[2] = sizeof *h;
+    cut[3] = bin_size / 2;
+    cut[4] = bin_size - 1;
+    for(i=0; i<5; i++) {
+        check_rejected(bad_path, bin, cut[i], "truncated");
+    }
+
+    // corrupt header
+    memcpy(bad, bin, bin_size);
+    h->bench_offset += 4;
+    check_rejected(bad_path, bad, bin_size, "misaligned section");
+
+    memcpy(bad, bin, bin_size);
+    h->metric_offset = h->file_size + 8;
+    check_rejected(bad_path, bad, bin_size, "section beyond end of file");
+
+    memcpy(bad, bin, bin_size);
+    h->n_benchmarks = 0x7fffffff;
+    check_rejected(bad_path, bad, bin_size, "section running off the file");
+
+    memcpy(bad, bin, bin_size);
+    h->n_p = 0;
+    check_rejected(bad_path, bad, bin_size, "no parameters");
+
+    memcpy(bad, bin, bin_size);
+    bad[bin_size-1] = 'x';
+    check_rejected(bad_path, bad, bin_size, "unterminated string table");
+
+    // corrupt benchmark section
+    memcpy(bad, bin, bin_size);
+    bb = (void *)(bad + h->bench_offset);
+    bb[N_BENCH-1].first_metric = h->n_metrics;
+    bb[N_BENCH-1].n_metrics = 1;
+    check_rejected(bad_path, bad, bin_size, "benchmark metrics out of range");
+
+    // corrupt interval section, its first record is the top of the stack,
+    // the point interval, which has a start only
+    memcpy(bad, bin, bin_size);
+    bi = (void *)(bad + h->interval_offset);
+    TEST_CHECK(bi[0].type == IT_POINT && bi[0].has_start && !bi[0].has_end);
+    bi[0].n_p = 1;
+    check_rejected(bad_path, bad, bin_size, "interval n_p differs from model");
+
+    memcpy(bad, bin, bin_size);
+    bi[0].n_p = 0;
+    check_rejected(bad_path, bad, bin_size, "interval without parameters");
+
+    memcpy(bad, bin, bin_size);
+    bi[0].type = IT_COMPLETE + 1;
+    check_rejected(bad_path, bad, bin_size, "unknown interval type");
+
+    memcpy(bad, bin, bin_size);
+    bi[0].type = -1;
+    check_rejected(bad_path, bad, bin_size, "negative interval type");
+
+    memcpy(bad, bin, bin_size);
+    bi[0].params = h->n_interval_params - 1;
+    check_rejected(bad_path, bad, bin_size, "interval params out of range");
+
+    memcpy(bad, bin, bin_size);
+    bi[0].has_end = 1;
+    bi[0].params = h->n_interval_params - 2;
+    check_rejected(bad_path, bad, bin_size, "interval end out of range");
+
+    // the unchanged file is still accepted
+    TEST_CHECK(test_write_file(bad_path, bin, bin_size) == 0);
+    r = read_model(bad_path, 0);
+    if(r != NULL) {
+        free_model(&r);
+    }
+
+    free(bad);
+    free(bin);
+    free(xml);
+    free(xml2);
+
+    unlink(xml_path);
+    unlink(bin_path);
+    unlink(xml2_path);
+    unlink(bad_path);
+    rmdir(dir);
+
+    free(xml_path);
+    free(bin_path);
+    free(xml2_path);
+    free(bad_path);
+
+    return test_result("binmodel_test");
+}
@@ -0,0 +1,360 @@
+/*
+    Copyright (C) 2008-2010 Robert Higgins
+        Author: Robert Higgins <robert.higgins@ucd.ie>
+
+    This file is part of PMM.
+
+    PMM is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMM is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+ * @file    delaunay_test.c
+ * @brief   Test Delaunay triangulation and interpolation
+ *
+ * A small point set whose triangulation is known is checked simplex by
+ * simplex, then interpolation is checked at vertices, on the hull, outside
+ * the hull, with duplicate and collinear points, and against linear functions
+ * which the interpolation must reproduce exactly.
+ */
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+
+#include "pmm_delaunay.h"
+#include "pmm_test.h"
+
+//! relative tolerance of interpolated values
+#define TOL 1.0e-9
+
+int
+count_real_simplices(struct pmm_delaunay *d);
+int
+has_simplex(struct pmm_delaunay *d, int a, int b, int c);
+void
+test_known(void);
+void
+test_degenerate(void);
+void
+test_linear(int n, int n_pts);
+
+/*!
+ * Count the simplices of a triangulation whose vertices are all real points,
+ * rather than vertices of the enclosing simplex
+ *
+ * @param   d   pointer to the triangulation
+ *
+ * @return number of simplices
+ */
+int
+count_real_simplices(struct pmm_delaunay *d)
+{
+    int s, i, n, count;
+
+    n = d->n;
+    count = 0;
+
+    for(s=0; s<d->n_simplices; s++) {
+        if(d->verts[s*(n+1)] < 0) {
+            continue;
+        }
+
+        for(i=0; i<=n && d->verts[s*(n+1)+i] > n; i++);
+
+        if(i > n) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+/*!
+ * Test if a 2-D triangulation has a triangle with the given vertices
+ *
+ * @param   d   pointer to the triangulation
+ * @param   a   index of a vertex
+ * @param   b   index of a vertex
+ * @param   c   index of a vertex
+ *
+ * @return 1 if the triangle is in the triangulation, 0 otherwise
+ */
+int
+has_simplex(struct pmm_delaunay *d, int a, int b, int c)
+{
+    int s, i, found;
+    int *v;
+
+    for(s=0; s<d->n_simplices; s++) {
+        v = &(d->verts[s*3]);
+        if(v[0] < 0) {
+            continue;
+        }
+
+        found = 0;
+        for(i=0; i<3; i++) {
+            found += v[i] == a || v[i] == b || v[i] == c;
+        }
+
+        if(found == 3) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*!
+ * Test a triangulation of four points in the plane that has only one
+ * Delaunay triangulation: (12,12) is outside the circumcircle of the other
+ * three points, so the diagonal runs from (10,0) to (0,10)
+ */
+void
+test_known(void)
+{
+    struct pmm_delaunay *d;
+    double lo[2] = {0.0, 0.0};
+    double hi[2] = {12.0, 12.0};
+    int pts[4][2] = {{0, 0}, {10, 0}, {0, 10}, {12, 12}};
+    double vals[4] = {0.0, 0.0, 0.0, 1.0};
+    int idx[4];
+    int p[2];
+    double y;
+    int i;
+
+    d = new_delaunay(2, lo, hi);
+    TEST_CHECK(d != NULL);
+    if(d == NULL) {
+        return;
+    }
+
+    for(i=0; i<4; i++) {
+        idx[i] = delaunay_insert(d, pts[i], vals[i]);
+        TEST_CHECK(idx[i] >= 0);
+    }
+
+    TEST_CHECK(count_real_simplices(d) == 2);
+    TEST_CHECK(has_simplex(d, idx[0], idx[1], idx[2]));
+    TEST_CHECK(has_simplex(d, idx[1], idx[2], idx[3]));
+
+    // on the far side of the diagonal the value is the weight of (12,12),
+    // 1/7 at (6,6), where the other diagonal would give 1/2
+    p[0] = 6; p[1] = 6;
+    TEST_CHECK(delaunay_interpolate(d, p, &y) == 0 &&
+               test_close(y, 1.0/7.0, TOL));
+
+    // on the near side no weight is on (12,12)
+    p[0] = 2; p[1] = 2;
+    TEST_CHECK(delaunay_interpolate(d, p, &y) == 0 && test_close(y, 0.0, TOL));
+
+    // exactly at each vertex the value of that vertex is returned
+    for(i=0; i<4; i++) {
+        y = -1.0;
+        TEST_CHECK(delaunay_interpolate(d, pts[i], &y) == 0 &&
+                   test_close(y, vals[i], TOL));
+    }
+
+    // on the hull between two vertices
+    p[0] = 5; p[1] = 0;
+    TEST_CHECK(delaunay_interpolate(d, p, &y) == 0 && test_close(y, 0.0, TOL));
+    p[0] = 11; p[1] = 6;
+    TEST_CHECK(delaunay_interpolate(d, p, &y) == 0 && test_close(y, 0.5, TOL));
+
+    // outside the hull, both inside and outside the box of the scaling
+    p[0] = 11; p[1] = 0;
+    TEST_CHECK(delaunay_interpolate(d, p, &y) < 0);
+    p[0] = 12; p[1] = 11;
+    TEST_CHECK(delaunay_interpolate(d, p, &y) < 0);
+    p[0] = -1; p[1] = 5;
+    TEST_CHECK(delaunay_interpolate(d, p, &y) < 0);
+    p[0] = 100; p[1] = 100;
+    TEST_CHECK(delaunay_interpolate(d, p, &y) < 0);
+
+    // a duplicate point replaces the value of the existing point
+    TEST_CHECK(delaunay_insert(d, pts[3], 2.0) == idx[3]);
+    TEST_CHECK(d->n_pts == 3 + 4);
+    TEST_CHECK(count_real_simplices(d) == 2);
+    p[0] = 6; p[1] = 6;
+    TEST_CHECK(delaunay_interpolate(d, p, &y) == 0 &&
+               test_close(y, 2.0/7.0, TOL));
+
+    free_delaunay(&d);
+    TEST_CHECK(d == NULL);
+}
+
+/*!
+ * Test triangulations of points on a line, which have no interior, before
+ * and after a point off the line is added
+ */
+void
+test_degenerate(void)
+{
+    struct pmm_delaunay *d;
+    double lo[2] = {0.0, 0.0};
+    double hi[2] = {10.0, 10.0};
+    int line[3][2] = {{0, 0}, {5, 5}, {10, 10}};
+    int off[2] = {10, 0};
+    int p[2];
+    double y;
+    int i;
+
+    d = new_delaunay(2, lo, hi);
+    TEST_CHECK(d != NULL);
+    if(d == NULL) {
+        return;
+    }
+
+    for(i=0; i<3; i++) {
+        TEST_CHECK(delaunay_insert(d, line[i], line[i][0]) >= 0);
+    }
+    TEST_CHECK(count_real_simplices(d) == 0);
+
+    // the vertices themselves are still found
+    for(i=0; i<3; i++) {
+        TEST_CHECK(delaunay_interpolate(d, line[i], &y) == 0 &&
+                   test_close(y, line[i][0], TOL));
+    }
+
+    // off the line there is no hull to interpolate in
+    p[0] = 5; p[1] = 4;
+    TEST_CHECK(delaunay_interpolate(d, p, &y) < 0);
+    p[0] = 0; p[1] = 10;
+    TEST_CHECK(delaunay_interpolate(d, p, &y) < 0);
+
+    // a point off the line gives the triangulation an interior, in which the
+    // linear function x is reproduced
+    TEST_CHECK(delaunay_insert(d, off, off[0]) >= 0);
+    TEST_CHECK(count_real_simplices(d) == 2);
+
+    p[0] = 7; p[1] = 3;
+    TEST_CHECK(delaunay_interpolate(d, p, &y) == 0 && test_close(y, 7.0, TOL));
+    p[0] = 3; p[1] = 3;
+    TEST_CHECK(delaunay_interpolate(d, p, &y) == 0 && test_close(y, 3.0, TOL));
+    p[0] = 3; p[1] = 7;
+    TEST_CHECK(delaunay_interpolate(d, p, &y) < 0);
+
+    free_delaunay(&d);
+
+    // in one dimension every triangulation is of collinear points
+    lo[0] = 0.0;
+    hi[0] = 100.0;
+    d = new_delaunay(1, lo, hi);
+    TEST_CHECK(d != NULL);
+    if(d == NULL) {
+        return;
+    }
+
+    p[0] = 40;
+    TEST_CHECK(delaunay_insert(d, p, 4.0) >= 0);
+    p[0] = 0;
+    TEST_CHECK(delaunay_insert(d, p, 0.0) >= 0);
+    p[0] = 100;
+    TEST_CHECK(delaunay_insert(d, p, 1.0) >= 0);
+    TEST_CHECK(delaunay_insert(d, p, 2.0) >= 0);
+
+    p[0] = 20;
+    TEST_CHECK(delaunay_interpolate(d, p, &y) == 0 && test_close(y, 2.0, TOL));
+    p[0] = 70;
+    TEST_CHECK(delaunay_interpolate(d, p, &y) == 0 && test_close(y, 3.0, TOL));
+    p[0] = 40;
+    TEST_CHECK(delaunay_interpolate(d, p, &y) == 0 && test_close(y, 4.0, TOL));
+    p[0] = 101;
+    TEST_CHECK(delaunay_interpolate(d, p, &y) < 0);
+    p[0] = -1;
+    TEST_CHECK(delaunay_interpolate(d, p, &y) < 0);
+
+    free_delaunay(&d);
+}
+
+/*!
+ * Test that interpolation of random points reproduces a linear function
+ * exactly, within the hull and at the vertices, and fails outside it. The
+ * corners of the box are inserted so that the hull is the box.
+ *
+ * @param   n       number of dimensions
+ * @param   n_pts   number of random points inserted
+ */
+void
+test_linear(int n, int n_pts)
+{
+    struct pmm_delaunay *d;
+    double lo[3], hi[3], coef[4];
+    int p[3];
+    double y, f;
+    int i, j, corner;
+
+    for(j=0; j<n; j++) {
+        lo[j] = 0.0;
+        hi[j] = 1000.0 * (j+1);
+        coef[j] = 0.5 + j;
+    }
+    coef[n] = 7.0;
+
+    d = new_delaunay(n, lo, hi);
+    TEST_CHECK(d != NULL);
+    if(d == NULL) {
+        return;
+    }
+
+    for(corner=0; corner<(1<<n); corner++) {
+        f = coef[n];
+        for(j=0; j<n; j++) {
+            p[j] = corner & (1<<j) ? (int)hi[j] : (int)lo[j];
+            f += coef[j] * p[j];
+        }
+        TEST_CHECK(delaunay_insert(d, p, f) >= 0);
+    }
+
+    for(i=0; i<n_pts; i++) {
+        f = coef[n];
+        for(j=0; j<n; j++) {
+            p[j] = rand() % ((int)hi[j] + 1);
+            f += coef[j] * p[j];
+        }
+        TEST_CHECK(delaunay_insert(d, p, f) >= 0);
+
+        // the point just inserted is a vertex
+        TEST_CHECK(delaunay_interpolate(d, p, &y) == 0 &&
+               test_close(y, f, TOL));
+    }
+
+    for(i=0; i<n_pts; i++) {
+        f = coef[n];
+        for(j=0; j<n; j++) {
+            p[j] = rand() % ((int)hi[j] + 1);
+            f += coef[j] * p[j];
+        }
+        TEST_CHECK(delaunay_interpolate(d, p, &y) == 0 &&
+               test_close(y, f, TOL));
+
+        p[i%n] = i % 2 ? -1 - rand() % 100 : (int)hi[i%n] + 1 + rand() % 100;
+        TEST_CHECK(delaunay_interpolate(d, p, &y) < 0);
+    }
+
+    free_delaunay(&d);
+}
+
+int
+main(void)
+{
+    srand(1);
+
+    test_known();
+    test_degenerate();
+    test_linear(1, 50);
+    test_linear(2, 200);
+    test_linear(3, 200);
+
+    return test_result("delaunay_test");
+}
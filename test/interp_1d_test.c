@@ -0,0 +1,196 @@
+/*
+    Copyright (C) 2008-2010 Robert Higgins
+        Author: Robert Higgins <robert.higgins@ucd.ie>
+
+    This file is part of PMM.
+
+    PMM is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMM is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+ * @file    interp_1d_test.c
+ * @brief   Test interpolation of the averaged points of 1-D bench lists
+ *
+ * interpolate_1d_averages searches from a hint left by the previous lookup.
+ * Its results and hints are compared with a linear scan for queries in
+ * ascending, descending and random order, including queries below the first
+ * and above the last benchmarked point, for lists of various sizes.
+ */
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+
+#include "pmm_model.h"
+#include "pmm_test.h"
+
+//! relative tolerance of interpolated values
+#define TOL 1.0e-12
+//! number of queries made in each order
+#define N_QUERIES 2000
+
+double
+linear_scan(struct pmm_bench_list *bl, int p, int *pos);
+void
+check_query(struct pmm_bench_list *bl, int p, int *hint);
+void
+test_list(int n_points);
+
+/*!
+ * Interpolate the averaged points of a bench list by scanning them in order
+ *
+ * @param   bl      pointer to the bench list, with averages up to date
+ * @param   p       parameter to interpolate at
+ * @param   pos     pointer to where the position of the first averaged point
+ *                  at or after p is stored
+ *
+ * @return the interpolated speed
+ */
+double
+linear_scan(struct pmm_bench_list *bl, int p, int *pos)
+{
+    int i;
+
+    for(i=0; i<bl->n_avg && bl->avg_p[i] < p; i++);
+
+    *pos = i;
+
+    if(i == bl->n_avg) {
+        return 0.0;
+    }
+    if(i == 0 || bl->avg_p[i] == p) {
+        return bl->avg_flops[i];
+    }
+
+    return (bl->avg_flops[i] - bl->avg_flops[i-1]) /
+           (bl->avg_p[i] - bl->avg_p[i-1]) * ((double)p - bl->avg_p[i-1]) +
+           bl->avg_flops[i-1];
+}
+
+/*!
+ * Check a lookup from a hint against a linear scan
+ *
+ * @param   bl      pointer to the bench list, with averages up to date
+ * @param   p       parameter to interpolate at
+ * @param   hint    pointer to the hint, carried between lookups
+ */
+void
+check_query(struct pmm_bench_list *bl, int p, int *hint)
+{
+    double expect, got;
+    int pos;
+
+    expect = linear_scan(bl, p, &pos);
+    got = interpolate_1d_averages(bl, p, hint);
+
+    TEST_CHECK(test_close(got, expect, TOL));
+    TEST_CHECK(*hint == pos);
+}
+
+/*!
+ * Test lookups in a 1-D model with a number of benchmarked points, some of
+ * which have several benchmarks
+ *
+ * @param   n_points    number of benchmarked points
+ */
+void
+test_list(int n_points)
+{
+    struct pmm_model *m;
+    struct pmm_bench_list *bl;
+    struct pmm_bench_point *e;
+    int i, p, first, last, hint;
+
+    m = test_new_model(1);
+    bl = m->bench_list;
+
+    first = 100;
+    last = first;
+    for(i=0, p=first; i<n_points; i++, p+=1+rand()%50) {
+        test_add_bench(m, &p, 1e6 + rand() % 1000000, 1.0, -1);
+        if(i % 3 == 0) {
+            test_add_bench(m, &p, 1e6 + rand() % 1000000, 1.0, -1);
+        }
+        last = p;
+    }
+
+    TEST_CHECK(update_bench_list_averages(bl) == 0);
+    TEST_CHECK(bl->n_avg == n_points);
+    for(i=0; i<bl->n_avg; i++) {
+        e = get_bench_point(bl, &(bl->avg_p[i]));
+        TEST_CHECK(e != NULL && bl->avg_flops[i] == e->stats.mean_flops);
+        TEST_CHECK(i == 0 || bl->avg_p[i-1] < bl->avg_p[i]);
+    }
+
+    // ascending, from below the first point to above the last
+    hint = 0;
+    for(p=first-20; p<=last+20; p++) {
+        check_query(bl, p, &hint);
+    }
+
+    // descending
+    for(p=last+20; p>=first-20; p--) {
+        check_query(bl, p, &hint);
+    }
+
+    // ascending with gaps, so that the gallop takes long strides
+    hint = 0;
+    for(p=first-20; p<=last+20; p+=1+rand()%200) {
+        check_query(bl, p, &hint);
+    }
+
+    // random, including far outside the points
+    for(i=0; i<N_QUERIES; i++) {
+        p = first - 100 + rand() % (last - first + 201);
+        check_query(bl, p, &hint);
+    }
+    check_query(bl, -1000000, &hint);
+    check_query(bl, 1000000, &hint);
+    check_query(bl, first, &hint);
+    check_query(bl, last, &hint);
+
+    // hints out of range are ignored
+    hint = -5;
+    check_query(bl, last, &hint);
+    hint = bl->n_avg + 5;
+    check_query(bl, first, &hint);
+
+    free_model(&m);
+}
+
+int
+main(void)
+{
+    struct pmm_model *m;
+    int hint, p;
+
+    srand(1);
+
+    // with no points every speed is zero
+    m = test_new_model(1);
+    TEST_CHECK(update_bench_list_averages(m->bench_list) == 0);
+    hint = 0;
+    p = 10;
+    TEST_CHECK(interpolate_1d_averages(m->bench_list, p, &hint) == 0.0);
+    free_model(&m);
+
+    test_list(1);
+    test_list(2);
+    test_list(3);
+    test_list(17);
+    test_list(64);
+    test_list(500);
+
+    return test_result("interp_1d_test");
+}
@@ -0,0 +1,398 @@
+/*
+    Copyright (C) 2008-2010 Robert Higgins
+        Author: Robert Higgins <robert.higgins@ucd.ie>
+
+    This file is part of PMM.
+
+    PMM is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMM is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+ * @file    journal_test.c
+ * @brief   Test replay and compaction of model journals
+ *
+ * A model is written to a temporary directory and benchmarks are appended
+ * to its journal. The model is then read back with the journal intact, with
+ * its last record cut short, with records the model file already holds, and
+ * after the journal has been compacted into the model file. Writes that fail
+ * must keep the benchmarks they did not write for the next write.
+ */
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "pmm_model.h"
+#include "pmm_cfgparser.h"
+#include "pmm_test.h"
+
+void
+add_benchmarks(struct pmm_model *m, int n);
+struct pmm_model*
+read_model(const char *path);
+void
+check_same(struct pmm_model *a, struct pmm_model *b);
+long
+file_size(const char *path);
+void
+check_failed_writes(struct pmm_model *m, const char *dir);
+
+/*!
+ * Insert benchmarks with distinct speeds into a single parameter model,
+ * every third at a point that is already benchmarked
+ *
+ * @param   m   pointer to the model
+ * @param   n   number of benchmarks
+ */
+void
+add_benchmarks(struct pmm_model *m, int n)
+{
+    int i, p;
+
+    for(i=0; i<n; i++) {
+        p = i % 3 == 2 ? 100 : 100 + 10 * (m->completion + 1);
+        test_add_bench(m, &p, 1000.0 * (m->completion + 1), 0.5, 1000);
+    }
+}
+
+/*!
+ * Read a model from its file and journal
+ *
+ * @param   path    path of the model file
+ *
+ * @return pointer to the model, the test is failed if it cannot be read
+ */
+struct pmm_model*
+read_model(const char *path)
+{
+    struct pmm_model *m;
+
+    m = new_model();
+    m->model_path = malloc(strlen(path) + 1);
+    if(m->model_path == NULL) {
+        fprintf(stderr, "Error allocating model path.\n");
+        exit(EXIT_FAILURE);
+    }
+    strcpy(m->model_path, path);
+
+    if(parse_model(m) < 0) {
+        fprintf(stderr, "Error reading model: %s\n", path);
+        test_failures++;
+        exit(test_result("journal_test"));
+    }
+
+    return m;
+}
+
+/*!
+ * Check that two models hold the same benchmarks
+ *
+ * @param   a   pointer to the first model
+ * @param   b   pointer to the second model
+ */
+void
+check_same(struct pmm_model *a, struct pmm_model *b)
+{
+    struct pmm_bench_point *ea, *eb;
+    int i;
+
+    TEST_CHECK(a->completion == b->completion);
+    TEST_CHECK(a->bench_list->size == b->bench_list->size);
+    TEST_CHECK(a->bench_list->n_points == b->bench_list->n_points);
+    if(a->bench_list->size != b->bench_list->size) {
+        return;
+    }
+
+    for(i=0; i<a->bench_list->size; i++) {
+        TEST_CHECK(a->bench_list->params[i] == b->bench_list->params[i]);
+
+        ea = get_bench_point(a->bench_list, &(a->bench_list->params[i]));
+        eb = get_bench_point(b->bench_list, &(a->bench_list->params[i]));
+        TEST_CHECK(ea != NULL && eb != NULL);
+        if(ea != NULL && eb != NULL) {
+            TEST_CHECK(ea->stats.n == eb->stats.n);
+            TEST_CHECK(ea->stats.mean_flops == eb->stats.mean_flops);
+        }
+    }
+}
+
+/*!
+ * Get the size of a file
+ *
+ * @param   path    path of the file
+ *
+ * @return size of the file, or -1 if it does not exist
+ */
+long
+file_size(const char *path)
+{
+    struct stat st;
+
+    if(stat(path, &st) < 0) {
+        return -1;
+    }
+
+    return st.st_size;
+}
+
+/*!
+ * Check that writes of a model that fail keep its new benchmarks pending, an
+ * append to a journal that cannot be opened and a compaction whose model file
+ * cannot be replaced, by pointing the model at paths that are directories
+ *
+ * @param   m       pointer to the model, with benchmarks not yet on disk
+ * @param   dir     temporary directory to make the paths in
+ */
+void
+check_failed_writes(struct pmm_model *m, const char *dir)
+{
+    char *model_path, *fail_dir, *fail_path, *fail_journal, *temp;
+    DIR *d;
+    struct dirent *e;
+    int n, execs;
+    double time;
+
+    model_path = m->model_path;
+
+    fail_dir = malloc(strlen(dir) + sizeof "/fail");
+    fail_path = malloc(strlen(dir) + sizeof "/fail/model.xml");
+    if(fail_dir == NULL || fail_path == NULL) {
+        fprintf(stderr, "Error allocating paths.\n");
+        exit(EXIT_FAILURE);
+    }
+    sprintf(fail_dir, "%s/fail", dir);
+    sprintf(fail_path, "%s/model.xml", fail_dir);
+
+    m->model_path = fail_path;
+    fail_journal = model_journal_path(m);
+    if(fail_journal == NULL) {
+        exit(EXIT_FAILURE);
+    }
+
+    TEST_CHECK(mkdir(fail_dir, S_IRWXU) == 0);
+    TEST_CHECK(mkdir(fail_path, S_IRWXU) == 0);
+    TEST_CHECK(mkdir(fail_journal, S_IRWXU) == 0);
+
+    n = m->n_unjournalled;
+    execs = m->unwritten_num_execs;
+    time = m->unwritten_time_spend;
+
+    TEST_CHECK(append_model_journal(m) < 0);
+    TEST_CHECK(m->n_unjournalled == n);
+
+    TEST_CHECK(write_model(m) < 0);
+    TEST_CHECK(m->n_unjournalled == n);
+    TEST_CHECK(m->unwritten_num_execs == execs);
+    TEST_CHECK(m->unwritten_time_spend == time);
+
+    m->model_path = model_path;
+
+    // remove the temporary file the failed compaction left
+    d = opendir(fail_dir);
+    TEST_CHECK(d != NULL);
+    while(d != NULL && (e = readdir(d)) != NULL) {
+        if(strncmp(e->d_name, "model.xml.", strlen("model.xml.")) != 0 ||
+           strcmp(e->d_name, strrchr(fail_journal, '/') + 1) == 0)
+        {
+            continue;
+        }
+
+        temp = malloc(strlen(fail_dir) + strlen(e->d_name) + 2);
+        if(temp != NULL) {
+            sprintf(temp, "%s/%s", fail_dir, e->d_name);
+            unlink(temp);
+            free(temp);
+        }
+    }
+    if(d != NULL) {
+        closedir(d);
+    }
+
+    rmdir(fail_journal);
+    rmdir(fail_path);
+    TEST_CHECK(rmdir(fail_dir) == 0);
+
+    free(fail_journal);
+    free(fail_path);
+    free(fail_dir);
+}
+
+int
+main(void)
+{
+    char dir[] = "/tmp/pmm_journal_test.XXXXXX";
+    char *path, *journal, *buf, *stale;
+    size_t size, first_size, stale_size;
+    struct pmm_model *m, *r;
+    int start = 0, end = 10000;
+    long len;
+
+    if(mkdtemp(dir) == NULL) {
+        perror("mkdtemp");
+        return 1;
+    }
+
+    path = malloc(strlen(dir) + sizeof "/model.xml");
+    if(path == NULL) {
+        fprintf(stderr, "Error allocating model path.\n");
+        return 1;
+    }
+    sprintf(path, "%s/model.xml", dir);
+
+    m = test_new_model(1);
+    test_set_paramdefs(m, &start, &end);
+    m->model_path = path;
+
+    journal = model_journal_path(m);
+    if(journal == NULL) {
+        return 1;
+    }
+
+    // a model file holding no journal records
+    add_benchmarks(m, 10);
+    TEST_CHECK(write_model(m) == 0);
+    TEST_CHECK(file_size(journal) <= 0);
+
+    // two journal records
+    add_benchmarks(m, 5);
+    TEST_CHECK(append_model_journal(m) == 0);
+    TEST_CHECK(m->journal_seq == 1);
+    first_size = file_size(journal);
+
+    add_benchmarks(m, 3);
+    TEST_CHECK(append_model_journal(m) == 0);
+    TEST_CHECK(m->journal_seq == 2);
+    TEST_CHECK(file_size(journal) == m->journal_size);
+    TEST_CHECK(m->journal_size > (long)first_size);
+
+    // nothing new to record
+    TEST_CHECK(append_model_journal(m) == 0);
+    TEST_CHECK(file_size(journal) == m->journal_size);
+
+    r = read_model(path);
+    TEST_CHECK(r->journal_seq == 2);
+    TEST_CHECK(r->completion == 18);
+    check_same(m, r);
+    free_model(&r);
+
+    buf = test_read_file(journal, &size);
+    TEST_CHECK(buf != NULL && size == (size_t)m->journal_size);
+    if(buf == NULL) {
+        return test_result("journal_test");
+    }
+
+    // the last record cut short, within its document and within its length
+    // line, is ignored and the records before it are replayed
+    len = (long)size - 1;
+    while(len >= (long)first_size) {
+        TEST_CHECK(test_write_file(journal, buf, len) == 0);
+
+        r = read_model(path);
+        TEST_CHECK(r->journal_seq == 1);
+        TEST_CHECK(r->completion == 15);
+        free_model(&r);
+
+        // every cut in the length line, a spread of cuts in the document
+        len -= len > (long)first_size + 8 ? 37 : 1;
+    }
+
+    // a record claiming to be longer than the rest of the journal
+    stale = malloc(size + 16);
+    if(stale == NULL) {
+        return 1;
+    }
+    memcpy(stale, buf, first_size);
+    stale_size = first_size + sprintf(stale + first_size, "%d\n<?xml",
+                                      1000000);
+    TEST_CHECK(test_write_file(journal, stale, stale_size) == 0);
+    r = read_model(path);
+    TEST_CHECK(r->journal_seq == 1 && r->completion == 15);
+    free_model(&r);
+    free(stale);
+
+    TEST_CHECK(test_write_file(journal, buf, size) == 0);
+
+    // compaction writes the journalled benchmarks to the model file and
+    // empties the journal
+    TEST_CHECK(write_model(m) == 0);
+    TEST_CHECK(file_size(journal) == 0);
+    TEST_CHECK(m->journal_size == 0);
+
+    r = read_model(path);
+    TEST_CHECK(r->journal_seq == 2);
+    check_same(m, r);
+    free_model(&r);
+
+    // records the model file already holds are skipped, as when the model is
+    // written but the journal is not emptied before a crash, while newer
+    // records appended after them are still replayed
+    TEST_CHECK(test_write_file(journal, buf, size) == 0);
+    m->journal_size = size;
+
+    r = read_model(path);
+    TEST_CHECK(r->journal_seq == 2);
+    check_same(m, r);
+    free_model(&r);
+
+    add_benchmarks(m, 4);
+    TEST_CHECK(append_model_journal(m) == 0);
+    TEST_CHECK(m->journal_seq == 3);
+
+    r = read_model(path);
+    TEST_CHECK(r->journal_seq == 3);
+    TEST_CHECK(r->completion == 22);
+    check_same(m, r);
+    free_model(&r);
+
+    // and a second compaction leaves nothing to replay
+    TEST_CHECK(write_model(m) == 0);
+    TEST_CHECK(file_size(journal) == 0);
+
+    r = read_model(path);
+    TEST_CHECK(r->journal_seq == 3);
+    check_same(m, r);
+    free_model(&r);
+
+    // benchmarks of failed writes reach the disk with the next write
+    add_benchmarks(m, 2);
+    m->unwritten_num_execs = 2;
+    m->unwritten_time_spend = 1.0;
+    check_failed_writes(m, dir);
+
+    TEST_CHECK(append_model_journal(m) == 0);
+    TEST_CHECK(m->n_unjournalled == 0);
+
+    r = read_model(path);
+    TEST_CHECK(r->completion == 24);
+    check_same(m, r);
+    free_model(&r);
+
+    TEST_CHECK(write_model(m) == 0);
+    TEST_CHECK(m->unwritten_num_execs == 0);
+    TEST_CHECK(m->unwritten_time_spend == 0.0);
+
+    unlink(journal);
+    unlink(path);
+    rmdir(dir);
+
+    free(buf);
+    free(journal);
+    free_model(&m);
+
+    return test_result("journal_test");
+}
@@ -0,0 +1,264 @@
+/*
+    Copyright (C) 2008-2010 Robert Higgins
+        Author: Robert Higgins <robert.higgins@ucd.ie>
+
+    This file is part of PMM.
+
+    PMM is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMM is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+ * @file    lookup_batch_test.c
+ * @brief   Test batch and single point model lookups against expected values
+ *
+ * lookup_model_batch() must give the speed and time of lookup_model() at
+ * every point, inside and outside the measured range, at benchmarked points
+ * and between them. The times are also checked against values worked out
+ * here from the benchmarks inserted: the measured mean at benchmarked points
+ * and otherwise the complexity over the speed, or over the speed of the
+ * nearest benchmark where there is no interpolated speed. The benchmarks
+ * report a complexity that is exactly the product of their parameters times
+ * a constant, so the fitted complexity is known.
+ */
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+
+#include "pmm_model.h"
+#include "pmm_test.h"
+
+#define N_QUERIES 200
+//! most benchmarks inserted into a test model
+#define MAX_BENCH 128
+
+/*!
+ * benchmark inserted into a test model
+ */
+struct bench_record {
+    int p[2];
+    double flops;
+    double seconds;
+};
+
+//! benchmarks inserted into the current test model
+struct bench_record records[MAX_BENCH];
+//! number of benchmarks inserted into the current test model
+int n_records;
+//! complexity reported by a benchmark over the product of its parameters
+double complexity_scale;
+
+void
+record_bench(struct pmm_model *m, int *p, double flops, double seconds);
+int
+expected_seconds(struct pmm_model *m, int *p, double flops, double seconds);
+void
+check_model(struct pmm_model *m, int *q, int n);
+
+/*!
+ * Insert a benchmark into a test model and record it
+ *
+ * @param   m       pointer to the model
+ * @param   p       pointer to the parameters of the benchmark
+ * @param   flops   speed of the benchmark
+ * @param   seconds time of the benchmark
+ */
+void
+record_bench(struct pmm_model *m, int *p, double flops, double seconds)
+{
+    double c;
+    int j;
+
+    c = complexity_scale;
+    for(j=0; j<m->n_p; j++) {
+        records[n_records].p[j] = p[j];
+        c *= p[j];
+    }
+    records[n_records].flops = flops;
+    records[n_records].seconds = seconds;
+    n_records++;
+
+    test_add_bench(m, p, flops, seconds, (long long int)c);
+}
+
+/*!
+ * Test if a predicted time is the one expected from the benchmarks recorded
+ *
+ * @param   m       pointer to the model
+ * @param   p       pointer to the parameters of the point
+ * @param   flops   speed interpolated at the point
+ * @param   seconds predicted time at the point
+ *
+ * @return 1 if the time is as expected, 0 if not
+ */
+int
+expected_seconds(struct pmm_model *m, int *p, double flops, double seconds)
+{
+    double sum, c, d, nearest_d;
+    int i, j, n;
+
+    // the measured mean at a benchmarked point
+    sum = 0.;
+    n = 0;
+    for(i=0; i<n_records; i++) {
+        for(j=0; j<m->n_p && records[i].p[j] == p[j]; j++);
+        if(j == m->n_p) {
+            sum += records[i].seconds;
+            n++;
+        }
+    }
+    if(n > 0) {
+        return test_close(seconds, sum/n, 1e-9);
+    }
+
+    c = complexity_scale;
+    for(j=0; j<m->n_p; j++) {
+        c *= p[j];
+    }
+
+    if(flops > 0.) {
+        return test_close(seconds, c/flops, 1e-9);
+    }
+
+    // otherwise over the speed of a nearest benchmark, any of those tied
+    nearest_d = -1.;
+    for(i=0; i<n_records; i++) {
+        d = 0.;
+        for(j=0; j<m->n_p; j++) {
+            d += ((double)records[i].p[j] - p[j]) *
+                 ((double)records[i].p[j] - p[j]);
+        }
+        if(nearest_d < 0. || d < nearest_d) {
+            nearest_d = d;
+        }
+    }
+
+    for(i=0; i<n_records; i++) {
+        d = 0.;
+        for(j=0; j<m->n_p; j++) {
+            d += ((double)records[i].p[j] - p[j]) *
+                 ((double)records[i].p[j] - p[j]);
+        }
+        if(d == nearest_d && test_close(seconds, c/records[i].flops, 1e-9)) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*!
+ * Compare a batch lookup of a model with single point lookups and with the
+ * times expected
+ *
+ * @param   m       pointer to the model
+ * @param   q       pointer to the query points, n_p values each
+ * @param   n       number of query points
+ */
+void
+check_model(struct pmm_model *m, int *q, int n)
+{
+    double *flops, *seconds;
+    struct pmm_benchmark *b;
+    int i;
+
+    flops = malloc(n * sizeof *flops);
+    seconds = malloc(n * sizeof *seconds);
+    if(flops == NULL || seconds == NULL) {
+        fprintf(stderr, "Error allocating memory.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    TEST_CHECK(lookup_model_batch(m, q, n, flops, seconds) == 0);
+
+    for(i=0; i<n; i++) {
+        b = lookup_model(m, &(q[i*m->n_p]));
+        TEST_CHECK(b != NULL);
+        if(b != NULL) {
+            TEST_CHECK(test_close(flops[i], b->flops, 1e-9));
+            TEST_CHECK(test_close(seconds[i], b->seconds, 1e-9));
+            free_benchmark(&b);
+        }
+
+        // every point is predicted, extrapolating from the nearest
+        // benchmark where there is no interpolated speed
+        TEST_CHECK(seconds[i] > 0.);
+        TEST_CHECK(expected_seconds(m, &(q[i*m->n_p]), flops[i], seconds[i]));
+    }
+
+    free(flops);
+    free(seconds);
+}
+
+int
+main(void)
+{
+    struct pmm_model *m;
+    int q[2*N_QUERIES];
+    int p[2];
+    int i, j;
+
+    srand(1);
+
+    // single parameter model, some points benchmarked twice
+    m = test_new_model(1);
+    n_records = 0;
+    complexity_scale = 1000.;
+    for(i=1; i<=40; i++) {
+        p[0] = 64*i;
+        record_bench(m, p, 1e6 + 1e4*(i%7), 0.5 + i*0.01);
+        if(i % 3 == 0) {
+            record_bench(m, p, 1.1e6 + 1e4*(i%5), 0.6 + i*0.01);
+        }
+    }
+
+    // random points, including below the first and above the last benchmark
+    for(i=0; i<N_QUERIES; i++) {
+        q[i] = 1 + rand() % 3000;
+    }
+    // benchmarked points and the end points
+    q[0] = 64;
+    q[1] = 64*40;
+    q[2] = 64*3;
+    check_model(m, q, N_QUERIES);
+
+    free_model(&m);
+
+    // two parameter model on a grid
+    m = test_new_model(2);
+    n_records = 0;
+    complexity_scale = 1.;
+    for(i=1; i<=8; i++) {
+        for(j=1; j<=8; j++) {
+            p[0] = 100*i;
+            p[1] = 50*j;
+            record_bench(m, p, 1e6 + 1e3*(i*j%11), 0.1*i*j);
+        }
+    }
+
+    // random points, including outside the convex hull
+    for(i=0; i<N_QUERIES; i++) {
+        q[2*i] = 1 + rand() % 1000;
+        q[2*i+1] = 1 + rand() % 500;
+    }
+    q[0] = 100;
+    q[1] = 50;
+    q[2] = 800;
+    q[3] = 400;
+    check_model(m, q, N_QUERIES);
+
+    free_model(&m);
+
+    return test_result("lookup_batch_test");
+}
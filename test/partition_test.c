@@ -0,0 +1,248 @@
+/*
+    Copyright (C) 2008-2010 Robert Higgins
+        Author: Robert Higgins <robert.higgins@ucd.ie>
+
+    This file is part of PMM.
+
+    PMM is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMM is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+ * @file    partition_test.c
+ * @brief   Test partitioning of a problem between models of known speed
+ *
+ * Each test model is benchmarked at regular points on a speed curve that is
+ * linear in the problem size, so the interpolated speed is the curve itself,
+ * and its benchmarks report a complexity equal to their size. The time of a
+ * part x is then x/s(x), worked out here independently of the partitioning.
+ * The parts must sum to the problem size and be balanced to within a unit:
+ * no processor may finish its part later than any other would finish its
+ * own with one more unit.
+ */
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "pmm_model.h"
+#include "pmm_partition.h"
+#include "pmm_test.h"
+
+//! most models partitioned between in a test
+#define MAX_MODELS 3
+//! spacing of the benchmarks of a test model
+#define BENCH_STEP 10
+
+/*!
+ * speed curve s(x) = c0 + c1*x of a test model
+ */
+struct speed_curve {
+    double c0;
+    double c1;
+};
+
+double
+curve_speed(struct speed_curve *c, int x);
+double
+curve_seconds(struct speed_curve *c, int x);
+struct pmm_model*
+new_curve_model(struct speed_curve *c, int end);
+void
+check_partition(struct speed_curve *curves, int n, int end, int size,
+                int *expected);
+void
+test_out_of_range(void);
+
+/*!
+ * Speed of a curve at a problem size
+ *
+ * @param   c   pointer to the curve
+ * @param   x   problem size
+ *
+ * @return the speed
+ */
+double
+curve_speed(struct speed_curve *c, int x)
+{
+    return c->c0 + c->c1*x;
+}
+
+/*!
+ * Execution time of a part on a curve, its size over its speed
+ *
+ * @param   c   pointer to the curve
+ * @param   x   size of the part
+ *
+ * @return the execution time, 0 for an empty part
+ */
+double
+curve_seconds(struct speed_curve *c, int x)
+{
+    if(x <= 0) {
+        return 0.0;
+    }
+
+    return x/curve_speed(c, x);
+}
+
+/*!
+ * Create a single parameter model benchmarked on a speed curve at 1 and at
+ * every BENCH_STEP up to an end
+ *
+ * @param   c       pointer to the curve
+ * @param   end     largest size benchmarked, beyond which the model has no
+ *                  speed
+ *
+ * @return pointer to the model
+ */
+struct pmm_model*
+new_curve_model(struct speed_curve *c, int end)
+{
+    struct pmm_model *m;
+    int x;
+
+    m = test_new_model(1);
+
+    x = 1;
+    test_add_bench(m, &x, curve_speed(c, x), curve_seconds(c, x), x);
+
+    for(x=BENCH_STEP; x<=end; x+=BENCH_STEP) {
+        test_add_bench(m, &x, curve_speed(c, x), curve_seconds(c, x), x);
+    }
+
+    return m;
+}
+
+/*!
+ * Partition a problem between models of speed curves and check the parts
+ *
+ * @param   curves      pointer to array of n speed curves
+ * @param   n           number of curves
+ * @param   end         largest size benchmarked on each curve
+ * @param   size        size of the problem
+ * @param   expected    pointer to array of n expected parts, or NULL to only
+ *                      check the parts are balanced
+ */
+void
+check_partition(struct speed_curve *curves, int n, int end, int size,
+                int *expected)
+{
+    struct pmm_model *models[MAX_MODELS];
+    int parts[MAX_MODELS];
+    double seconds[MAX_MODELS];
+    long long sum;
+    int i, j;
+
+    for(i=0; i<n; i++) {
+        models[i] = new_curve_model(&(curves[i]), end);
+    }
+
+    TEST_CHECK(partition_models(models, n, size, parts, seconds) == 0);
+
+    sum = 0;
+    for(i=0; i<n; i++) {
+        TEST_CHECK(parts[i] >= 0 && parts[i] <= size);
+        sum += parts[i];
+
+        if(expected != NULL) {
+            TEST_CHECK(parts[i] == expected[i]);
+        }
+
+        TEST_CHECK(test_close(seconds[i], curve_seconds(&(curves[i]), parts[i]),
+                              1e-9));
+    }
+    TEST_CHECK(sum == size);
+
+    // moving a unit to any other processor with a speed for it would not
+    // finish sooner
+    for(i=0; i<n; i++) {
+        for(j=0; j<n; j++) {
+            if(j == i || parts[i] == 0 || parts[j] + 1 > end) {
+                continue;
+            }
+
+            TEST_CHECK(curve_seconds(&(curves[i]), parts[i]) <=
+                       curve_seconds(&(curves[j]), parts[j] + 1)*(1 + 1e-9));
+        }
+    }
+
+    for(i=0; i<n; i++) {
+        free_model(&(models[i]));
+    }
+}
+
+/*!
+ * Test problems beyond the sizes the models have speeds for
+ */
+void
+test_out_of_range(void)
+{
+    struct speed_curve curves[2] = { { 10.0, 0.0 }, { 1.0, 0.0 } };
+    struct pmm_model *models[2];
+    int parts[2];
+    double seconds[2];
+
+    // the fast processor is capped at the largest size it was benchmarked at
+    models[0] = new_curve_model(&(curves[0]), 100);
+    models[1] = new_curve_model(&(curves[1]), 1000);
+
+    TEST_CHECK(partition_models(models, 2, 500, parts, seconds) == 0);
+    TEST_CHECK(parts[0] == 100);
+    TEST_CHECK(parts[1] == 400);
+    TEST_CHECK(test_close(seconds[0], 10.0, 1e-9));
+    TEST_CHECK(test_close(seconds[1], 400.0, 1e-9));
+
+    // together the models cannot take the whole problem
+    TEST_CHECK(partition_models(models, 2, 1101, parts, seconds) < 0);
+
+    // a model with no speed at all is given nothing
+    free_model(&(models[0]));
+    models[0] = test_new_model(1);
+    TEST_CHECK(partition_models(models, 2, 500, parts, seconds) == 0);
+    TEST_CHECK(parts[0] == 0);
+    TEST_CHECK(parts[1] == 500);
+    TEST_CHECK(seconds[0] == 0.0);
+
+    free_model(&(models[0]));
+    free_model(&(models[1]));
+}
+
+int
+main(void)
+{
+    struct speed_curve constant[3] = { { 1.0, 0.0 }, { 2.0, 0.0 },
+                                       { 3.0, 0.0 } };
+    struct speed_curve linear[3] = { { 1.0, 0.01 }, { 4.0, 0.0 },
+                                     { 2.0, -0.0005 } };
+    int even[3] = { 100, 200, 300 };
+    int leftover[3] = { 100, 200, 301 };
+    int empty[3] = { 0, 0, 0 };
+    int size;
+
+    // equal times at constant speeds, with and without units left over
+    check_partition(constant, 3, 1000, 600, even);
+    check_partition(constant, 3, 1000, 601, leftover);
+    check_partition(constant, 3, 1000, 0, empty);
+    check_partition(constant, 2, 1000, 7, NULL);
+
+    // speeds that rise, stay level and fall with the problem size
+    for(size=1; size<=2000; size+=37) {
+        check_partition(linear, 3, 1000, size, NULL);
+    }
+
+    test_out_of_range();
+
+    return test_result("partition_test");
+}
@@ -0,0 +1,257 @@
+/*
+    Copyright (C) 2008-2010 Robert Higgins
+        Author: Robert Higgins <robert.higgins@ucd.ie>
+
+    This file is part of PMM.
+
+    PMM is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMM is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+ * @file    pmm_test.c
+ * @brief   Helpers shared by the unit tests
+ */
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "pmm_model.h"
+#include "pmm_test.h"
+
+int test_failures = 0;
+
+/*!
+ * Create an empty model with a bench list
+ *
+ * @param   n_p     number of parameters of the model
+ *
+ * @return pointer to the model, the test is failed if it cannot be created
+ */
+struct pmm_model*
+test_new_model(int n_p)
+{
+    struct pmm_model *m;
+
+    m = new_model();
+    if(m == NULL) {
+        fprintf(stderr, "Error creating model.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    m->n_p = n_p;
+    m->bench_list = new_bench_list(m, n_p);
+    if(m->bench_list == NULL) {
+        fprintf(stderr, "Error creating bench list.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return m;
+}
+
+/*!
+ * Insert a benchmark into a model
+ *
+ * @param   m           pointer to the model
+ * @param   p           pointer to the parameters of the benchmark
+ * @param   flops       speed of the benchmark
+ * @param   seconds     execution time of the benchmark
+ * @param   complexity  complexity of the benchmark or -1
+ *
+ * @return pointer to the inserted benchmark, the test is failed if it cannot
+ * be inserted
+ */
+struct pmm_benchmark*
+test_add_bench(struct pmm_model *m, int *p, double flops, double seconds,
+               long long int complexity)
+{
+    struct pmm_benchmark *b;
+    int j;
+
+    b = new_list_benchmark(m->bench_list);
+    if(b == NULL) {
+        fprintf(stderr, "Error allocating benchmark.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for(j=0; j<m->n_p; j++) {
+        b->p[j] = p[j];
+    }
+    b->flops = flops;
+    b->seconds = seconds;
+    b->complexity = complexity;
+    double_to_timeval(seconds, &(b->wall_t));
+    double_to_timeval(seconds, &(b->used_t));
+
+    if(insert_bench(m, b) < 0) {
+        fprintf(stderr, "Error inserting benchmark.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return b;
+}
+
+/*!
+ * Give a model parameter definitions, named p0, p1 ... with a stride of 1
+ *
+ * @param   m       pointer to the model, with n_p set
+ * @param   start   pointer to the start of each parameter
+ * @param   end     pointer to the end of each parameter
+ */
+void
+test_set_paramdefs(struct pmm_model *m, int *start, int *end)
+{
+    struct pmm_paramdef *pd;
+    int i;
+
+    m->pd_set = new_paramdef_set();
+    if(m->pd_set == NULL) {
+        fprintf(stderr, "Error creating parameter definitions.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    m->pd_set->n_p = m->n_p;
+    m->pd_set->pd_array = calloc(m->n_p, sizeof *(m->pd_set->pd_array));
+    if(m->pd_set->pd_array == NULL) {
+        fprintf(stderr, "Error allocating parameter definitions.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for(i=0; i<m->n_p; i++) {
+        pd = &(m->pd_set->pd_array[i]);
+
+        pd->name = malloc(16);
+        if(pd->name == NULL) {
+            fprintf(stderr, "Error allocating parameter name.\n");
+            exit(EXIT_FAILURE);
+        }
+        snprintf(pd->name, 16, "p%d", i);
+
+        pd->order = i;
+        pd->start = start[i];
+        pd->end = end[i];
+        pd->stride = 1;
+        pd->offset = 0;
+    }
+}
+
+/*!
+ * Read the whole of a file
+ *
+ * @param   path    path of the file
+ * @param   size    pointer to where the size of the file is stored
+ *
+ * @return pointer to the newly allocated contents of the file, or NULL if it
+ * cannot be read
+ */
+char*
+test_read_file(const char *path, size_t *size)
+{
+    FILE *f;
+    char *buf;
+    long len;
+
+    f = fopen(path, "rb");
+    if(f == NULL) {
+        return NULL;
+    }
+
+    if(fseek(f, 0, SEEK_END) != 0 || (len = ftell(f)) < 0 ||
+       fseek(f, 0, SEEK_SET) != 0)
+    {
+        fclose(f);
+        return NULL;
+    }
+
+    buf = malloc(len + 1);
+    if(buf == NULL || fread(buf, 1, len, f) != (size_t)len) {
+        free(buf);
+        fclose(f);
+        return NULL;
+    }
+    buf[len] = '\0';
+
+    fclose(f);
+
+    *size = len;
+
+    return buf;
+}
+
+/*!
+ * Replace the contents of a file
+ *
+ * @param   path    path of the file
+ * @param   buf     pointer to the new contents
+ * @param   size    size of the new contents
+ *
+ * @return 0 on success, -1 on failure
+ */
+int
+test_write_file(const char *path, const char *buf, size_t size)
+{
+    FILE *f;
+
+    f = fopen(path, "wb");
+    if(f == NULL) {
+        return -1;
+    }
+
+    if(fwrite(buf, 1, size, f) != size) {
+        fclose(f);
+        return -1;
+    }
+
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+/*!
+ * Compare two values to a relative tolerance, NAN only matching NAN
+ *
+ * @param   a       first value
+ * @param   b       second value
+ * @param   tol     relative tolerance
+ *
+ * @return 1 if the values match, 0 if not
+ */
+int
+test_close(double a, double b, double tol)
+{
+    if(isnan(a) || isnan(b)) {
+        return isnan(a) && isnan(b);
+    }
+
+    return fabs(a - b) <= tol * fmax(1.0, fmax(fabs(a), fabs(b)));
+}
+
+/*!
+ * Report the result of a test
+ *
+ * @param   name    name of the test
+ *
+ * @return exit status of the test, 0 if all checks passed, 1 otherwise
+ */
+int
+test_result(const char *name)
+{
+    if(test_failures > 0) {
+        fprintf(stderr, "%s: %d checks failed\n", name, test_failures);
+        return 1;
+    }
+
+    printf("%s: passed\n", name);
+
+    return 0;
+}
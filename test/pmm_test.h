@@ -0,0 +1,68 @@
+/*
+    Copyright (C) 2008-2010 Robert Higgins
+        Author: Robert Higgins <robert.higgins@ucd.ie>
+
+    This file is part of PMM.
+
+    PMM is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMM is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+ * @file   pmm_test.h
+ * @brief  Helpers shared by the unit tests
+ *
+ * Each unit test is a program run by make check, which exits with 0 if all
+ * of its checks pass and 1 otherwise.
+ */
+
+#ifndef PMM_TEST_H_
+#define PMM_TEST_H_
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stddef.h>
+
+#include "pmm_model.h"
+
+//! number of checks that have failed
+extern int test_failures;
+
+//! check a condition, reporting it and counting a failure if it is false
+#define TEST_CHECK(cond) do { \
+    if(!(cond)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, \
+                #cond); \
+        test_failures++; \
+    } \
+} while(0)
+
+struct pmm_model*
+test_new_model(int n_p);
+struct pmm_benchmark*
+test_add_bench(struct pmm_model *m, int *p, double flops, double seconds,
+               long long int complexity);
+void
+test_set_paramdefs(struct pmm_model *m, int *start, int *end);
+char*
+test_read_file(const char *path, size_t *size);
+int
+test_write_file(const char *path, const char *buf, size_t size);
+int
+test_close(double a, double b, double tol);
+int
+test_result(const char *name);
+
+#endif /*PMM_TEST_H_*/
@@ -0,0 +1,227 @@
+/*
+    Copyright (C) 2008-2010 Robert Higgins
+        Author: Robert Higgins <robert.higgins@ucd.ie>
+
+    This file is part of PMM.
+
+    PMM is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMM is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+ * @file    slab_test.c
+ * @brief   Test the slab allocator and the release of slab benchmarks
+ *
+ * Objects are allocated from a slab across several chunks, released and
+ * allocated again, checking that released objects are reused and that live
+ * objects never overlap. Benchmarks allocated from the slab of a bench list
+ * are then copied with copy_benchmark, and the slab benchmarks and their
+ * malloc'd copies are freed in interleaved order with free_benchmark.
+ */
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "pmm_model.h"
+#include "pmm_slab.h"
+#include "pmm_test.h"
+
+//! number of objects allocated from the test slab, spanning several chunks
+#define N_OBJS 300
+//! number of benchmarks added to the test model
+#define N_BENCH 100
+
+void
+test_slab(void);
+void
+test_benchmarks(void);
+
+/*!
+ * Test allocation, release and reuse of objects of a slab
+ */
+void
+test_slab(void)
+{
+    struct pmm_slab *s;
+    unsigned char *obj[N_OBJS];
+    void *again;
+    size_t size;
+    int i, j;
+
+    // small objects are rounded up to hold the free list link
+    s = new_slab(1);
+    TEST_CHECK(s != NULL);
+    if(s == NULL) {
+        return;
+    }
+    TEST_CHECK(s->size >= sizeof(void *));
+    TEST_CHECK(s->size == slab_align(s->size));
+    free_slab(&s);
+    TEST_CHECK(s == NULL);
+
+    size = 3 * sizeof(int);
+    s = new_slab(size);
+    if(s == NULL) {
+        TEST_CHECK(s != NULL);
+        return;
+    }
+
+    for(i=0; i<N_OBJS; i++) {
+        obj[i] = slab_alloc(s);
+        TEST_CHECK(obj[i] != NULL);
+        if(obj[i] == NULL) {
+            free_slab(&s);
+            return;
+        }
+        TEST_CHECK((size_t)obj[i] % slab_align(1) == 0);
+        memset(obj[i], i & 0xff, size);
+    }
+    TEST_CHECK(s->n_objs == N_OBJS);
+
+    // writing one object did not overwrite another
+    for(i=0; i<N_OBJS; i++) {
+        for(j=0; j<(int)size; j++) {
+            TEST_CHECK(obj[i][j] == (unsigned char)(i & 0xff));
+        }
+    }
+
+    // released objects are handed out again, most recently released first
+    for(i=0; i<N_OBJS; i+=3) {
+        slab_free(s, obj[i]);
+    }
+    TEST_CHECK(s->n_objs == N_OBJS - (N_OBJS+2)/3);
+
+    for(i=N_OBJS-1-(N_OBJS-1)%3; i>=0; i-=3) {
+        again = slab_alloc(s);
+        TEST_CHECK(again == obj[i]);
+        memset(obj[i], i & 0xff, size);
+    }
+    TEST_CHECK(s->n_objs == N_OBJS);
+
+    // with the free list empty a new object is distinct from all others
+    again = slab_alloc(s);
+    TEST_CHECK(again != NULL);
+    for(i=0; i<N_OBJS; i++) {
+        TEST_CHECK(again != (void *)obj[i]);
+    }
+    memset(again, 0xff, size);
+    for(i=0; i<N_OBJS; i++) {
+        for(j=0; j<(int)size; j++) {
+            TEST_CHECK(obj[i][j] == (unsigned char)(i & 0xff));
+        }
+    }
+
+    // objects still in use are released with the slab
+    free_slab(&s);
+}
+
+/*!
+ * Test copying and freeing benchmarks of a bench list, which are allocated
+ * from its slab, together with copies allocated by malloc
+ */
+void
+test_benchmarks(void)
+{
+    struct pmm_model *m;
+    struct pmm_benchmark *b[N_BENCH], *copy[N_BENCH], *reused;
+    int i, p[2];
+
+    m = test_new_model(2);
+
+    for(i=0; i<N_BENCH; i++) {
+        p[0] = i;
+        p[1] = 2 * i;
+        b[i] = test_add_bench(m, p, 1e6 + i, 1.0, 100 + i);
+
+        b[i]->cpuset = malloc(8);
+        if(b[i]->cpuset != NULL) {
+            strcpy(b[i]->cpuset, "0-3");
+        }
+        TEST_CHECK(add_benchmark_metric(b[i], "cycles", i) == 0);
+        TEST_CHECK(b[i]->slab != NULL);
+    }
+    TEST_CHECK(m->bench_list->slab->n_objs == N_BENCH);
+
+    for(i=0; i<N_BENCH; i++) {
+        copy[i] = new_benchmark();
+        TEST_CHECK(copy[i] != NULL);
+        if(copy[i] == NULL) {
+            exit(test_result("slab_test"));
+        }
+        TEST_CHECK(copy_benchmark(copy[i], b[i]) == 0);
+
+        // the copy owns its own parameter array and is not in the slab
+        TEST_CHECK(copy[i]->slab == NULL);
+        TEST_CHECK(copy[i]->p != b[i]->p);
+        TEST_CHECK(copy[i]->n_p == 2);
+        TEST_CHECK(copy[i]->p[0] == i && copy[i]->p[1] == 2 * i);
+        TEST_CHECK(copy[i]->complexity == 100 + i);
+        TEST_CHECK(copy[i]->cpuset != NULL &&
+                   strcmp(copy[i]->cpuset, "0-3") == 0);
+        TEST_CHECK(copy[i]->n_metrics == 1 && copy[i]->metrics[0].value == i);
+    }
+    // copies did not come from the slab
+    TEST_CHECK(m->bench_list->slab->n_objs == N_BENCH);
+
+    // free half the slab benchmarks and every copy, interleaved
+    for(i=0; i<N_BENCH; i++) {
+        if(i % 2 == 0) {
+            TEST_CHECK(remove_bench_from_bench_list(m->bench_list, b[i]) == 0);
+            free_benchmark(&(b[i]));
+            TEST_CHECK(b[i] == NULL);
+        }
+        free_benchmark(&(copy[i]));
+        TEST_CHECK(copy[i] == NULL);
+    }
+    TEST_CHECK(m->bench_list->slab->n_objs == N_BENCH / 2);
+
+    // the remaining slab benchmarks are intact
+    for(i=1; i<N_BENCH; i+=2) {
+        TEST_CHECK(b[i]->p[0] == i && b[i]->p[1] == 2 * i);
+        TEST_CHECK(b[i]->flops == 1e6 + i);
+        TEST_CHECK(b[i]->n_metrics == 1 && b[i]->metrics[0].value == i);
+    }
+
+    // a new benchmark reuses the last released slab object with its own
+    // inline parameter array
+    reused = new_list_benchmark(m->bench_list);
+    TEST_CHECK(reused != NULL);
+    if(reused != NULL) {
+        TEST_CHECK(reused->slab == m->bench_list->slab);
+        TEST_CHECK(reused->n_p == 2);
+        TEST_CHECK(reused->p != NULL);
+        TEST_CHECK(reused->cpuset == NULL);
+        TEST_CHECK(reused->n_metrics == 0 && reused->metrics == NULL);
+        reused->p[0] = 7;
+        reused->p[1] = 14;
+        for(i=1; i<N_BENCH; i+=2) {
+            TEST_CHECK(b[i]->p[0] == i && b[i]->p[1] == 2 * i);
+        }
+        free_benchmark(&reused);
+    }
+    TEST_CHECK(m->bench_list->slab->n_objs == N_BENCH / 2);
+
+    // the model releases the remaining slab benchmarks
+    free_model(&m);
+}
+
+int
+main(void)
+{
+    test_slab();
+    test_benchmarks();
+
+    return test_result("slab_test");
+}
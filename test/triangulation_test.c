@@ -0,0 +1,311 @@
+/*
+    Copyright (C) 2008-2010 Robert Higgins
+        Author: Robert Higgins <robert.higgins@ucd.ie>
+
+    This file is part of PMM.
+
+    PMM is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMM is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+ * @file    triangulation_test.c
+ * @brief   Test the cached triangulation of a model against full rebuilds
+ *
+ * Benchmarks are inserted into and removed from a model of two parameters,
+ * and after each batch the cached triangulation, kept up to date in place as
+ * benchmarks are inserted, is compared with a triangulation built from
+ * scratch. Interpolation excluding a benchmarked point is compared with a
+ * triangulation built without that point.
+ */
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "pmm_model.h"
+#include "pmm_param.h"
+#include "pmm_delaunay.h"
+#include "pmm_test.h"
+
+//! relative tolerance of interpolated values
+#define TOL 1.0e-9
+//! number of random queries compared after each batch
+#define N_QUERIES 500
+//! upper bounds of the parameters
+#define HI_0 1000
+#define HI_1 2000
+
+void
+set_box(struct pmm_model *m);
+void
+random_point(int *p);
+void
+add_random_benchmarks(struct pmm_model *m, int n);
+void
+remove_random_benchmarks(struct pmm_model *m, int n);
+void
+check_against_rebuild(struct pmm_model *m);
+void
+check_excluding(struct pmm_model *m, int n);
+
+/*!
+ * Give a model parameter definitions, so that its triangulations are scaled
+ * from a fixed box rather than from the bounding box of its benchmarks
+ *
+ * @param   m   pointer to the model
+ */
+void
+set_box(struct pmm_model *m)
+{
+    m->pd_set = new_paramdef_set();
+    if(m->pd_set == NULL) {
+        fprintf(stderr, "Error creating parameter definitions.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    m->pd_set->n_p = 2;
+    m->pd_set->pd_array = calloc(2, sizeof *(m->pd_set->pd_array));
+    if(m->pd_set->pd_array == NULL) {
+        fprintf(stderr, "Error allocating parameter definitions.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    m->pd_set->pd_array[0].start = 0;
+    m->pd_set->pd_array[0].end = HI_0;
+    m->pd_set->pd_array[1].start = 0;
+    m->pd_set->pd_array[1].end = HI_1;
+}
+
+/*!
+ * Choose a random point, a little beyond the box on all sides so that some
+ * points fall outside the hull of the benchmarks
+ *
+ * @param   p   pointer to array where the point is stored
+ */
+void
+random_point(int *p)
+{
+    p[0] = rand() % (HI_0 + 101) - 50;
+    p[1] = rand() % (HI_1 + 101) - 50;
+}
+
+/*!
+ * Insert benchmarks with random speeds into a model, every fourth at a point
+ * that is already benchmarked, so that averages change as well as points
+ * being added
+ *
+ * @param   m   pointer to the model
+ * @param   n   number of benchmarks
+ */
+void
+add_random_benchmarks(struct pmm_model *m, int n)
+{
+    struct pmm_bench_list *bl;
+    int p[2];
+    int i, k;
+
+    bl = m->bench_list;
+
+    for(i=0; i<n; i++) {
+        if(i % 4 == 3 && bl->size > 0) {
+            k = rand() % bl->size;
+            p[0] = bl->params[2*k];
+            p[1] = bl->params[2*k+1];
+        }
+        else {
+            p[0] = rand() % (HI_0 + 1);
+            p[1] = rand() % (HI_1 + 1);
+        }
+
+        test_add_bench(m, p, 1e6 + rand() % 1000000, 1.0, -1);
+    }
+}
+
+/*!
+ * Remove random benchmarks from a model
+ *
+ * @param   m   pointer to the model
+ * @param   n   number of benchmarks
+ */
+void
+remove_random_benchmarks(struct pmm_model *m, int n)
+{
+    struct pmm_bench_list *bl;
+    struct pmm_benchmark *b;
+    int i, k;
+
+    bl = m->bench_list;
+
+    for(i=0; i<n && bl->size > 0; i++) {
+        k = rand() % bl->size;
+        b = get_first_bench(m, &(bl->params[2*k]));
+        TEST_CHECK(b != NULL);
+        if(b == NULL) {
+            return;
+        }
+
+        TEST_CHECK(remove_bench_from_bench_list(bl, b) == 0);
+        free_benchmark(&b);
+    }
+}
+
+/*!
+ * Compare the cached triangulation of a model with one built from scratch,
+ * at the benchmarked points and at random points
+ *
+ * @param   m   pointer to the model
+ */
+void
+check_against_rebuild(struct pmm_model *m)
+{
+    struct pmm_delaunay *cached, *full;
+    struct pmm_bench_list *bl;
+    double y_cached, y_full;
+    int ret_cached, ret_full;
+    int p[2];
+    int i;
+
+    bl = m->bench_list;
+
+    cached = get_model_triangulation(m);
+    full = triangulate_model(m, PMM_AVG);
+    TEST_CHECK(cached != NULL && full != NULL);
+    if(cached == NULL || full == NULL) {
+        return;
+    }
+
+    TEST_CHECK(cached->version == bl->version);
+    TEST_CHECK(cached->n_pts == full->n_pts);
+
+    for(i=0; i<bl->size + N_QUERIES; i++) {
+        if(i < bl->size) {
+            p[0] = bl->params[2*i];
+            p[1] = bl->params[2*i+1];
+        }
+        else {
+            random_point(p);
+        }
+
+        y_cached = NAN;
+        y_full = NAN;
+        ret_cached = delaunay_interpolate(cached, p, &y_cached);
+        ret_full = delaunay_interpolate(full, p, &y_full);
+
+        TEST_CHECK(ret_cached == ret_full);
+        TEST_CHECK(test_close(y_cached, y_full, TOL));
+    }
+
+    free_delaunay(&full);
+}
+
+/*!
+ * Compare interpolation of a model excluding a benchmarked point with a
+ * triangulation of the other points of the model
+ *
+ * @param   m   pointer to the model
+ * @param   n   number of points to check
+ */
+void
+check_excluding(struct pmm_model *m, int n)
+{
+    struct pmm_bench_list *bl;
+    struct pmm_bench_point *e;
+    struct pmm_benchmark *b;
+    struct pmm_delaunay *d;
+    double lo[2] = {0.0, 0.0};
+    double hi[2] = {HI_0, HI_1};
+    double y;
+    int *q;
+    int i, k;
+
+    bl = m->bench_list;
+
+    for(k=0; k<n; k++) {
+        q = &(bl->params[2*(rand() % bl->size)]);
+
+        d = new_delaunay(2, lo, hi);
+        TEST_CHECK(d != NULL);
+        if(d == NULL) {
+            return;
+        }
+
+        for(i=0; i<bl->size; i++) {
+            if(params_cmp(&(bl->params[2*i]), q, 2) == 0) {
+                continue;
+            }
+
+            e = get_bench_point(bl, &(bl->params[2*i]));
+            TEST_CHECK(delaunay_insert(d, &(bl->params[2*i]),
+                                       e->stats.mean_flops) >= 0);
+        }
+
+        y = NAN;
+        if(delaunay_interpolate(d, q, &y) < 0) {
+            y = NAN;
+        }
+
+        b = interpolate_delaunay_model(m, q, 1);
+        TEST_CHECK(b != NULL);
+        if(b != NULL) {
+            TEST_CHECK(test_close(b->flops, y, TOL));
+            free_benchmark(&b);
+        }
+
+        // excluding the point leaves the cached triangulation unchanged
+        TEST_CHECK(m->triangulation != NULL &&
+                   m->triangulation->version == bl->version);
+
+        free_delaunay(&d);
+    }
+}
+
+int
+main(void)
+{
+    struct pmm_model *m;
+    struct pmm_delaunay *cached;
+    int round;
+
+    srand(1);
+
+    m = test_new_model(2);
+    set_box(m);
+
+    add_random_benchmarks(m, 50);
+
+    for(round=0; round<4; round++) {
+        check_against_rebuild(m);
+        cached = m->triangulation;
+
+        // inserts update the cached triangulation in place
+        add_random_benchmarks(m, 100);
+        TEST_CHECK(m->triangulation == cached);
+        TEST_CHECK(m->triangulation != NULL &&
+                   m->triangulation->version == m->bench_list->version);
+        check_against_rebuild(m);
+        check_excluding(m, 20);
+
+        // removals leave it to be rebuilt, and inserts after removals
+        // neither use nor update the stale triangulation
+        remove_random_benchmarks(m, 40);
+        add_random_benchmarks(m, 10);
+        check_against_rebuild(m);
+        check_excluding(m, 20);
+    }
+
+    free_model(&m);
+
+    return test_result("triangulation_test");
+}